@@ -41,12 +41,11 @@ S3D_MATERIAL::S3D_MATERIAL( S3D_MASTER* father, const wxString& name ) :
     m_Name = name;
 }
 
-void S3D_MATERIAL::SetMaterial()
+void S3D_MATERIAL::SetMaterial( S3D_MASTER* aMaster )
 {
-    S3D_MASTER * s3dParent = (S3D_MASTER *) GetParent();
-    s3dParent->SetLastTransparency( m_Transparency );
+    aMaster->SetLastTransparency( m_Transparency );
 
-    if( ! s3dParent->IsOpenGlAllowed() )
+    if( ! aMaster->IsOpenGlAllowed() )
         return;
 
     glColorMaterial( GL_FRONT_AND_BACK, GL_AMBIENT_AND_DIFFUSE );
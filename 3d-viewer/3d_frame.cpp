@@ -141,6 +141,9 @@ void EDA_3D_FRAME::OnCloseWindow( wxCloseEvent& Event )
     if( Parent() )
         Parent()->m_Draw3DFrame = NULL;
 
+    // the 3D shapes are read again when the viewer is opened again
+    S3D_MODEL_CACHE::Clear();
+
     Destroy();
 }
 
@@ -0,0 +1,192 @@
+/**
+ * @file 3d_model_cache.cpp
+ */
+
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <map>
+
+#include <fctsys.h>
+#include <common.h>
+#include <wx/filename.h>
+
+#include <3d_viewer.h>
+#include <info3d_visu.h>
+#include "3d_struct.h"
+#include "modelparsers.h"
+
+
+extern void TransfertToGLlist( std::vector< S3D_VERTEX >& aVertices, double aBiuTo3DUnits );
+
+
+S3D_MODEL::~S3D_MODEL()
+{
+    for( unsigned ii = 0; ii < m_materials.size(); ++ii )
+        delete m_materials[ii];
+}
+
+
+void S3D_MODEL::AddMaterial( S3D_MATERIAL* aMaterial )
+{
+    m_materials.push_back( aMaterial );
+}
+
+
+S3D_MATERIAL* S3D_MODEL::FindMaterial( const wxString& aName ) const
+{
+    // A material defined again hides the previous one.
+    for( unsigned ii = m_materials.size(); ii > 0; --ii )
+    {
+        if( m_materials[ii - 1]->m_Name == aName )
+            return m_materials[ii - 1];
+    }
+
+    return NULL;
+}
+
+
+void S3D_MODEL::UseMaterial( S3D_MATERIAL* aMaterial )
+{
+    STEP step = { aMaterial, 0, 0 };
+
+    m_steps.push_back( step );
+}
+
+
+void S3D_MODEL::AddFace( const std::vector< S3D_VERTEX >& aVertices )
+{
+    STEP step = { NULL, (unsigned) m_vertices.size(), (unsigned) aVertices.size() };
+
+    m_vertices.insert( m_vertices.end(), aVertices.begin(), aVertices.end() );
+    m_steps.push_back( step );
+}
+
+
+void S3D_MODEL::Draw( S3D_MASTER* aMaster ) const
+{
+    double vrmlunits_to_3Dunits = g_Parm_3D_Visu.m_BiuTo3Dunits * UNITS3D_TO_UNITSPCB;
+    std::vector< S3D_VERTEX > vertices;
+
+    for( unsigned ii = 0; ii < m_steps.size(); ++ii )
+    {
+        const STEP& step = m_steps[ii];
+
+        if( step.material )
+        {
+            // sets the transparency of aMaster, which IsOpenGlAllowed() depends on
+            step.material->SetMaterial( aMaster );
+            continue;
+        }
+
+        if( !aMaster->IsOpenGlAllowed() )
+            continue;
+
+        vertices.assign( m_vertices.begin() + step.first,
+                         m_vertices.begin() + step.first + step.count );
+
+        aMaster->ObjectCoordsTo3DUnits( vertices );
+        TransfertToGLlist( vertices, vrmlunits_to_3Dunits );
+    }
+}
+
+
+/**
+ * The models of the process, by file name, with the modification time of the file
+ * when it was parsed.
+ */
+class MODEL_MAP
+{
+public:
+    struct ENTRY
+    {
+        time_t      mtime;
+        S3D_MODEL*  model;
+    };
+
+    typedef std::map< wxString, ENTRY > MAP;
+
+    MAP     m_models;
+
+    ~MODEL_MAP()
+    {
+        Clear();
+    }
+
+    void Clear()
+    {
+        for( MAP::iterator it = m_models.begin(); it != m_models.end(); ++it )
+            delete it->second.model;
+
+        m_models.clear();
+    }
+};
+
+
+static MODEL_MAP s_models;
+
+
+S3D_MODEL* S3D_MODEL_CACHE::Get( const wxString& aFileName )
+{
+    wxStructStat stat;
+
+    if( wxStat( aFileName, &stat ) != 0 )
+        return NULL;
+
+    MODEL_MAP::MAP::iterator it = s_models.m_models.find( aFileName );
+
+    if( it != s_models.m_models.end() )
+    {
+        if( it->second.mtime == stat.st_mtime )
+            return it->second.model;
+
+        // the file has been modified since it was parsed
+        delete it->second.model;
+        s_models.m_models.erase( it );
+    }
+
+    wxFileName fn( aFileName );
+    S3D_MODEL* model = new S3D_MODEL;
+    S3D_MODEL_PARSER* parser = S3D_MODEL_PARSER::Create( model, fn.GetExt() );
+
+    if( !parser )
+    {
+        delete model;
+        return NULL;
+    }
+
+    parser->Load( aFileName );
+    delete parser;
+
+    MODEL_MAP::ENTRY entry = { stat.st_mtime, model };
+
+    s_models.m_models[aFileName] = entry;
+
+    return model;
+}
+
+
+void S3D_MODEL_CACHE::Clear()
+{
+    s_models.Clear();
+}
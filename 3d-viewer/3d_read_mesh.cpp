@@ -39,16 +39,16 @@
 #include "modelparsers.h"
 
 
-S3D_MODEL_PARSER* S3D_MODEL_PARSER::Create( S3D_MASTER* aMaster,
+S3D_MODEL_PARSER* S3D_MODEL_PARSER::Create( S3D_MODEL* aModel,
                                             const wxString aExtension )
 {
     if ( aExtension == wxT( "x3d" ) )
     {
-        return new X3D_MODEL_PARSER( aMaster );
+        return new X3D_MODEL_PARSER( aModel );
     }
     else if ( aExtension == wxT( "wrl" ) )
     {
-        return new VRML_MODEL_PARSER( aMaster );
+        return new VRML_MODEL_PARSER( aModel );
     }
     else
     {
@@ -112,20 +112,18 @@ int S3D_MASTER::ReadData()
         return -1;
     }
 
-    wxFileName fn( filename );
+    // A file used by several footprints is parsed only once.
+    S3D_MODEL* model = S3D_MODEL_CACHE::Get( filename );
 
-    wxString extension = fn.GetExt();
-    S3D_MODEL_PARSER* parser = S3D_MODEL_PARSER::Create( this, extension );
-
-    if( parser )
+    if( model )
     {
-        parser->Load( filename );
-        delete parser;
+        model->Draw( this );
         return 0;
     }
     else
     {
-        wxLogDebug( wxT( "Unknown file type '%s'" ), GetChars( extension ) );
+        wxFileName fn( filename );
+        wxLogDebug( wxT( "Unknown file type '%s'" ), GetChars( fn.GetExt() ) );
     }
 
     return -1;
@@ -30,6 +30,7 @@
 #ifndef STRUCT_3D_H
 #define STRUCT_3D_H
 
+#include <vector>
 #include <common.h>
 #include <base_struct.h>
 
@@ -80,7 +81,12 @@ public:
     S3D_MATERIAL* Next() const { return (S3D_MATERIAL*) Pnext; }
     S3D_MATERIAL* Back() const { return (S3D_MATERIAL*) Pback; }
 
-    void SetMaterial();
+    /**
+     * Function SetMaterial
+     * makes this material the current OpenGL one.
+     * @param aMaster is the 3D shape drawn with this material.
+     */
+    void SetMaterial( S3D_MASTER* aMaster );
 
 #if defined(DEBUG)
     void Show( int nestLevel, std::ostream& os ) const { ShowDummy( os ); } // override
@@ -192,6 +198,95 @@ public:
 };
 
 
+/**
+ * Class S3D_MODEL
+ * holds the materials and the faces of a 3D shape file, in the units of the file.
+ * A file is parsed only once into a S3D_MODEL, kept by S3D_MODEL_CACHE, which is
+ * drawn for each footprint using it with the scale, rotation and offset of the
+ * S3D_MASTER of the footprint.
+ */
+class S3D_MODEL
+{
+public:
+    S3D_MODEL() {}
+    ~S3D_MODEL();
+
+    /**
+     * Function AddMaterial
+     * adds a material definition to the model, which owns it afterwards.
+     */
+    void AddMaterial( S3D_MATERIAL* aMaterial );
+
+    /**
+     * Function FindMaterial
+     * @return S3D_MATERIAL* - the last material named @a aName added, or NULL.
+     */
+    S3D_MATERIAL* FindMaterial( const wxString& aName ) const;
+
+    /**
+     * Function UseMaterial
+     * makes @a aMaterial, a material of the model, the one of the next faces.
+     */
+    void UseMaterial( S3D_MATERIAL* aMaterial );
+
+    /**
+     * Function AddFace
+     * adds a polygon to the model.
+     */
+    void AddFace( const std::vector< S3D_VERTEX >& aVertices );
+
+    /**
+     * Function Draw
+     * sends the model to the current OpenGL list.
+     * @param aMaster gives the scale, rotation and offset of the model, and which
+     *  faces, transparent or not, are drawn.
+     */
+    void Draw( S3D_MASTER* aMaster ) const;
+
+private:
+    /// A material change when material is not NULL, else a face
+    struct STEP
+    {
+        S3D_MATERIAL*   material;
+        unsigned        first;      ///< first vertex of the face in m_vertices
+        unsigned        count;      ///< vertex count of the face
+    };
+
+    std::vector< S3D_MATERIAL* >    m_materials;    ///< owned
+    std::vector< STEP >             m_steps;        ///< in the order of the file
+    std::vector< S3D_VERTEX >       m_vertices;
+
+    // not copyable, the materials are owned
+    S3D_MODEL( const S3D_MODEL& );
+    S3D_MODEL& operator=( const S3D_MODEL& );
+};
+
+
+/**
+ * Class S3D_MODEL_CACHE
+ * keeps the 3D shape files of the process parsed, by file name, so a shape used by
+ * many footprints is only read once.  A file modified since it was parsed is read
+ * again.
+ */
+class S3D_MODEL_CACHE
+{
+public:
+    /**
+     * Function Get
+     * @param aFileName is the full name of a 3D shape file.
+     * @return S3D_MODEL* - the model of the file, owned by the cache, or NULL if
+     *  the file does not exist or its type is not known.
+     */
+    static S3D_MODEL* Get( const wxString& aFileName );
+
+    /**
+     * Function Clear
+     * frees all the models, e.g. when the 3D viewer is closed.
+     */
+    static void Clear();
+};
+
+
 /* Describes a complex 3D */
 class STRUCT_3D_SHAPE : public EDA_ITEM
 {
@@ -30,15 +30,14 @@
 #define MODELPARSERS_H
 
 #include <map>
+#include <string>
 #include <vector>
 #include <wx/string.h>
 
 
-class S3D_MASTER;
+class S3D_MODEL;
 class S3D_VERTEX;
 
-extern void TransfertToGLlist( std::vector< S3D_VERTEX >& aVertices, double aBiuTo3DUnits );
-
 class S3D_MODEL_PARSER;
 class X3D_MODEL_PARSER;
 
@@ -49,16 +48,16 @@ class X3D_MODEL_PARSER;
 class S3D_MODEL_PARSER
 {
 public:
-    S3D_MODEL_PARSER(S3D_MASTER* aMaster) :
-        master( aMaster )
+    S3D_MODEL_PARSER( S3D_MODEL* aModel ) :
+        model( aModel )
     {}
 
     virtual ~S3D_MODEL_PARSER()
     {}
 
-    S3D_MASTER* GetMaster()
+    S3D_MODEL* GetModel()
     {
-        return master;
+        return model;
     }
 
     /**
@@ -66,10 +65,10 @@ public:
      * Factory method for creating concrete 3D model parsers
      * Notice that the caller is responsible to delete created parser.
      *
-     * @param aMaster is master object that the parser will fill.
+     * @param aModel is the model object that the parser will fill.
      * @param aExtension is file extension of the file you are going to parse.
      */
-    static S3D_MODEL_PARSER* Create( S3D_MASTER* aMaster, const wxString aExtension );
+    static S3D_MODEL_PARSER* Create( S3D_MODEL* aModel, const wxString aExtension );
     /**
      * Function Load
      *
@@ -78,7 +77,7 @@ public:
     virtual void Load( const wxString aFilename ) = 0;
 
 private:
-    S3D_MASTER* master;
+    S3D_MODEL* model;
 };
 
 
@@ -91,7 +90,7 @@ class wxXmlNode;
 class X3D_MODEL_PARSER: public S3D_MODEL_PARSER
 {
 public:
-    X3D_MODEL_PARSER( S3D_MASTER* aMaster );
+    X3D_MODEL_PARSER( S3D_MODEL* aModel );
     ~X3D_MODEL_PARSER();
     void Load( const wxString aFilename );
 
@@ -137,57 +136,79 @@ private:
     void rotate( S3D_VERTEX& aCoordinate, S3D_VERTEX& aRotAxis, double angle );
 };
 
+class VRML_LEXER;
+
 /**
- * class WRL_MODEL_PARSER
- * Parses
+ * class VRML_MODEL_PARSER
+ * Parses the IndexedFaceSet and the Material nodes of a VRML 2.0 file, the other
+ * nodes are skipped, except for their children.
  */
 class VRML_MODEL_PARSER: public S3D_MODEL_PARSER
 {
 public:
-    VRML_MODEL_PARSER( S3D_MASTER* aMaster );
+    VRML_MODEL_PARSER( S3D_MODEL* aModel );
     ~VRML_MODEL_PARSER();
     void Load( const wxString aFilename );
 
 private:
     /**
-     * Function ReadMaterial
-     * read the description of a 3D material definition in the form:
-     * DEF yellow material Material (
-     * DiffuseColor 1.00000 1.00000 0.00000e 0
-     * EmissiveColor 0.00000e 0 0.00000e 0 0.00000e 0
-     * SpecularColor 1.00000 1.00000 1.00000
-     * AmbientIntensity 1.00000
-     * Transparency 0.00000e 0
-     * Shininess 1.00000
-     *)
-     * Or type:
-     * USE yellow material
+     * Function readNode
+     * reads a node, of the type @a aType or, if @a aType is "DEF", of the type
+     * following its name.  The node is read up to its closing brace.
      */
-    int readMaterial( FILE* file, int* LineNum );
-    int readChildren( FILE* file, int* LineNum );
-    int readShape( FILE* file, int* LineNum );
-    int readAppearance( FILE* file, int* LineNum );
-    int readGeometry( FILE* file, int* LineNum );
+    bool readNode( VRML_LEXER& aLexer, const char* aType );
 
     /**
-     * Function ReadCoordList
-     * reads 3D coordinate lists like:
-     *      coord Coordinate { point [
-     *        -5.24489 6.57640e-3 -9.42129e-2,
-     *        -5.11821 6.57421e-3 0.542654,
-     *        -3.45868 0.256565 1.32000 ] }
-     *  or:
-     *  normal Normal { vector [
-     *        0.995171 -6.08102e-6 9.81541e-2,
-     *        0.923880 -4.09802e-6 0.382683,
-     *        0.707107 -9.38186e-7 0.707107]
-     *      }
+     * Function readNodeHeader
+     * reads the beginning of the node value of a field, up to the opening brace of
+     * the node, in the form:
+     *  [DEF name] type {
+     * or:
+     *  USE name
+     * or:
+     *  NULL
      *
-     *  text_buffer contains the first line of this node :
-     *     "coord Coordinate { point ["
+     * @param aType receives the type of the node, empty for USE or NULL.
+     * @param aName receives the name of the DEF or USE, empty if none.
+     * @return int - 1 if the body of the node follows, 0 for USE or NULL, -1 on error.
+     */
+    int readNodeHeader( VRML_LEXER& aLexer, std::string* aType, std::string* aName );
+
+    /**
+     * Function readMaterial
+     * reads the value of the material field of an Appearance node:
+     * DEF yellow_material Material {
+     *   diffuseColor 1.00000 1.00000 0.00000e 0
+     *   emissiveColor 0.00000e 0 0.00000e 0 0.00000e 0
+     *   specularColor 1.00000 1.00000 1.00000
+     *   ambientIntensity 1.00000
+     *   transparency 0.00000e 0
+     *   shininess 1.00000
+     * }
+     * Or:
+     * USE yellow_material
      */
-    void readCoordsList( FILE* file, char* text_buffer, std::vector< double >& aList,
-                         int* LineNum );
+    bool readMaterial( VRML_LEXER& aLexer );
+    bool readChildren( VRML_LEXER& aLexer );
+    bool readShape( VRML_LEXER& aLexer );
+    bool readAppearance( VRML_LEXER& aLexer );
+
+    /**
+     * Function readGeometry
+     * reads the value of the geometry field of a Shape node.  Only the IndexedFaceSet
+     * nodes are read:
+     *  geometry IndexedFaceSet {
+     *      coord Coordinate { point [
+     *          -5.24489 6.57640e-3 -9.42129e-2,
+     *          -5.11821 6.57421e-3 0.542654,
+     *          -3.45868 0.256565 1.32000 ] }
+     *      coordIndex [ 0, 1, 2, -1 ]
+     *  }
+     */
+    bool readGeometry( VRML_LEXER& aLexer );
+
+    /// Reads the value of the coord field of an IndexedFaceSet node into @a aPoints.
+    bool readCoordinate( VRML_LEXER& aLexer, std::vector< S3D_VERTEX >& aPoints );
 };
 
 #endif // MODELPARSERS_H
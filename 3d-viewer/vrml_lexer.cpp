@@ -0,0 +1,477 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file vrml_lexer.cpp
+ */
+
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+
+#include <fctsys.h>
+#include <macros.h>
+#include <richio.h>
+#include <kicad_string.h>
+
+#include "3d_struct.h"
+#include "vrml_lexer.h"
+
+
+/// Greatest integer below which all the integers are exact doubles, 2^53.
+#define EXACT_INTEGER_MAX   9007199254740992ULL
+
+/// Count of the digits always held by an uint64_t.
+#define MANTISSA_DIGITS_MAX 19
+
+
+static inline bool isBlank( char c )
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == ',';
+}
+
+
+static inline bool isDelimiter( char c )
+{
+    return c == '{' || c == '}' || c == '[' || c == ']';
+}
+
+
+static inline bool isDigit( char c )
+{
+    return c >= '0' && c <= '9';
+}
+
+
+VRML_LEXER::VRML_LEXER( LINE_READER* aReader ) :
+    m_reader( aReader ),
+    m_next( "" ),
+    m_peekEnd( NULL ),
+    m_peeked( false )
+{
+}
+
+
+bool VRML_LEXER::skipBlanks()
+{
+    while( m_next )
+    {
+        if( isBlank( *m_next ) )
+            ++m_next;
+        else if( *m_next == '#' || *m_next == 0 )     // a comment, or the end of the line
+            m_next = m_reader->ReadLine();
+        else
+            return true;
+    }
+
+    return false;
+}
+
+
+const char* VRML_LEXER::scanToken( const char* aText )
+{
+    const char* cp = aText;
+
+    if( isDelimiter( *cp ) )
+    {
+        m_peekToken.assign( cp, 1 );
+        return cp + 1;
+    }
+
+    if( *cp == '"' )
+    {
+        // A string does not span several lines here, it is only used by the
+        // fields which are ignored.
+        m_peekToken.clear();
+
+        for( ++cp; *cp && *cp != '"'; ++cp )
+        {
+            if( *cp == '\\' && cp[1] )
+                ++cp;
+
+            m_peekToken += *cp;
+        }
+
+        return *cp ? cp + 1 : cp;
+    }
+
+    while( *cp && !isBlank( *cp ) && !isDelimiter( *cp ) && *cp != '#' )
+        ++cp;
+
+    m_peekToken.assign( aText, cp - aText );
+
+    return cp;
+}
+
+
+const char* VRML_LEXER::PeekTok()
+{
+    if( !m_peeked )
+    {
+        m_peekEnd = skipBlanks() ? scanToken( m_next ) : NULL;
+        m_peeked  = true;
+    }
+
+    return m_peekEnd ? m_peekToken.c_str() : NULL;
+}
+
+
+const char* VRML_LEXER::NextTok()
+{
+    if( !PeekTok() )
+        return NULL;
+
+    m_next   = m_peekEnd;
+    m_peeked = false;
+
+    m_token.swap( m_peekToken );
+
+    return m_token.c_str();
+}
+
+
+bool VRML_LEXER::NextTokIs( const char* aText )
+{
+    const char* tok = PeekTok();
+
+    if( !tok || stricmp( tok, aText ) != 0 )
+        return false;
+
+    NextTok();
+    return true;
+}
+
+
+bool VRML_LEXER::ReadNumber( double* aValue )
+{
+    // A peeked token is read again from the line, which still holds it.
+    m_peeked = false;
+
+    if( !skipBlanks() )
+        return false;
+
+    const char* end = ParseNumber( m_next, aValue );
+
+    if( !end )
+        return false;
+
+    m_next = end;
+    return true;
+}
+
+
+bool VRML_LEXER::ReadVertex( S3D_VERTEX& aVertex )
+{
+    return ReadNumber( &aVertex.x ) && ReadNumber( &aVertex.y ) && ReadNumber( &aVertex.z );
+}
+
+
+bool VRML_LEXER::ReadVertices( std::vector< S3D_VERTEX >& aVertices )
+{
+    m_peeked = false;
+
+    if( !skipBlanks() )
+        return false;
+
+    if( *m_next != '[' )
+    {
+        S3D_VERTEX vertex;
+
+        if( !ReadVertex( vertex ) )
+            return false;
+
+        aVertices.push_back( vertex );
+        return true;
+    }
+
+    ++m_next;
+
+    for( ;; )
+    {
+        if( !skipBlanks() )
+            return false;
+
+        if( *m_next == ']' )
+        {
+            ++m_next;
+            return true;
+        }
+
+        S3D_VERTEX vertex;
+
+        if( !ReadVertex( vertex ) )
+            return false;
+
+        aVertices.push_back( vertex );
+    }
+}
+
+
+bool VRML_LEXER::ReadIndices( std::vector< int >& aIndices )
+{
+    m_peeked = false;
+
+    if( !skipBlanks() )
+        return false;
+
+    bool list = *m_next == '[';
+
+    if( list )
+        ++m_next;
+
+    for( ;; )
+    {
+        if( !skipBlanks() )
+            return false;
+
+        if( list && *m_next == ']' )
+        {
+            ++m_next;
+            return true;
+        }
+
+        const char* cp = m_next;
+        bool        negative = *cp == '-';
+
+        if( *cp == '-' || *cp == '+' )
+            ++cp;
+
+        if( !isDigit( *cp ) )
+            return false;
+
+        int64_t value = 0;
+
+        // an index out of the range of an int is as wrong as a too large one
+        for( ; isDigit( *cp ); ++cp )
+        {
+            if( value <= INT_MAX )
+                value = value * 10 + ( *cp - '0' );
+        }
+
+        if( value > INT_MAX )
+            value = INT_MAX;
+
+        aIndices.push_back( negative ? -(int) value : (int) value );
+        m_next = cp;
+
+        if( !list )
+            return true;
+    }
+}
+
+
+bool VRML_LEXER::SkipValue()
+{
+    const char* tok = PeekTok();
+
+    if( !tok )
+        return false;
+
+    // No value, which is an error, but the end of the node must not be lost.
+    if( !strcmp( tok, "}" ) || !strcmp( tok, "]" ) )
+        return true;
+
+    tok = NextTok();
+
+    if( !strcmp( tok, "[" ) || !strcmp( tok, "{" ) )
+        return SkipBlock();
+
+    if( !strcmp( tok, "USE" ) )
+        return NextTok() != NULL;
+
+    if( !strcmp( tok, "DEF" ) )
+    {
+        // the name, then the type of the node
+        if( !NextTok() || !NextTok() )
+            return false;
+    }
+
+    if( NextTokIs( "{" ) )
+        return SkipBlock();
+
+    // the other numbers of a multiple value field, e.g. of a SFColor
+    double value;
+
+    while( ( tok = PeekTok() ) != NULL && ParseNumber( tok, &value ) )
+        NextTok();
+
+    return true;
+}
+
+
+bool VRML_LEXER::SkipBlock()
+{
+    int depth = 1;
+
+    for( ;; )
+    {
+        // No NextTok(), which would copy the token, the numbers are only skipped.
+        m_peeked = false;
+
+        if( !skipBlanks() )
+            return false;
+
+        char c = *m_next;
+
+        if( c == '{' || c == '[' )
+        {
+            ++depth;
+            ++m_next;
+        }
+        else if( c == '}' || c == ']' )
+        {
+            ++m_next;
+
+            if( --depth == 0 )
+                return true;
+        }
+        else if( c == '"' )
+        {
+            m_next = scanToken( m_next );
+        }
+        else
+        {
+            while( *m_next && !isBlank( *m_next ) && !isDelimiter( *m_next ) && *m_next != '#'
+                   && *m_next != '"' )
+                ++m_next;
+        }
+    }
+}
+
+
+unsigned VRML_LEXER::LineNumber() const
+{
+    return m_reader->LineNumber();
+}
+
+
+const char* VRML_LEXER::ParseNumber( const char* aText, double* aValue )
+{
+    // All the powers of ten which are exact doubles
+    static const double powersOf10[] =
+    {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const int   powerMax = DIM( powersOf10 ) - 1;
+    const char* cp = aText;
+    bool        negative = *cp == '-';
+
+    if( *cp == '-' || *cp == '+' )
+        ++cp;
+
+    uint64_t    mantissa = 0;
+    int         digits   = 0;       // significant digits in mantissa
+    int         exponent = 0;
+    bool        exact    = true;    // all the digits are in mantissa
+    bool        number   = false;   // a digit has been found
+
+    for( ; isDigit( *cp ); ++cp )
+    {
+        number = true;
+
+        if( digits < MANTISSA_DIGITS_MAX )
+        {
+            mantissa = mantissa * 10 + ( *cp - '0' );
+
+            if( mantissa )
+                ++digits;
+        }
+        else
+        {
+            exact = false;
+        }
+    }
+
+    if( *cp == '.' )
+    {
+        for( ++cp; isDigit( *cp ); ++cp )
+        {
+            number = true;
+
+            if( digits < MANTISSA_DIGITS_MAX )
+            {
+                mantissa = mantissa * 10 + ( *cp - '0' );
+                --exponent;
+
+                if( mantissa )
+                    ++digits;
+            }
+            else
+            {
+                exact = false;
+            }
+        }
+    }
+
+    if( !number )
+        return NULL;
+
+    // The exponent is a part of the number only if it has digits, as for strtod().
+    if( *cp == 'e' || *cp == 'E' )
+    {
+        const char* ep = cp + 1;
+        bool        negativeExp = *ep == '-';
+
+        if( *ep == '-' || *ep == '+' )
+            ++ep;
+
+        if( isDigit( *ep ) )
+        {
+            int value = 0;
+
+            for( ; isDigit( *ep ); ++ep )
+            {
+                if( value < 100000 )
+                    value = value * 10 + ( *ep - '0' );
+            }
+
+            exponent += negativeExp ? -value : value;
+            cp = ep;
+        }
+    }
+
+    // Both the mantissa and the power of ten are exact doubles, so one multiplication
+    // or division gives the correctly rounded value, i.e. the one of strtod().
+    if( exact && mantissa <= EXACT_INTEGER_MAX
+        && exponent >= -powerMax && exponent <= powerMax )
+    {
+        double value = (double) mantissa;
+
+        if( exponent < 0 )
+            value /= powersOf10[-exponent];
+        else
+            value *= powersOf10[exponent];
+
+        *aValue = negative ? -value : value;
+        return cp;
+    }
+
+    char* end;
+
+    *aValue = strtod( aText, &end );
+
+    return end;
+}
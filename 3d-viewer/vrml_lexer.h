@@ -0,0 +1,154 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file vrml_lexer.h
+ */
+
+#ifndef VRML_LEXER_H
+#define VRML_LEXER_H
+
+#include <string>
+#include <vector>
+
+
+class LINE_READER;
+class S3D_VERTEX;
+
+
+/**
+ * Class VRML_LEXER
+ * splits the text of a VRML 2.0 file into tokens.  The blanks, the commas and the
+ * comments separate the tokens, which are '{', '}', '[', ']', the quoted strings,
+ * without their quotes, and the words.  The arrays of numbers are read straight
+ * from the lines of the LINE_READER, usually a MMAP_LINE_READER, into the vectors
+ * of the model, without a token copy nor strtod() for the usual numbers.
+ */
+class VRML_LEXER
+{
+public:
+    /**
+     * Constructor VRML_LEXER
+     * @param aReader gives the lines of the file, it is not owned.
+     */
+    VRML_LEXER( LINE_READER* aReader );
+
+    /**
+     * Function NextTok
+     * @return const char* - the next token, or NULL at the end of the file.  The text
+     *  is valid until the next call to NextTok().
+     */
+    const char* NextTok();
+
+    /**
+     * Function PeekTok
+     * @return const char* - the token the next NextTok() will return, or NULL at
+     *  the end of the file.
+     */
+    const char* PeekTok();
+
+    /**
+     * Function NextTokIs
+     * reads the next token if it is @a aText, ignoring the case.
+     * @return bool - true if the token was @a aText, false otherwise.
+     */
+    bool NextTokIs( const char* aText );
+
+    /**
+     * Function ReadNumber
+     * reads a number, e.g. a SFFloat value.
+     * @return bool - false if the next token is not a number.
+     */
+    bool ReadNumber( double* aValue );
+
+    /**
+     * Function ReadVertex
+     * reads three numbers, e.g. a SFColor or SFVec3f value.
+     */
+    bool ReadVertex( S3D_VERTEX& aVertex );
+
+    /**
+     * Function ReadVertices
+     * appends the values of a MFVec3f field, a bracketed list of triplets or a
+     * single one, to @a aVertices.
+     * @return bool - false if the list is not well formed.
+     */
+    bool ReadVertices( std::vector< S3D_VERTEX >& aVertices );
+
+    /**
+     * Function ReadIndices
+     * appends the values of a MFInt32 field, a bracketed list of integers or a
+     * single one, to @a aIndices.
+     * @return bool - false if the list is not well formed.
+     */
+    bool ReadIndices( std::vector< int >& aIndices );
+
+    /**
+     * Function SkipValue
+     * reads and ignores the value of a field: numbers, words, a bracketed list or
+     * a node, with its DEF name if any.
+     * @return bool - false at the end of the file.
+     */
+    bool SkipValue();
+
+    /**
+     * Function SkipBlock
+     * reads and ignores tokens up to the '}' or ']' closing a block, the opening
+     * one having been read already.
+     * @return bool - false at the end of the file.
+     */
+    bool SkipBlock();
+
+    /// @return the number of the line being read, for error messages.
+    unsigned LineNumber() const;
+
+    /**
+     * Function ParseNumber
+     * reads the decimal number at the beginning of @a aText, as strtod() does in
+     * the C locale, with the same result.  The common numbers, whose digits fit in
+     * a double and whose power of ten is small, are converted exactly without
+     * strtod(), the others are given to strtod().
+     *
+     * @return const char* - the text after the number, or NULL if @a aText does not
+     *  begin with a number.
+     */
+    static const char* ParseNumber( const char* aText, double* aValue );
+
+private:
+    /// Skips the blanks, commas and comments, reading lines as needed.
+    /// @return false at the end of the file.
+    bool skipBlanks();
+
+    /// Copies the token beginning at @a aText to m_peekToken.
+    /// @return the text after the token.
+    const char* scanToken( const char* aText );
+
+    LINE_READER*    m_reader;
+    const char*     m_next;         ///< next char of the current line, NULL at the end
+    std::string     m_token;        ///< the text of the last token read
+    std::string     m_peekToken;    ///< the text of the token after m_next
+    const char*     m_peekEnd;      ///< end of m_peekToken in the line, NULL at the end
+    bool            m_peeked;       ///< m_peekToken and m_peekEnd are up to date
+};
+
+#endif // VRML_LEXER_H
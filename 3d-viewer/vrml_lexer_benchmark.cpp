@@ -0,0 +1,235 @@
+/**
+ * @file vrml_lexer_benchmark.cpp
+ * @brief measures the time taken to read the numbers of VRML files.
+ */
+
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/*
+    Usage: vrml_lexer_benchmark [--repeat=<n>] <wrl file> ...
+
+        --repeat=<n>    count of readings of each file, 5 by default
+
+    Each *.wrl file is read <n> times, first line by line with GetLine(), strtok()
+    and atof() as the VRML parser did before, then with MMAP_LINE_READER and
+    VRML_LEXER.  Both read all the numbers of the file, a difference in their count
+    or their sum is reported.  The mean time of one reading is printed in
+    milliseconds for both.
+
+    It needs no display, e.g. for a corpus of 3D shapes:
+        vrml_lexer_benchmark --repeat=3 `find $KISYS3DMOD -name "*.wrl"`
+*/
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include <fctsys.h>
+#include <common.h>
+#include <kicad_string.h>
+#include <richio.h>
+
+#include "vrml_lexer.h"
+
+
+static void usage()
+{
+    fprintf( stderr, "usage: vrml_lexer_benchmark [--repeat=<n>] <wrl file> ...\n" );
+}
+
+
+/**
+ * Function readLines
+ * reads all the numbers of a file as the former parser did.
+ * @return bool - false if the file cannot be read.
+ */
+static bool readLines( const char* aFileName, unsigned* aCount, double* aSum )
+{
+    FILE* file = fopen( aFileName, "rt" );
+
+    if( !file )
+        return false;
+
+    char    line[1024];
+    int     lineNum = 0;
+
+    *aCount = 0;
+    *aSum   = 0.0;
+
+    while( GetLine( file, line, &lineNum, 512 ) )
+    {
+        for( char* text = strtok( line, " ,\t\n\r" ); text; text = strtok( NULL, " ,\t\n\r" ) )
+        {
+            // the brackets may be glued to the numbers
+            while( *text == '[' || *text == '{' )
+                ++text;
+
+            if( ( *text >= '0' && *text <= '9' ) || *text == '-' || *text == '+' || *text == '.' )
+            {
+                *aSum += atof( text );
+                ++*aCount;
+            }
+        }
+    }
+
+    fclose( file );
+
+    return true;
+}
+
+
+/**
+ * Function readTokens
+ * reads all the numbers of a file with VRML_LEXER.
+ * @return bool - false if the file cannot be read.
+ */
+static bool readTokens( const char* aFileName, unsigned* aCount, double* aSum )
+{
+    *aCount = 0;
+    *aSum   = 0.0;
+
+    try
+    {
+        MMAP_LINE_READER    reader( FROM_UTF8( aFileName ), 0, 256 * 1024 * 1024 );
+        VRML_LEXER          lexer( &reader );
+        double              value;
+
+        for( ;; )
+        {
+            // ReadNumber() reads the numbers straight from the line, the other
+            // tokens are copied by NextTok().
+            if( lexer.ReadNumber( &value ) )
+            {
+                *aSum += value;
+                ++*aCount;
+            }
+            else if( !lexer.NextTok() )
+            {
+                break;
+            }
+        }
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        fprintf( stderr, "vrml_lexer_benchmark: %s\n", TO_UTF8( ioe.errorText ) );
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * Function benchmarkFile
+ * reads a file both ways and prints the timings.
+ * @return bool - false if the file cannot be read.
+ */
+static bool benchmarkFile( const char* aFileName, int aRepeat )
+{
+    unsigned    linesCount = 0;
+    unsigned    tokensCount = 0;
+    double      linesSum = 0.0;
+    double      tokensSum = 0.0;
+    unsigned    start = GetRunningMicroSecs();
+
+    for( int rr = 0; rr < aRepeat; ++rr )
+    {
+        if( !readLines( aFileName, &linesCount, &linesSum ) )
+        {
+            fprintf( stderr, "vrml_lexer_benchmark: cannot read %s\n", aFileName );
+            return false;
+        }
+    }
+
+    unsigned lines = GetRunningMicroSecs() - start;
+
+    start = GetRunningMicroSecs();
+
+    for( int rr = 0; rr < aRepeat; ++rr )
+    {
+        if( !readTokens( aFileName, &tokensCount, &tokensSum ) )
+            return false;
+    }
+
+    unsigned tokens = GetRunningMicroSecs() - start;
+
+    // The line reader also reads the numbers of the comments, and cuts the lines
+    // longer than its buffer, so both can differ.
+    if( linesCount != tokensCount || linesSum != tokensSum )
+    {
+        fprintf( stderr, "vrml_lexer_benchmark: %s: %u numbers (sum %.17g) read line by line, "
+                 "%u (sum %.17g) by the lexer\n",
+                 aFileName, linesCount, linesSum, tokensCount, tokensSum );
+    }
+
+    printf( "%s: %u numbers, GetLine/atof %.2f ms, VRML_LEXER %.2f ms\n",
+            aFileName, tokensCount, lines / 1000.0 / aRepeat, tokens / 1000.0 / aRepeat );
+
+    return true;
+}
+
+
+int main( int argc, char** argv )
+{
+    int repeat = 5;
+    int errors = 0;
+    int files  = 0;
+
+    for( int ii = 1; ii < argc; ++ii )
+    {
+        if( !strncmp( argv[ii], "--repeat=", 9 ) )
+        {
+            repeat = atoi( argv[ii] + 9 );
+
+            if( repeat <= 0 )
+            {
+                usage();
+                return 1;
+            }
+
+            continue;
+        }
+
+        if( argv[ii][0] == '-' )
+        {
+            usage();
+            return 1;
+        }
+
+        ++files;
+
+        if( !benchmarkFile( argv[ii], repeat ) )
+            ++errors;
+    }
+
+    if( !files )
+    {
+        usage();
+        return 1;
+    }
+
+    return errors ? 1 : 0;
+}
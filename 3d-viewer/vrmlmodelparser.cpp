@@ -30,18 +30,22 @@
 
 #include <fctsys.h>
 #include <vector>
+#include <common.h>
 #include <macros.h>
 #include <kicad_string.h>
-#include <info3d_visu.h>
+#include <richio.h>
 
 #include "3d_struct.h"
 #include "modelparsers.h"
+#include "vrml_lexer.h"
 
-// separator chars
-static const char* sep_chars = " \t\n\r";
 
-VRML_MODEL_PARSER::VRML_MODEL_PARSER( S3D_MASTER* aMaster ) :
-    S3D_MODEL_PARSER( aMaster )
+/// Longest line read, some exporters write a whole array on one line.
+#define VRML_LINE_MAX   ( 256 * 1024 * 1024 )
+
+
+VRML_MODEL_PARSER::VRML_MODEL_PARSER( S3D_MODEL* aModel ) :
+    S3D_MODEL_PARSER( aModel )
 {}
 
 
@@ -51,503 +55,394 @@ VRML_MODEL_PARSER::~VRML_MODEL_PARSER()
 
 void VRML_MODEL_PARSER::Load( const wxString aFilename )
 {
-    char       line[1024], * text;
-    FILE*      file;
-    int        LineNum = 0;
+    // strtod(), used for the uncommon numbers, needs the C locale
+    LOCALE_IO toggle;
 
-    file = wxFopen( aFilename, wxT( "rt" ) );
-
-    if( file == NULL )
+    try
     {
-        return;
-    }
+        MMAP_LINE_READER    reader( aFilename, 0, VRML_LINE_MAX );
+        VRML_LEXER          lexer( &reader );
+        const char*         text;
 
-    // Switch the locale to standard C (needed to print floating point numbers like 1.3)
-    SetLocaleTo_C_standard();
-
-    while( GetLine( file, line, &LineNum, 512 ) )
-    {
-        text = strtok( line, sep_chars );
-        if ( text == NULL )
-            continue;
-
-        if( stricmp( text, "DEF" ) == 0 || stricmp( text, "Group" ) == 0 )
+        while( ( text = lexer.NextTok() ) != NULL )
         {
-            while( GetLine( file, line, &LineNum, 512 ) )
+            // e.g. the body of a PROTO
+            if( !strcmp( text, "[" ) || !strcmp( text, "{" ) )
             {
-                text = strtok( line, sep_chars );
+                if( !lexer.SkipBlock() )
+                    break;
 
-                if( text == NULL )
-                    continue;
+                continue;
+            }
 
-                if( *text == '}' )
-                    break;
+            // a node, else e.g. a ROUTE statement, which is ignored
+            const char* next = lexer.PeekTok();
 
-                if( stricmp( text, "children" ) == 0 )
+            if( stricmp( text, "DEF" ) == 0 || ( next && !strcmp( next, "{" ) ) )
+            {
+                if( !readNode( lexer, text ) )
                 {
-                    readChildren( file, &LineNum );
+                    DBG( printf( "VRML read error at line %u\n", lexer.LineNumber() ) );
+                    break;
                 }
             }
         }
     }
-
-    fclose( file );
-    SetLocaleTo_Default();       // revert to the current locale
+    catch( const IO_ERROR& ioe )
+    {
+        wxLogDebug( wxT( "%s" ), GetChars( ioe.errorText ) );
+    }
 }
 
 
-int VRML_MODEL_PARSER::readMaterial( FILE* file, int* LineNum )
+bool VRML_MODEL_PARSER::readNode( VRML_LEXER& aLexer, const char* aType )
 {
-    char          line[512], * text, * command;
-    wxString      mat_name;
-    S3D_MATERIAL* material = NULL;
-
-    command  = strtok( NULL, sep_chars );
-    text     = strtok( NULL, sep_chars );
-    mat_name = FROM_UTF8( text );
+    std::string type = aType;
 
-    if( stricmp( command, "USE" ) == 0 )
+    if( stricmp( aType, "DEF" ) == 0 )
     {
-        for( material = GetMaster()->m_Materials; material; material = material->Next() )
-        {
-            if( material->m_Name == mat_name )
-            {
-                material->SetMaterial();
-                return 1;
-            }
-        }
+        const char* text;
 
-        DBG( printf( "ReadMaterial error: material not found\n" ) );
-        return 0;
-    }
+        // the name, then the type
+        if( !aLexer.NextTok() || ( text = aLexer.NextTok() ) == NULL )
+            return false;
 
-    if( stricmp( command, "DEF" ) == 0 || stricmp( command, "Material") == 0)
+        type = text;
+    }
+    else if( stricmp( aType, "USE" ) == 0 )
     {
-        material = new S3D_MATERIAL( GetMaster(), mat_name );
+        // the instances of a node are not supported
+        return aLexer.NextTok() != NULL;
+    }
 
-        GetMaster()->Insert( material );
+    if( !aLexer.NextTokIs( "{" ) )
+        return false;
 
-        while( GetLine( file, line, LineNum, 512 ) )
-        {
-            text = strtok( line, sep_chars );
+    if( stricmp( type.c_str(), "Shape" ) == 0 )
+        return readShape( aLexer );
 
-            if( text == NULL )
-                continue;
+    // A grouping node, e.g. Group or Transform, whose transform is not supported,
+    // or any other node, which is skipped.
+    const char* text;
 
-            if( text[0] == '}' )
-            {
-                material->SetMaterial();
-                return 0;
-            }
+    while( ( text = aLexer.NextTok() ) != NULL )
+    {
+        if( *text == '}' )
+            return true;
 
-            if( stricmp( text, "diffuseColor" ) == 0 )
-            {
-                text = strtok( NULL, sep_chars );
-                material->m_DiffuseColor.x = atof( text );
-                text = strtok( NULL, sep_chars );
-                material->m_DiffuseColor.y = atof( text );
-                text = strtok( NULL, sep_chars );
-                material->m_DiffuseColor.z = atof( text );
-            }
-            else if( stricmp( text, "emissiveColor" ) == 0 )
-            {
-                text = strtok( NULL, sep_chars );
-                material->m_EmissiveColor.x = atof( text );
-                text = strtok( NULL, sep_chars );
-                material->m_EmissiveColor.y = atof( text );
-                text = strtok( NULL, sep_chars );
-                material->m_EmissiveColor.z = atof( text );
-            }
-            else if( strnicmp( text, "specularColor", 13 ) == 0 )
-            {
-                text = strtok( NULL, sep_chars );
-                material->m_SpecularColor.x = atof( text );
-                text = strtok( NULL, sep_chars );
-                material->m_SpecularColor.y = atof( text );
-                text = strtok( NULL, sep_chars );
-                material->m_SpecularColor.z = atof( text );
-            }
-            else if( strnicmp( text, "ambientIntensity", 16 ) == 0 )
-            {
-                text = strtok( NULL, sep_chars );
-                material->m_AmbientIntensity = atof( text );
-            }
-            else if( strnicmp( text, "transparency", 12 ) == 0 )
-            {
-                text = strtok( NULL, sep_chars );
-                material->m_Transparency = atof( text );
-            }
-            else if( strnicmp( text, "shininess", 9 ) == 0 )
-            {
-                text = strtok( NULL, sep_chars );
-                material->m_Shininess = atof( text );
-            }
+        if( stricmp( text, "children" ) == 0 )
+        {
+            if( !readChildren( aLexer ) )
+                return false;
+        }
+        else if( !aLexer.SkipValue() )
+        {
+            return false;
         }
     }
 
-    return -1;
+    return false;
 }
 
 
-int VRML_MODEL_PARSER::readChildren( FILE* file, int* LineNum )
+int VRML_MODEL_PARSER::readNodeHeader( VRML_LEXER& aLexer, std::string* aType,
+                                       std::string* aName )
 {
-    char line[1024], * text;
+    const char* text = aLexer.NextTok();
+
+    aType->clear();
+    aName->clear();
+
+    if( !text )
+        return -1;
 
-    while( GetLine( file, line, LineNum, 512 ) )
+    if( stricmp( text, "NULL" ) == 0 )
+        return 0;
+
+    if( stricmp( text, "USE" ) == 0 || stricmp( text, "DEF" ) == 0 )
     {
-        text = strtok( line, sep_chars );
+        bool use = stricmp( text, "USE" ) == 0;
 
-        if( *text == ']' )
-            return 0;
+        if( ( text = aLexer.NextTok() ) == NULL )
+            return -1;
 
-        if( *text == ',' )
-            continue;
+        *aName = text;
 
-        if( stricmp( text, "Shape" ) == 0 )
-        {
-            readShape( file, LineNum );
-        }
-        else
-        {
-            DBG( printf( "ReadChildren error line %d <%s> \n", *LineNum, text ) );
-            break;
-        }
+        if( use )
+            return 0;
+
+        if( ( text = aLexer.NextTok() ) == NULL )
+            return -1;
     }
 
-    return 1;
+    *aType = text;
+
+    return aLexer.NextTokIs( "{" ) ? 1 : -1;
 }
 
 
-int VRML_MODEL_PARSER::readShape( FILE* file, int* LineNum )
+bool VRML_MODEL_PARSER::readMaterial( VRML_LEXER& aLexer )
 {
-    char line[1024], * text;
-    int  err = 1;
+    std::string     type;
+    std::string     name;
+    int             header = readNodeHeader( aLexer, &type, &name );
+
+    if( header < 0 )
+        return false;
+
+    if( header == 0 )
+    {
+        if( name.empty() )      // NULL
+            return true;
+
+        S3D_MATERIAL* material = GetModel()->FindMaterial( FROM_UTF8( name.c_str() ) );
+
+        if( material )
+            GetModel()->UseMaterial( material );
+        else
+            DBG( printf( "ReadMaterial error: material not found\n" ) );
+
+        return true;
+    }
 
-    while( GetLine( file, line, LineNum, 512 ) )
+    S3D_MATERIAL*   material = new S3D_MATERIAL( NULL, FROM_UTF8( name.c_str() ) );
+    const char*     text;
+    double          value;
+
+    GetModel()->AddMaterial( material );
+
+    while( ( text = aLexer.NextTok() ) != NULL )
     {
-        text = strtok( line, sep_chars );
+        bool ok = true;
 
         if( *text == '}' )
         {
-            err = 0;
-            break;
+            GetModel()->UseMaterial( material );
+            return true;
         }
 
-        if( stricmp( text, "appearance" ) == 0 )
+        if( stricmp( text, "diffuseColor" ) == 0 )
         {
-            readAppearance( file, LineNum );
+            ok = aLexer.ReadVertex( material->m_DiffuseColor );
         }
-        else if( stricmp( text, "geometry" ) == 0 )
+        else if( stricmp( text, "emissiveColor" ) == 0 )
+        {
+            ok = aLexer.ReadVertex( material->m_EmissiveColor );
+        }
+        else if( stricmp( text, "specularColor" ) == 0 )
+        {
+            ok = aLexer.ReadVertex( material->m_SpecularColor );
+        }
+        else if( stricmp( text, "ambientIntensity" ) == 0 )
         {
-            readGeometry( file, LineNum );
+            if( ( ok = aLexer.ReadNumber( &value ) ) )
+                material->m_AmbientIntensity = value;
+        }
+        else if( stricmp( text, "transparency" ) == 0 )
+        {
+            if( ( ok = aLexer.ReadNumber( &value ) ) )
+                material->m_Transparency = value;
+        }
+        else if( stricmp( text, "shininess" ) == 0 )
+        {
+            if( ( ok = aLexer.ReadNumber( &value ) ) )
+                material->m_Shininess = value;
         }
         else
         {
-            DBG( printf( "ReadShape error line %d <%s> \n", *LineNum, text ) );
-            break;
+            ok = aLexer.SkipValue();
         }
+
+        if( !ok )
+            return false;
     }
 
-    return err;
+    return false;
 }
 
 
-int VRML_MODEL_PARSER::readAppearance( FILE* file, int* LineNum )
+bool VRML_MODEL_PARSER::readChildren( VRML_LEXER& aLexer )
 {
-    char line[1024], * text;
-    int  err = 1;
+    bool        list = aLexer.NextTokIs( "[" );
+    const char* text;
 
-    while( GetLine( file, line, LineNum, 512 ) )
+    do
     {
-        text = strtok( line, sep_chars );
+        if( ( text = aLexer.NextTok() ) == NULL )
+            return false;
 
-        if( *text == '}' )
-        {
-            err = 0;
-            break;
-        }
+        if( list && *text == ']' )
+            return true;
 
-        if( stricmp( text, "material" ) == 0 )
-        {
-            readMaterial( file, LineNum );
-        }
-        else
+        if( !readNode( aLexer, text ) )
         {
-            DBG( printf( "ReadAppearance error line %d <%s> \n", *LineNum, text ) );
-            break;
+            DBG( printf( "ReadChildren error line %u\n", aLexer.LineNumber() ) );
+            return false;
         }
-    }
+    } while( list );
 
-    return err;
+    return true;
 }
 
 
-void VRML_MODEL_PARSER::readCoordsList( FILE* file, char* text_buffer,
-                                        std::vector< double >& aList, int* LineNum )
+bool VRML_MODEL_PARSER::readShape( VRML_LEXER& aLexer )
 {
-    unsigned int ii = 0, jj = 0;
-    char*        text;
-    bool         HasData   = false;
-    bool         StartData = false;
-    bool         EndNode   = false;
-    char         string_num[512];
-
-    text = text_buffer;
+    const char* text;
 
-    while( !EndNode )
+    while( ( text = aLexer.NextTok() ) != NULL )
     {
-        if( *text == 0 )  // Needs data !
+        bool ok;
+
+        if( *text == '}' )
+            return true;
+
+        if( stricmp( text, "appearance" ) == 0 )
+            ok = readAppearance( aLexer );
+        else if( stricmp( text, "geometry" ) == 0 )
+            ok = readGeometry( aLexer );
+        else
+            ok = aLexer.SkipValue();
+
+        if( !ok )
         {
-            text = text_buffer;
-            GetLine( file, text_buffer, LineNum, 512 );
+            DBG( printf( "ReadShape error line %u\n", aLexer.LineNumber() ) );
+            return false;
         }
+    }
 
-        while( !EndNode && *text )
-        {
-            switch( *text )
-            {
-            case '[':
-                StartData = true;
-                jj = 0;
-                string_num[jj] = 0;
-                break;
-
-            case '}':
-                EndNode = true;
-                break;
-
-            case ']':
-            case '\t':
-            case ' ':
-            case ',':
-                jj = 0;
-
-                if( !StartData || !HasData )
-                    break;
+    return false;
+}
 
-                aList.push_back( atof( string_num ) );
-                string_num[jj] = 0;
-                ii++;
 
-                HasData = false;
+bool VRML_MODEL_PARSER::readAppearance( VRML_LEXER& aLexer )
+{
+    std::string     type;
+    std::string     name;
+    int             header = readNodeHeader( aLexer, &type, &name );
 
-                if( *text == ']' )
-                {
-                    StartData = false;
-                }
+    if( header <= 0 )
+        return header == 0;
 
-                break;
+    const char* text;
 
-            default:
-                if( !StartData )
-                    break;
+    while( ( text = aLexer.NextTok() ) != NULL )
+    {
+        bool ok;
 
-                if( jj >= sizeof( string_num ) )
-                    break;
+        if( *text == '}' )
+            return true;
 
-                string_num[jj] = *text;
-                jj++;
-                string_num[jj] = 0;
-                HasData = true;
-                break;
-            }
+        if( stricmp( text, "material" ) == 0 )
+            ok = readMaterial( aLexer );
+        else
+            ok = aLexer.SkipValue();
 
-            text++;
+        if( !ok )
+        {
+            DBG( printf( "ReadAppearance error line %u\n", aLexer.LineNumber() ) );
+            return false;
         }
     }
+
+    return false;
 }
 
 
-int VRML_MODEL_PARSER::readGeometry( FILE* file, int* LineNum )
+bool VRML_MODEL_PARSER::readCoordinate( VRML_LEXER& aLexer, std::vector< S3D_VERTEX >& aPoints )
 {
-    char    line[1024], buffer[1024], * text;
-    int     err    = 1;
-    std::vector< double > points;
-    std::vector< double > list;
-    double vrmlunits_to_3Dunits = g_Parm_3D_Visu.m_BiuTo3Dunits * UNITS3D_TO_UNITSPCB;
+    std::string     type;
+    std::string     name;
+    int             header = readNodeHeader( aLexer, &type, &name );
 
-    while( GetLine( file, line, LineNum, 512 ) )
-    {
-        strcpy( buffer, line );
-        text = strtok( buffer, sep_chars );
+    if( header <= 0 )
+        return header == 0;
 
-        if( text == NULL )
-            continue;
+    const char* text;
 
-        if( *text == '}' )
-        {
-            err = 0;
-            break;
-        }
+    while( ( text = aLexer.NextTok() ) != NULL )
+    {
+        bool ok;
 
-        if( stricmp( text, "normalPerVertex" ) == 0 )
-        {
-            text = strtok( NULL, " ,\t\n\r" );
+        if( *text == '}' )
+            return true;
 
-            if( text && stricmp( text, "true" ) == 0 )
-            {
-            }
-            else
-            {
-            }
+        if( stricmp( text, "point" ) == 0 )
+            ok = aLexer.ReadVertices( aPoints );
+        else
+            ok = aLexer.SkipValue();
 
-            continue;
-        }
+        if( !ok )
+            return false;
+    }
 
-        if( stricmp( text, "colorPerVertex" ) == 0 )
-        {
-            text = strtok( NULL, " ,\t\n\r" );
+    return false;
+}
 
-            if( text && stricmp( text, "true" ) == 0 )
-            {
-            }
-            else
-            {
-            }
-            continue;
-        }
 
-        if( stricmp( text, "normal" ) == 0 )
-        {
-            readCoordsList( file, line, list, LineNum );
-            list.clear();
-            continue;
-        }
+bool VRML_MODEL_PARSER::readGeometry( VRML_LEXER& aLexer )
+{
+    std::string     type;
+    std::string     name;
+    int             header = readNodeHeader( aLexer, &type, &name );
 
-        if( stricmp( text, "normalIndex" ) == 0 )
-        {
-            while( GetLine( file, line, LineNum, 512 ) )
-            {
-                text = strtok( line, " ,\t\n\r" );
+    if( header <= 0 )
+        return header == 0;
 
-                while( text )
-                {
-                    if( *text == ']' )
-                        break;
+    if( stricmp( type.c_str(), "IndexedFaceSet" ) != 0 )
+        return aLexer.SkipBlock();
 
-                    text = strtok( NULL, " ,\t\n\r" );
-                }
+    std::vector< S3D_VERTEX >   points;
+    std::vector< int >          coordIndex;
+    const char*                 text;
 
-                if( text && (*text == ']') )
-                    break;
-            }
+    while( ( text = aLexer.NextTok() ) != NULL )
+    {
+        bool ok;
 
-            continue;
-        }
+        if( *text == '}' )
+            break;
 
-        if( stricmp( text, "color" ) == 0 )
-        {
-            readCoordsList( file, line, list, LineNum );
-            list.clear();
-            continue;
-        }
+        if( stricmp( text, "coord" ) == 0 )
+            ok = readCoordinate( aLexer, points );
+        else if( stricmp( text, "coordIndex" ) == 0 )
+            ok = aLexer.ReadIndices( coordIndex );
+        else        // e.g. normal, normalIndex, color, colorIndex, solid
+            ok = aLexer.SkipValue();
 
-        if( stricmp( text, "solid" ) == 0 )
+        if( !ok )
         {
-            // ignore solid
-            continue;
+            wxLogError( wxT( "3D geometry read error at line %u." ), aLexer.LineNumber() );
+            return false;
         }
+    }
 
-        if( stricmp( text, "colorIndex" ) == 0 )
-        {
-            while( GetLine( file, line, LineNum, 512 ) )
-            {
-                text = strtok( line, " ,\t\n\r" );
-
-                while( text )
-                {
-                    if( *text == ']' )
-                        break;
+    if( !text )
+        return false;
 
-                    text = strtok( NULL, " ,\t\n\r" );
-                }
+    // The faces are separated by -1, the last one may not be followed by it.
+    std::vector< S3D_VERTEX > vertices;
 
-                if( text && (*text == ']') )
-                    break;
-            }
+    for( unsigned ii = 0; ii <= coordIndex.size(); ii++ )
+    {
+        if( ii == coordIndex.size() || coordIndex[ii] < 0 )
+        {
+            if( !vertices.empty() )
+                GetModel()->AddFace( vertices );
 
+            vertices.clear();
             continue;
         }
 
-        if( stricmp( text, "coord" ) == 0 )
+        if( coordIndex[ii] >= (int) points.size() )
         {
-            readCoordsList( file, line, points, LineNum );
+            // the syntax is right, so the next shapes can still be read
+            wxLogError( wxT( "3D geometry index read error <%d> at line %u." ),
+                        coordIndex[ii], aLexer.LineNumber() );
+            return true;
         }
-        else if( stricmp( text, "coordIndex" ) == 0 )
-        {
-            if( points.size() < 3 || points.size() % 3 != 0 )
-            {
-                wxLogError( wxT( "3D geometry read error <%s> at line %d." ),
-                            GetChars( FROM_UTF8( text ) ), *LineNum );
-                err = 1;
-                break;
-            }
-
-            std::vector< int > coordIndex;
-            std::vector< S3D_VERTEX > vertices;
 
-            while( GetLine( file, line, LineNum, 512 ) )
-            {
-                int jj;
-                text = strtok( line, " ,\t\n\r" );
-
-                while( text )
-                {
-                    if( *text == ']' )
-                        break;
-
-                    jj = atoi( text );
-
-                    if( jj < 0 )
-                    {
-                        for( jj = 0; jj < (int) coordIndex.size(); jj++ )
-                        {
-                            int kk = coordIndex[jj] * 3;
-
-                            if( (kk < 0) || ((kk + 3) > (int)points.size()) )
-                            {
-                                wxLogError( wxT( "3D geometry index read error <%s> at line %d." ),
-                                            GetChars( FROM_UTF8( text ) ), *LineNum );
-                                err = 1;
-                                break;
-                            }
-
-                            S3D_VERTEX vertex;
-                            vertex.x = points[kk];
-                            vertex.y = points[kk + 1];
-                            vertex.z = points[kk + 2];
-                            vertices.push_back( vertex );
-                        }
-
-                        if( GetMaster()->IsOpenGlAllowed() )
-                        {
-                            GetMaster()->ObjectCoordsTo3DUnits( vertices );
-                            TransfertToGLlist( vertices, vrmlunits_to_3Dunits );
-                        }
-
-                        vertices.clear();
-                        coordIndex.clear();
-                    }
-                    else
-                    {
-                        coordIndex.push_back( jj );
-                    }
-
-                    text = strtok( NULL, " ,\t\n\r" );
-                }
-
-                if( text && (*text == ']') )
-                    break;
-            }
-        }
-        else
-        {
-            wxLogError( wxT( "3D geometry read error <%s> at line %d." ),
-                        GetChars( FROM_UTF8( text ) ), *LineNum );
-            err = 1;
-            break;
-        }
+        vertices.push_back( points[ coordIndex[ii] ] );
     }
 
-    return err;
+    return true;
 }
@@ -41,8 +41,8 @@
 #include <xnode.h>
 
 
-X3D_MODEL_PARSER::X3D_MODEL_PARSER( S3D_MASTER* aMaster ) :
-    S3D_MODEL_PARSER( aMaster )
+X3D_MODEL_PARSER::X3D_MODEL_PARSER( S3D_MODEL* aModel ) :
+    S3D_MODEL_PARSER( aModel )
 {}
 
 
@@ -196,8 +196,8 @@ void X3D_MODEL_PARSER::readMaterial( wxXmlNode* aMatNode )
     {
         double amb, shine, transp;
 
-        S3D_MATERIAL* material = new S3D_MATERIAL( GetMaster(), properties[ wxT( "DEF" ) ] );
-        GetMaster()->Insert( material );
+        S3D_MATERIAL* material = new S3D_MATERIAL( NULL, properties[ wxT( "DEF" ) ] );
+        GetModel()->AddMaterial( material );
 
         if( !parseDoubleTriplet( properties[ wxT( "diffuseColor" ) ],
                                  material->m_DiffuseColor ) )
@@ -251,7 +251,7 @@ void X3D_MODEL_PARSER::readMaterial( wxXmlNode* aMatNode )
             DBG( printf( "trans error") );
         }
 
-        material->SetMaterial();
+        GetModel()->UseMaterial( material );
 
         // VRML
         wxString vrml_material;
@@ -268,44 +268,41 @@ void X3D_MODEL_PARSER::readMaterial( wxXmlNode* aMatNode )
     // USE existing material named by value of USE
     else if( properties.find( wxT( "USE" ) ) != properties.end() )
     {
-        S3D_MATERIAL* material = NULL;
         wxString mat_name = properties[ wxT( "USE" ) ];
+        S3D_MATERIAL* material = GetModel()->FindMaterial( mat_name );
 
-        for( material = GetMaster()->m_Materials; material; material = material->Next() )
+        if( material )
         {
-            if( material->m_Name == mat_name )
-            {
-                wxString vrml_material;
+            wxString vrml_material;
 
-                vrml_material.Append( wxString::Format( wxT( "specularColor %f %f %f\n" ),
-                                                             material->m_SpecularColor.x,
-                                                             material->m_SpecularColor.y,
-                                                             material->m_SpecularColor.z ) );
+            vrml_material.Append( wxString::Format( wxT( "specularColor %f %f %f\n" ),
+                                                         material->m_SpecularColor.x,
+                                                         material->m_SpecularColor.y,
+                                                         material->m_SpecularColor.z ) );
 
-                vrml_material.Append( wxString::Format( wxT( "diffuseColor %f %f %f\n" ),
-                                                             material->m_DiffuseColor.x,
-                                                             material->m_DiffuseColor.y,
-                                                             material->m_DiffuseColor.z ) );
+            vrml_material.Append( wxString::Format( wxT( "diffuseColor %f %f %f\n" ),
+                                                         material->m_DiffuseColor.x,
+                                                         material->m_DiffuseColor.y,
+                                                         material->m_DiffuseColor.z ) );
 
-                vrml_material.Append( wxString::Format( wxT( "emissiveColor %f %f %f\n" ),
-                                                             material->m_EmissiveColor.x,
-                                                             material->m_EmissiveColor.y,
-                                                             material->m_EmissiveColor.z ) );
+            vrml_material.Append( wxString::Format( wxT( "emissiveColor %f %f %f\n" ),
+                                                         material->m_EmissiveColor.x,
+                                                         material->m_EmissiveColor.y,
+                                                         material->m_EmissiveColor.z ) );
 
-                vrml_material.Append( wxString::Format( wxT( "ambientIntensity %f\n"),
-                                                             material->m_AmbientIntensity ) );
+            vrml_material.Append( wxString::Format( wxT( "ambientIntensity %f\n"),
+                                                         material->m_AmbientIntensity ) );
 
-                vrml_material.Append( wxString::Format( wxT( "shininess %f\n"),
-                                                             material->m_Shininess ) );
+            vrml_material.Append( wxString::Format( wxT( "shininess %f\n"),
+                                                         material->m_Shininess ) );
 
-                vrml_material.Append( wxString::Format( wxT( "transparency %f\n"),
-                                                             material->m_Transparency ) );
+            vrml_material.Append( wxString::Format( wxT( "transparency %f\n"),
+                                                         material->m_Transparency ) );
 
-                vrml_materials.push_back( vrml_material );
+            vrml_materials.push_back( vrml_material );
 
-                material->SetMaterial();
-                return;
-            }
+            GetModel()->UseMaterial( material );
+            return;
         }
 
         DBG( printf( "ReadMaterial error: material not found\n" ) );
@@ -381,9 +378,6 @@ void X3D_MODEL_PARSER::readIndexedFaceSet( wxXmlNode* aFaceNode,
         DBG( printf("rotation read error") );
     }
 
-    double vrmlunits_to_3Dunits = g_Parm_3D_Visu.m_BiuTo3Dunits *
-                                  UNITS3D_TO_UNITSPCB;
-
     /* Step 2: Read all coordinate points
      * ---------------------------- */
     std::vector< double > points;
@@ -479,11 +473,7 @@ void X3D_MODEL_PARSER::readIndexedFaceSet( wxXmlNode* aFaceNode,
                 vertices.push_back( triplets.at( *id ) );
             }
 
-            if( GetMaster()->IsOpenGlAllowed() )
-            {
-                GetMaster()->ObjectCoordsTo3DUnits( vertices );
-                TransfertToGLlist( vertices, vrmlunits_to_3Dunits );
-            }
+            GetModel()->AddFace( vertices );
 
             vertices.clear();
             coordIndex.clear();
@@ -109,6 +109,10 @@ macro( perform_feature_checks )
     # getc() on platforms where getc_unlocked() doesn't exist.
     check_symbol_exists( getc_unlocked "stdio.h" HAVE_FGETC_NOLOCK )
 
+    # Check for Posix mmap() used by MMAP_LINE_READER.  Fall back to reading the whole
+    # file at once on platforms where mmap() doesn't exist.
+    check_symbol_exists( mmap "sys/mman.h" HAVE_MMAP )
+
     # Generate config.h.
     configure_file( ${PROJECT_SOURCE_DIR}/CMakeModules/config.h.cmake
         ${CMAKE_BINARY_DIR}/config.h
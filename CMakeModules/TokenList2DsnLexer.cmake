@@ -199,6 +199,199 @@ if( NOT ( tokensBefore EQUAL tokensAfter ) )
     message( FATAL_ERROR "Duplicate tokens found in file <${inputFile}>." )
 endif()
 
+# Build the perfect hash of the keywords, see struct KEYWORD_HASH in dsnlexer.h.
+# The hashes of each token must be computed exactly as in DSNLEXER::findToken().
+# All the intermediate values stay below 2^31 to be safe with a 32 bit math( EXPR ).
+# The displacement d of a bucket is tried from 0 up, as d0 = d / slotCount and
+# d1 = d % slotCount, until all its keywords fall into free slots.
+
+# the byte value of each character a token can contain
+set( ordinal 48 )
+foreach( c 0 1 2 3 4 5 6 7 8 9 )
+    set( ord_${c} ${ordinal} )
+    math( EXPR ordinal "${ordinal} + 1" )
+endforeach()
+
+set( ord__ 95 )
+
+set( ordinal 97 )
+foreach( c a b c d e f g h i j k l m n o p q r s t u v w x y z )
+    set( ord_${c} ${ordinal} )
+    math( EXPR ordinal "${ordinal} + 1" )
+endforeach()
+
+set( ndx 0 )
+
+foreach( token ${tokens} )
+    set( h 0 )
+
+    string( LENGTH "${token}" len )
+    math( EXPR last "${len} - 1" )
+
+    foreach( pos RANGE ${last} )
+        string( SUBSTRING "${token}" ${pos} 1 c )
+        math( EXPR h "( ${h} * 31 + ${ord_${c}} ) & 8388607" )
+    endforeach()
+
+    math( EXPR h "${h} ^ ( ${h} >> 12 )" )
+    math( EXPR h0 "( ${h} * 29 ) & 8388607" )
+    math( EXPR h2 "( ${h} * 37 ) & 8388607" )
+
+    math( EXPR h0_${ndx} "${h0} ^ ( ${h0} >> 12 )" )
+    set( h1_${ndx} ${h} )
+    math( EXPR h2_${ndx} "${h2} ^ ( ${h2} >> 12 )" )
+    math( EXPR ndx "${ndx} + 1" )
+endforeach()
+
+# Both counts are powers of 2:  about 4 keywords per bucket, and at most 80% of
+# the slots used.
+math( EXPR lastToken "${tokensAfter} - 1" )
+math( EXPR minSlotCount "${tokensAfter} + ${tokensAfter} / 4 + 1" )
+set( slotCount 1 )
+
+while( slotCount LESS minSlotCount )
+    math( EXPR slotCount "${slotCount} * 2" )
+endwhile()
+
+math( EXPR minBucketCount "( ${tokensAfter} + 3 ) / 4" )
+set( bucketCount 1 )
+
+while( bucketCount LESS minBucketCount )
+    math( EXPR bucketCount "${bucketCount} * 2" )
+endwhile()
+
+math( EXPR lastBucket "${bucketCount} - 1" )
+
+set( hashFound FALSE )
+
+while( NOT hashFound )
+    # Two keywords of a bucket can have the same hashes modulo slotCount, and then no
+    # displacement separates them: try again with twice as many slots.
+    set( hashFound TRUE )
+
+    foreach( b RANGE ${lastBucket} )
+        set( bucket_${b} "" )
+        unset( d0_${b} )
+        unset( d1_${b} )
+    endforeach()
+
+    set( maxBucketSize 0 )
+
+    foreach( i RANGE ${lastToken} )
+        math( EXPR b "${h0_${i}} & ( ${bucketCount} - 1 )" )
+        math( EXPR f1_${i} "${h1_${i}} & ( ${slotCount} - 1 )" )
+        math( EXPR f2_${i} "${h2_${i}} & ( ${slotCount} - 1 )" )
+        list( APPEND bucket_${b} ${i} )
+        list( LENGTH bucket_${b} size )
+
+        if( size GREATER maxBucketSize )
+            set( maxBucketSize ${size} )
+        endif()
+    endforeach()
+
+    set( usedSlots "" )
+    math( EXPR maxDisplacement "${slotCount} * ${slotCount}" )
+
+    # place the largest buckets first
+    set( size ${maxBucketSize} )
+
+    while( hashFound AND size GREATER 0 )
+        foreach( b RANGE ${lastBucket} )
+            list( LENGTH bucket_${b} bucketSize )
+
+            if( bucketSize EQUAL size )
+                set( d 0 )
+                set( placed FALSE )
+
+                while( NOT placed AND d LESS maxDisplacement )
+                    math( EXPR d0 "${d} / ${slotCount}" )
+                    math( EXPR d1 "${d} % ${slotCount}" )
+                    set( bucketSlots "" )
+                    set( placed TRUE )
+
+                    foreach( i ${bucket_${b}} )
+                        math( EXPR slot "( ${f1_${i}} + ${d0} * ${f2_${i}} + ${d1} ) & ( ${slotCount} - 1 )" )
+                        list( FIND usedSlots ${slot} usedNdx )
+                        list( FIND bucketSlots ${slot} bucketNdx )
+
+                        if( NOT usedNdx EQUAL -1 OR NOT bucketNdx EQUAL -1 )
+                            set( placed FALSE )
+                            break()
+                        endif()
+
+                        list( APPEND bucketSlots ${slot} )
+                    endforeach()
+
+                    if( NOT placed )
+                        math( EXPR d "${d} + 1" )
+                    endif()
+                endwhile()
+
+                if( NOT placed )
+                    set( hashFound FALSE )
+                    break()
+                endif()
+
+                set( d0_${b} ${d0} )
+                set( d1_${b} ${d1} )
+
+                list( APPEND usedSlots ${bucketSlots} )
+
+                foreach( i ${bucket_${b}} )
+                    list( GET bucketSlots 0 slot )
+                    list( REMOVE_AT bucketSlots 0 )
+                    set( slot_${slotCount}_${slot} ${i} )
+                endforeach()
+            endif()
+        endforeach()
+
+        math( EXPR size "${size} - 1" )
+    endwhile()
+
+    if( NOT hashFound )
+        math( EXPR slotCount "${slotCount} * 2" )
+
+        if( slotCount GREATER 32768 )
+            message( FATAL_ERROR "${dsnErrorMsg} no perfect hash found for file <${inputFile}>." )
+        endif()
+    endif()
+endwhile()
+
+# empty buckets have no displacement
+set( displacements "" )
+set( count 0 )
+
+foreach( b RANGE ${lastBucket} )
+    if( NOT DEFINED d0_${b} )
+        set( d0_${b} 0 )
+        set( d1_${b} 0 )
+    endif()
+
+    if( count EQUAL 0 )
+        set( displacements "${displacements}\n   " )
+    endif()
+
+    set( displacements "${displacements} ${d0_${b}}, ${d1_${b}}," )
+    math( EXPR count "( ${count} + 1 ) % 8" )
+endforeach()
+
+set( slots "" )
+set( count 0 )
+math( EXPR lastSlot "${slotCount} - 1" )
+
+foreach( s RANGE ${lastSlot} )
+    if( NOT DEFINED slot_${slotCount}_${s} )
+        set( slot_${slotCount}_${s} -1 )
+    endif()
+
+    if( count EQUAL 0 )
+        set( slots "${slots}\n   " )
+    endif()
+
+    set( slots "${slots} ${slot_${slotCount}_${s}}," )
+    math( EXPR count "( ${count} + 1 ) % 16" )
+endforeach()
+
 file( WRITE "${outHeaderFile}" "${includeFileHeader}" )
 file( WRITE "${outCppFile}" "${sourceFileHeader}" )
 
@@ -240,6 +433,9 @@ class ${LEXERCLASS} : public DSNLEXER
     static const KEYWORD  keywords[];
     static const unsigned keyword_count;
 
+    /// Auto generated perfect hash of the keywords table:
+    static const KEYWORD_HASH keywords_hash;
+
 public:
     /**
      * Constructor ( const std::string&, const wxString& )
@@ -248,7 +444,7 @@ public:
      *   If left empty, then _(\"clipboard\") is used.
      */
     ${LEXERCLASS}( const std::string& aSExpression, const wxString& aSource = wxEmptyString ) :
-        DSNLEXER( keywords, keyword_count, aSExpression, aSource )
+        DSNLEXER( keywords, keyword_count, aSExpression, aSource, &keywords_hash )
     {
     }
 
@@ -262,7 +458,7 @@ public:
      * @param aFilename is the name of the opened file, needed for error reporting.
      */
     ${LEXERCLASS}( FILE* aFile, const wxString& aFilename ) :
-        DSNLEXER( keywords, keyword_count, aFile, aFilename )
+        DSNLEXER( keywords, keyword_count, aFile, aFilename, &keywords_hash )
     {
     }
 
@@ -278,7 +474,7 @@ public:
      *  STRING_LINE_READER or FILE_LINE_READER.  No ownership is taken of aLineReader.
      */
     ${LEXERCLASS}( LINE_READER* aLineReader ) :
-        DSNLEXER( keywords, keyword_count, aLineReader )
+        DSNLEXER( keywords, keyword_count, aLineReader, &keywords_hash )
     {
     }
 
@@ -370,6 +566,19 @@ file( APPEND "${outCppFile}"
 const unsigned ${LEXERCLASS}::keyword_count = unsigned( sizeof( ${LEXERCLASS}::keywords )/sizeof( ${LEXERCLASS}::keywords[0] ) );
 
 
+// perfect hash of keywords[], d0 and d1 of each bucket, then the keyword of each slot
+static const unsigned short keyword_displacements[] = {${displacements}
+};
+
+static const short keyword_slots[] = {${slots}
+};
+
+const KEYWORD_HASH ${LEXERCLASS}::keywords_hash = {
+    keyword_displacements, ${bucketCount},
+    keyword_slots, ${slotCount}
+};
+
+
 const char* ${LEXERCLASS}::TokenName( T aTok )
 {
     const char* ret;
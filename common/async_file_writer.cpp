@@ -0,0 +1,155 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file async_file_writer.cpp
+ */
+
+#include <fctsys.h>
+#include <wx/filefn.h>
+#include <boost/thread.hpp>
+
+#include <async_file_writer.h>
+
+
+/// Suffix of the temporary file written before it is renamed
+static const wxChar tempSuffix[] = wxT( "-tmp" );
+
+
+ASYNC_FILE_WRITER::ASYNC_FILE_WRITER() :
+    m_thread( NULL ),
+    m_done( true ),
+    m_ok( true )
+{
+}
+
+
+ASYNC_FILE_WRITER::~ASYNC_FILE_WRITER()
+{
+    Wait();
+}
+
+
+void ASYNC_FILE_WRITER::Write( const wxString& aFileName, std::string& aText )
+{
+    Wait();
+
+    // A copy which does not share its buffer with the caller's string
+    m_fileName = wxString( aFileName.wc_str() );
+    m_text.clear();
+    m_text.swap( aText );
+    m_done = false;
+
+    m_thread = new boost::thread( &ASYNC_FILE_WRITER::run, this );
+}
+
+
+bool ASYNC_FILE_WRITER::IsBusy()
+{
+    MUTLOCK lock( m_lock );
+
+    return !m_done;
+}
+
+
+bool ASYNC_FILE_WRITER::Wait( wxString* aError )
+{
+    if( m_thread )
+    {
+        m_thread->join();
+        delete m_thread;
+        m_thread = NULL;
+
+        // the memory is not needed any more
+        std::string().swap( m_text );
+    }
+
+    if( !m_ok && aError )
+        *aError = m_error;
+
+    return m_ok;
+}
+
+
+void ASYNC_FILE_WRITER::run()
+{
+    bool        ok = true;
+    wxString    error;
+
+    try
+    {
+        WriteFile( m_fileName, m_text );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        ok    = false;
+        error = ioe.errorText;
+    }
+
+    MUTLOCK lock( m_lock );
+
+    m_ok    = ok;
+    m_error = error;
+    m_done  = true;
+}
+
+
+void ASYNC_FILE_WRITER::WriteFile( const wxString& aFileName, const std::string& aText,
+                                   bool aUseTempFile )
+    throw( IO_ERROR )
+{
+    wxString    tempFileName = aUseTempFile ? aFileName + tempSuffix : aFileName;
+    FILE*       fp = wxFopen( tempFileName, wxT( "wt" ) );
+
+    if( !fp )
+    {
+        wxString msg = wxString::Format( _( "cannot open or save file '%s'" ),
+                                         GetChars( tempFileName ) );
+        THROW_IO_ERROR( msg );
+    }
+
+    // fclose() flushes the buffer, so it can fail too, e.g. on a full disk.
+    bool written = aText.empty() || fwrite( aText.data(), aText.size(), 1, fp ) == 1;
+
+    if( fclose( fp ) != 0 )
+        written = false;
+
+    if( !written )
+    {
+        if( aUseTempFile )
+            wxRemoveFile( tempFileName );
+
+        wxString msg = wxString::Format( _( "error writing to file '%s'" ),
+                                         GetChars( tempFileName ) );
+        THROW_IO_ERROR( msg );
+    }
+
+    if( aUseTempFile && !wxRenameFile( tempFileName, aFileName, true ) )
+    {
+        wxRemoveFile( tempFileName );
+
+        wxString msg = wxString::Format( _( "cannot rename file '%s' to '%s'" ),
+                                         GetChars( tempFileName ), GetChars( aFileName ) );
+        THROW_IO_ERROR( msg );
+    }
+}
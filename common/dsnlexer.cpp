@@ -52,6 +52,10 @@ void DSNLEXER::init()
     commentsAreTokens = false;
 
 #if 1
+    // the perfect hash is used instead of the hashtable, which is not needed then
+    if( keywordPerfectHash )
+        return;
+
     if( keywordCount > 11 )
     {
         // resize the hashtable bucket count
@@ -71,10 +75,12 @@ void DSNLEXER::init()
 
 
 DSNLEXER::DSNLEXER( const KEYWORD* aKeywordTable, unsigned aKeywordCount,
-                    FILE* aFile, const wxString& aFilename ) :
+                    FILE* aFile, const wxString& aFilename,
+                    const KEYWORD_HASH* aKeywordHash ) :
     iOwnReaders( true ),
     keywords( aKeywordTable ),
-    keywordCount( aKeywordCount )
+    keywordCount( aKeywordCount ),
+    keywordPerfectHash( aKeywordHash )
 {
     FILE_LINE_READER* fileReader = new FILE_LINE_READER( aFile, aFilename );
     PushReader( fileReader );
@@ -83,10 +89,12 @@ DSNLEXER::DSNLEXER( const KEYWORD* aKeywordTable, unsigned aKeywordCount,
 
 
 DSNLEXER::DSNLEXER( const KEYWORD* aKeywordTable, unsigned aKeywordCount,
-                    const std::string& aClipboardTxt, const wxString& aSource ) :
+                    const std::string& aClipboardTxt, const wxString& aSource,
+                    const KEYWORD_HASH* aKeywordHash ) :
     iOwnReaders( true ),
     keywords( aKeywordTable ),
-    keywordCount( aKeywordCount )
+    keywordCount( aKeywordCount ),
+    keywordPerfectHash( aKeywordHash )
 {
     STRING_LINE_READER* stringReader = new STRING_LINE_READER( aClipboardTxt, aSource.IsEmpty() ?
                                         wxString( _( "clipboard" ) ) : aSource );
@@ -96,10 +104,11 @@ DSNLEXER::DSNLEXER( const KEYWORD* aKeywordTable, unsigned aKeywordCount,
 
 
 DSNLEXER::DSNLEXER( const KEYWORD* aKeywordTable, unsigned aKeywordCount,
-                    LINE_READER* aLineReader ) :
+                    LINE_READER* aLineReader, const KEYWORD_HASH* aKeywordHash ) :
     iOwnReaders( false ),
     keywords( aKeywordTable ),
-    keywordCount( aKeywordCount )
+    keywordCount( aKeywordCount ),
+    keywordPerfectHash( aKeywordHash )
 {
     if( aLineReader )
         PushReader( aLineReader );
@@ -201,8 +210,49 @@ int DSNLEXER::findToken( const std::string& tok )
 
 #else
 
-inline int DSNLEXER::findToken( const std::string& tok )
+int DSNLEXER::findToken( const std::string& tok )
 {
+    if( keywordPerfectHash )
+    {
+        // Same hashes as in TokenList2DsnLexer.cmake, see struct KEYWORD_HASH
+        const KEYWORD_HASH& ph = *keywordPerfectHash;
+        unsigned    h = 0;
+
+        for( std::string::const_iterator it = tok.begin();  it != tok.end();  ++it )
+            h = ( h * 31 + (unsigned char) *it ) & 0x7FFFFF;
+
+        h ^= h >> 12;
+
+        unsigned    h0 = ( h * 29 ) & 0x7FFFFF;
+        unsigned    h2 = ( h * 37 ) & 0x7FFFFF;
+
+        h0 ^= h0 >> 12;
+        h2 ^= h2 >> 12;
+
+        // both counts are powers of 2
+        const unsigned short* d = ph.displacements + 2 * ( h0 & ( ph.bucketCount - 1 ) );
+        unsigned    mask = ph.slotCount - 1;
+        int         ndx  = ph.slots[ ( ( h & mask ) + d[0] * ( h2 & mask ) + d[1] ) & mask ];
+
+        if( ndx >= 0 )
+        {
+            // the only keyword which can match
+            const char* name = keywords[ndx].name;
+            const char* cp   = tok.c_str();
+
+            while( *name && *name == *cp )
+            {
+                ++name;
+                ++cp;
+            }
+
+            if( *name == *cp )
+                return keywords[ndx].token;
+        }
+
+        return DSN_SYMBOL;      // not a keyword, some arbitrary symbol.
+    }
+
     KEYWORD_MAP::const_iterator it = keyword_hash.find( tok.c_str() );
     if( it != keyword_hash.end() )
         return it->second;
@@ -644,7 +694,15 @@ L_read:
                 }
 
                 else
-                    curText += *head++;
+                {
+                    // copy the run of plain characters up to the next escape or quote
+                    const char* run = head;
+
+                    while( head<limit && *head != '\\' && *head != '"' )
+                        ++head;
+
+                    curText.append( run, head );
+                }
 
             }   // while
 
@@ -723,12 +781,12 @@ L_read:
         }
     }           // specctraMode
 
-    // non-quoted token, read it into curText.
-    curText.clear();
-
+    // non-quoted token, find its end then copy it into curText in one go.
     head = cur;
     while( head<limit && !isSep( *head ) )
-        curText += *head++;
+        ++head;
+
+    curText.assign( cur, head );
 
     if( isNumber( curText.c_str(), curText.c_str() + curText.size() ) )
     {
@@ -776,3 +834,90 @@ wxArrayString* DSNLEXER::ReadCommentLines() throw( IO_ERROR )
 
     return ret;
 }
+
+
+int DSNLEXER::ReadListText( std::string& aText ) throw( IO_ERROR )
+{
+    wxASSERT( !specctraMode );
+
+    int         lineNumber = CurLineNumber();
+    int         depth = 1;
+    const char* cur   = start + curOffset;
+    const char* mark  = cur;        // beginning of the text not yet appended
+
+    aText.append( curOffset, ' ' );
+
+    for(;;)
+    {
+        while( cur < limit )
+        {
+            if( isSpace( *cur ) )
+                ++cur;
+
+            else if( *cur == '(' )
+            {
+                ++depth;
+                ++cur;
+            }
+
+            else if( *cur == ')' )
+            {
+                if( --depth == 0 )
+                {
+                    aText.append( mark, cur + 1 );
+                    aText += '\n';
+
+                    prevTok   = curTok;
+                    curTok    = DSN_RIGHT;
+                    curText   = ')';
+                    curOffset = cur - start;
+                    next      = cur + 1;
+
+                    return lineNumber;
+                }
+
+                ++cur;
+            }
+
+            // a quoted string, which ends on its line like in NextTok().
+            else if( *cur == stringDelimiter )
+            {
+                for( ++cur;  cur < limit && *cur != stringDelimiter;  ++cur )
+                {
+                    if( *cur == '\\' && cur + 1 < limit )
+                        ++cur;      // skip the escaped character, it may be a quote
+                }
+
+                if( cur < limit )
+                    ++cur;
+            }
+
+            else
+            {
+                while( cur < limit && !isSep( *cur ) )
+                    ++cur;
+            }
+        }
+
+        aText.append( mark, limit );
+
+        if( readLine() == 0 )
+            break;
+
+        cur  = start;
+        mark = start;
+
+        while( cur < limit && isSpace( *cur ) )
+            ++cur;
+
+        // A comment line, which is kept in the text since the
+        // DSNLEXER which tokenizes it will skip it too.
+        if( cur < limit && *cur == '#' )
+            cur = limit;
+    }
+
+    curTok = DSN_EOF;
+
+    wxString errtxt( _( "Un-terminated list" ) );
+    THROW_PARSE_ERROR( errtxt, CurSource(), CurLine(), CurLineNumber(), CurOffset() );
+}
@@ -0,0 +1,209 @@
+/**
+ * @file dsnlexer_benchmark.cpp
+ * @brief measures the time taken by DSNLEXER to resolve the keywords of boards.
+ */
+
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/*
+    Usage: dsnlexer_benchmark [--repeat=<n>] <board file> ...
+
+        --repeat=<n>    count of lookups of each token, 10 by default
+
+    Each *.kicad_pcb board is read with PCB_LEXER, and the text of its keywords and
+    symbols is kept.  They are then all resolved, <n> times, first with the perfect
+    hash generated by TokenList2DsnLexer.cmake, then with the KEYWORD_MAP hashtable.
+    The mean time of one lookup is printed in nanoseconds for both.
+
+    e.g. dsnlexer_benchmark ../demos/video/video.kicad_pcb ../demos/interf_u/interf_u.kicad_pcb
+*/
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <richio.h>
+#include <common.h>
+#include <pcb_lexer.h>
+
+
+/**
+ * Class KEYWORD_BENCHMARK
+ * is a PCB_LEXER which can resolve a token with or without its perfect hash.
+ */
+class KEYWORD_BENCHMARK : public PCB_LEXER
+{
+public:
+    KEYWORD_BENCHMARK( LINE_READER* aLineReader ) :
+        PCB_LEXER( aLineReader )
+    {
+        // DSNLEXER does not fill the hashtable when there is a perfect hash
+        for( unsigned ii = 0; ii < keywordCount; ++ii )
+            keyword_hash[ DSNLEXER::keywords[ii].name ] = DSNLEXER::keywords[ii].token;
+    }
+
+    int FindToken( const std::string& aToken, bool aPerfectHash )
+    {
+        const KEYWORD_HASH* perfectHash = keywordPerfectHash;
+
+        if( !aPerfectHash )
+            keywordPerfectHash = NULL;
+
+        int tok = findToken( aToken );
+
+        keywordPerfectHash = perfectHash;
+
+        return tok;
+    }
+};
+
+
+static void usage()
+{
+    fprintf( stderr, "usage: dsnlexer_benchmark [--repeat=<n>] <board file> ...\n" );
+}
+
+
+/**
+ * Function lookupTime
+ * resolves all @a aTokens @a aRepeat times.
+ * @return the mean time of one lookup, in nanoseconds.
+ */
+static double lookupTime( KEYWORD_BENCHMARK& aLexer, const std::vector<std::string>& aTokens,
+                          int aRepeat, bool aPerfectHash, int* aChecksum )
+{
+    int      checksum = 0;
+    unsigned start = GetRunningMicroSecs();
+
+    for( int rr = 0; rr < aRepeat; ++rr )
+    {
+        for( unsigned ii = 0; ii < aTokens.size(); ++ii )
+            checksum += aLexer.FindToken( aTokens[ii], aPerfectHash );
+    }
+
+    unsigned elapsed = GetRunningMicroSecs() - start;
+
+    *aChecksum = checksum;
+
+    return aTokens.empty() ? 0.0 : 1000.0 * elapsed / ( (double) aTokens.size() * aRepeat );
+}
+
+
+/**
+ * Function benchmarkBoard
+ * reads the tokens of a board and prints the keyword lookup timings.
+ * @return false if the board cannot be read, or if both lookups disagree.
+ */
+static bool benchmarkBoard( const char* aFileName, int aRepeat )
+{
+    std::vector<std::string> tokens;
+
+    try
+    {
+        MMAP_LINE_READER    reader( FROM_UTF8( aFileName ) );
+        KEYWORD_BENCHMARK   lexer( &reader );
+        int                 tok;
+
+        while( ( tok = lexer.NextTok() ) != DSN_EOF )
+        {
+            if( tok >= 0 || tok == DSN_SYMBOL )
+                tokens.push_back( lexer.CurStr() );
+        }
+
+        for( unsigned ii = 0; ii < tokens.size(); ++ii )
+        {
+            if( lexer.FindToken( tokens[ii], true ) != lexer.FindToken( tokens[ii], false ) )
+            {
+                fprintf( stderr, "dsnlexer_benchmark: lookups of '%s' disagree\n",
+                         tokens[ii].c_str() );
+                return false;
+            }
+        }
+
+        int     perfectSum;
+        int     hashtableSum;
+        double  perfect   = lookupTime( lexer, tokens, aRepeat, true, &perfectSum );
+        double  hashtable = lookupTime( lexer, tokens, aRepeat, false, &hashtableSum );
+
+        // the sums also keep the compiler from dropping the lookups
+        if( perfectSum != hashtableSum )
+            return false;
+
+        printf( "%s: %u tokens, perfect hash %.1f ns, hashtable %.1f ns\n",
+                aFileName, (unsigned) tokens.size(), perfect, hashtable );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        fprintf( stderr, "dsnlexer_benchmark: %s\n", TO_UTF8( ioe.errorText ) );
+        return false;
+    }
+
+    return true;
+}
+
+
+int main( int argc, char** argv )
+{
+    int repeat = 10;
+    int errors = 0;
+    int boards = 0;
+
+    for( int ii = 1; ii < argc; ++ii )
+    {
+        if( !strncmp( argv[ii], "--repeat=", 9 ) )
+        {
+            repeat = atoi( argv[ii] + 9 );
+
+            if( repeat <= 0 )
+            {
+                usage();
+                return 1;
+            }
+
+            continue;
+        }
+
+        if( argv[ii][0] == '-' )
+        {
+            usage();
+            return 1;
+        }
+
+        ++boards;
+
+        if( !benchmarkBoard( argv[ii], repeat ) )
+            ++errors;
+    }
+
+    if( !boards )
+    {
+        usage();
+        return 1;
+    }
+
+    return errors ? 1 : 0;
+}
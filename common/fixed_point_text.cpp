@@ -0,0 +1,129 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file fixed_point_text.cpp
+ * @brief Conversions between the decimal text of the files and fixed point integers.
+ */
+
+#include <limits.h>
+#include <stdint.h>
+
+#include <fixed_point_text.h>
+
+
+int FormatFixedPoint( char* aBuffer, int aValue, int aDecimals )
+{
+    char        digits[FIXED_POINT_TEXT_MAX];   // least significant first
+    int         count = 0;
+    char*       cp = aBuffer;
+
+    // -INT_MIN does not fit in an int
+    unsigned    magnitude = aValue < 0 ? 0u - (unsigned) aValue : (unsigned) aValue;
+
+    do
+    {
+        digits[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while( magnitude );
+
+    // at least one digit before the decimal point
+    while( count <= aDecimals )
+        digits[count++] = '0';
+
+    if( aValue < 0 )
+        *cp++ = '-';
+
+    for( int ii = count - 1;  ii >= aDecimals;  --ii )
+        *cp++ = digits[ii];
+
+    int last = 0;       // the last decimal which is not a trailing zero
+
+    while( last < aDecimals && digits[last] == '0' )
+        ++last;
+
+    if( last < aDecimals )
+    {
+        *cp++ = '.';
+
+        for( int ii = aDecimals - 1;  ii >= last;  --ii )
+            *cp++ = digits[ii];
+    }
+
+    *cp = '\0';
+
+    return cp - aBuffer;
+}
+
+
+bool ParseFixedPoint( const char* aText, int aDecimals, int* aValue )
+{
+    const char* cp = aText;
+    bool        negative = false;
+    uint64_t    value = 0;          // 10 digits and 9 decimals do not overflow
+    int         digits = 0;
+    int         decimals = 0;
+
+    if( *cp == '-' || *cp == '+' )
+        negative = *cp++ == '-';
+
+    for( ; *cp >= '0' && *cp <= '9';  ++cp )
+    {
+        if( ++digits > 10 )
+            return false;
+
+        value = value * 10 + ( *cp - '0' );
+    }
+
+    if( *cp == '.' )
+    {
+        for( ++cp;  *cp >= '0' && *cp <= '9';  ++cp )
+        {
+            if( decimals < aDecimals )
+            {
+                value = value * 10 + ( *cp - '0' );
+                ++decimals;
+            }
+            else if( *cp != '0' )
+            {
+                return false;   // the value must be rounded
+            }
+
+            ++digits;
+        }
+    }
+
+    // no digit at all, or an exponent or anything else after the number
+    if( !digits || *cp )
+        return false;
+
+    for( ; decimals < aDecimals;  ++decimals )
+        value *= 10;
+
+    if( value > ( negative ? (uint64_t) INT_MAX + 1 : (uint64_t) INT_MAX ) )
+        return false;
+
+    *aValue = negative ? (int) ( 0u - (unsigned) value ) : (int) value;
+
+    return true;
+}
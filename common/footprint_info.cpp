@@ -45,7 +45,18 @@
 #include <fp_lib_table.h>
 #include <fpid.h>
 #include <class_module.h>
+#include <async_file_writer.h>
+#include <task_pool.h>
 #include <boost/thread.hpp>
+#include <boost/bind.hpp>
+#include <algorithm>
+#include <set>
+#include <stdint.h>
+
+#include <wx/dir.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/stdpaths.h>
 
 
 /*
@@ -110,46 +121,55 @@ void FOOTPRINT_INFO::load()
 }
 
 
-#define JOBZ                6       // no. libraries per worker thread.  It takes about
-                                    // a second to load a GITHUB library, so assigning
-                                    // this no. libraries to each thread should give a little
-                                    // over this no. seconds total time if the original delay
-                                    // were caused by latencies alone.
+#define LOADER_THREADS_MIN  4u      // min no. loader threads.  It takes about a second
+                                    // to load a GITHUB library, mostly latencies, so more
+                                    // threads than processors are useful then.
                                     // (If https://github.com does not mind.)
 
 #define NTOLERABLE_ERRORS   4       // max errors before aborting, although threads
                                     // in progress will still pile on for a bit.  e.g. if 9 threads
                                     // expect 9 greater than this.
 
-void FOOTPRINT_LIST::loader_job( const wxString* aNicknameList, int aJobZ )
+void FOOTPRINT_LIST::loader_job( LIBRARY_JOB* aJob, bool aLoad )
 {
-    //DBG(printf( "%s: first:'%s' count:%d\n", __func__, (char*) TO_UTF8( *aNicknameList ), aJobZ );)
+    //DBG(printf( "%s: '%s' load:%d\n", __func__, (char*) TO_UTF8( aJob->nickname ), aLoad );)
 
-    for( int i=0; i<aJobZ; ++i )
-    {
-        if( m_error_count >= NTOLERABLE_ERRORS )
-            break;
+    if( m_error_count >= NTOLERABLE_ERRORS )
+        return;
 
-        const wxString& nickname = aNicknameList[i];
+    try
+    {
+        if( aLoad )
+            loadLibrary( aJob );
+        else
+            findCachedLibrary( aJob );
+    }
+    catch( const PARSE_ERROR& pe )
+    {
+        // m_errors.push_back is not thread safe, lock its MUTEX.
+        MUTLOCK lock( m_errors_lock );
 
-        try
-        {
-            wxArrayString fpnames = m_lib_table->FootprintEnumerate( nickname );
+        ++m_error_count;        // modify only under lock
+        m_errors.push_back( new IO_ERROR( pe ) );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        MUTLOCK lock( m_errors_lock );
 
-            for( unsigned ni=0;  ni<fpnames.GetCount();  ++ni )
-            {
-                FOOTPRINT_INFO* fpinfo = new FOOTPRINT_INFO( this, nickname, fpnames[ni] );
+        ++m_error_count;
+        m_errors.push_back( new IO_ERROR( ioe ) );
+    }
 
-                addItem( fpinfo );
-            }
-        }
-        catch( const PARSE_ERROR& pe )
+    // Catch anything unexpected and map it into the expected.
+    // Likely even more important since this function runs on GUI-less
+    // worker threads.
+    catch( const std::exception& se )
+    {
+        // This is a round about way to do this, but who knows what THROW_IO_ERROR()
+        // may be tricked out to do someday, keep it in the game.
+        try
         {
-            // m_errors.push_back is not thread safe, lock its MUTEX.
-            MUTLOCK lock( m_errors_lock );
-
-            ++m_error_count;        // modify only under lock
-            m_errors.push_back( new IO_ERROR( pe ) );
+            THROW_IO_ERROR( se.what() );
         }
         catch( const IO_ERROR& ioe )
         {
@@ -158,27 +178,13 @@ void FOOTPRINT_LIST::loader_job( const wxString* aNicknameList, int aJobZ )
             ++m_error_count;
             m_errors.push_back( new IO_ERROR( ioe ) );
         }
+    }
+}
 
-        // Catch anything unexpected and map it into the expected.
-        // Likely even more important since this function runs on GUI-less
-        // worker threads.
-        catch( const std::exception& se )
-        {
-            // This is a round about way to do this, but who knows what THROW_IO_ERROR()
-            // may be tricked out to do someday, keep it in the game.
-            try
-            {
-                THROW_IO_ERROR( se.what() );
-            }
-            catch( const IO_ERROR& ioe )
-            {
-                MUTLOCK lock( m_errors_lock );
 
-                ++m_error_count;
-                m_errors.push_back( new IO_ERROR( ioe ) );
-            }
-        }
-    }
+bool FOOTPRINT_LIST::largerLibrary( const LIBRARY_JOB* aFirst, const LIBRARY_JOB* aSecond )
+{
+    return aFirst->size > aSecond->size;
 }
 
 
@@ -193,83 +199,389 @@ bool FOOTPRINT_LIST::ReadFootprintFiles( FP_LIB_TABLE* aTable, const wxString* a
     m_errors.clear();
     m_list.clear();
 
+    readCache();
+
+    std::vector< wxString > nicknames;
+
     if( aNickname )
         // single footprint
-        loader_job( aNickname, 1 );
+        nicknames.push_back( *aNickname );
     else
-    {
-        std::vector< wxString > nicknames;
-
         // do all of them
         nicknames = aTable->GetLogicalLibs();
 
+    std::vector< LIBRARY_JOB > jobs( nicknames.size() );
+
+    for( unsigned i=0;  i<nicknames.size();  ++i )
+    {
+        jobs[i].nickname = nicknames[i];
+        jobs[i].size     = 0;
+        jobs[i].done     = false;
+    }
+
 #if USE_WORKER_THREADS
 
-        // Even though the PLUGIN API implementation is the place for the
-        // locale toggling, in order to keep LOCAL_IO::C_count at 1 or greater
-        // for the duration of all helper threads, we increment by one here via instantiation.
-        // Only done here because of the multi-threaded nature of this code.
-        // Without this C_count skips in and out of "equal to zero" and causes
-        // needless locale toggling among the threads, based on which of them
-        // are in a PLUGIN::FootprintLoad() function.  And that is occasionally
-        // none of them.
-        LOCALE_IO   top_most_nesting;
+    // Even though the PLUGIN API implementation is the place for the
+    // locale toggling, in order to keep LOCAL_IO::C_count at 1 or greater
+    // for the duration of all helper threads, we increment by one here via instantiation.
+    // Only done here because of the multi-threaded nature of this code.
+    // Without this C_count skips in and out of "equal to zero" and causes
+    // needless locale toggling among the threads, based on which of them
+    // are in a PLUGIN::FootprintLoad() function.  And that is occasionally
+    // none of them.
+    LOCALE_IO   top_most_nesting;
+
+    TASK_POOL   pool( std::max( LOADER_THREADS_MIN, boost::thread::hardware_concurrency() ) );
+#else
+    TASK_POOL   pool( 1 );
+#endif
+
+    // First the libraries which are up to date in the cache, which also gives
+    // the timestamps and the sizes of the others.
+    for( unsigned i=0;  i<jobs.size();  ++i )
+        pool.Add( boost::bind( &FOOTPRINT_LIST::loader_job, this, &jobs[i], false ) );
+
+    pool.Run();
 
-        // Something which will not invoke a thread copy constructor, one of many ways obviously:
-        typedef boost::ptr_vector< boost::thread >  MYTHREADS;
+    // Then the others, each library is one task since its PLUGIN is not thread safe.
+    // The largest ones go first, so no thread is left with a large one at the end
+    // while the others are idle, they steal the small ones instead.
+    std::vector< LIBRARY_JOB* > toLoad;
+
+    for( unsigned i=0;  i<jobs.size();  ++i )
+    {
+        if( !jobs[i].done )
+            toLoad.push_back( &jobs[i] );
+    }
 
-        MYTHREADS threads;
+    std::stable_sort( toLoad.begin(), toLoad.end(), largerLibrary );
 
-        // Give each thread JOBZ nicknames to process.  The last portion of, or if the entire
-        // size() is small, I'll do myself.
-        for( unsigned i=0; i<nicknames.size();  )
+    for( unsigned i=0;  i<toLoad.size();  ++i )
+        pool.Add( boost::bind( &FOOTPRINT_LIST::loader_job, this, toLoad[i], true ) );
+
+    pool.Run();
+
+    // the remaining nicknames have been skipped after too many errors.
+    if( m_error_count >= NTOLERABLE_ERRORS )
+        retv = false;
+
+    if( !aNickname )
+    {
+        m_list.sort();
+
+        // Forget the libraries which are not in the table any more.
+        std::set< wxString > known( nicknames.begin(), nicknames.end() );
+
+        for( CACHE::iterator it = m_cache.begin();  it != m_cache.end();  )
         {
-            if( m_error_count >= NTOLERABLE_ERRORS )
+            if( known.count( it->first ) )
+            {
+                ++it;
+            }
+            else
             {
-                // abort the remaining nicknames.
-                retv = false;
-                break;
+                m_cache.erase( it++ );
+                m_cache_modified = true;
             }
+        }
+    }
 
-            int jobz = JOBZ;
+    writeCache();
 
-            if( i + jobz >= nicknames.size() )
-            {
-                jobz = nicknames.size() - i;
+    // The result of this function can be a blend of successes and failures, whose
+    // mix is given by the Count()s of the two lists.  The return value indicates whether
+    // an abort occurred, even true does not necessarily mean full success, although
+    // false definitely means failure.
 
-                // Only a little bit to do, I'll do it myself, on current thread.
-                loader_job( &nicknames[i], jobz );
-            }
-            else
+    return retv;
+}
+
+
+/**
+ * Function libraryTimestamp
+ * returns a text which changes whenever a file of the local library @a aPath is
+ * added, removed or modified, from the names, sizes and modification times of its
+ * files.  This is much faster than loading the library.
+ *
+ * @param aPath is a library directory, e.g. *.pretty, or a library file, e.g. *.mod.
+ * @param aSize receives the total size of the files of the library.
+ * @return wxString - the timestamp, or empty if @a aPath is not a local file or
+ *  directory, e.g. an URL, in which case the library cannot be cached.
+ */
+static wxString libraryTimestamp( const wxString& aPath, uint64_t* aSize )
+{
+    wxStructStat    st;
+
+    *aSize = 0;
+
+    if( wxStat( aPath, &st ) != 0 )
+        return wxEmptyString;
+
+    if( !wxDirExists( aPath ) )
+        *aSize = st.st_size;
+
+    // Mix each file's name, size and time into a 64 bit value, which are summed
+    // so the order of the files in the directory does not matter.
+    uint64_t    sum = uint64_t( st.st_mtime ) * 0x9E3779B97F4A7C15ULL + uint64_t( st.st_size );
+    unsigned    count = 0;
+
+    if( wxDirExists( aPath ) )
+    {
+        wxDir       dir( aPath );
+        wxString    name;
+
+        for( bool cont = dir.IsOpened() && dir.GetFirst( &name, wxEmptyString, wxDIR_FILES );
+             cont;  cont = dir.GetNext( &name ) )
+        {
+            if( wxStat( aPath + wxFileName::GetPathSeparator() + name, &st ) != 0 )
+                continue;
+
+            std::string utf8 = TO_UTF8( name );
+            uint64_t    h = 14695981039346656037ULL;    // FNV-1a of the name
+
+            for( unsigned ii = 0;  ii < utf8.size();  ++ii )
+                h = ( h ^ (unsigned char) utf8[ii] ) * 1099511628211ULL;
+
+            h ^= uint64_t( st.st_mtime ) * 0x9E3779B97F4A7C15ULL;
+            h ^= uint64_t( st.st_size ) * 0xC2B2AE3D27D4EB4FULL;
+            h ^= h >> 29;
+
+            sum += h;
+            ++count;
+
+            *aSize += st.st_size;
+        }
+    }
+
+    return wxString::Format( wxT( "%u-%08x%08x" ), count,
+                             unsigned( sum >> 32 ), unsigned( sum & 0xFFFFFFFF ) );
+}
+
+
+void FOOTPRINT_LIST::findCachedLibrary( LIBRARY_JOB* aJob ) throw( IO_ERROR )
+{
+    // A library which is not even in the table is not loaded afterwards.
+    aJob->done = true;
+
+    const FP_LIB_TABLE::ROW* row = m_lib_table->FindRow( aJob->nickname );
+
+    wxString    fullURI = row->GetFullURI( true );
+
+    aJob->uri       = row->GetType() + wxT( ' ' ) + row->GetOptions() + wxT( ' ' ) + fullURI;
+    aJob->timestamp = libraryTimestamp( fullURI, &aJob->size );
+
+    if( !aJob->timestamp.IsEmpty() )
+    {
+        MUTLOCK lock( m_cache_lock );
+
+        CACHE::const_iterator it = m_cache.find( aJob->nickname );
+
+        if( it != m_cache.end() && it->second.uri == aJob->uri
+          && it->second.timestamp == aJob->timestamp )
+        {
+            const std::vector< CACHED_FOOTPRINT >& fps = it->second.footprints;
+
+            for( unsigned ni=0;  ni<fps.size();  ++ni )
             {
-                // Delegate the job to a worker thread created here.
-                threads.push_back( new boost::thread( &FOOTPRINT_LIST::loader_job,
-                        this, &nicknames[i], jobz ) );
+                addItem( new FOOTPRINT_INFO( this, aJob->nickname, fps[ni].name,
+                                             fps[ni].doc, fps[ni].keywords, fps[ni].padCount ) );
             }
 
-            i += jobz;
+            return;
         }
+    }
+
+    aJob->done = false;
+}
+
+
+void FOOTPRINT_LIST::loadLibrary( LIBRARY_JOB* aJob ) throw( IO_ERROR )
+{
+    CACHED_LIBRARY  lib;
+
+    lib.uri       = aJob->uri;
+    lib.timestamp = aJob->timestamp;
+
+    wxArrayString fpnames = m_lib_table->FootprintEnumerate( aJob->nickname );
+
+    for( unsigned ni=0;  ni<fpnames.GetCount();  ++ni )
+    {
+        FOOTPRINT_INFO* fpinfo = new FOOTPRINT_INFO( this, aJob->nickname, fpnames[ni] );
+
+        addItem( fpinfo );
+
+        CACHED_FOOTPRINT fp;
+
+        fp.name     = fpnames[ni];
+        fp.doc      = fpinfo->GetDoc();
+        fp.keywords = fpinfo->GetKeywords();
+        fp.padCount = fpinfo->GetPadCount();
+
+        lib.footprints.push_back( fp );
+    }
+
+    // Only a library which has been completely loaded is cached.
+    if( !lib.timestamp.IsEmpty() )
+    {
+        MUTLOCK lock( m_cache_lock );
+
+        m_cache[aJob->nickname] = lib;
+        m_cache_modified = true;
+    }
+}
+
+
+#define FP_INFO_CACHE_VERSION   1       // bump this when the cache file format changes
+
+static const KEYWORD empty_keywords[1] = {};
+
+
+wxString FOOTPRINT_LIST::GetCacheFileName()
+{
+    // next to the global footprint library table
+    wxFileName fn = FP_LIB_TABLE::GetGlobalTableFileName();
+
+    fn.SetName( wxT( "fp-info-cache" ) );
+
+    return fn.GetFullPath();
+}
+
 
-        // Wait for all the worker threads to complete, it does not matter in what order
-        // we wait for them as long as a full sweep is made.  Think of the great race,
-        // everyone must finish.
-        for( unsigned i=0;  i<threads.size();  ++i )
+void FOOTPRINT_LIST::readCache()
+{
+    m_cache.clear();
+    m_cache_modified = false;
+
+    wxString    fileName = GetCacheFileName();
+    FILE*       fp = wxFileExists( fileName ) ? wxFopen( fileName, wxT( "rt" ) ) : NULL;
+
+    if( !fp )
+        return;
+
+    try
+    {
+        // lexer now owns fp, will close on exception or return
+        DSNLEXER    lexer( empty_keywords, 0, fp, fileName );
+
+        lexer.NeedLEFT();
+        lexer.NeedSYMBOL();
+
+        if( strcmp( lexer.CurText(), "fp_info_cache" ) )
+            lexer.Expecting( "fp_info_cache" );
+
+        lexer.NeedNUMBER( "version" );
+
+        // a cache file written by another version is rebuilt
+        if( atoi( lexer.CurText() ) != FP_INFO_CACHE_VERSION )
+            return;
+
+        // (lib nickname uri timestamp (fp name pad_count doc keywords) ...)
+        while( lexer.NextTok() == DSN_LEFT )
         {
-            threads[i].join();
+            lexer.NeedSYMBOL();
+
+            if( strcmp( lexer.CurText(), "lib" ) )
+                lexer.Expecting( "lib" );
+
+            lexer.NeedSYMBOLorNUMBER();
+            CACHED_LIBRARY& lib = m_cache[ FROM_UTF8( lexer.CurText() ) ];
+
+            lexer.NeedSYMBOLorNUMBER();
+            lib.uri = FROM_UTF8( lexer.CurText() );
+
+            lexer.NeedSYMBOLorNUMBER();
+            lib.timestamp = FROM_UTF8( lexer.CurText() );
+
+            while( lexer.NextTok() == DSN_LEFT )
+            {
+                CACHED_FOOTPRINT fp;
+
+                lexer.NeedSYMBOL();
+
+                if( strcmp( lexer.CurText(), "fp" ) )
+                    lexer.Expecting( "fp" );
+
+                lexer.NeedSYMBOLorNUMBER();
+                fp.name = FROM_UTF8( lexer.CurText() );
+
+                lexer.NeedNUMBER( "pad_count" );
+                fp.padCount = atoi( lexer.CurText() );
+
+                lexer.NeedSYMBOLorNUMBER();
+                fp.doc = FROM_UTF8( lexer.CurText() );
+
+                lexer.NeedSYMBOLorNUMBER();
+                fp.keywords = FROM_UTF8( lexer.CurText() );
+
+                lexer.NeedRIGHT();
+
+                lib.footprints.push_back( fp );
+            }
+
+            if( lexer.CurTok() != DSN_RIGHT )
+                lexer.Expecting( DSN_RIGHT );
         }
-#else
-        loader_job( &nicknames[0], nicknames.size() );
-#endif
 
-        m_list.sort();
+        if( lexer.CurTok() != DSN_RIGHT )
+            lexer.Expecting( DSN_RIGHT );
     }
+    catch( const IO_ERROR& ioe )
+    {
+        // A damaged cache file is not an error, all the libraries are loaded
+        // and the file is written again.
+        DBG(printf( "%s: %s\n", __func__, TO_UTF8( ioe.errorText ) );)
 
-    // The result of this function can be a blend of successes and failures, whose
-    // mix is given by the Count()s of the two lists.  The return value indicates whether
-    // an abort occurred, even true does not necessarily mean full success, although
-    // false definitely means failure.
+        m_cache.clear();
+        m_cache_modified = true;
+    }
+}
 
-    return retv;
+
+void FOOTPRINT_LIST::writeCache()
+{
+    if( !m_cache_modified )
+        return;
+
+    m_cache_modified = false;
+
+    try
+    {
+        STRING_FORMATTER    sf;
+
+        sf.Print( 0, "(fp_info_cache %d\n", FP_INFO_CACHE_VERSION );
+
+        for( CACHE::const_iterator it = m_cache.begin();  it != m_cache.end();  ++it )
+        {
+            const CACHED_LIBRARY& lib = it->second;
+
+            sf.Print( 1, "(lib %s %s %s\n",
+                      sf.Quotew( it->first ).c_str(),
+                      sf.Quotew( lib.uri ).c_str(),
+                      sf.Quotew( lib.timestamp ).c_str() );
+
+            for( unsigned ni=0;  ni<lib.footprints.size();  ++ni )
+            {
+                const CACHED_FOOTPRINT& fp = lib.footprints[ni];
+
+                sf.Print( 2, "(fp %s %d %s %s)\n",
+                          sf.Quotew( fp.name ).c_str(), fp.padCount,
+                          sf.Quotew( fp.doc ).c_str(),
+                          sf.Quotew( fp.keywords ).c_str() );
+            }
+
+            sf.Print( 1, ")\n" );
+        }
+
+        sf.Print( 0, ")\n" );
+
+        // written through a temporary file, so another instance never reads half a cache
+        ASYNC_FILE_WRITER::WriteFile( GetCacheFileName(), sf.GetString() );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        // Not fatal, the libraries will be loaded again next time.
+        DBG(printf( "%s: %s\n", __func__, TO_UTF8( ioe.errorText ) );)
+    }
 }
 
 
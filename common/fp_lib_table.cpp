@@ -846,7 +846,7 @@ bool FP_LIB_TABLE::LoadGlobalTable( FP_LIB_TABLE& aTable ) throw (IO_ERROR, PARS
         }
     }
 
-    FILE_LINE_READER    reader( fn.GetFullPath() );
+    MMAP_LINE_READER    reader( fn.GetFullPath() );
     FP_LIB_TABLE_LEXER  lexer( &reader );
 
     aTable.Parse( &lexer );
@@ -879,7 +879,7 @@ void FP_LIB_TABLE::Load( const wxString& aFileName )
     // Empty footprint library tables are valid.
     if( wxFileName::IsFileReadable( aFileName ) )
     {
-        FILE_LINE_READER    reader( aFileName );
+        MMAP_LINE_READER    reader( aFileName );
         FP_LIB_TABLE_LEXER  lexer( &reader );
 
         Parse( &lexer );
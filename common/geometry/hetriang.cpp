@@ -55,6 +55,18 @@ using namespace std;
 
 #ifdef TTL_USE_NODE_ID
   int Node::id_count = 0;
+
+  int Node::nextId()
+  {
+      int id;
+
+#ifdef USE_OPENMP
+      #pragma omp critical( ttl_node_id )
+#endif /* USE_OPENMP */
+      id = id_count++;
+
+      return id;
+  }
 #endif
 
 
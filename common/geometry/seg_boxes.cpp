@@ -0,0 +1,188 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+#include <geometry/seg_boxes.h>
+#include <geometry/shape_line_chain.h>
+
+const int SEG_BOXES::BlockSize;
+
+
+static inline int clampCoord( VECTOR2I::extended_type aValue )
+{
+    const VECTOR2I::extended_type lo = std::numeric_limits<int>::min();
+    const VECTOR2I::extended_type hi = std::numeric_limits<int>::max();
+
+    return (int) std::min( std::max( aValue, lo ), hi );
+}
+
+
+SEG_BOXES::SEG_BOXES( const SHAPE_LINE_CHAIN& aChain ) :
+    m_chain( aChain ),
+    m_count( 0 ),
+    m_minX( NULL ),
+    m_minY( NULL ),
+    m_maxX( NULL ),
+    m_maxY( NULL ),
+    m_bbox( VECTOR2I( 0, 0 ), VECTOR2I( 0, 0 ) )
+{
+    int n = aChain.SegmentCount();
+
+    if( n <= 0 )
+        return;
+
+    m_count = n;
+
+    // The arrays are padded up to a whole block with empty boxes, which overlap
+    // nothing, so that overlapping() always compares a whole block.
+    int padded = ( n + BlockSize - 1 ) / BlockSize * BlockSize;
+    int* boxes = m_inline;
+
+    if( padded > BlockSize )
+    {
+        m_heap.resize( 4 * padded );
+        boxes = &m_heap[0];
+    }
+
+    int* minX = boxes;
+    int* minY = boxes + padded;
+    int* maxX = boxes + 2 * padded;
+    int* maxY = boxes + 3 * padded;
+
+    std::fill( minX + n, minX + padded, std::numeric_limits<int>::max() );
+    std::fill( minY + n, minY + padded, std::numeric_limits<int>::max() );
+    std::fill( maxX + n, maxX + padded, std::numeric_limits<int>::min() );
+    std::fill( maxY + n, maxY + padded, std::numeric_limits<int>::min() );
+
+    VECTOR2I bbMin = aChain.CPoint( 0 );
+    VECTOR2I bbMax = bbMin;
+
+    for( int i = 0; i < n; i++ )
+    {
+        const SEG s = aChain.CSegment( i );
+
+        minX[i] = std::min( s.A.x, s.B.x );
+        minY[i] = std::min( s.A.y, s.B.y );
+        maxX[i] = std::max( s.A.x, s.B.x );
+        maxY[i] = std::max( s.A.y, s.B.y );
+
+        bbMin.x = std::min( bbMin.x, minX[i] );
+        bbMin.y = std::min( bbMin.y, minY[i] );
+        bbMax.x = std::max( bbMax.x, maxX[i] );
+        bbMax.y = std::max( bbMax.y, maxY[i] );
+    }
+
+    m_minX = minX;
+    m_minY = minY;
+    m_maxX = maxX;
+    m_maxY = maxY;
+
+    m_bbox = BOX2I( bbMin, bbMax - bbMin );
+}
+
+
+int SEG_BOXES::overlapping( int aFirst, int aMinX, int aMinY, int aMaxX, int aMaxY,
+                            int* aIndices ) const
+{
+    const int count = std::min( BlockSize, Size() - aFirst );
+    const int* minX = &m_minX[aFirst];
+    const int* minY = &m_minY[aFirst];
+    const int* maxX = &m_maxX[aFirst];
+    const int* maxY = &m_maxY[aFirst];
+    unsigned char hit[BlockSize];
+
+    // No branch, no early exit and a constant count here, so that the compiler can
+    // compare several boxes at once.
+    for( int i = 0; i < BlockSize; i++ )
+    {
+        hit[i] = ( minX[i] <= aMaxX ) & ( maxX[i] >= aMinX )
+                 & ( minY[i] <= aMaxY ) & ( maxY[i] >= aMinY );
+    }
+
+    int found = 0;
+
+    for( int i = 0; i < count; i++ )
+    {
+        if( hit[i] )
+            aIndices[found++] = aFirst + i;
+    }
+
+    return found;
+}
+
+
+int SEG_BOXES::collide( const SEG& aSeg, int aClearance, std::vector<int>* aIndices ) const
+{
+    const ecoord dist_sq = (ecoord) aClearance * aClearance;
+    const ecoord inflate = std::abs( (ecoord) aClearance );
+
+    const int sMinX = std::min( aSeg.A.x, aSeg.B.x );
+    const int sMinY = std::min( aSeg.A.y, aSeg.B.y );
+    const int sMaxX = std::max( aSeg.A.x, aSeg.B.x );
+    const int sMaxY = std::max( aSeg.A.y, aSeg.B.y );
+
+    // A box distance below the clearance is below it on both axes, so the boxes
+    // farther than that on one axis are skipped without computing the distance.
+    const int minX = clampCoord( sMinX - inflate );
+    const int minY = clampCoord( sMinY - inflate );
+    const int maxX = clampCoord( sMaxX + inflate );
+    const int maxY = clampCoord( sMaxY + inflate );
+
+    if( Size() == 0 || m_bbox.GetLeft() > maxX || m_bbox.GetRight() < minX
+        || m_bbox.GetTop() > maxY || m_bbox.GetBottom() < minY )
+        return 0;
+
+    int indices[BlockSize];
+    int collisions = 0;
+
+    for( int first = 0; first < Size(); first += BlockSize )
+    {
+        int found = overlapping( first, minX, minY, maxX, maxY, indices );
+
+        for( int k = 0; k < found; k++ )
+        {
+            int i = indices[k];
+
+            // the same test as BOX2I::SquaredDistance() in SHAPE_LINE_CHAIN::Collide()
+            ecoord dx = std::max( std::max( (ecoord) m_minX[i] - sMaxX,
+                                            (ecoord) sMinX - m_maxX[i] ), (ecoord) 0 );
+            ecoord dy = std::max( std::max( (ecoord) m_minY[i] - sMaxY,
+                                            (ecoord) sMinY - m_maxY[i] ), (ecoord) 0 );
+
+            if( dx * dx + dy * dy < dist_sq && m_chain.CSegment( i ).Collide( aSeg, aClearance ) )
+            {
+                collisions++;
+
+                if( !aIndices )
+                    return collisions;
+
+                aIndices->push_back( i );
+            }
+        }
+    }
+
+    return collisions;
+}
@@ -22,15 +22,31 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
  */
 
+#include <algorithm>
+#include <cstdlib>
+
 #include <math/vector2d.h>
 
 #include <geometry/shape.h>
 #include <geometry/shape_line_chain.h>
 #include <geometry/shape_circle.h>
 #include <geometry/shape_rect.h>
+#include <geometry/seg_boxes.h>
 
 typedef VECTOR2I::extended_type ecoord;
 
+/**
+ * Function segBoxOverlaps()
+ * tells if the bounding box of aSeg overlaps the box aMin - aMax. The shapes whose
+ * boxes, inflated by the clearance, do not overlap cannot collide, which spares the
+ * exact test of the far segments.
+ */
+static inline bool segBoxOverlaps( const SEG& aSeg, const VECTOR2I& aMin, const VECTOR2I& aMax )
+{
+    return std::min( aSeg.A.x, aSeg.B.x ) <= aMax.x && std::max( aSeg.A.x, aSeg.B.x ) >= aMin.x
+        && std::min( aSeg.A.y, aSeg.B.y ) <= aMax.y && std::max( aSeg.A.y, aSeg.B.y ) >= aMin.y;
+}
+
 static inline bool Collide( const SHAPE_CIRCLE& aA, const SHAPE_CIRCLE& aB, int aClearance,
                             bool aNeedMTV, VECTOR2I& aMTV )
 {
@@ -119,9 +135,15 @@ static inline  bool Collide( const SHAPE_RECT& aA, const SHAPE_CIRCLE& aB, int a
 static inline bool Collide( const SHAPE_CIRCLE& aA, const SHAPE_LINE_CHAIN& aB, int aClearance,
                             bool aNeedMTV, VECTOR2I& aMTV )
 {
+    const int rc = std::abs( aA.GetRadius() + aClearance );
+    const VECTOR2I pmin = aA.GetCenter() - VECTOR2I( rc, rc );
+    const VECTOR2I pmax = aA.GetCenter() + VECTOR2I( rc, rc );
+
     for( int s = 0; s < aB.SegmentCount(); s++ )
     {
-        if( aA.Collide( aB.CSegment( s ), aClearance ) )
+        const SEG seg = aB.CSegment( s );
+
+        if( segBoxOverlaps( seg, pmin, pmax ) && aA.Collide( seg, aClearance ) )
             return true;
     }
 
@@ -132,8 +154,19 @@ static inline bool Collide( const SHAPE_CIRCLE& aA, const SHAPE_LINE_CHAIN& aB,
 static inline bool Collide( const SHAPE_LINE_CHAIN& aA, const SHAPE_LINE_CHAIN& aB, int aClearance,
                             bool aNeedMTV, VECTOR2I& aMTV )
 {
-    for( int i = 0; i < aB.SegmentCount(); i++ )
-        if( aA.Collide( aB.CSegment( i ), aClearance ) )
+    // The collision of two segments does not depend on their order, so the segments
+    // of the shorter chain are tested against the longer one, whose boxes are packed
+    // once for all of them.
+    const SHAPE_LINE_CHAIN& longer  = aA.SegmentCount() >= aB.SegmentCount() ? aA : aB;
+    const SHAPE_LINE_CHAIN& shorter = aA.SegmentCount() >= aB.SegmentCount() ? aB : aA;
+
+    if( shorter.SegmentCount() <= 1 )
+        return shorter.SegmentCount() == 1 && longer.Collide( shorter.CSegment( 0 ), aClearance );
+
+    SEG_BOXES boxes( longer );
+
+    for( int i = 0; i < shorter.SegmentCount(); i++ )
+        if( boxes.Collide( shorter.CSegment( i ), aClearance ) )
             return true;
 
     return false;
@@ -143,11 +176,15 @@ static inline bool Collide( const SHAPE_LINE_CHAIN& aA, const SHAPE_LINE_CHAIN&
 static inline bool Collide( const SHAPE_RECT& aA, const SHAPE_LINE_CHAIN& aB, int aClearance,
                             bool aNeedMTV, VECTOR2I& aMTV )
 {
+    const int c = std::abs( aClearance );
+    const VECTOR2I pmin = aA.GetPosition() - VECTOR2I( c, c );
+    const VECTOR2I pmax = aA.GetPosition() + aA.GetSize() + VECTOR2I( c, c );
+
     for( int s = 0; s < aB.SegmentCount(); s++ )
     {
         SEG seg = aB.CSegment( s );
 
-        if( aA.Collide( seg, aClearance ) )
+        if( segBoxOverlaps( seg, pmin, pmax ) && aA.Collide( seg, aClearance ) )
             return true;
     }
 
@@ -25,9 +25,15 @@
 
 
 #include <cstdarg>
+#include <algorithm>
 
+#include <config.h>
 #include <richio.h>
 
+#if defined( HAVE_MMAP )
+#include <sys/mman.h>
+#endif
+
 
 // Fall back to getc() when getc_unlocked() is not available on the target platform.
 #if !defined( HAVE_FGETC_NOLOCK )
@@ -259,6 +265,202 @@ char* FILE_LINE_READER::ReadLine() throw( IO_ERROR )
 }
 
 
+MMAP_LINE_READER::MMAP_LINE_READER( const wxString& aFileName,
+            unsigned aStartingLineNumber,
+            unsigned aMaxLineLength ) throw( IO_ERROR ) :
+    LINE_READER( aMaxLineLength ),
+    buffer( 0 ),
+    size( 0 ),
+    ndx( 0 ),
+    mapped( false ),
+    nulAt( 0 ),
+    savedChar( 0 )
+{
+    lineBuffer = line;
+    source     = aFileName;
+
+    load();
+
+    lineNum = aStartingLineNumber;
+}
+
+
+MMAP_LINE_READER::~MMAP_LINE_READER()
+{
+    release();
+
+    // LINE_READER's destructor frees its own buffer, not the mapped bytes.
+    line = lineBuffer;
+}
+
+
+void MMAP_LINE_READER::load() throw( IO_ERROR )
+{
+#if defined( HAVE_MMAP )
+    FILE* fp = wxFopen( source, wxT( "rb" ) );
+#else
+    FILE* fp = wxFopen( source, wxT( "rt" ) );
+#endif
+
+    if( !fp )
+    {
+        wxString msg = wxString::Format(
+            _( "Unable to open filename '%s' for reading" ), source.GetData() );
+        THROW_IO_ERROR( msg );
+    }
+
+    long fileSize = -1;
+
+    if( fseek( fp, 0L, SEEK_END ) == 0 )
+    {
+        fileSize = ftell( fp );
+        rewind( fp );
+    }
+
+    if( fileSize < 0 )
+    {
+        fclose( fp );
+
+        wxString msg = wxString::Format(
+            _( "Unable to read file '%s'" ), source.GetData() );
+        THROW_IO_ERROR( msg );
+    }
+
+#if defined( HAVE_MMAP )
+    // The mapping is private and writable: a nul is written after each line, and
+    // some readers modify the line they get (e.g. with strtok()), which must not
+    // reach the file.  Only the pages actually written to are copied.
+    if( fileSize > 0 )
+    {
+        void* addr = mmap( NULL, fileSize, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                           fileno( fp ), 0 );
+
+        if( addr != MAP_FAILED )
+        {
+            buffer = (char*) addr;
+            size   = fileSize;
+            mapped = true;
+
+#if defined( MADV_SEQUENTIAL )
+            madvise( addr, size, MADV_SEQUENTIAL );
+#endif
+        }
+    }
+#endif
+
+    if( !mapped && fileSize > 0 )
+    {
+        // No mmap(), or it failed: read the whole file, with room for a trailing nul.
+        // In text mode, fewer bytes than fileSize can be read.
+        buffer = new char[fileSize + 1];
+        size   = fread( buffer, 1, fileSize, fp );
+        buffer[size] = 0;
+    }
+
+    fclose( fp );
+}
+
+
+void MMAP_LINE_READER::release()
+{
+    if( mapped )
+    {
+#if defined( HAVE_MMAP )
+        munmap( buffer, size );
+#endif
+    }
+    else
+    {
+        delete[] buffer;
+    }
+
+    buffer = 0;
+    size   = 0;
+    ndx    = 0;
+    mapped = false;
+    nulAt  = 0;
+}
+
+
+char* MMAP_LINE_READER::ReadLine() throw( IO_ERROR )
+{
+    if( nulAt )
+    {
+        *nulAt = savedChar;
+        nulAt  = 0;
+    }
+
+    // lineNum is incremented even if there was no line read, because this
+    // leads to better error reporting when we hit an end of file.
+    ++lineNum;
+
+    if( ndx >= size )
+    {
+        line   = lineBuffer;
+        length = 0;
+
+        if( line )
+            line[0] = 0;
+
+        return NULL;
+    }
+
+    char*   begin = buffer + ndx;
+    char*   nl    = (char*) memchr( begin, '\n', size - ndx );
+    size_t  len   = nl ? nl - begin + 1 : size - ndx;    // include the newline
+
+    if( len >= maxLineLength )
+        THROW_IO_ERROR( _( "Maximum line length exceeded" ) );
+
+    ndx += len;
+
+    if( ndx < size || !mapped )
+    {
+        // Terminate the line in place, the next ReadLine() puts the byte back.
+        // A read buffer always has a spare byte at its end.
+        if( ndx < size )
+        {
+            nulAt     = buffer + ndx;
+            savedChar = *nulAt;
+            *nulAt    = 0;
+        }
+
+        line   = begin;
+        length = len;
+    }
+    else
+    {
+        // The last line of a mapping without a trailing byte to hold the nul.
+        line   = lineBuffer;
+        length = 0;
+
+        if( len + 1 > capacity )
+            expandCapacity( len + 1 );
+
+        lineBuffer = line;
+
+        memcpy( line, begin, len );
+        line[len] = 0;
+        length = len;
+    }
+
+    return line;
+}
+
+
+void MMAP_LINE_READER::Rewind() throw( IO_ERROR )
+{
+    // The lines read may have been modified in place, so start from the file again.
+    release();
+
+    line    = lineBuffer;
+    length  = 0;
+    lineNum = 0;
+
+    load();
+}
+
+
 STRING_LINE_READER::STRING_LINE_READER( const std::string& aString, const wxString& aSource ) :
     LINE_READER( LINE_READER_LINE_DEFAULT_MAX ),
     lines( aString ),
@@ -438,10 +640,15 @@ int OUTPUTFORMATTER::Print( int nestLevel, const char* fmt, ... ) throw( IO_ERRO
     int result = 0;
     int total  = 0;
 
-    for( int i=0; i<nestLevel;  ++i )
+    // the indentation, written without formatting, one block of blanks at a time.
+    static const char blanks[] = "                                ";
+
+    for( int indent = nestLevel * NESTWIDTH;  indent > 0;  indent -= result )
     {
+        result = std::min( indent, (int) sizeof( blanks ) - 1 );
+
         // no error checking needed, an exception indicates an error.
-        result = sprint( "%*c", NESTWIDTH, ' ' );
+        write( blanks, result );
 
         total += result;
     }
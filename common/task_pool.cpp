@@ -0,0 +1,266 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file task_pool.cpp
+ */
+
+#include <task_pool.h>
+
+
+TASK_POOL::TASK_POOL( unsigned aThreadCount ) :
+    m_threadCount( aThreadCount ),
+    m_pending( 0 ),
+    m_added( 0 ),
+    m_count( 0 ),
+    m_done( 0 ),
+    m_next( 0 ),
+    m_batch( 0 ),
+    m_busy( 0 ),
+    m_cancelled( false ),
+    m_quit( false )
+{
+    if( !m_threadCount )
+        m_threadCount = boost::thread::hardware_concurrency();
+
+    if( !m_threadCount )
+        m_threadCount = 1;
+
+    for( unsigned ii = 0; ii < m_threadCount; ++ii )
+        m_queues.push_back( new QUEUE );
+
+    // The thread calling Run() is the worker 0.
+    for( unsigned ii = 1; ii < m_threadCount; ++ii )
+        m_threads.push_back( new boost::thread( &TASK_POOL::workerMain, this, ii ) );
+}
+
+
+TASK_POOL::~TASK_POOL()
+{
+    {
+        LOCK lock( m_lock );
+
+        m_quit = true;
+    }
+
+    m_wakeUp.notify_all();
+
+    for( unsigned ii = 0; ii < m_threads.size(); ++ii )
+        m_threads[ii].join();
+}
+
+
+void TASK_POOL::Add( const TASK& aTask )
+{
+    unsigned*   index = m_index.get();
+
+    {
+        LOCK lock( m_lock );
+
+        ++m_pending;
+        ++m_added;
+        ++m_count;
+
+        // A task adds to the queue of its own thread, anything else is spread
+        // over all the queues.
+        unsigned queue = index ? *index : m_next++ % m_threadCount;
+
+        // Queued while m_lock is held, so a worker which has seen m_added
+        // unchanged cannot miss this task, see worker().
+        MUTLOCK queueLock( m_queues[queue].lock );
+
+        m_queues[queue].tasks.push_back( aTask );
+    }
+
+    m_wakeUp.notify_all();
+}
+
+
+bool TASK_POOL::Run( const PROGRESS& aProgress )
+{
+    {
+        LOCK lock( m_lock );
+
+        m_done      = 0;
+        m_cancelled = false;
+        m_busy      = m_threads.size();
+        ++m_batch;
+    }
+
+    m_wakeUp.notify_all();
+
+    // The current thread is the worker 0, the only one which reports the progress.
+    m_index.reset( new unsigned( 0 ) );
+
+    worker( 0, aProgress.empty() ? NULL : &aProgress );
+
+    m_index.reset();
+
+    LOCK lock( m_lock );
+
+    while( m_busy )
+        m_idle.wait( lock );
+
+    m_count = 0;
+    m_next  = 0;
+
+    return !m_cancelled;
+}
+
+
+void TASK_POOL::Cancel()
+{
+    LOCK lock( m_lock );
+
+    m_cancelled = true;
+}
+
+
+bool TASK_POOL::IsCancelled()
+{
+    LOCK lock( m_lock );
+
+    return m_cancelled;
+}
+
+
+void TASK_POOL::workerMain( unsigned aIndex )
+{
+    m_index.reset( new unsigned( aIndex ) );
+
+    unsigned batch = 0;
+
+    for( ;; )
+    {
+        {
+            LOCK lock( m_lock );
+
+            while( batch == m_batch && !m_quit )
+                m_wakeUp.wait( lock );
+
+            if( m_quit )
+                break;
+
+            batch = m_batch;
+        }
+
+        worker( aIndex, NULL );
+
+        LOCK lock( m_lock );
+
+        if( --m_busy == 0 )
+            m_idle.notify_all();
+    }
+}
+
+
+void TASK_POOL::worker( unsigned aIndex, const PROGRESS* aProgress )
+{
+    TASK        task;
+    unsigned    added;      // m_added when the queues were last known to be up to date
+
+    {
+        LOCK lock( m_lock );
+
+        added = m_added;
+    }
+
+    for( ;; )
+    {
+        if( pop( aIndex, task ) )
+        {
+            // The cancelled tasks are popped anyway, to count them as done.
+            if( !IsCancelled() )
+                task();
+
+            task.clear();
+
+            unsigned done;
+            unsigned count;
+
+            {
+                LOCK lock( m_lock );
+
+                --m_pending;
+                done  = ++m_done;
+                count = m_count;
+                added = m_added;
+
+                // The last task wakes up the threads waiting for another one.
+                if( !m_pending )
+                    m_wakeUp.notify_all();
+            }
+
+            if( aProgress && !(*aProgress)( done, count ) )
+                Cancel();
+        }
+        else
+        {
+            LOCK lock( m_lock );
+
+            // No more task anywhere, and none running which could add one.
+            if( !m_pending )
+                break;
+
+            // The other threads are running their last tasks, which may add more.
+            // Sleep unless some were added since pop() looked at the queues.
+            if( added == m_added )
+                m_wakeUp.wait( lock );
+
+            added = m_added;
+        }
+    }
+}
+
+
+bool TASK_POOL::pop( unsigned aIndex, TASK& aTask )
+{
+    {
+        QUEUE&  own = m_queues[aIndex];
+        MUTLOCK lock( own.lock );
+
+        if( !own.tasks.empty() )
+        {
+            aTask = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+
+    // Steal from the other end of the queue of another thread, where its
+    // owner is the least likely to be.
+    for( unsigned ii = 1; ii < m_threadCount; ++ii )
+    {
+        QUEUE&  victim = m_queues[( aIndex + ii ) % m_threadCount];
+        MUTLOCK lock( victim.lock );
+
+        if( !victim.tasks.empty() )
+        {
+            aTask = victim.tasks.back();
+            victim.tasks.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,491 @@
+/**
+ * @file eeschema_erc.cpp
+ * @brief command line tool running the ERC on a schematic, without any window.
+ */
+
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/*
+    Usage: eeschema_erc [options] <schematic file>
+
+        --format=json|xml   report format, json by default
+        --output=<file>     report file, the standard output by default
+
+    The exit code is the number of ERC errors and warnings found, up to 100,
+    or one of the error codes of EESCHEMA_ERC_EXIT_CODE.
+
+    The hierarchy is loaded with LoadSchematicFile(), the component pins are
+    taken from the cache library of the schematic (<name>-cache.lib), and the
+    ERC is the RunERC() of the ERC dialog, with the default pin conflict table.
+    No frame and no window are created, so this can run on a machine without
+    display, as pcbnew_drc does for the boards.
+*/
+
+
+#include <fctsys.h>
+#include <algorithm>
+#include <wx/init.h>
+#include <wx/filename.h>
+#include <wx/wfstream.h>
+#include <wx/xml/xml.h>
+
+#include <macros.h>
+#include <common.h>
+#include <kiway.h>
+#include <pgm_base.h>
+#include <richio.h>
+#include <xnode.h>
+#include <base_units.h>
+#include <wildcards_and_files_ext.h>
+
+#include <general.h>
+#include <class_library.h>
+#include <class_sch_screen.h>
+#include <sch_sheet.h>
+#include <sch_sheet_path.h>
+#include <sch_marker.h>
+#include <erc.h>
+
+
+/// Exit codes of eeschema_erc, when it cannot give a number of ERC markers
+enum EESCHEMA_ERC_EXIT_CODE
+{
+    EXIT_NO_VIOLATION   = 0,
+    EXIT_MAX_VIOLATIONS = 100,      ///< 100 markers or more
+    EXIT_BAD_COMMAND    = 101,      ///< unknown option, or no schematic file
+    EXIT_LOAD_ERROR     = 102,      ///< the schematic file cannot be read
+    EXIT_WRITE_ERROR    = 103,      ///< the report file cannot be written
+    EXIT_NOT_ANNOTATED  = 104       ///< the schematic must be annotated before the ERC
+};
+
+
+/**
+ * Struct PGM_ERC
+ * implements PGM_BASE for this tool, which has no wxApp.  eeschema.cpp is linked in
+ * for the eeschema globals, and its Pgm() is given this object as single_top does.
+ */
+static struct PGM_ERC : public PGM_BASE
+{
+    bool OnPgmInit( wxApp* aWxApp ) { return true; }
+    void OnPgmExit()                { }
+    void MacOpenFile( const wxString& aFileName ) { }
+} program;
+
+
+/**
+ * Function jsonString
+ * quotes and escapes aText for a JSON document.
+ */
+static std::string jsonString( const wxString& aText )
+{
+    std::string utf8 = TO_UTF8( aText );
+    std::string ret  = "\"";
+
+    for( unsigned ii = 0; ii < utf8.size(); ++ii )
+    {
+        unsigned char c = utf8[ii];
+
+        if( c == '"' || c == '\\' )
+        {
+            ret += '\\';
+            ret += c;
+        }
+        else if( c < 0x20 )
+        {
+            char buf[8];
+            sprintf( buf, "\\u%04x", c );
+            ret += buf;
+        }
+        else
+            ret += c;
+    }
+
+    ret += '"';
+
+    return ret;
+}
+
+
+/// @return a coordinate in mm, in the C locale
+static wxString toMillimeters( int aValue )
+{
+    return wxString::Format( wxT( "%.4f" ), To_User_Unit( MILLIMETRES, aValue ) );
+}
+
+
+/// @return the severity of an ERC marker, as written in the reports
+static const char* severity( const SCH_MARKER* aMarker )
+{
+    return aMarker->GetErrorLevel() == ERR ? "error" : "warning";
+}
+
+
+/**
+ * Struct ERC_VIOLATION
+ * is an ERC marker and the sheet it was found in.
+ */
+struct ERC_VIOLATION
+{
+    wxString            m_sheet;
+    const SCH_MARKER*   m_marker;
+};
+
+
+/**
+ * Function collectViolations
+ * gathers the ERC markers of the whole hierarchy.  A screen used by several sheets
+ * has its markers reported once for each sheet, as WriteDiagnosticERC() does.
+ */
+static void collectViolations( std::vector<ERC_VIOLATION>& aViolations )
+{
+    SCH_SHEET_LIST sheetList;
+
+    for( SCH_SHEET_PATH* sheet = sheetList.GetFirst(); sheet; sheet = sheetList.GetNext() )
+    {
+        for( SCH_ITEM* item = sheet->LastDrawList(); item; item = item->Next() )
+        {
+            if( item->Type() != SCH_MARKER_T )
+                continue;
+
+            const SCH_MARKER* marker = (const SCH_MARKER*) item;
+
+            if( marker->GetMarkerType() != MARK_ERC )
+                continue;
+
+            ERC_VIOLATION violation;
+            violation.m_sheet  = sheet->PathHumanReadable();
+            violation.m_marker = marker;
+            aViolations.push_back( violation );
+        }
+    }
+}
+
+
+/**
+ * Function formatJsonItem
+ * writes one ERC marker as a JSON object, without the trailing comma.
+ */
+static void formatJsonItem( OUTPUTFORMATTER& aOut, int aNestLevel,
+                            const ERC_VIOLATION& aViolation )
+{
+    const DRC_ITEM& item = aViolation.m_marker->GetReporter();
+
+    aOut.Print( aNestLevel, "{\n" );
+    aOut.Print( aNestLevel + 1, "\"sheet\": %s,\n", jsonString( aViolation.m_sheet ).c_str() );
+    aOut.Print( aNestLevel + 1, "\"severity\": \"%s\",\n", severity( aViolation.m_marker ) );
+    aOut.Print( aNestLevel + 1, "\"code\": %d,\n", item.GetErrorCode() );
+    aOut.Print( aNestLevel + 1, "\"description\": %s,\n",
+                jsonString( item.GetErrorText() ).c_str() );
+    aOut.Print( aNestLevel + 1, "\"items\": [\n" );
+
+    aOut.Print( aNestLevel + 2, "{ \"text\": %s, \"x\": %s, \"y\": %s }",
+                jsonString( item.GetTextA() ).c_str(),
+                TO_UTF8( toMillimeters( item.GetPointA().x ) ),
+                TO_UTF8( toMillimeters( item.GetPointA().y ) ) );
+
+    if( item.HasSecondItem() )
+    {
+        aOut.Print( 0, ",\n" );
+        aOut.Print( aNestLevel + 2, "{ \"text\": %s, \"x\": %s, \"y\": %s }",
+                    jsonString( item.GetTextB() ).c_str(),
+                    TO_UTF8( toMillimeters( item.GetPointB().x ) ),
+                    TO_UTF8( toMillimeters( item.GetPointB().y ) ) );
+    }
+
+    aOut.Print( 0, "\n" );
+    aOut.Print( aNestLevel + 1, "]\n" );
+    aOut.Print( aNestLevel, "}" );
+}
+
+
+static std::string formatJsonReport( const wxString& aSchematicFile,
+                                     const std::vector<ERC_VIOLATION>& aViolations )
+{
+    STRING_FORMATTER out;
+
+    out.Print( 0, "{\n" );
+    out.Print( 1, "\"schematic\": %s,\n", jsonString( aSchematicFile ).c_str() );
+
+    out.Print( 1, "\"violations\": [\n" );
+
+    for( unsigned ii = 0; ii < aViolations.size(); ++ii )
+    {
+        formatJsonItem( out, 2, aViolations[ii] );
+        out.Print( 0, ii + 1 < aViolations.size() ? ",\n" : "\n" );
+    }
+
+    out.Print( 1, "]\n" );
+    out.Print( 0, "}\n" );
+
+    return out.GetString();
+}
+
+
+/**
+ * Function xmlItem
+ * builds the XML node of one ERC marker.
+ */
+static XNODE* xmlItem( const ERC_VIOLATION& aViolation )
+{
+    const DRC_ITEM& item = aViolation.m_marker->GetReporter();
+
+    XNODE* xitem = new XNODE( wxXML_ELEMENT_NODE, wxT( "violation" ) );
+
+    xitem->AddAttribute( wxT( "sheet" ), aViolation.m_sheet );
+    xitem->AddAttribute( wxT( "severity" ), FROM_UTF8( severity( aViolation.m_marker ) ) );
+    xitem->AddAttribute( wxT( "code" ), wxString::Format( wxT( "%d" ), item.GetErrorCode() ) );
+    xitem->AddAttribute( wxT( "description" ), item.GetErrorText() );
+
+    XNODE* xpos = new XNODE( wxXML_ELEMENT_NODE, wxT( "item" ) );
+    xpos->AddAttribute( wxT( "text" ), item.GetTextA() );
+    xpos->AddAttribute( wxT( "x" ), toMillimeters( item.GetPointA().x ) );
+    xpos->AddAttribute( wxT( "y" ), toMillimeters( item.GetPointA().y ) );
+    xitem->AddChild( xpos );
+
+    if( item.HasSecondItem() )
+    {
+        xpos = new XNODE( wxXML_ELEMENT_NODE, wxT( "item" ) );
+        xpos->AddAttribute( wxT( "text" ), item.GetTextB() );
+        xpos->AddAttribute( wxT( "x" ), toMillimeters( item.GetPointB().x ) );
+        xpos->AddAttribute( wxT( "y" ), toMillimeters( item.GetPointB().y ) );
+        xitem->AddChild( xpos );
+    }
+
+    return xitem;
+}
+
+
+static bool writeXmlReport( const wxString& aReportFile, const wxString& aSchematicFile,
+                            const std::vector<ERC_VIOLATION>& aViolations )
+{
+    XNODE* xroot = new XNODE( wxXML_ELEMENT_NODE, wxT( "erc" ) );
+
+    xroot->AddAttribute( wxT( "schematic" ), aSchematicFile );
+
+    XNODE* xviolations = new XNODE( wxXML_ELEMENT_NODE, wxT( "violations" ) );
+    xroot->AddChild( xviolations );
+
+    for( unsigned ii = 0; ii < aViolations.size(); ++ii )
+        xviolations->AddChild( xmlItem( aViolations[ii] ) );
+
+    wxXmlDocument xdoc;
+
+    xdoc.SetRoot( xroot );
+
+    if( aReportFile.IsEmpty() )
+    {
+        wxFFileOutputStream out( stdout );
+        return xdoc.Save( out, 2 );
+    }
+
+    return xdoc.Save( aReportFile, 2 );
+}
+
+
+/**
+ * Function loadCacheLibrary
+ * loads the cache library of the schematic, which has all the components it uses,
+ * as SCH_EDIT_FRAME::LoadCacheLibrary() does.
+ * @return false if there is no cache library, or it cannot be read.
+ */
+static bool loadCacheLibrary( const wxString& aSchematicFile )
+{
+    wxFileName fn = aSchematicFile;
+
+    // <root_name>-cache.lib, or <root_name>.cache.lib before apr 2009
+    fn.SetName( fn.GetName() + wxT( "-cache" ) );
+    fn.SetExt( SchematicLibraryFileExtension );
+
+    if( !fn.FileExists() )
+    {
+        fn = aSchematicFile;
+        fn.SetExt( wxT( "cache.lib" ) );
+    }
+
+    if( !fn.FileExists() )
+        return false;
+
+    wxString     errMsg;
+    CMP_LIBRARY* libCache = CMP_LIBRARY::LoadLibrary( fn, errMsg );
+
+    if( !libCache )
+    {
+        fprintf( stderr, "eeschema_erc: %s\n", TO_UTF8( errMsg ) );
+        return false;
+    }
+
+    libCache->SetCache();
+    CMP_LIBRARY::GetLibraryList().push_back( libCache );
+
+    return true;
+}
+
+
+static void usage()
+{
+    fprintf( stderr,
+             "Usage: eeschema_erc [options] <schematic file>\n"
+             "    --format=json|xml   report format, json by default\n"
+             "    --output=<file>     report file, the standard output by default\n" );
+}
+
+
+int main( int argc, char** argv )
+{
+    wxInitializer initializer;
+
+    if( !initializer.IsOk() )
+    {
+        fprintf( stderr, "eeschema_erc: cannot initialize wxWidgets\n" );
+        return EXIT_BAD_COMMAND;
+    }
+
+    int kifaceVersion;
+    KIFACE_GETTER( &kifaceVersion, KIFACE_VERSION, &program );
+
+    wxString    schematicFile;
+    wxString    reportFile;
+    bool        xmlFormat = false;
+
+    for( int ii = 1; ii < argc; ++ii )
+    {
+        wxString arg = FROM_UTF8( argv[ii] );
+
+        if( arg.StartsWith( wxT( "--output=" ), &reportFile ) )
+            continue;
+
+        if( arg == wxT( "--format=json" ) )
+            xmlFormat = false;
+        else if( arg == wxT( "--format=xml" ) )
+            xmlFormat = true;
+        else if( !arg.StartsWith( wxT( "-" ) ) && schematicFile.IsEmpty() )
+            schematicFile = arg;
+        else
+        {
+            usage();
+            return EXIT_BAD_COMMAND;
+        }
+    }
+
+    if( schematicFile.IsEmpty() )
+    {
+        usage();
+        return EXIT_BAD_COMMAND;
+    }
+
+    wxFileName fn = schematicFile;
+
+    // The report file is given relative to the current directory, the sub-sheets
+    // relative to the schematic directory, as in SCH_EDIT_FRAME::OpenProjectFiles()
+    if( !reportFile.IsEmpty() )
+    {
+        wxFileName reportFn = reportFile;
+        reportFn.MakeAbsolute();
+        reportFile = reportFn.GetFullPath();
+    }
+
+    fn.MakeAbsolute();
+    schematicFile = fn.GetFullPath();
+    wxSetWorkingDirectory( fn.GetPath() );
+
+    if( !loadCacheLibrary( schematicFile ) )
+        fprintf( stderr, "eeschema_erc: no cache library for %s, the pins are not tested\n",
+                 TO_UTF8( schematicFile ) );
+
+    g_RootSheet = new SCH_SHEET();
+    g_RootSheet->SetFileName( schematicFile );
+
+    wxString errorMsg;
+
+    if( !g_RootSheet->Load( NULL, &errorMsg ) )
+    {
+        fprintf( stderr, "eeschema_erc: %s", TO_UTF8( errorMsg ) );
+
+        delete g_RootSheet;
+        g_RootSheet = NULL;
+        CMP_LIBRARY::RemoveAllLibraries();
+
+        return EXIT_LOAD_ERROR;
+    }
+
+    // Errors of items which were skipped, the rest of the hierarchy is tested
+    if( !errorMsg.IsEmpty() )
+        fprintf( stderr, "eeschema_erc: %s", TO_UTF8( errorMsg ) );
+
+    int violations = 0;
+    int exitCode   = EXIT_NO_VIOLATION;
+    wxArrayString messages;
+
+    if( !RunERC( &messages ) )
+    {
+        for( unsigned ii = 0; ii < messages.GetCount(); ++ii )
+            fprintf( stderr, "eeschema_erc: %s", TO_UTF8( messages[ii] ) );
+
+        exitCode = EXIT_NOT_ANNOTATED;
+    }
+    else
+    {
+        std::vector<ERC_VIOLATION> list;
+        collectViolations( list );
+        violations = list.size();
+
+        // Numbers are written with a '.', whatever the user locale
+        LOCALE_IO toggle;
+        bool written;
+
+        if( xmlFormat )
+        {
+            written = writeXmlReport( reportFile, schematicFile, list );
+        }
+        else
+        {
+            std::string report = formatJsonReport( schematicFile, list );
+            FILE* fp = reportFile.IsEmpty() ? stdout : wxFopen( reportFile, wxT( "wt" ) );
+
+            if( fp )
+            {
+                written = fwrite( report.data(), 1, report.size(), fp ) == report.size();
+
+                if( fp != stdout )
+                    written = ( fclose( fp ) == 0 ) && written;
+            }
+            else
+                written = false;
+        }
+
+        if( !written )
+        {
+            fprintf( stderr, "eeschema_erc: cannot write %s\n", TO_UTF8( reportFile ) );
+            exitCode = EXIT_WRITE_ERROR;
+        }
+        else
+            exitCode = std::min( violations, (int) EXIT_MAX_VIOLATIONS );
+    }
+
+    delete g_RootSheet;
+    g_RootSheet = NULL;
+    CMP_LIBRARY::RemoveAllLibraries();
+
+    return exitCode;
+}
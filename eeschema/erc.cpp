@@ -121,6 +121,9 @@ const wxString CommentERC_V[] =
 int  DiagErc[PIN_NMAX][PIN_NMAX];
 bool DiagErcTableInit;       // go to true after DiagErc init
 
+// Buffer of the netlist items, in netlist.cpp
+extern NETLIST_OBJECT_LIST s_NetObjectslist;
+
 /**
  * Default Look up table which gives the ERC error level for a pair of connected pins
  * Same as DiagErc, but cannot be modified.
@@ -483,6 +486,124 @@ void TestOthersItems( NETLIST_OBJECT_LIST* aList,
 }
 
 
+bool RunERC( wxArrayString* aMessagesList )
+{
+    if( !DiagErcTableInit )
+    {
+        memcpy( DiagErc, DefaultDiagErc, sizeof(DefaultDiagErc) );
+        DiagErcTableInit = true;
+    }
+
+    /* Build the whole sheet list in hierarchy (sheet, not screen) */
+    SCH_SHEET_LIST sheets;
+    sheets.AnnotatePowerSymbols();
+
+    SCH_REFERENCE_LIST componentsList;
+    sheets.GetComponents( componentsList );
+
+    if( componentsList.CheckAnnotation( aMessagesList ) )
+    {
+        if( aMessagesList )
+        {
+            wxString msg = _( "Annotation required!" );
+            msg += wxT( "\n" );
+            aMessagesList->Add( msg );
+        }
+
+        return false;
+    }
+
+    SCH_SCREENS screens;
+
+    // Erase all previous DRC markers.
+    screens.DeleteAllMarkers( MARK_ERC );
+
+    for( SCH_SCREEN* screen = screens.GetFirst(); screen != NULL; screen = screens.GetNext() )
+    {
+        /* Ff wire list has changed, delete Undo Redo list to avoid pointers on deleted
+         * data problems.
+         */
+        if( screen->SchematicCleanUp( NULL ) )
+            screen->ClearUndoRedoList();
+    }
+
+    /* Test duplicate sheet names inside a given sheet, one cannot have sheets with
+     * duplicate names (file names can be duplicated).
+     */
+    TestDuplicateSheetNames( true );
+
+    s_NetObjectslist.BuildNetListInfo( sheets );
+
+    NETLIST_OBJECT_LIST* objectsConnectedList = &s_NetObjectslist;
+
+    // Reset the connection type indicator
+    objectsConnectedList->ResetConnectionsType();
+
+    unsigned lastNet;
+    unsigned nextNet = lastNet = 0;
+    int NetNbItems = 0;
+    int MinConn    = NOC;
+
+    for( unsigned net = 0; net < objectsConnectedList->size(); net++ )
+    {
+        if( objectsConnectedList->GetItemNet( lastNet ) !=
+            objectsConnectedList->GetItemNet( net ) )
+        {
+            // New net found:
+            MinConn    = NOC;
+            NetNbItems = 0;
+            nextNet   = net;
+        }
+
+        switch( objectsConnectedList->GetItemType( net ) )
+        {
+        // These items do not create erc problems
+        case NET_ITEM_UNSPECIFIED:
+        case NET_SEGMENT:
+        case NET_BUS:
+        case NET_JUNCTION:
+        case NET_LABEL:
+        case NET_BUSLABELMEMBER:
+        case NET_PINLABEL:
+        case NET_GLOBLABEL:
+        case NET_GLOBBUSLABELMEMBER:
+            break;
+
+        case NET_HIERLABEL:
+        case NET_HIERBUSLABELMEMBER:
+        case NET_SHEETLABEL:
+        case NET_SHEETBUSLABELMEMBER:
+
+            // ERC problems when pin sheets do not match hierarchical labels.
+            // Each pin sheet must match a hierarchical label
+            // Each hierarchical label must match a pin sheet
+            TestLabel( objectsConnectedList, net, nextNet );
+            break;
+
+        case NET_NOCONNECT:
+
+            // ERC problems when a noconnect symbol is connected to more than one pin.
+            MinConn = NET_NC;
+
+            if( NetNbItems != 0 )
+                Diagnose( objectsConnectedList->GetItem( net ), NULL, MinConn, UNC );
+
+            break;
+
+        case NET_PIN:
+
+            // Look for ERC problems between pins:
+            TestOthersItems( objectsConnectedList, net, nextNet, &NetNbItems, &MinConn );
+            break;
+        }
+
+        lastNet = net;
+    }
+
+    return true;
+}
+
+
 bool WriteDiagnosticERC( const wxString& aFullFileName )
 {
     SCH_ITEM*       item;
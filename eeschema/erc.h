@@ -66,6 +66,17 @@ extern const wxString CommentERC_V[];
 #define NOC    0  // initial state of a net: no connection
 
 
+/**
+ * Function RunERC
+ * tests the whole hierarchy of g_RootSheet, and adds an ERC marker on the screens for
+ * each problem found.  The previous ERC markers are deleted.  No frame is needed, so this
+ * is used by the ERC dialog and by eeschema_erc.
+ *
+ * @param aMessagesList gets the annotation errors, if not NULL.
+ * @return false if the schematic is not annotated, in which case nothing is tested.
+ */
+extern bool RunERC( wxArrayString* aMessagesList );
+
 /**
  * Function WriteDiagnosticERC
  * save the ERC errors to \a aFullFileName.
@@ -9,6 +9,7 @@
 
 class TRANSFORM;
 class SCH_SHEET;
+class SCH_SCREEN;
 
 #define EESCHEMA_VERSION 2
 #define SCHEMATIC_HEAD_STRING "Schematic File Version"
@@ -92,4 +93,18 @@ EDA_COLOR_T GetInvisibleItemColor();
 
 void        SetLayerColor( EDA_COLOR_T aColor, int aLayer );
 
+/**
+ * Function LoadSchematicFile
+ * reads the items of the schematic file \a aFullFileName into \a aScreen, without any frame.
+ * SCH_EDIT_FRAME::LoadOneEEFile() displays the messages of this function.
+ *
+ * @param aAppend = false to set the file name of \a aScreen, true to append the items.
+ * @param aErrorMsg gets the error message, if the file cannot be read or an item is bad.
+ * @param aWarningMsg gets the warning message, if the file is from a more recent Eeschema.
+ * @return false if the file cannot be opened or is not a schematic file, true else, although
+ *         the file may be only partially loaded.
+ */
+bool LoadSchematicFile( SCH_SCREEN* aScreen, const wxString& aFullFileName, bool aAppend,
+                        wxString& aErrorMsg, wxString& aWarningMsg );
+
 #endif    // _GENERAL_H_
@@ -54,11 +54,7 @@ static void LoadLayers( LINE_READER* aLine );
 
 bool SCH_EDIT_FRAME::LoadOneEEFile( SCH_SCREEN* aScreen, const wxString& aFullFileName, bool append )
 {
-    char            name1[256];
-    bool            itemLoaded = false;
-    SCH_ITEM*       item;
     wxString        msgDiag;            // Error and log messages
-    char*           line;
     wxFileName      fn;
 
     if( aScreen == NULL )
@@ -72,8 +68,46 @@ bool SCH_EDIT_FRAME::LoadOneEEFile( SCH_SCREEN* aScreen, const wxString& aFullFi
 
     wxLogTrace( traceAutoSave, wxT( "Loading schematic file " ) + aFullFileName );
 
+    msgDiag.Printf( _( "Loading <%s>" ), GetChars( aFullFileName ) );
+    PrintMsg( msgDiag );
+
+    wxString errorMsg;
+    wxString warningMsg;
+    bool     success = LoadSchematicFile( aScreen, aFullFileName, append, errorMsg, warningMsg );
+
+    if( !warningMsg.IsEmpty() )
+        DisplayInfoMessage( this, warningMsg );
+
+    if( !errorMsg.IsEmpty() )
+        DisplayError( this, errorMsg );
+
+    if( !success )
+        return false;
+
+    msgDiag.Printf( _( "Done Loading <%s>" ), GetChars( aScreen->GetFileName() ) );
+    PrintMsg( msgDiag );
+
+    return true;    // Although it may be that file is only partially loaded.
+}
+
+
+bool LoadSchematicFile( SCH_SCREEN* aScreen, const wxString& aFullFileName, bool aAppend,
+                        wxString& aErrorMsg, wxString& aWarningMsg )
+{
+    char            name1[256];
+    bool            itemLoaded = false;
+    SCH_ITEM*       item;
+    wxString        msgDiag;            // Error messages of the item loaders
+    char*           line;
+
+    if( aScreen == NULL )
+        return false;
+
+    if( aFullFileName.IsEmpty() )
+        return false;
+
     aScreen->SetCurItem( NULL );
-    if( !append )
+    if( !aAppend )
         aScreen->SetFileName( aFullFileName );
 
     FILE* f;
@@ -86,23 +120,18 @@ bool SCH_EDIT_FRAME::LoadOneEEFile( SCH_SCREEN* aScreen, const wxString& aFullFi
 
     if( ( f = wxFopen( fname, wxT( "rt" ) ) ) == NULL )
     {
-        msgDiag.Printf( _( "Failed to open <%s>" ), GetChars( aFullFileName ) );
-        DisplayError( this, msgDiag );
+        aErrorMsg.Printf( _( "Failed to open <%s>" ), GetChars( aFullFileName ) );
         return false;
     }
 
     // reader now owns the open FILE.
     FILE_LINE_READER    reader( f, aFullFileName );
 
-    msgDiag.Printf( _( "Loading <%s>" ), GetChars( aScreen->GetFileName() ) );
-    PrintMsg( msgDiag );
-
     if( !reader.ReadLine()
         || strncmp( (char*)reader + 9, SCHEMATIC_HEAD_STRING,
                     sizeof( SCHEMATIC_HEAD_STRING ) - 1 ) != 0 )
     {
-        msgDiag.Printf( _( "<%s> is NOT an Eeschema file!" ), GetChars( aFullFileName ) );
-        DisplayError( this, msgDiag );
+        aErrorMsg.Printf( _( "<%s> is NOT an Eeschema file!" ), GetChars( aFullFileName ) );
         return false;
     }
 
@@ -119,10 +148,9 @@ bool SCH_EDIT_FRAME::LoadOneEEFile( SCH_SCREEN* aScreen, const wxString& aFullFi
 
     if( version > EESCHEMA_VERSION )
     {
-        msgDiag.Printf( _( "<%s> was created by a more recent \
+        aWarningMsg.Printf( _( "<%s> was created by a more recent \
 version of Eeschema and may not load correctly. Please consider updating!" ),
                 GetChars( aFullFileName ) );
-        DisplayInfoMessage( this, msgDiag );
     }
 
 #if 0
@@ -139,8 +167,7 @@ again." );
 
     if( !reader.ReadLine() || strncmp( reader, "LIBS:", 5 ) != 0 )
     {
-        msgDiag.Printf( _( "<%s> is NOT an Eeschema file!" ), GetChars( aFullFileName ) );
-        DisplayError( this, msgDiag );
+        aErrorMsg.Printf( _( "<%s> is NOT an Eeschema file!" ), GetChars( aFullFileName ) );
         return false;
     }
 
@@ -243,10 +270,9 @@ again." );
 
         if( !itemLoaded )
         {
-            msgDiag.Printf( _( "Eeschema file object not loaded at line %d, aborted" ),
-                            reader.LineNumber() );
-            msgDiag << wxT( "\n" ) << FROM_UTF8( line );
-            DisplayError( this, msgDiag );
+            aErrorMsg.Printf( _( "Eeschema file object not loaded at line %d, aborted" ),
+                              reader.LineNumber() );
+            aErrorMsg << wxT( "\n" ) << FROM_UTF8( line );
             break;
         }
     }
@@ -257,9 +283,6 @@ again." );
 
     aScreen->TestDanglingEnds();
 
-    msgDiag.Printf( _( "Done Loading <%s>" ), GetChars( aScreen->GetFileName() ) );
-    PrintMsg( msgDiag );
-
     return true;    // Although it may be that file is only partially loaded.
 }
 
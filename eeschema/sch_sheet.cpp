@@ -750,7 +750,7 @@ bool SCH_SHEET::LocatePathOfScreen( SCH_SCREEN* aScreen, SCH_SHEET_PATH* aList )
 }
 
 
-bool SCH_SHEET::Load( SCH_EDIT_FRAME* aFrame )
+bool SCH_SHEET::Load( SCH_EDIT_FRAME* aFrame, wxString* aErrorMsg )
 {
     bool success = true;
 
@@ -768,7 +768,21 @@ bool SCH_SHEET::Load( SCH_EDIT_FRAME* aFrame )
         else
         {
             SetScreen( new SCH_SCREEN() );
-            success = aFrame->LoadOneEEFile( m_screen, m_fileName );
+
+            if( aFrame )
+            {
+                success = aFrame->LoadOneEEFile( m_screen, m_fileName );
+            }
+            else
+            {
+                wxString errorMsg;
+                wxString warningMsg;
+
+                success = LoadSchematicFile( m_screen, m_fileName, false, errorMsg, warningMsg );
+
+                if( aErrorMsg && !errorMsg.IsEmpty() )
+                    *aErrorMsg << errorMsg << wxT( "\n" );
+            }
 
             if( success )
             {
@@ -780,7 +794,7 @@ bool SCH_SHEET::Load( SCH_EDIT_FRAME* aFrame )
                     {
                         SCH_SHEET* sheetstruct = (SCH_SHEET*) bs;
 
-                        if( !sheetstruct->Load( aFrame ) )
+                        if( !sheetstruct->Load( aFrame, aErrorMsg ) )
                             success = false;
                     }
 
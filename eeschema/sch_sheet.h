@@ -424,10 +424,12 @@ public:
      *  m_screen point on the screen, and its m_RefCount is
      * incremented
      *  else creates a new associated screen and load the data file.
-     *  @param aFrame = a SCH_EDIT_FRAME pointer to the maim schematic frame
+     *  @param aFrame = a SCH_EDIT_FRAME pointer to the maim schematic frame, or NULL
+     *                  to load the files without any frame (see LoadSchematicFile())
+     *  @param aErrorMsg = when aFrame is NULL, gets the load errors, if not NULL
      *  @return true if OK
      */
-    bool Load( SCH_EDIT_FRAME* aFrame );
+    bool Load( SCH_EDIT_FRAME* aFrame, wxString* aErrorMsg = NULL );
 
     /**
      * Function SearchHierarchy
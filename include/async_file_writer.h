@@ -0,0 +1,112 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file async_file_writer.h
+ */
+
+#ifndef ASYNC_FILE_WRITER_H_
+#define ASYNC_FILE_WRITER_H_
+
+#include <string>
+#include <wx/string.h>
+
+#include <richio.h>
+#include <ki_mutex.h>
+
+
+namespace boost { class thread; }
+
+
+/**
+ * Class ASYNC_FILE_WRITER
+ * writes files which have been formatted in memory on a worker thread, so the
+ * caller, usually the UI thread, does not wait for the disk.  A file is written
+ * to a temporary file of the same directory, which is then renamed, so a crash
+ * or another program never finds a partially written file: it is meant for the
+ * files the program owns, e.g. auto save files, which may replace a link.
+ * One file is written at a time.
+ */
+class ASYNC_FILE_WRITER
+{
+public:
+    ASYNC_FILE_WRITER();
+
+    /// Waits for the end of the write in progress, if any.
+    ~ASYNC_FILE_WRITER();
+
+    /**
+     * Function Write
+     * starts writing @a aText to @a aFileName on the worker thread, once the
+     * write in progress, if any, is finished.
+     *
+     * @param aFileName is the full name of the file to write.
+     * @param aText is the content of the file.  It is swapped with an empty string,
+     *  which avoids a copy of a large file.
+     */
+    void Write( const wxString& aFileName, std::string& aText );
+
+    /**
+     * Function IsBusy
+     * @return bool - true while a file is being written.
+     */
+    bool IsBusy();
+
+    /**
+     * Function Wait
+     * waits for the end of the write in progress, if any.
+     *
+     * @param aError receives the error message if the last write failed, may be NULL.
+     * @return bool - false if the last write failed, true otherwise.
+     */
+    bool Wait( wxString* aError = NULL );
+
+    /**
+     * Function WriteFile
+     * writes @a aText to @a aFileName on the current thread.
+     *
+     * @param aUseTempFile tells to write a temporary file renamed to @a aFileName
+     *  once complete, which leaves the file unchanged on an error.  Otherwise the
+     *  file is written in place, which keeps the links to it, its permissions and
+     *  its owner, e.g. for a document of the user.
+     * @throw IO_ERROR if the file cannot be written.
+     */
+    static void WriteFile( const wxString& aFileName, const std::string& aText,
+                           bool aUseTempFile = true )
+        throw( IO_ERROR );
+
+private:
+    /// The worker thread function
+    void run();
+
+    boost::thread*  m_thread;
+    MUTEX           m_lock;         ///< protects m_done
+    bool            m_done;         ///< true when m_thread has finished its write
+
+    wxString        m_fileName;     ///< the file being written
+    std::string     m_text;         ///< its content
+    bool            m_ok;           ///< result of the last write
+    wxString        m_error;        ///< error message of the last write, if it failed
+};
+
+#endif  // ASYNC_FILE_WRITER_H_
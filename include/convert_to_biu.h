@@ -20,8 +20,10 @@
 #if defined(PCBNEW) || defined(CVPCB) || defined(GERBVIEW)
  #if defined(GERBVIEW)
   #define IU_PER_MM        1e5     // Gerbview IU is 10 nanometers.
+  #define IU_PER_MM_LOG10  5       // IU_PER_MM is 10^IU_PER_MM_LOG10, see fixed_point_text.h
  #else
   #define IU_PER_MM        1e6     // Pcbnew IU is 1 nanometer.
+  #define IU_PER_MM_LOG10  6       // IU_PER_MM is 10^IU_PER_MM_LOG10, see fixed_point_text.h
  #endif
  #define IU_PER_MILS       (IU_PER_MM * 0.0254)
  #define IU_PER_DECIMILS   (IU_PER_MM * 0.00254)
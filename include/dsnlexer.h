@@ -42,6 +42,25 @@ struct KEYWORD
     const char* name;       ///< unique keyword.
     int         token;      ///< a zero based index into an array of KEYWORDs
 };
+
+
+/**
+ * Struct KEYWORD_HASH
+ * is a perfect hash of a KEYWORD table, computed by TokenList2DsnLexer.cmake along
+ * with the table itself.  One hash h is computed over the bytes of a token, and
+ * mixed into h0 and h2:  h0 selects a bucket, and the two displacements of the
+ * bucket give the only slot where the token can be found:
+ *   slot = ( h + d0 * h2 + d1 ) % slotCount
+ * bucketCount and slotCount are powers of 2, so that no division is needed.
+ * The generator and DSNLEXER::findToken() must compute exactly the same hashes.
+ */
+struct KEYWORD_HASH
+{
+    const unsigned short*   displacements;  ///< d0 and d1 of each bucket
+    unsigned                bucketCount;
+    const short*            slots;          ///< index in the KEYWORD table, or -1 if empty
+    unsigned                slotCount;
+};
 #endif
 
 // something like this macro can be used to help initialize a KEYWORD table.
@@ -110,7 +129,9 @@ protected:
 
     const KEYWORD*      keywords;               ///< table sorted by CMake for bsearch()
     unsigned            keywordCount;           ///< count of keywords table
-    KEYWORD_MAP         keyword_hash;           ///< fast, specialized "C string" hashtable
+    const KEYWORD_HASH* keywordPerfectHash;     ///< perfect hash of keywords, if generated
+    KEYWORD_MAP         keyword_hash;           ///< fast, specialized "C string" hashtable,
+                                                ///< used without keywordPerfectHash
 
     void init();
 
@@ -136,7 +157,8 @@ protected:
 
     /**
      * Function findToken
-     * takes aToken string and looks up the string in the keywords table.
+     * takes aToken string and looks up the string in the keywords table, with
+     * the perfect hash of the table when the lexer has one.
      *
      * @param aToken is a string to lookup in the keywords table.
      * @return int - with a value from the enum DSN_T matching the keyword text,
@@ -170,9 +192,11 @@ public:
      * @param aKeywordCount is the count of tokens in aKeywordTable.
      * @param aFile is an open file, which will be closed when this is destructed.
      * @param aFileName is the name of the file
+     * @param aKeywordHash is the perfect hash of aKeywordTable, or NULL.
      */
     DSNLEXER( const KEYWORD* aKeywordTable, unsigned aKeywordCount,
-              FILE* aFile, const wxString& aFileName );
+              FILE* aFile, const wxString& aFileName,
+              const KEYWORD_HASH* aKeywordHash = NULL );
 
     /**
      * Constructor ( std::string&*, const wxString& )
@@ -183,9 +207,11 @@ public:
      * @param aKeywordCount is the count of tokens in aKeywordTable.
      * @param aSExpression is text to feed through a STRING_LINE_READER
      * @param aSource is a description of aSExpression, used for error reporting.
+     * @param aKeywordHash is the perfect hash of aKeywordTable, or NULL.
      */
     DSNLEXER( const KEYWORD* aKeywordTable, unsigned aKeywordCount,
-              const std::string& aSExpression, const wxString& aSource = wxEmptyString );
+              const std::string& aSExpression, const wxString& aSource = wxEmptyString,
+              const KEYWORD_HASH* aKeywordHash = NULL );
 
     /**
      * Constructor ( LINE_READER* )
@@ -200,9 +226,11 @@ public:
      *
      * @param aLineReader is any subclassed instance of LINE_READER, such as
      *  STRING_LINE_READER or FILE_LINE_READER.  No ownership is taken.
+     *
+     * @param aKeywordHash is the perfect hash of aKeywordTable, or NULL.
      */
     DSNLEXER( const KEYWORD* aKeywordTable, unsigned aKeywordCount,
-              LINE_READER* aLineReader = NULL );
+              LINE_READER* aLineReader = NULL, const KEYWORD_HASH* aKeywordHash = NULL );
 
     virtual ~DSNLEXER();
 
@@ -370,6 +398,24 @@ public:
      */
     wxArrayString* ReadCommentLines() throw( IO_ERROR );
 
+    /**
+     * Function ReadListText
+     * skips the remainder of the current list, from the current token up to and
+     * including the DSN_RIGHT which closes the list, and appends its raw text to
+     * @a aText so another DSNLEXER can tokenize it later, for instance on another
+     * thread.  Only the parentheses outside of quoted strings and comment lines are
+     * counted, so this is much faster than reading the tokens.  The text before the
+     * current token in its line is replaced with blanks, which keeps the offsets of
+     * the tokens for the error messages.  Upon return the ')' is CurTok().
+     * Not supported in specctraMode.
+     *
+     * @param aText is where to append the text, which always ends with a '\n'.
+     * @return int - the line number of the current token, i.e. of the first line
+     *   appended to @a aText.
+     * @throw IO_ERROR if the input ends before the list is closed.
+     */
+    int ReadListText( std::string& aText ) throw( IO_ERROR );
+
     /**
      * Function IsSymbol
      * tests a token to see if it is a symbol.  This means it cannot be a
@@ -0,0 +1,75 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file fixed_point_text.h
+ * @brief Conversions between the decimal text of the files and fixed point integers.
+ *
+ * The board files hold the coordinates in millimeters, and a board internal unit is
+ * a nanometer, i.e. the 6th decimal of the text.  These functions convert an int
+ * count of such decimals to and from its text without going through a double, so
+ * without printf(), strtod() nor any locale.  See the test program
+ * tools/test-nm-biu-to-ascii-mm-round-tripping.cpp, which checks them against the
+ * printf() and strtod() conversions for all the int values.
+ */
+
+#ifndef FIXED_POINT_TEXT_H_
+#define FIXED_POINT_TEXT_H_
+
+
+/// Size of the buffer needed by FormatFixedPoint(), including the nul.
+#define FIXED_POINT_TEXT_MAX    16
+
+
+/**
+ * Function FormatFixedPoint
+ * writes the decimal text of @a aValue / 10^@a aDecimals, with a '.' as decimal
+ * separator, without the trailing zeros of the fraction and without exponent.
+ * For the board units, this is the text of "%.10g" of the value in millimeters.
+ *
+ * @param aBuffer receives the nul terminated text, it must hold at least
+ *  FIXED_POINT_TEXT_MAX bytes.
+ * @param aValue is the value, as a count of the smallest decimal.
+ * @param aDecimals is the count of decimals of @a aValue, up to 9.
+ * @return int - the length of the text.
+ */
+int FormatFixedPoint( char* aBuffer, int aValue, int aDecimals );
+
+/**
+ * Function ParseFixedPoint
+ * reads the decimal text @a aText, with a '.' as decimal separator, as a count of
+ * 10^-@a aDecimals.  Only the plain decimal numbers which are exactly such a count
+ * are read, i.e. an optional sign, then at most 10 digits, then at most @a aDecimals
+ * decimals which are not zero.  For any other text, e.g. with an exponent, more
+ * decimals or a value out of the range of an int, the caller must use strtod() and
+ * round the result, which would give the same value for a number read here.
+ *
+ * @param aText is the nul terminated text of the number, and nothing else.
+ * @param aDecimals is the count of decimals of the value, up to 9.
+ * @param aValue receives the value if the text can be read.
+ * @return bool - true if the text has been read, false otherwise.
+ */
+bool ParseFixedPoint( const char* aText, int aDecimals, int* aValue );
+
+
+#endif  // FIXED_POINT_TEXT_H_
@@ -30,6 +30,9 @@
 #define FOOTPRINT_INFO_H_
 
 
+#include <map>
+#include <vector>
+#include <stdint.h>
 #include <boost/ptr_container/ptr_vector.hpp>
 #include <boost/foreach.hpp>
 
@@ -75,6 +78,20 @@ public:
 #endif
     }
 
+    /// Constructor for an already loaded footprint, e.g. from the footprint info cache file.
+    FOOTPRINT_INFO( FOOTPRINT_LIST* aOwner, const wxString& aNickname, const wxString& aFootprintName,
+                    const wxString& aDoc, const wxString& aKeywords, int aPadCount ) :
+        m_owner( aOwner ),
+        m_loaded( true ),
+        m_nickname( aNickname ),
+        m_fpname( aFootprintName ),
+        m_num( 0 ),
+        m_pad_count( aPadCount ),
+        m_doc( aDoc ),
+        m_keywords( aKeywords )
+    {
+    }
+
     const wxString& GetDoc()
     {
         ensure_loaded();
@@ -165,15 +182,80 @@ class FOOTPRINT_LIST
     MUTEX   m_errors_lock;
     MUTEX   m_list_lock;
 
+    /// A footprint as kept in the footprint info cache file.
+    struct CACHED_FOOTPRINT
+    {
+        wxString    name;
+        wxString    doc;
+        wxString    keywords;
+        int         padCount;
+    };
+
+    /// A library of the footprint info cache file, valid as long as the files of
+    /// the library keep the same timestamp.
+    struct CACHED_LIBRARY
+    {
+        wxString    uri;                ///< plugin type, options and full URI
+        wxString    timestamp;          ///< see libraryTimestamp() in footprint_info.cpp
+        std::vector< CACHED_FOOTPRINT > footprints;
+    };
+
+    typedef std::map< wxString, CACHED_LIBRARY >    CACHE;  ///< key is the nickname
+
+    CACHE   m_cache;
+    bool    m_cache_modified;
+    MUTEX   m_cache_lock;
+
+    /// A library to load by ReadFootprintFiles()
+    struct LIBRARY_JOB
+    {
+        wxString    nickname;
+        wxString    uri;                ///< as in CACHED_LIBRARY
+        wxString    timestamp;          ///< as in CACHED_LIBRARY
+        uint64_t    size;               ///< size of the library files, the largest is loaded first
+        bool        done;               ///< loaded from the cache, or failed
+    };
+
+    /**
+     * Function findCachedLibrary
+     * fills m_list with the footprints of the library of @a aJob, if the cache holds
+     * it and is up to date, then sets aJob->done.  Otherwise fills in the timestamp
+     * and the size of @a aJob, for loadLibrary().
+     */
+    void findCachedLibrary( LIBRARY_JOB* aJob ) throw( IO_ERROR );
+
+    /**
+     * Function loadLibrary
+     * fills m_list with the footprints of the library of @a aJob, loaded from the
+     * library itself, which is then cached.
+     */
+    void loadLibrary( LIBRARY_JOB* aJob ) throw( IO_ERROR );
+
+    /// Sort function of the libraries to load, the largest first.
+    static bool largerLibrary( const LIBRARY_JOB* aFirst, const LIBRARY_JOB* aSecond );
+
+    /**
+     * Function readCache
+     * fills m_cache from the footprint info cache file, or leaves it empty if the
+     * file does not exist or cannot be read.
+     */
+    void readCache();
+
+    /**
+     * Function writeCache
+     * saves m_cache to the footprint info cache file, if it has been modified.
+     */
+    void writeCache();
+
     /**
      * Function loader_job
-     * loads footprints from @a aNicknameList and calls AddItem() on to help fill
-     * m_list.
+     * is a TASK_POOL task, which calls findCachedLibrary() or loadLibrary() for
+     * @a aJob and keeps their errors in m_errors.
      *
-     * @param aNicknameList is a wxString[] holding libraries to load all footprints from.
-     * @param aJobZ is the size of the job, i.e. the count of nicknames.
+     * @param aJob is the library to load.
+     * @param aLoad is false to look for the library in the cache, true to load it.
      */
-    void loader_job( const wxString* aNicknameList, int aJobZ );
+    void loader_job( LIBRARY_JOB* aJob, bool aLoad );
 
     void addItem( FOOTPRINT_INFO* aItem )
     {
@@ -189,7 +271,8 @@ public:
 
     FOOTPRINT_LIST() :
         m_lib_table( 0 ),
-        m_error_count( 0 )
+        m_error_count( 0 ),
+        m_cache_modified( false )
     {
     }
 
@@ -242,6 +325,15 @@ public:
 
     void DisplayErrors( wxTopLevelWindow* aCaller = NULL );
 
+    /**
+     * Function GetCacheFileName
+     * @return wxString - the full name of the footprint info cache file, which keeps
+     *  the names, descriptions, keywords and pad counts of the footprints of the
+     *  local libraries between sessions, so ReadFootprintFiles() only loads the
+     *  libraries which have been modified.
+     */
+    static wxString GetCacheFileName();
+
     FP_LIB_TABLE* GetTable() const { return m_lib_table; }
 };
 
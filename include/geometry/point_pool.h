@@ -0,0 +1,220 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef __POINT_POOL_H
+#define __POINT_POOL_H
+
+#include <cstddef>
+#include <new>
+
+/**
+ * Class POINT_POOL
+ *
+ * Recycles the point arrays of the SHAPE_LINE_CHAINs, which the router creates,
+ * copies and destroys by the thousands per mouse move. An array takes a block of
+ * the next power of two size, from a free list per size: a freed block goes back
+ * to its list, and the next array of the same size class takes it without the heap.
+ * The blocks are taken from chunks which are never given back, and the arrays larger
+ * than the largest class use the heap.
+ * Not thread safe: the router is the only user of SHAPE_LINE_CHAIN, from one thread.
+ */
+class POINT_POOL
+{
+public:
+    static void* Alloc( size_t aSize )
+    {
+        int sizeClass = classOf( aSize );
+
+        if( sizeClass < 0 )
+            return ::operator new( aSize );
+
+        POINT_POOL& pool = instance();
+
+        if( !pool.m_free[sizeClass] )
+            pool.grow( sizeClass );
+
+        BLOCK* block = pool.m_free[sizeClass];
+        pool.m_free[sizeClass] = block->next;
+
+        return block;
+    }
+
+    static void Free( void* aPtr, size_t aSize )
+    {
+        if( !aPtr )
+            return;
+
+        int sizeClass = classOf( aSize );
+
+        if( sizeClass < 0 )
+        {
+            ::operator delete( aPtr );
+            return;
+        }
+
+        POINT_POOL& pool = instance();
+        BLOCK* block = static_cast<BLOCK*>( aPtr );
+
+        block->next = pool.m_free[sizeClass];
+        pool.m_free[sizeClass] = block;
+    }
+
+private:
+    ///> Blocks of MinBlockSize << i bytes, for i < ClassCount (16 bytes to 8 kB).
+    static const size_t MinBlockSize = 16;
+    static const int ClassCount = 10;
+
+    ///> Number of blocks of a chunk.
+    static const int ChunkSize = 64;
+
+    struct BLOCK
+    {
+        BLOCK* next;
+    };
+
+    POINT_POOL()
+    {
+        for( int i = 0; i < ClassCount; i++ )
+            m_free[i] = NULL;
+    }
+
+    static POINT_POOL& instance()
+    {
+        // never deleted, as chains may be freed by destructors of other statics
+        static POINT_POOL* pool = new POINT_POOL;
+
+        return *pool;
+    }
+
+    ///> @return the size class of a block of aSize bytes, or -1 if it is too large.
+    static int classOf( size_t aSize )
+    {
+        size_t blockSize = MinBlockSize;
+
+        for( int i = 0; i < ClassCount; i++, blockSize <<= 1 )
+        {
+            if( aSize <= blockSize )
+                return i;
+        }
+
+        return -1;
+    }
+
+    void grow( int aClass )
+    {
+        size_t blockSize = MinBlockSize << aClass;
+        char* chunk = static_cast<char*>( ::operator new( ChunkSize * blockSize ) );
+
+        for( int i = ChunkSize - 1; i >= 0; i-- )
+        {
+            BLOCK* block = reinterpret_cast<BLOCK*>( chunk + i * blockSize );
+            block->next = m_free[aClass];
+            m_free[aClass] = block;
+        }
+    }
+
+    BLOCK* m_free[ClassCount];
+};
+
+
+/**
+ * Class POINT_ALLOCATOR
+ * Standard allocator taking memory from the POINT_POOL, for the point vector of
+ * SHAPE_LINE_CHAIN.
+ */
+template <class T>
+class POINT_ALLOCATOR
+{
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <class U>
+    struct rebind
+    {
+        typedef POINT_ALLOCATOR<U> other;
+    };
+
+    POINT_ALLOCATOR()
+    {
+    }
+
+    template <class U>
+    POINT_ALLOCATOR( const POINT_ALLOCATOR<U>& )
+    {
+    }
+
+    pointer allocate( size_type aCount, const void* = 0 )
+    {
+        return static_cast<pointer>( POINT_POOL::Alloc( aCount * sizeof( T ) ) );
+    }
+
+    void deallocate( pointer aBlock, size_type aCount )
+    {
+        POINT_POOL::Free( aBlock, aCount * sizeof( T ) );
+    }
+
+    void construct( pointer aBlock, const T& aValue )
+    {
+        new( aBlock ) T( aValue );
+    }
+
+    void destroy( pointer aBlock )
+    {
+        aBlock->~T();
+    }
+
+    size_type max_size() const
+    {
+        return size_type( -1 ) / sizeof( T );
+    }
+
+    pointer address( reference aValue ) const
+    {
+        return &aValue;
+    }
+
+    const_pointer address( const_reference aValue ) const
+    {
+        return &aValue;
+    }
+
+    template <class U>
+    bool operator==( const POINT_ALLOCATOR<U>& ) const
+    {
+        return true;
+    }
+
+    template <class U>
+    bool operator!=( const POINT_ALLOCATOR<U>& ) const
+    {
+        return false;
+    }
+};
+
+#endif
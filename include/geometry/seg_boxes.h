@@ -0,0 +1,138 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef __SEG_BOXES_H
+#define __SEG_BOXES_H
+
+#include <vector>
+
+#include <math/box2.h>
+#include <geometry/seg.h>
+
+class SHAPE_LINE_CHAIN;
+
+/**
+ * Class SEG_BOXES
+ *
+ * Holds the bounding boxes of the segments of a SHAPE_LINE_CHAIN, packed in one array
+ * per coordinate, for testing many segments against the same chain. The boxes are
+ * compared with the inflated box of the tested segment by blocks, in a loop of plain
+ * int comparisons which the compiler vectorizes. Only the segments whose box is close
+ * enough are given to SEG::Collide(), so the result is exactly the one of
+ * SHAPE_LINE_CHAIN::Collide().
+ *
+ * The chain is not copied: it must outlive the SEG_BOXES and not be changed.
+ * The boxes of a chain of up to BlockSize segments are kept in the object itself,
+ * so packing a short chain, e.g. a routed line, takes no heap allocation.
+ */
+class SEG_BOXES
+{
+public:
+    SEG_BOXES( const SHAPE_LINE_CHAIN& aChain );
+
+    int Size() const
+    {
+        return m_count;
+    }
+
+    /// Returns the bounding box of the whole chain.
+    const BOX2I& BBox() const
+    {
+        return m_bbox;
+    }
+
+    /**
+     * Function Collide()
+     *
+     * Checks if segment aSeg lies closer to the chain than aClearance, as
+     * SHAPE_LINE_CHAIN::Collide() does.
+     * @return true, when a collision has been found
+     */
+    bool Collide( const SEG& aSeg, int aClearance = 0 ) const
+    {
+        return collide( aSeg, aClearance, NULL ) > 0;
+    }
+
+    /**
+     * Function CollidingSegments()
+     *
+     * Finds all the segments of the chain which lie closer to segment aSeg than
+     * aClearance, i.e. the ones for which SEG::Collide() is true.
+     * @param aIndices receives the indices of these segments, in increasing order.
+     * @return the count of segments found
+     */
+    int CollidingSegments( const SEG& aSeg, int aClearance, std::vector<int>& aIndices ) const
+    {
+        aIndices.clear();
+
+        return collide( aSeg, aClearance, &aIndices );
+    }
+
+private:
+    typedef VECTOR2I::extended_type ecoord;
+
+    /// Count of segments whose boxes are compared in one pass.
+    static const int BlockSize = 64;
+
+    /**
+     * Function overlapping()
+     *
+     * Finds the segments from aFirst to aFirst + BlockSize - 1 whose box overlaps the
+     * box (aMinX, aMinY) - (aMaxX, aMaxY).
+     * @param aIndices receives the indices of the segments found.
+     * @return the count of segments found
+     */
+    int overlapping( int aFirst, int aMinX, int aMinY, int aMaxX, int aMaxY,
+                     int* aIndices ) const;
+
+    /**
+     * Function collide()
+     *
+     * Tests aSeg against the segments of the chain.
+     * @param aIndices receives the indices of the colliding segments, or NULL to
+     *                 stop at the first one.
+     * @return the count of colliding segments found
+     */
+    int collide( const SEG& aSeg, int aClearance, std::vector<int>* aIndices ) const;
+
+    const SHAPE_LINE_CHAIN& m_chain;
+    int m_count;
+
+    ///> The box coordinates, in one array per coordinate, each padded to whole blocks.
+    const int* m_minX;
+    const int* m_minY;
+    const int* m_maxX;
+    const int* m_maxY;
+
+    ///> The storage of the arrays above: m_inline for a single block, else m_heap.
+    int m_inline[4 * BlockSize];
+    std::vector<int> m_heap;
+
+    BOX2I m_bbox;
+
+    // Not copyable: the arrays may point into the object
+    SEG_BOXES( const SEG_BOXES& );
+    SEG_BOXES& operator=( const SEG_BOXES& );
+};
+
+#endif // __SEG_BOXES_H
@@ -33,6 +33,7 @@
 #include <math/vector2d.h>
 #include <geometry/shape.h>
 #include <geometry/seg.h>
+#include <geometry/point_pool.h>
 
 /**
  * Class SHAPE_LINE_CHAIN
@@ -46,8 +47,9 @@
 class SHAPE_LINE_CHAIN : public SHAPE
 {
 private:
-    typedef std::vector<VECTOR2I>::iterator point_iter;
-    typedef std::vector<VECTOR2I>::const_iterator point_citer;
+    typedef std::vector<VECTOR2I, POINT_ALLOCATOR<VECTOR2I> > POINT_VECTOR;
+    typedef POINT_VECTOR::iterator point_iter;
+    typedef POINT_VECTOR::const_iterator point_citer;
 
 public:
     /**
@@ -534,8 +536,8 @@ public:
     }
 
 private:
-    /// array of vertices
-    std::vector<VECTOR2I> m_points;
+    /// array of vertices, taken from the POINT_POOL
+    POINT_VECTOR m_points;
 
     /// is the line chain closed?
     bool m_closed;
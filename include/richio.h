@@ -381,6 +381,67 @@ public:
 };
 
 
+/**
+ * Class MMAP_LINE_READER
+ * is a LINE_READER that maps a whole file into memory, when the platform allows it,
+ * else reads it at once.  ReadLine() returns a pointer into the mapped bytes instead
+ * of copying each line: the byte following the line is temporarily replaced by a nul
+ * and restored by the next ReadLine(), so the returned line is valid until then only,
+ * as with the other LINE_READERs.  This is the reader of choice for large files such
+ * as boards and netlists.
+ */
+class MMAP_LINE_READER : public LINE_READER
+{
+protected:
+
+    char*   buffer;     ///< the mapped or read file contents
+    size_t  size;       ///< no. bytes in buffer
+    size_t  ndx;        ///< offset of the next line in buffer
+    bool    mapped;     ///< buffer is a memory mapping, else it was allocated by new[]
+
+    char*   lineBuffer; ///< the buffer allocated by LINE_READER, restored before its destruction
+    char*   nulAt;      ///< where a nul was written into buffer after the current line
+    char    savedChar;  ///< the byte which was at nulAt
+
+public:
+
+    /**
+     * Constructor MMAP_LINE_READER
+     * opens @a aFileName and maps its contents.
+     *
+     * @param aFileName is the name of the file to open and to use for error reporting purposes.
+     * @param aStartingLineNumber is the initial line number to report on error, see
+     *  FILE_LINE_READER.
+     * @param aMaxLineLength is the maximum allowed length of a line.
+     *
+     * @throw IO_ERROR if @a aFileName cannot be opened or read.
+     */
+    MMAP_LINE_READER( const wxString& aFileName,
+            unsigned aStartingLineNumber = 0,
+            unsigned aMaxLineLength = LINE_READER_LINE_DEFAULT_MAX ) throw( IO_ERROR );
+
+    ~MMAP_LINE_READER();
+
+    char* ReadLine() throw( IO_ERROR );   // see LINE_READER::ReadLine() description
+
+    /**
+     * Function Rewind
+     * goes back to the beginning of the file and resets the line number back to zero.
+     * Line number will go to 1 on first ReadLine().  The file is read again, since the
+     * lines may have been modified in place.
+     * @throw IO_ERROR if the file cannot be opened again.
+     */
+    void Rewind() throw( IO_ERROR );
+
+private:
+    /// map or read the file named by source
+    void load() throw( IO_ERROR );
+
+    /// unmap or free the file contents
+    void release();
+};
+
+
 /**
  * Class STRING_LINE_READER
  * is a LINE_READER that reads from a multiline 8 bit wide std::string
@@ -610,6 +671,16 @@ public:
         return mystring;
     }
 
+    /**
+     * Function MutableString
+     * gives access to the buffer itself, e.g. to swap() a large output
+     * out of the formatter instead of copying it.
+     */
+    std::string& MutableString()
+    {
+        return mystring;
+    }
+
 protected:
     //-----<OUTPUTFORMATTER>------------------------------------------------
     void write( const char* aOutBuf, int aCount ) throw( IO_ERROR );
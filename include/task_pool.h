@@ -0,0 +1,160 @@
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file task_pool.h
+ */
+
+#ifndef TASK_POOL_H_
+#define TASK_POOL_H_
+
+#include <deque>
+#include <boost/function.hpp>
+#include <boost/ptr_container/ptr_vector.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/tss.hpp>
+
+#include <ki_mutex.h>
+
+
+/**
+ * Class TASK_POOL
+ * runs a batch of independent tasks on several threads.
+ *
+ * Each thread has its own queue of tasks, and a thread whose queue is empty steals
+ * the tasks of the others, so the threads stay busy until the very end of the batch
+ * even when the tasks have very different durations.  A task may Add() more tasks,
+ * they go to the queue of its thread.
+ *
+ * The worker threads are started by the constructor and stopped by the destructor,
+ * they sleep between the batches, so a pool may be Run() often at no cost.
+ *
+ * Usage:
+ * <code>
+ *     TASK_POOL pool;
+ *
+ *     for( unsigned i = 0; i < count; ++i )
+ *         pool.Add( boost::bind( &MY_CLASS::job, this, i ) );
+ *
+ *     pool.Run();
+ * </code>
+ */
+class TASK_POOL
+{
+public:
+    /// A task, which must not throw, since it may run on a worker thread.
+    typedef boost::function< void () >  TASK;
+
+    /**
+     * A progress reporter, called on the thread of Run() with the count of tasks done
+     * and the count of tasks added.  It returns false to Cancel() the batch.
+     */
+    typedef boost::function< bool ( unsigned aDone, unsigned aCount ) > PROGRESS;
+
+    /**
+     * Constructor TASK_POOL
+     * starts the worker threads.
+     * @param aThreadCount is the count of threads running the tasks, including the
+     *  one calling Run(), or 0 for one thread per processor.
+     */
+    TASK_POOL( unsigned aThreadCount = 0 );
+
+    /**
+     * Destructor
+     * stops the worker threads, it must not be called during a Run().
+     */
+    ~TASK_POOL();
+
+    /**
+     * Function Add
+     * adds a task to the next Run(), or to the current one if called by a task.
+     * It is thread safe.
+     */
+    void Add( const TASK& aTask );
+
+    /**
+     * Function Run
+     * runs all the tasks added so far, and those they add, on the current thread
+     * and on the worker threads, and returns when they are all done.  The pool may
+     * be Run() again afterwards with other tasks.
+     *
+     * @param aProgress is called on the current thread after each task it has run.
+     * @return bool - false if the batch has been cancelled, true otherwise.
+     */
+    bool Run( const PROGRESS& aProgress = PROGRESS() );
+
+    /**
+     * Function Cancel
+     * drops the tasks of the current Run() which have not started yet.  The running
+     * tasks are not interrupted, a long task may check IsCancelled() itself.
+     * It is thread safe.
+     */
+    void Cancel();
+
+    bool IsCancelled();
+
+    unsigned GetThreadCount() const     { return m_threadCount; }
+
+private:
+    /// The tasks of a thread, the thread runs them in the order they have been
+    /// added, the other threads steal the most recently added ones.
+    struct QUEUE
+    {
+        MUTEX               lock;
+        std::deque< TASK >  tasks;
+    };
+
+    typedef boost::unique_lock< boost::mutex > LOCK;
+
+    /// The main function of the worker thread @a aIndex, which runs each batch.
+    void workerMain( unsigned aIndex );
+
+    /// The task loop of the thread @a aIndex, for one batch.
+    void worker( unsigned aIndex, const PROGRESS* aProgress );
+
+    /// Takes a task from the queue of the thread @a aIndex, or from another one.
+    bool pop( unsigned aIndex, TASK& aTask );
+
+    unsigned                    m_threadCount;
+    boost::ptr_vector< QUEUE >  m_queues;       ///< one per thread
+    boost::ptr_vector< boost::thread > m_threads;    ///< the workers, from the index 1
+    boost::thread_specific_ptr< unsigned > m_index;  ///< queue index of the current thread
+
+    boost::mutex                m_lock;     ///< protects the members below
+    boost::condition_variable   m_wakeUp;   ///< a batch starts, a task is added or all are done
+    boost::condition_variable   m_idle;     ///< the workers are done with the batch
+
+    unsigned    m_pending;      ///< tasks added and not done
+    unsigned    m_added;        ///< tasks added since the pool creation
+    unsigned    m_count;        ///< tasks added to the current Run()
+    unsigned    m_done;         ///< tasks done in the current Run()
+    unsigned    m_next;         ///< queue of the next task added out of a Run()
+    unsigned    m_batch;        ///< count of Run() calls
+    unsigned    m_busy;         ///< worker threads in the current Run()
+    bool        m_cancelled;
+    bool        m_quit;         ///< the worker threads must stop
+};
+
+#endif  // TASK_POOL_H_
@@ -100,6 +100,9 @@ protected:
 
     /// A unique id for each node (TTL_USE_NODE_ID must be defined)
     int id_;
+
+    /// Returns the next id, nodes may be created by several threads at once
+    static int nextId();
 #endif
 
     int x_, y_;
@@ -113,7 +116,7 @@ public:
     flag_( false ),
 #endif
 #ifdef TTL_USE_NODE_ID
-    id_( id_count++ ),
+    id_( nextId() ),
 #endif
     x_( x ), y_( y ), refCount_( 0 ) {}
 
@@ -58,6 +58,36 @@ class FP_LIB_TABLE;
 class FPID;
 class TOOL_MANAGER;
 class TOOL_DISPATCHER;
+class BOARD_ITEM;
+class PICKED_ITEMS_LIST;
+
+
+/**
+ * Class BOARD_CHANGE_LISTENER
+ * is told of the changes made to the board by the edit commands of a PCB_BASE_FRAME,
+ * for the tools which keep their own copy of the board, see
+ * PCB_BASE_FRAME::AddBoardChangeListener().
+ */
+class BOARD_CHANGE_LISTENER
+{
+public:
+    virtual ~BOARD_CHANGE_LISTENER() {}
+
+    /**
+     * Function OnBoardItemChanged
+     * is called when \a aItem is about to be changed, deleted or swapped by an undo.
+     * The item must not be read, it may already be freed.
+     */
+    virtual void OnBoardItemChanged( BOARD_ITEM* aItem ) = 0;
+
+    /**
+     * Function OnBoardChanged
+     * is called when the board has been changed behind the undo list, e.g. the nets
+     * of the pads by a netlist read, so that any item may have changed.
+     */
+    virtual void OnBoardChanged() = 0;
+};
+
 
 /**
  * class PCB_BASE_FRAME
@@ -93,6 +123,27 @@ protected:
     TOOL_MANAGER*       m_toolManager;
     TOOL_DISPATCHER*    m_toolDispatcher;
 
+    /// Told of the board changes, see AddBoardChangeListener()
+    std::vector<BOARD_CHANGE_LISTENER*> m_boardChangeListeners;
+
+    /**
+     * Function notifyItemChanged
+     * calls BOARD_CHANGE_LISTENER::OnBoardItemChanged() of the listeners for \a aItem.
+     */
+    void notifyItemChanged( BOARD_ITEM* aItem );
+
+    /**
+     * Function notifyItemsChanged
+     * calls notifyItemChanged() for all the items of an undo/redo command.
+     */
+    void notifyItemsChanged( const PICKED_ITEMS_LIST& aItems );
+
+    /**
+     * Function notifyBoardChanged
+     * calls BOARD_CHANGE_LISTENER::OnBoardChanged() of the listeners.
+     */
+    void notifyBoardChanged();
+
     void updateGridSelectBox();
     void updateZoomSelectBox();
     virtual void unitsChangeRefresh();
@@ -121,6 +172,15 @@ public:
 
     ~PCB_BASE_FRAME();
 
+    /**
+     * Function AddBoardChangeListener
+     * registers \a aListener to be told of the changes made to the board by the edit
+     * commands, until RemoveBoardChangeListener().  A listener is only added once.
+     */
+    void AddBoardChangeListener( BOARD_CHANGE_LISTENER* aListener );
+
+    void RemoveBoardChangeListener( BOARD_CHANGE_LISTENER* aListener );
+
     /**
      * Function LoadFootprint
      * attempts to load \a aFootprintId from the footprint library table.
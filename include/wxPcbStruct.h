@@ -51,6 +51,7 @@ class PCB_TARGET;
 class DIMENSION;
 class EDGE_MODULE;
 class DRC;
+class ASYNC_FILE_WRITER;
 class ZONE_CONTAINER;
 class DRAWSEGMENT;
 class GENERAL_COLLECTOR;
@@ -114,6 +115,8 @@ protected:
 
     DRC* m_drc;                                 ///< the DRC controller, see drc.cpp
 
+    ASYNC_FILE_WRITER* m_autoSaveWriter;        ///< writes the auto save files in the background
+
     PARAM_CFG_ARRAY   m_configSettings;         ///< List of Pcbnew configuration settings.
 
     wxString          m_lastNetListRead;        ///< Last net list read with relative path.
@@ -263,6 +266,7 @@ public:
     void OnUpdateLayerPair( wxUpdateUIEvent& aEvent );
     void OnUpdateLayerSelectBox( wxUpdateUIEvent& aEvent );
     void OnUpdateDrcEnable( wxUpdateUIEvent& aEvent );
+    void OnUpdateOnlineDrc( wxUpdateUIEvent& aEvent );
     void OnUpdateShowBoardRatsnest( wxUpdateUIEvent& aEvent );
     void OnUpdateShowModuleRatsnest( wxUpdateUIEvent& aEvent );
     void OnUpdateAutoDeleteTrack( wxUpdateUIEvent& aEvent );
@@ -1360,9 +1364,8 @@ public:
      * The old fillings are removed
      * @param aActiveWindow = the current active window, if a progress bar is shown
      *                      = NULL to do not display a progress bar
-     * @param aVerbose = true to show error messages
      */
-    int Fill_All_Zones( wxWindow * aActiveWindow, bool aVerbose = true );
+    void Fill_All_Zones( wxWindow * aActiveWindow );
 
 
     /**
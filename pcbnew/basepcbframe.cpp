@@ -29,6 +29,7 @@
  */
 
 #include <fctsys.h>
+#include <algorithm>
 #include <kiface_i.h>
 #include <wxstruct.h>
 #include <pcbcommon.h>
@@ -58,6 +59,7 @@
 #include <pcb_painter.h>
 #include <worksheet_viewitem.h>
 #include <ratsnest_data.h>
+#include <class_undoredo_container.h>
 #include <ratsnest_viewitem.h>
 
 #include <tool/tool_manager.h>
@@ -174,6 +176,43 @@ PCB_BASE_FRAME::~PCB_BASE_FRAME()
 }
 
 
+void PCB_BASE_FRAME::AddBoardChangeListener( BOARD_CHANGE_LISTENER* aListener )
+{
+    if( std::find( m_boardChangeListeners.begin(), m_boardChangeListeners.end(),
+                   aListener ) == m_boardChangeListeners.end() )
+        m_boardChangeListeners.push_back( aListener );
+}
+
+
+void PCB_BASE_FRAME::RemoveBoardChangeListener( BOARD_CHANGE_LISTENER* aListener )
+{
+    m_boardChangeListeners.erase( std::remove( m_boardChangeListeners.begin(),
+                                               m_boardChangeListeners.end(), aListener ),
+                                  m_boardChangeListeners.end() );
+}
+
+
+void PCB_BASE_FRAME::notifyItemChanged( BOARD_ITEM* aItem )
+{
+    for( unsigned ii = 0; ii < m_boardChangeListeners.size(); ++ii )
+        m_boardChangeListeners[ii]->OnBoardItemChanged( aItem );
+}
+
+
+void PCB_BASE_FRAME::notifyItemsChanged( const PICKED_ITEMS_LIST& aItems )
+{
+    for( unsigned ii = 0; ii < aItems.GetCount(); ++ii )
+        notifyItemChanged( static_cast<BOARD_ITEM*>( aItems.GetPickedItem( ii ) ) );
+}
+
+
+void PCB_BASE_FRAME::notifyBoardChanged()
+{
+    for( unsigned ii = 0; ii < m_boardChangeListeners.size(); ++ii )
+        m_boardChangeListeners[ii]->OnBoardChanged();
+}
+
+
 FP_LIB_TABLE* PCB_BASE_FRAME::FootprintLibs() const
 {
     PROJECT&        prj = Prj();
@@ -42,6 +42,7 @@
 #include <class_edge_mod.h>
 
 #include <ratsnest_data.h>
+#include <drc_stuff.h>
 
 #include <tools/selection_tool.h>
 #include <tool/tool_manager.h>
@@ -347,6 +348,11 @@ void PCB_EDIT_FRAME::SaveCopyInUndoList( BOARD_ITEM*    aItem,
     break;
     }
 
+    m_drc->OnlineItemChanged( aItem );
+
+    // e.g. the interactive router, which keeps its world between its runs
+    notifyItemChanged( aItem );
+
     if( commandToUndo->GetCount() )
     {
         /* Save the copy in undo list */
@@ -433,6 +439,9 @@ void PCB_EDIT_FRAME::SaveCopyInUndoList( const PICKED_ITEMS_LIST& aItemsList,
         }
     }
 
+    m_drc->OnlineItemsChanged( *commandToUndo );
+    notifyItemsChanged( *commandToUndo );
+
     if( commandToUndo->GetCount() )
     {
         /* Save the copy in undo list */
@@ -611,6 +620,9 @@ void PCB_EDIT_FRAME::PutDataInPreviousState( PICKED_ITEMS_LIST* aList, bool aRed
     if( not_found )
         wxMessageBox( wxT( "Incomplete undo/redo operation: some items not found" ) );
 
+    m_drc->OnlineItemsChanged( *aList );
+    notifyItemsChanged( *aList );
+
     // Rebuild pointers and ratsnest that can be changed.
     if( reBuild_ratsnest && aRebuildRatsnet )
     {
@@ -197,6 +197,29 @@ protected:
 };
 
 
+/**
+ * Class ZONE_FILL_REPORTER
+ * follows, and possibly stops, BOARD::FillAllZones().  It is only called from the
+ * thread which started the fill, even when the zones are filled by several threads.
+ */
+class ZONE_FILL_REPORTER
+{
+public:
+
+    /**
+     * Function Report
+     * is called after a zone is filled.
+     * @param aZone The zone just filled
+     * @param aDone The number of zones already filled
+     * @param aTotal The number of zones to fill
+     * @return bool - true to continue, false to stop filling zones.
+     */
+    virtual bool Report( const ZONE_CONTAINER* aZone, int aDone, int aTotal ) = 0;
+
+    virtual ~ZONE_FILL_REPORTER() { }
+};
+
+
 /**
  * Class BOARD
  * holds information pertinent to a Pcbnew printed circuit board.
@@ -1351,6 +1374,15 @@ public:
     int Test_Drc_Areas_Outlines_To_Areas_Outlines( ZONE_CONTAINER* aArea_To_Examine,
                                                    bool            aCreate_Markers );
 
+    /**
+     * Function FillAllZones
+     * removes the segment zones of old boards, and fills again the copper zones, the
+     * largest first.  The zones are filled in parallel.
+     * @param aReporter = follows the fill, and can stop it, can be NULL
+     * @return the number of zones filled
+     */
+    int FillAllZones( ZONE_FILL_REPORTER* aReporter = NULL );
+
     /****** function relative to ratsnest calculations: */
 
     /**
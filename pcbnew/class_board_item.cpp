@@ -33,6 +33,8 @@
 #include <pcbnew.h>
 
 #include <class_board.h>
+#include <fixed_point_text.h>
+#include <climits>
 #include <string>
 
 wxString BOARD_ITEM::ShowShape( STROKE_T aShape )
@@ -88,87 +90,27 @@ wxString BOARD_ITEM::GetLayerName() const
 
 std::string BOARD_ITEM::FormatInternalUnits( int aValue )
 {
-#if 1
-
-    char    buf[50];
-    int     len;
-    double  mm = aValue / IU_PER_MM;
-
-    if( mm != 0.0 && fabs( mm ) <= 0.0001 )
-    {
-        len = sprintf( buf, "%.10f", mm );
-
-        while( --len > 0 && buf[len] == '0' )
-            buf[len] = '\0';
-
-        if( buf[len] == '.' )
-            buf[len] = '\0';
-        else
-            ++len;
-    }
-    else
-    {
-        len = sprintf( buf, "%.10g", mm );
-    }
+    // The exact decimal text of the value in mm, which is the one of "%.10g"
+    // since an int has 10 digits at most.  See the test program
+    // tools/test-nm-biu-to-ascii-mm-round-tripping.cpp to confirm it.
+    char    buf[FIXED_POINT_TEXT_MAX];
+    int     len = FormatFixedPoint( buf, aValue, IU_PER_MM_LOG10 );
 
     return std::string( buf, len );
+}
 
-#else
-
-    // Assume aValue is in nanometers, and that we want the result in millimeters,
-    // and that int is 32 bits wide.  Then perform an alternative algorithm.
-    // Can be used to verify that the above algorithm is correctly generating text.
-    // Convert aValue into an integer string, then insert a decimal point manually.
-    // Results are the same as above general purpose algorithm.
-
-    wxASSERT( sizeof(int) == 4 );
 
-    if( aValue == 0 )
-        return std::string( 1, '0' );
-    else
+std::string BOARD_ITEM::FormatAngle( double aAngle )
+{
+    // Angles are in tenths of degree, almost always a whole count of them
+    if( fabs( aAngle ) < INT_MAX && aAngle == (int) aAngle )
     {
-        char    buf[50];
-        int     len = sprintf( buf, aValue > 0 ? "%06d" : "%07d", aValue );     // optionally pad w/leading zeros
+        char    buf[FIXED_POINT_TEXT_MAX];
+        int     len = FormatFixedPoint( buf, (int) aAngle, 1 );
 
-        std::string ret( buf, len );
-
-        std::string::iterator it = ret.end() - 1;           // last byte
-
-        // insert '.' at 6 positions from end, dividing by 10e6 (a million), nm => mm
-        std::string::iterator decpoint = ret.end() - 6;
-
-        // truncate trailing zeros, up to decimal point position
-        for(  ; *it=='0' && it >= decpoint;  --it )
-            ret.erase( it );    // does not invalidate iterators it or decpoint
-
-        if( it >= decpoint )
-        {
-            ret.insert( decpoint, '.' );
-
-            // decpoint is invalidated here, after insert()
-
-#if 1       // want a leading zero when decimal point is in first position?
-            if( ret[0] == '.' )
-            {
-                // insert leading zero ahead of decimal point.
-                ret.insert( ret.begin(), '0' );
-            }
-            else if( ret[0]=='-' && ret[1]=='.' )
-            {
-                ret.insert( ret.begin() + 1, '0' );
-            }
-#endif
-        }
-
-        return ret;
+        return std::string( buf, len );
     }
 
-#endif
-}
-
-
-std::string BOARD_ITEM::FormatAngle( double aAngle )
-{
     char temp[50];
 
     int len = snprintf( temp, sizeof(temp), "%.10g", aAngle / 10.0 );
@@ -46,9 +46,71 @@ extern void Merge_SubNets_Connected_By_CopperAreas( BOARD* aPcb, int aNetcode );
 static void RebuildTrackChain( BOARD* pcb );
 
 
+/**
+ * Class DISJOINT_SETS
+ * is a union-find structure over the items 0 to N-1, with path compression and
+ * union by rank: merging two clusters does not need to relabel their items.
+ */
+class DISJOINT_SETS
+{
+public:
+    DISJOINT_SETS( int aCount ) :
+        m_parent( aCount ), m_rank( aCount, 0 )
+    {
+        for( int ii = 0; ii < aCount; ii++ )
+            m_parent[ii] = ii;
+    }
+
+    /// @return the representative item of the set which contains aItem
+    int Find( int aItem )
+    {
+        int root = aItem;
+
+        while( m_parent[root] != root )
+            root = m_parent[root];
+
+        while( m_parent[aItem] != root )
+        {
+            int next = m_parent[aItem];
+            m_parent[aItem] = root;
+            aItem = next;
+        }
+
+        return root;
+    }
+
+    /// merges the sets which contain aItemA and aItemB
+    void Union( int aItemA, int aItemB )
+    {
+        int rootA = Find( aItemA );
+        int rootB = Find( aItemB );
+
+        if( rootA == rootB )
+            return;
+
+        if( m_rank[rootA] < m_rank[rootB] )
+            EXCHG( rootA, rootB );
+
+        m_parent[rootB] = rootA;
+
+        if( m_rank[rootA] == m_rank[rootB] )
+            m_rank[rootA]++;
+    }
+
+private:
+    std::vector<int> m_parent;
+    std::vector<int> m_rank;
+};
+
+
 CONNECTIONS::CONNECTIONS( BOARD * aBrd )
 {
     m_brd = aBrd;
+    m_firstTrack = m_lastTrack = NULL;
+
+    // Connection points are searched at most a pad radius away: with cells of about
+    // the size of a pad, a search explores only a few cells.
+    m_cellSize = Millimeter2iu( 1.0 );
 }
 
 
@@ -142,79 +204,90 @@ void CONNECTIONS::CollectItemsNearTo( std::vector<CONNECTED_POINT*>& aList,
 {
     /* Search items in m_Candidates that position is <= aDistMax from aPosition
      * (Rectilinear distance)
-     * m_Candidates is sorted by X then Y values, so a fast binary search is used
-     * to locate the "best" entry point in list
-     * The best entry is a pad having its m_Pos.x == (or near) aPosition.x
-     * All candidates are near this candidate in list
-     * So from this entry point, a linear search is made to find all candidates
+     * Only the cells of the candidates grid which intersect the square of half size
+     * aDistMax centered on aPosition can contain such candidates.
      */
-    int idxmax = m_candidates.size()-1;
+    int xmin = cellCoord( aPosition.x - aDistMax );
+    int xmax = cellCoord( aPosition.x + aDistMax );
+    int ymin = cellCoord( aPosition.y - aDistMax );
+    int ymax = cellCoord( aPosition.y + aDistMax );
 
-    int delta = m_candidates.size();
+    wxPoint diff;
 
-    int idx = 0;        // Starting index is the beginning of list
-    while( delta )
+    // For a very large area (a big pad), testing all candidates is faster
+    // than exploring cells which are mostly empty.
+    if( (double) ( xmax - xmin + 1 ) * ( ymax - ymin + 1 ) > m_candidatesHash.size() )
     {
-        // Calculate half size of remaining interval to test.
-        // Ensure the computed value is not truncated (too small)
-        if( (delta & 1) && ( delta > 1 ) )
-            delta++;
-        delta /= 2;
-
-        CONNECTED_POINT& item = m_candidates[idx];
-
-        int dist = item.GetPoint().x - aPosition.x;
-        if( abs(dist) <= aDistMax )
+        for( unsigned ii = 0; ii < m_candidates.size(); ii++ )
         {
-            break;   // A good entry point is found. The list can be scanned from this point.
-        }
+            CONNECTED_POINT* item = &m_candidates[ii];
+            diff = item->GetPoint() - aPosition;
 
-        else if( item.GetPoint().x < aPosition.x ) // We should search after this item
-        {
-            idx += delta;
-            if( idx > idxmax )
-                idx = idxmax;
+            if( abs( diff.x ) <= aDistMax && abs( diff.y ) <= aDistMax )
+                aList.push_back( item );
         }
-        else    // We should search before this item
+
+        return;
+    }
+
+    for( int cx = xmin; cx <= xmax; cx++ )
+    {
+        for( int cy = ymin; cy <= ymax; cy++ )
         {
-            idx -= delta;
-            if( idx < 0 )
-                idx = 0;
+            boost::unordered_map<uint64_t, CANDIDATES_RANGE>::const_iterator cell =
+                m_candidatesHash.find( cellKey( cx, cy ) );
+
+            if( cell == m_candidatesHash.end() )
+                continue;
+
+            for( int ii = cell->second.first; ii < cell->second.second; ii++ )
+            {
+                CONNECTED_POINT* item = &m_candidates[ii];
+                diff = item->GetPoint() - aPosition;
+
+                if( abs( diff.x ) > aDistMax || abs( diff.y ) > aDistMax )
+                    continue;
+
+                // We have here a good candidate: add it
+                aList.push_back( item );
+            }
         }
     }
+}
 
-    /* Now explore the candidate list from the "best" entry point found
-     * (candidate "near" aPosition.x)
-     * We explore the list until abs(candidate->m_Point.x - aPosition.x) > aDistMax
-     * because the list is sorted by X position (and for a given X pos, by Y pos)
-     * Currently a linear search is made because the number of candidates
-     * having the right X position is usually small
-     */
-    // search next candidates in list
-    wxPoint diff;
-    for( int ii = idx; ii <= idxmax; ii++ )
-    {
-        CONNECTED_POINT* item = &m_candidates[ii];
-        diff = item->GetPoint() - aPosition;
-        if( abs(diff.x) > aDistMax )
-            break;    // Exit: the distance is to long, we cannot find other candidates
-        if( abs(diff.y) > aDistMax )
-            continue;    // the y distance is to long, but we can find other candidates
-        // We have here a good candidate: add it
-        aList.push_back( item );
-    }
-    // search previous candidates in list
-    for(  int ii = idx-1; ii >=0; ii-- )
-    {
-        CONNECTED_POINT * item = &m_candidates[ii];
-        diff = item->GetPoint() - aPosition;
-        if( abs(diff.x) > aDistMax )
-            break;
-        if( abs(diff.y) > aDistMax )
-            continue;
-        // We have here a good candidate:add it
-        aList.push_back( item );
+
+void CONNECTIONS::buildCandidatesHash()
+{
+    m_candidatesHash.clear();
+
+    // Sort the candidates by cell.  Sorting the (cell, index) pairs keeps the
+    // previous order of the candidates inside a cell.
+    std::vector< std::pair<uint64_t, int> > keys;
+    keys.reserve( m_candidates.size() );
+
+    for( unsigned ii = 0; ii < m_candidates.size(); ii++ )
+    {
+        const wxPoint& point = m_candidates[ii].GetPoint();
+        keys.push_back( std::make_pair( cellKey( cellCoord( point.x ), cellCoord( point.y ) ),
+                                        (int) ii ) );
     }
+
+    sort( keys.begin(), keys.end() );
+
+    std::vector<CONNECTED_POINT> sorted;
+    sorted.reserve( m_candidates.size() );
+
+    for( unsigned ii = 0; ii < keys.size(); ii++ )
+    {
+        sorted.push_back( m_candidates[keys[ii].second] );
+
+        if( ii == 0 || keys[ii].first != keys[ii - 1].first )
+            m_candidatesHash[keys[ii].first] = CANDIDATES_RANGE( ii, ii + 1 );
+        else
+            m_candidatesHash[keys[ii].first].second = ii + 1;
+    }
+
+    m_candidates.swap( sorted );
 }
 
 
@@ -228,6 +301,8 @@ void CONNECTIONS::BuildPadsCandidatesList()
         CONNECTED_POINT candidate( pad, pad->GetPosition() );
         m_candidates.push_back( candidate );
     }
+
+    buildCandidatesHash();
 }
 
 /* sort function used to sort .m_Connected by X the Y values
@@ -278,8 +353,10 @@ void CONNECTIONS::BuildTracksCandidatesList( TRACK * aBegin, TRACK * aEnd)
 
     // Sort list by increasing X coordinate,
     // and for increasing Y coordinate when items have the same X coordinate
-    // So candidates to the same location are consecutive in list.
+    // So candidates to the same location are consecutive in a cell of the grid.
     sort( m_candidates.begin(), m_candidates.end(), sortConnectedPointByXthenYCoordinates );
+
+    buildCandidatesHash();
 }
 
 /* Populates .m_connected with tracks/vias connected to aTrack
@@ -299,40 +376,12 @@ int CONNECTIONS::SearchConnectedTracks( const TRACK * aTrack )
     LAYER_MSK layerMask = aTrack->GetLayerMask();
 
     // Search for connections to starting point:
-#define USE_EXTENDED_SEARCH
-#ifdef USE_EXTENDED_SEARCH
     int dist_max = aTrack->GetWidth() / 2;
     static std::vector<CONNECTED_POINT*> tracks_candidates;
-#endif
+
     wxPoint position = aTrack->GetStart();
     for( int kk = 0; kk < 2; kk++ )
     {
-#ifndef USE_EXTENDED_SEARCH
-        int idx = searchEntryPointInCandidatesList( position );
-        if ( idx >= 0 )
-        {
-            // search after:
-            for ( unsigned ii = idx; ii < m_candidates.size(); ii ++ )
-            {
-                if( m_candidates[ii].GetTrack() == aTrack )
-                    continue;
-                if( m_candidates[ii].GetPoint() != position )
-                    break;
-                if( m_candidates[ii].GetTrack()->GetLayerMask() & layerMask )
-                    m_connected.push_back( m_candidates[ii].GetTrack() );
-            }
-            // search before:
-            for ( int ii = idx-1; ii >= 0; ii -- )
-            {
-                if( m_candidates[ii].GetTrack() == aTrack )
-                    continue;
-                if( m_candidates[ii].GetPoint() != position )
-                    break;
-                if( m_candidates[ii].GetTrack()->GetLayerMask() & layerMask )
-                    m_connected.push_back( m_candidates[ii].GetTrack() );
-            }
-        }
-#else
         tracks_candidates.clear();
         CollectItemsNearTo( tracks_candidates, position, dist_max );
         for ( unsigned ii = 0; ii < tracks_candidates.size(); ii ++ )
@@ -355,7 +404,6 @@ int CONNECTIONS::SearchConnectedTracks( const TRACK * aTrack )
 
             m_connected.push_back( ctrack );
         }
-#endif
 
         // Search for connections to ending point:
         if( aTrack->Type() == PCB_VIA_T )
@@ -367,62 +415,6 @@ int CONNECTIONS::SearchConnectedTracks( const TRACK * aTrack )
     return count;
 }
 
-int CONNECTIONS::searchEntryPointInCandidatesList( const wxPoint & aPoint)
-{
-    // Search the aPoint coordinates in m_Candidates
-    // m_Candidates is sorted by X then Y values, and a fast binary search is used
-    int idxmax = m_candidates.size()-1;
-
-    int delta = m_candidates.size();
-
-    int idx = 0;        // Starting index is the beginning of list
-    while( delta )
-    {
-        // Calculate half size of remaining interval to test.
-        // Ensure the computed value is not truncated (too small)
-        if( (delta & 1) && ( delta > 1 ) )
-            delta++;
-        delta /= 2;
-
-        CONNECTED_POINT & candidate = m_candidates[idx];
-        if( candidate.GetPoint() == aPoint )   // candidate found
-        {
-            return idx;
-        }
-
-        // Not found: test the middle of the remaining sub list
-        if( candidate.GetPoint().x == aPoint.x )   // Must search considering Y coordinate
-        {
-            if(candidate.GetPoint().y < aPoint.y)  // Must search after this item
-            {
-                idx += delta;
-                if( idx > idxmax )
-                    idx = idxmax;
-            }
-            else // Must search before this item
-            {
-                idx -= delta;
-                if( idx < 0 )
-                    idx = 0;
-            }
-        }
-        else if( candidate.GetPoint().x < aPoint.x ) // Must search after this item
-        {
-            idx += delta;
-            if( idx > idxmax )
-                idx = idxmax;
-        }
-        else // Must search before this item
-        {
-            idx -= delta;
-            if( idx < 0 )
-                idx = 0;
-        }
-    }
-
-    return -1;
-}
-
 /* Used after a track change (delete a track ou add a track)
  * Connections to pads are recalculated
  * Note also aFirstTrack (and aLastTrack ) can be NULL
@@ -463,83 +455,6 @@ void CONNECTIONS::Build_CurrNet_SubNets_Connections( TRACK* aFirstTrack, TRACK*
 }
 
 
-/**
- * Change a subnet value to a new value, in m_sortedPads pad list
- * After that, 2 cluster (or subnets) are merged into only one.
- * Note: the resulting subnet value is the smallest between aOldSubNet et aNewSubNet
- */
-int CONNECTIONS::Merge_PadsSubNets( int aOldSubNet, int aNewSubNet )
-{
-    int    change_count = 0;
-
-    if( aOldSubNet == aNewSubNet )
-        return 0;
-
-    if( (aOldSubNet > 0) && (aOldSubNet < aNewSubNet) )
-        EXCHG( aOldSubNet, aNewSubNet );
-
-    // Examine connections between intersecting pads
-    for( unsigned ii = 0; ii < m_sortedPads.size(); ii++ )
-    {
-        D_PAD * curr_pad = m_sortedPads[ii];
-        if( curr_pad->GetSubNet() != aOldSubNet )
-            continue;
-
-        change_count++;
-        curr_pad->SetSubNet( aNewSubNet );
-    }
-
-    return change_count;
-}
-
-/*
- * Change a subnet value to a new value, for tracks and pads which are connected to.
- * The result is merging 2 clusters (or subnets) into only one cluster.
- * Note: the resulting sub net value is the smallest between aOldSubNet et aNewSubNet
- */
-int CONNECTIONS::Merge_SubNets( int aOldSubNet, int aNewSubNet )
-{
-    TRACK* curr_track;
-    int    change_count = 0;
-
-    if( aOldSubNet == aNewSubNet )
-        return 0;
-
-    if( (aOldSubNet > 0) && (aOldSubNet < aNewSubNet) )
-        EXCHG( aOldSubNet, aNewSubNet );
-
-    curr_track = (TRACK*)m_firstTrack;
-
-    for( ; curr_track != NULL; curr_track = curr_track->Next() )
-    {
-        if( curr_track->GetSubNet() != aOldSubNet )
-        {
-            if( curr_track == m_lastTrack )
-                break;
-
-            continue;
-        }
-
-        change_count++;
-        curr_track->SetSubNet( aNewSubNet );
-
-        for( unsigned ii = 0; ii < curr_track->m_PadsConnected.size(); ii++ )
-        {
-            D_PAD * pad = curr_track->m_PadsConnected[ii];
-            if( pad->GetSubNet() == aOldSubNet )
-            {
-                pad->SetSubNet( curr_track->GetSubNet() );
-            }
-        }
-
-        if( curr_track == m_lastTrack )
-            break;
-    }
-
-    return change_count;
-}
-
-
 /* Test a list of track segments, to create or propagate a sub netcode to pads and
  * segments connected together.
  * The track list must be sorted by nets, and all segments
@@ -554,139 +469,76 @@ int CONNECTIONS::Merge_SubNets( int aOldSubNet, int aNewSubNet )
  */
 void CONNECTIONS::Propagate_SubNets()
 {
-    int sub_netcode = 1;
+    // Give an index to each item, tracks first and then pads.  The subnet member
+    // holds this index until the clusters are known.
+    std::vector<BOARD_CONNECTED_ITEM*> items;
+    TRACK* curr_track;
 
-    TRACK* curr_track = (TRACK*)m_firstTrack;
-    if( curr_track )
-        curr_track->SetSubNet( sub_netcode );
+    for( curr_track = (TRACK*) m_firstTrack; curr_track; curr_track = curr_track->Next() )
+    {
+        curr_track->SetSubNet( items.size() );
+        items.push_back( curr_track );
 
-    // Examine connections between tracks and pads
-    for( ; curr_track != NULL; curr_track = curr_track->Next() )
+        if( curr_track == m_lastTrack )
+            break;
+    }
+
+    unsigned track_count = items.size();
+
+    for( unsigned ii = 0; ii < m_sortedPads.size(); ii++ )
     {
-        // First: handling connections to pads
-        for( unsigned ii = 0; ii < curr_track->m_PadsConnected.size(); ii++ )
-        {
-            D_PAD * pad = curr_track->m_PadsConnected[ii];
+        m_sortedPads[ii]->SetSubNet( items.size() );
+        items.push_back( m_sortedPads[ii] );
+    }
 
-            if( curr_track->GetSubNet() )        // the track segment is already a cluster member
-            {
-                if( pad->GetSubNet() > 0 )
-                {
-                    // The pad is already a cluster member, so we can merge the 2 clusters
-                    Merge_SubNets( pad->GetSubNet(), curr_track->GetSubNet() );
-                }
-                else
-                {
-                    /* The pad is not yet attached to a cluster , so we can add this pad to
-                     * the cluster */
-                    pad->SetSubNet( curr_track->GetSubNet() );
-                }
-            }
-            else                              // the track segment is not attached to a cluster
-            {
-                if( pad->GetSubNet() > 0 )
-                {
-                    // it is connected to a pad in a cluster, merge this track
-                    curr_track->SetSubNet( pad->GetSubNet() );
-                }
-                else
-                {
-                    /* it is connected to a pad not in a cluster, so we must create a new
-                     * cluster (only with the 2 items: the track and the pad) */
-                    sub_netcode++;
-                    curr_track->SetSubNet( sub_netcode );
-                    pad->SetSubNet( curr_track->GetSubNet() );
-                }
-            }
-        }
+    // Merge the clusters of connected items:
+    // tracks connected to pads or to other tracks, and intersecting pads
+    DISJOINT_SETS clusters( items.size() );
 
-        // Test connections between segments
-        for( unsigned ii = 0; ii < curr_track->m_TracksConnected.size(); ii++ )
-        {
-            BOARD_CONNECTED_ITEM* track = curr_track->m_TracksConnected[ii];
-            if( curr_track->GetSubNet() )   // The current track is already a cluster member
-            {
-                // The other track is already a cluster member, so we can merge the 2 clusters
-                if( track->GetSubNet() )
-                {
-                    Merge_SubNets( track->GetSubNet(), curr_track->GetSubNet() );
-                }
-                else
-                {
-                    /* The other track is not yet attached to a cluster , so we can add this
-                     * other track to the cluster */
-                    track->SetSubNet( curr_track->GetSubNet() );
-                }
-            }
-            else        // the current track segment is not yet attached to a cluster
-            {
-                if( track->GetSubNet() )
-                {
-                    // The other track is already a cluster member, so we can add
-                    // the current segment to the cluster
-                    curr_track->SetSubNet( track->GetSubNet() );
-                }
-                else
-                {
-                    /* it is connected to an other segment not in a cluster, so we must
-                     * create a new cluster (only with the 2 track segments) */
-                    sub_netcode++;
-                    curr_track->SetSubNet( sub_netcode );
-                    track->SetSubNet( curr_track->GetSubNet() );
-                }
-            }
-        }
+    for( unsigned ii = 0; ii < track_count; ii++ )
+    {
+        curr_track = (TRACK*) items[ii];
 
-        if( curr_track == m_lastTrack )
-            break;
+        for( unsigned jj = 0; jj < curr_track->m_PadsConnected.size(); jj++ )
+            clusters.Union( ii, curr_track->m_PadsConnected[jj]->GetSubNet() );
+
+        for( unsigned jj = 0; jj < curr_track->m_TracksConnected.size(); jj++ )
+            clusters.Union( ii, curr_track->m_TracksConnected[jj]->GetSubNet() );
     }
 
-    // Examine connections between intersecting pads, and propagate
-    // sub_netcodes to intersecting pads
     for( unsigned ii = 0; ii < m_sortedPads.size(); ii++ )
     {
         D_PAD * curr_pad = m_sortedPads[ii];
+
         for( unsigned jj = 0; jj < curr_pad->m_PadsConnected.size(); jj++ )
+            clusters.Union( track_count + ii, curr_pad->m_PadsConnected[jj]->GetSubNet() );
+    }
+
+    // Number the clusters from 1, in the order of their first item.
+    // An item connected to nothing is not a cluster member (its subnet is 0),
+    // but the first track always starts the cluster 1.
+    std::vector<int> cluster_size( items.size(), 0 );
+
+    for( unsigned ii = 0; ii < items.size(); ii++ )
+        cluster_size[clusters.Find( ii )]++;
+
+    std::vector<int> sub_netcodes( items.size(), 0 );
+    int sub_netcode = 0;
+
+    for( unsigned ii = 0; ii < items.size(); ii++ )
+    {
+        int root = clusters.Find( ii );
+
+        if( cluster_size[root] < 2 && !( ii == 0 && track_count ) )
         {
-            D_PAD * pad = curr_pad->m_PadsConnected[jj];
-            if( curr_pad->GetSubNet() )   // the current pad is already attached to a cluster
-            {
-                if( pad->GetSubNet() > 0 )
-                {
-                    // The pad is already a cluster member, so we can merge the 2 clusters
-                    // Store the initial subnets, which will be modified by Merge_PadsSubNets
-                    int subnet1 = pad->GetSubNet();
-                    int subnet2 = curr_pad->GetSubNet();
-                    // merge subnets of pads only, even those not connected by tracks
-                    Merge_PadsSubNets( subnet1, subnet2 );
-                    // merge subnets of tracks (and pads, which are already merged)
-                    Merge_SubNets( subnet1, subnet2 );
-                }
-                else
-                {
-                    // The pad is not yet attached to a cluster,
-                    // so we can add this pad to the cluster
-                    pad->SetSubNet( curr_pad->GetSubNet() );
-                }
-            }
-            else   // the current pad is not attached to a cluster
-            {
-                if( pad->GetSubNet() > 0 )
-                {
-                    // the connected pad is in a cluster,
-                    // so we can add the current pad to the cluster
-                    curr_pad->SetSubNet( pad->GetSubNet() );
-                }
-                else
-                {
-                    // the connected pad is not in a cluster,
-                    // so we must create a new cluster, with the 2 pads.
-                    sub_netcode++;
-                    curr_pad->SetSubNet( sub_netcode );
-                    pad->SetSubNet( curr_pad->GetSubNet() );
-                }
-            }
+            items[ii]->SetSubNet( 0 );
+            continue;
         }
+
+        if( sub_netcodes[root] == 0 )
+            sub_netcodes[root] = ++sub_netcode;
+
+        items[ii]->SetSubNet( sub_netcodes[root] );
     }
 }
 
@@ -832,10 +684,16 @@ void PCB_BASE_FRAME::RecalculateAllTracksNetcode()
     // Build the net info list
     GetBoard()->BuildListOfNets();
 
+    // The nets of the tracks are changed behind the undo list: the interactive
+    // router and the other board change listeners are told when one of them is
+    // not the same at the end.
+    std::vector<int> oldNetcodes;
+
     // Reset variables and flags used in computation
     curr_track = m_Pcb->m_Track;
     for( ; curr_track != NULL; curr_track = curr_track->Next() )
     {
+        oldNetcodes.push_back( curr_track->GetNetCode() );
         curr_track->m_TracksConnected.clear();
         curr_track->m_PadsConnected.clear();
         curr_track->start = NULL;
@@ -847,7 +705,10 @@ void PCB_BASE_FRAME::RecalculateAllTracksNetcode()
 
     // If no pad, reset pointers and netcode, and do nothing else
     if( m_Pcb->GetPadCount() == 0 )
+    {
+        notifyBoardChanged();
         return;
+    }
 
     CONNECTIONS connections( m_Pcb );
     connections.BuildPadsList();
@@ -866,50 +727,68 @@ void PCB_BASE_FRAME::RecalculateAllTracksNetcode()
             curr_track->SetNetCode( curr_track->m_PadsConnected[0]->GetNetCode() );
     }
 
-    // Pass 2: build connections between track ends
+    // Pass 2: build connections between track ends, and merge the clusters
+    // of connected tracks having no netcode yet.  The tracks connected to a pad
+    // keep its netcode, and are not merged: a cluster must not join two nets.
+    // m_Param holds the index of a track during this pass.
+    std::vector<TRACK*> tracks;
+
     for( curr_track = m_Pcb->m_Track; curr_track != NULL; curr_track = curr_track->Next() )
     {
+        curr_track->m_Param = tracks.size();
+        tracks.push_back( curr_track );
+    }
+
+    DISJOINT_SETS clusters( tracks.size() );
+
+    for( unsigned ii = 0; ii < tracks.size(); ii++ )
+    {
+        curr_track = tracks[ii];
         connections.SearchConnectedTracks( curr_track );
         connections.GetConnectedTracks( curr_track );
+
+        if( curr_track->GetNetCode() != 0 )
+            continue;
+
+        for( unsigned kk = 0; kk < curr_track->m_TracksConnected.size(); kk++ )
+        {
+            TRACK* other = curr_track->m_TracksConnected[kk];
+
+            if( other->GetNetCode() == 0 )
+                clusters.Union( ii, (int) other->m_Param );
+        }
     }
 
-    // Propagate net codes from a segment to other connected segments
-    bool new_pass_request = true;   // set to true if a track has its netcode changed from 0
-                                    // to a known netcode to re-evaluate netcodes
-                                    // of connected items
-    while( new_pass_request )
+    // Propagate net codes to the tracks having none: each cluster of them gets
+    // the netcode of the first track, in list order, connected to the cluster
+    // and having one.
+    std::vector<int> netcodes( tracks.size(), 0 );
+
+    for( unsigned ii = 0; ii < tracks.size(); ii++ )
     {
-        new_pass_request = false;
+        curr_track = tracks[ii];
 
-        for( curr_track = m_Pcb->m_Track; curr_track; curr_track = curr_track->Next() )
+        if( curr_track->GetNetCode() != 0 )
+            continue;
+
+        int root = clusters.Find( ii );
+
+        for( unsigned kk = 0; kk < curr_track->m_TracksConnected.size() && netcodes[root] == 0; kk++ )
+            netcodes[root] = curr_track->m_TracksConnected[kk]->GetNetCode();
+    }
+
+    for( unsigned ii = 0; ii < tracks.size(); ii++ )
+    {
+        if( tracks[ii]->GetNetCode() == 0 )
+            tracks[ii]->SetNetCode( netcodes[clusters.Find( ii )] );
+    }
+
+    for( unsigned ii = 0; ii < tracks.size(); ii++ )
+    {
+        if( tracks[ii]->GetNetCode() != oldNetcodes[ii] )
         {
-            int netcode = curr_track->GetNetCode();
-            if( netcode == 0 )
-            {   // try to find a connected item having a netcode
-                for( unsigned kk = 0; kk < curr_track->m_TracksConnected.size(); kk++ )
-                {
-                    int altnetcode = curr_track->m_TracksConnected[kk]->GetNetCode();
-                    if( altnetcode )
-                    {
-                        new_pass_request = true;
-                        netcode = altnetcode;
-                        curr_track->SetNetCode(netcode);
-                        break;
-                    }
-                }
-            }
-            if( netcode )    // this track has a netcode
-            {   // propagate this netcode to connected tracks having no netcode
-                for( unsigned kk = 0; kk < curr_track->m_TracksConnected.size(); kk++ )
-                {
-                    int altnetcode = curr_track->m_TracksConnected[kk]->GetNetCode();
-                    if( altnetcode == 0 )
-                    {
-                        curr_track->m_TracksConnected[kk]->SetNetCode(netcode);
-                        new_pass_request = true;
-                    }
-                }
-            }
+            notifyBoardChanged();
+            break;
         }
     }
 
@@ -30,6 +30,9 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
  */
 
+#include <stdint.h>
+#include <boost/unordered_map.hpp>
+
 #include <class_track.h>
 #include <class_board.h>
 
@@ -95,6 +98,12 @@ private:
                                                 // to a given track or via
     std::vector <CONNECTED_POINT> m_candidates; // List of points to test
                                                 // (end points of tracks or vias location )
+                                                // sorted by cell of m_candidatesHash
+    typedef std::pair<int, int> CANDIDATES_RANGE;   // first and past the last candidate
+                                                    // index of a cell
+    boost::unordered_map<uint64_t, CANDIDATES_RANGE> m_candidatesHash;
+                                                // cells of the candidates grid
+    int m_cellSize;                             // the side length of a cell
     BOARD * m_brd;                              // the master board.
     const TRACK * m_firstTrack;                 // The first track used to build m_Candidates
     const TRACK * m_lastTrack;                  // The last track used to build m_Candidates
@@ -199,7 +208,9 @@ public:
      * function CollectItemsNearTo
      * Used by SearchTracksConnectedToPads
      * Fills aList with pads near to aPosition
-     * near means aPosition to pad position <= aDistMax
+     * near means aPosition to pad position <= aDistMax, in X and in Y.
+     * Only the cells of the candidates grid which intersect this square are
+     * explored, so the search time does not depend on the candidate count.
      * @param aList = list to fill
      * @param aPosition = aPosition to use as reference
      * @param aDistMax = dist max from aPosition to a candidate to select it
@@ -220,44 +231,30 @@ public:
      * For a given net, if all tracks are created, there is only one cluster.
      * but if not all tracks are created, there are more than one cluster,
      * and some ratsnests will be left active.
+     * The clusters are built with a disjoint-set structure, so the time needed is
+     * linear in the count of items and connections.
      */
     void Propagate_SubNets();
 
 private:
     /**
-     * function searchEntryPointInCandidatesList
-     * Search an item in m_Connected connected to aPoint
-     * note m_Connected containts usually more than one candidate
-     * and searchEntryPointInCandidatesList returns an index to one of these candidates
-     * Others are neightbor of the indexed item.
-     * @param aPoint is the reference coordinates
-     * @return the index of item found or -1 if no candidate
+     * Function buildCandidatesHash
+     * sorts m_candidates by cells of a square grid and fills m_candidatesHash
+     * with the range of candidates found in each cell.
      */
-    int searchEntryPointInCandidatesList( const wxPoint & aPoint);
+    void buildCandidatesHash();
 
-    /**
-     * Function Merge_SubNets
-     * Change a subnet old value to a new value, for tracks and pads which are connected to
-     * tracks from m_firstTrack to m_lastTrack and their connected pads.
-     * and modify the subnet parameter (change the old value to the new value).
-     * After that, 2 cluster (or subnets) are merged into only one.
-     * Note: the resulting sub net value is the smallest between aOldSubNet and aNewSubNet
-     * @return modification count
-     * @param aOldSubNet = subnet value to modify
-     * @param aNewSubNet = new subnet value for each item which have old_val as subnet value
-     */
-    int Merge_SubNets( int aOldSubNet, int aNewSubNet );
+    /// @return the coordinate of the grid cell which contains aCoord
+    int cellCoord( int aCoord ) const
+    {
+        return aCoord >= 0 ? aCoord / m_cellSize : -( ( -aCoord - 1 ) / m_cellSize ) - 1;
+    }
 
-    /**
-     * Function Merge_PadsSubNets
-     * Change a subnet value to a new value, in m_sortedPads pad list
-     * After that, 2 cluster (or subnets) are merged into only one.
-     * Note: the resulting subnet value is the smallest between aOldSubNet et aNewSubNet
-     * @return modification count
-     * @param aOldSubNet = subnet value to modify
-     * @param aNewSubNet = new subnet value for each item which have old_val as subnet value
-     */
-    int Merge_PadsSubNets( int aOldSubNet, int aNewSubNet );
+    /// @return the key of the grid cell at aCellX, aCellY in m_candidatesHash
+    static uint64_t cellKey( int aCellX, int aCellY )
+    {
+        return ( (uint64_t) (uint32_t) aCellX << 32 ) | (uint32_t) aCellY;
+    }
 };
 
 #endif      //  ifndef CONNECT_H
@@ -38,13 +38,86 @@
 #include <class_track.h>
 #include <class_pad.h>
 #include <class_zone.h>
+#include <class_netinfo.h>
 
 #include <pcbnew.h>
+#include <ratsnest_data.h>
 #include <drc_stuff.h>
+#include <drc_spatial_index.h>
 
 #include <dialog_drc.h>
 #include <wx/progdlg.h>
 
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif /* USE_OPENMP */
+
+
+/**
+ * Function isMainThread
+ * @return true in the thread running DRC::RunTests(), which is the master thread
+ * of the parallel tests.  Only this one can use the UI.
+ */
+static inline bool isMainThread()
+{
+#ifdef USE_OPENMP
+    return omp_get_thread_num() == 0;
+#else
+    return true;
+#endif /* USE_OPENMP */
+}
+
+
+/**
+ * Class DRC_PROGRESS_DIALOG
+ * is the progress reporter used when the caller of DRC::RunTests() gives none:
+ * it shows a cancellable progress dialog for each test which is long enough.
+ */
+class DRC_PROGRESS_DIALOG : public DRC_PROGRESS_REPORTER
+{
+public:
+    DRC_PROGRESS_DIALOG( wxWindow* aParent ) :
+        m_parent( aParent ),
+        m_dialog( NULL )
+    {
+    }
+
+    ~DRC_PROGRESS_DIALOG()
+    {
+        if( m_dialog )
+            m_dialog->Destroy();
+    }
+
+    bool Report( const wxString& aTitle, int aDone, int aTotal )
+    {
+        if( aTitle != m_title )     // a new test is starting
+        {
+            if( m_dialog )
+                m_dialog->Destroy();
+
+            m_dialog = NULL;
+            m_title  = aTitle;
+
+            // Only show a dialog if there are many items to test
+            if( aTotal > 2000 )
+            {
+                m_dialog = new wxProgressDialog( aTitle, wxEmptyString, aTotal, m_parent,
+                                                 wxPD_AUTO_HIDE | wxPD_CAN_ABORT );
+            }
+        }
+
+        if( !m_dialog )
+            return true;
+
+        return m_dialog->Update( std::min( aDone, aTotal ), wxEmptyString );
+    }
+
+private:
+    wxWindow*         m_parent;
+    wxProgressDialog* m_dialog;
+    wxString          m_title;
+};
+
 
 void DRC::ShowDialog()
 {
@@ -93,15 +166,35 @@ DRC::DRC( PCB_EDIT_FRAME* aPcbWindow )
 {
     m_mainWindow = aPcbWindow;
     m_pcb = aPcbWindow->GetBoard();
+
+    init();
+}
+
+
+DRC::DRC( BOARD* aBoard )
+{
+    m_mainWindow = NULL;
+    m_pcb = aBoard;
+
+    init();
+}
+
+
+void DRC::init()
+{
     m_ui  = 0;
 
     // establish initial values for everything:
     m_doPad2PadTest     = true;     // enable pad to pad clearance tests
     m_doUnconnectedTest = true;     // enable unconnected tests
     m_doZonesTest = true;           // enable zone to items clearance tests
+    m_doKeepoutTest = true;         // enable keepout areas to items tests
 
     m_doCreateRptFile = false;
 
+    // The cross check with the legacy track walk is only useful to test the DRC itself
+    m_doLegacyCrossCheck = wxGetEnv( wxT( "KICAD_DRC_CROSSCHECK" ), NULL );
+
     // m_rptFilename set to empty by its constructor
 
     m_currentMarker = NULL;
@@ -113,6 +206,52 @@ DRC::DRC( PCB_EDIT_FRAME* aPcbWindow )
     m_ycliplo = 0;
     m_xcliphi = 0;
     m_ycliphi = 0;
+
+    m_abortDRC = false;
+    m_drcInProgress = false;
+
+    m_spatialIndex = NULL;
+    m_progressReporter = NULL;
+
+    m_onlineIndex = NULL;
+    m_onlineBoard = NULL;
+    m_onlineRulesChanged = false;
+}
+
+
+DRC::DRC( const DRC& aParent, WORKER_T )
+{
+    m_mainWindow = aParent.m_mainWindow;
+    m_pcb = aParent.m_pcb;
+    m_ui  = 0;
+
+    m_doPad2PadTest      = aParent.m_doPad2PadTest;
+    m_doUnconnectedTest  = aParent.m_doUnconnectedTest;
+    m_doZonesTest        = aParent.m_doZonesTest;
+    m_doKeepoutTest      = aParent.m_doKeepoutTest;
+    m_doCreateRptFile    = false;
+    m_doLegacyCrossCheck = aParent.m_doLegacyCrossCheck;
+
+    m_currentMarker = NULL;
+
+    m_segmAngle  = 0;
+    m_segmLength = 0;
+
+    m_xcliplo = 0;
+    m_ycliplo = 0;
+    m_xcliphi = 0;
+    m_ycliphi = 0;
+
+    m_abortDRC = false;
+    m_drcInProgress = true;
+
+    // read only, owned by the parent
+    m_spatialIndex = aParent.m_spatialIndex;
+    m_progressReporter = NULL;
+
+    m_onlineIndex = NULL;
+    m_onlineBoard = NULL;
+    m_onlineRulesChanged = false;
 }
 
 
@@ -121,6 +260,11 @@ DRC::~DRC()
     // maybe someday look at pointainer.h  <- google for "pointainer.h"
     for( unsigned i = 0; i<m_unconnected.size();  ++i )
         delete m_unconnected[i];
+
+    // a marker left here has not been given to the board
+    delete m_currentMarker;
+
+    delete m_onlineIndex;
 }
 
 
@@ -165,8 +309,8 @@ int DRC::Drc( ZONE_CONTAINER* aArea, int aCornerIndex )
 
 void DRC::RunTests( wxTextCtrl* aMessages )
 {
-    // Ensure ratsnest is up to date:
-    if( (m_pcb->m_Status_Pcb & LISTE_RATSNEST_ITEM_OK) == 0 )
+    // Ensure ratsnest is up to date (without a frame, see testUnconnected()):
+    if( m_mainWindow && (m_pcb->m_Status_Pcb & LISTE_RATSNEST_ITEM_OK) == 0 )
     {
         if( aMessages )
         {
@@ -194,6 +338,26 @@ void DRC::RunTests( wxTextCtrl* aMessages )
         return;
     }
 
+    // tracks, vias and pads are not modified by the tests below,
+    // so they can be indexed only once.
+    DRC_SPATIAL_INDEX spatialIndex;
+
+    spatialIndex.Build( m_pcb );
+    m_spatialIndex = &spatialIndex;
+
+    // Without a reporter from the caller, show the progress of the long tests
+    DRC_PROGRESS_DIALOG    progressDialog( m_mainWindow );
+    DRC_PROGRESS_REPORTER* callerReporter = m_progressReporter;
+
+    if( !m_progressReporter && m_mainWindow )
+        m_progressReporter = &progressDialog;
+
+    m_abortDRC = false;
+    m_drcInProgress = true;
+
+    // The track markers of this run replace the ones of the online tests
+    m_onlineMarkers.clear();
+
     // test pad to pad clearances, nothing to do with tracks, vias or zones.
     if( m_doPad2PadTest )
     {
@@ -207,36 +371,45 @@ void DRC::RunTests( wxTextCtrl* aMessages )
     }
 
     // test track and via clearances to other tracks, pads, and vias
-    if( aMessages )
+    if( !isAborted() )
     {
-        aMessages->AppendText( _( "Track clearances...\n" ) );
-        wxSafeYield();
-    }
+        if( aMessages )
+        {
+            aMessages->AppendText( _( "Track clearances...\n" ) );
+            wxSafeYield();
+        }
 
-    testTracks( true );
+        testTracks();
+    }
 
-    // Before testing segments and unconnected, refill all zones:
-    // this is a good caution, because filled areas can be outdated.
-    if( aMessages )
+    // The remaining tests are skipped if the user has cancelled the DRC
+    if( !isAborted() )
     {
-        aMessages->AppendText( _( "Fill zones...\n" ) );
-        wxSafeYield();
-    }
+        // Before testing segments and unconnected, refill all zones:
+        // this is a good caution, because filled areas can be outdated.
+        if( aMessages )
+        {
+            aMessages->AppendText( _( "Fill zones...\n" ) );
+            wxSafeYield();
+        }
 
-    m_mainWindow->Fill_All_Zones( aMessages ? aMessages->GetParent() : m_mainWindow,
-                                  false );
+        if( m_mainWindow )
+            m_mainWindow->Fill_All_Zones( aMessages ? aMessages->GetParent() : m_mainWindow );
+        else
+            m_pcb->FillAllZones();
 
-    // test zone clearances to other zones
-    if( aMessages )
-    {
-        aMessages->AppendText( _( "Test zones...\n" ) );
-        wxSafeYield();
-    }
+        // test zone clearances to other zones
+        if( aMessages )
+        {
+            aMessages->AppendText( _( "Test zones...\n" ) );
+            wxSafeYield();
+        }
 
-    testZones();
+        testZones();
+    }
 
     // find and gather unconnected pads.
-    if( m_doUnconnectedTest )
+    if( m_doUnconnectedTest && !isAborted() )
     {
         if( aMessages )
         {
@@ -248,7 +421,7 @@ void DRC::RunTests( wxTextCtrl* aMessages )
     }
 
     // find and gather vias, tracks, pads inside keepout areas.
-    if( m_doKeepoutTest )
+    if( m_doKeepoutTest && !isAborted() )
     {
         if( aMessages )
         {
@@ -259,6 +432,10 @@ void DRC::RunTests( wxTextCtrl* aMessages )
         testKeepoutAreas();
     }
 
+    m_spatialIndex = NULL;
+    m_progressReporter = callerReporter;
+    m_drcInProgress = false;
+
     // update the m_ui listboxes
     updatePointers();
 
@@ -283,7 +460,8 @@ void DRC::ListUnconnectedPads()
 void DRC::updatePointers()
 {
     // update my pointers, m_mainWindow is the only unchangeable one
-    m_pcb = m_mainWindow->GetBoard();
+    if( m_mainWindow )
+        m_pcb = m_mainWindow->GetBoard();
 
     if( m_ui )  // Use diag list boxes only in DRC dialog
     {
@@ -434,76 +612,195 @@ void DRC::testPad2Pad()
     }
 
     // Test the pads
-    D_PAD** listEnd = &sortedPads[ sortedPads.size() ];
+    const int padCount = sortedPads.size();
 
-    for( unsigned i = 0; i< sortedPads.size(); ++i )
-    {
-        D_PAD* pad = sortedPads[i];
+    if( padCount == 0 )
+        return;
+
+    D_PAD** listEnd = &sortedPads[0] + padCount;
+
+    // One marker slot per pad, so the markers can be added in the pad order
+    // whatever the thread which found them.
+    std::vector<MARKER_PCB*> markers( padCount, (MARKER_PCB*) NULL );
+    int done = 0;
+
+    reportProgress( _( "Pad clearances" ), 0, padCount );
 
-        int    x_limit = max_size + pad->GetClearance() +
-                         pad->GetBoundingRadius() + pad->GetPosition().x;
+#ifdef USE_OPENMP
+    #pragma omp parallel shared( sortedPads, markers, done )
+#endif /* USE_OPENMP */
+    {
+        DRC worker( *this, WORKER );
 
-        if( !doPadToPadsDrc( pad, &sortedPads[i], listEnd, x_limit ) )
+#ifdef USE_OPENMP
+        #pragma omp for schedule( dynamic, 64 )
+#endif /* USE_OPENMP */
+        for( int i = 0; i < padCount; ++i )
         {
-            wxASSERT( m_currentMarker );
-            m_pcb->Add( m_currentMarker );
-            m_currentMarker = 0;
+            if( isAborted() )
+                continue;   // an OpenMP loop cannot be left with break
+
+            D_PAD* pad = sortedPads[i];
+
+            int    x_limit = max_size + pad->GetClearance() +
+                             pad->GetBoundingRadius() + pad->GetPosition().x;
+
+            if( !worker.doPadToPadsDrc( pad, &sortedPads[i], listEnd, x_limit ) )
+            {
+                wxASSERT( worker.m_currentMarker );
+                markers[i] = worker.m_currentMarker;
+                worker.m_currentMarker = 0;
+            }
+
+#ifdef USE_OPENMP
+            #pragma omp atomic
+#endif /* USE_OPENMP */
+            done++;
+
+            if( isMainThread() && ( i % 256 ) == 0 )
+                reportProgress( _( "Pad clearances" ), done, padCount );
         }
     }
+
+    for( int i = 0; i < padCount; ++i )
+    {
+        if( markers[i] )
+            m_pcb->Add( markers[i] );
+    }
 }
 
 
-void DRC::testTracks( bool aShowProgressBar )
+void DRC::testTracks()
 {
-    wxProgressDialog * progressDialog = NULL;
-    const int delta = 500;  // This is the number of tests between 2 calls to the
-                            // progress bar
-    int count = 0;
-    for( TRACK* segm = m_pcb->m_Track; segm && segm->Next(); segm = segm->Next() )
-        count++;
+    // The last segment has nothing left to be compared to, as in the legacy walk
+    const int count = m_spatialIndex->GetTrackCount() - 1;
 
-    int deltamax = count/delta;
+    if( count <= 0 )
+        return;
 
-    if( aShowProgressBar && deltamax > 3 )
-    {
-        progressDialog = new wxProgressDialog( _( "Track clearances" ), wxEmptyString,
-                                               deltamax, m_mainWindow,
-                                               wxPD_AUTO_HIDE | wxPD_CAN_ABORT );
-        progressDialog->Update( 0, wxEmptyString );
-    }
+    // Neighbour tracks are given to the same thread, see GetTrackOrdinalsByTile()
+    std::vector<int> workOrder;
+    m_spatialIndex->GetTrackOrdinalsByTile( Millimeter2iu( 5 ), workOrder );
+
+    // One marker slot per track, so the markers can be added in m_Track order
+    // whatever the thread which found them.
+    std::vector<MARKER_PCB*> markers( count, (MARKER_PCB*) NULL );
+    int done = 0;
+    int mismatches = 0;
 
-    int ii = 0;
-    count = 0;
+    reportProgress( _( "Track clearances" ), 0, count );
 
-    for( TRACK* segm = m_pcb->m_Track; segm && segm->Next(); segm = segm->Next() )
+#ifdef USE_OPENMP
+    #pragma omp parallel shared( workOrder, markers, done, mismatches )
+#endif /* USE_OPENMP */
     {
-        if ( ii++ > delta )
+        DRC worker( *this, WORKER );
+
+#ifdef USE_OPENMP
+        #pragma omp for schedule( dynamic, 64 )
+#endif /* USE_OPENMP */
+        for( int ii = 0; ii < (int) workOrder.size(); ++ii )
         {
-            ii = 0;
-            count++;
+            int ordinal = workOrder[ii];
+
+            if( isAborted() || ordinal >= count )
+                continue;   // an OpenMP loop cannot be left with break
+
+            TRACK* segm = m_spatialIndex->GetTrack( ordinal );
+            bool   ok   = worker.doTrackDrc( segm, ordinal, *m_spatialIndex );
+
+            if( m_doLegacyCrossCheck && !worker.crossCheckTrackDrc( segm, ok ) )
+            {
+#ifdef USE_OPENMP
+                #pragma omp atomic
+#endif /* USE_OPENMP */
+                mismatches++;
+            }
 
-            if( progressDialog )
+            if( !ok )
             {
-                if( !progressDialog->Update( count, wxEmptyString ) )
-                    break;  // Aborted by user
+                wxASSERT( worker.m_currentMarker );
+                markers[ordinal] = worker.m_currentMarker;
+                worker.m_currentMarker = 0;
             }
+
+#ifdef USE_OPENMP
+            #pragma omp atomic
+#endif /* USE_OPENMP */
+            done++;
+
+            if( isMainThread() && ( ii % 256 ) == 0 )
+                reportProgress( _( "Track clearances" ), done, count );
         }
+    }
 
-        if( !doTrackDrc( segm, segm->Next(), true ) )
+    for( int ordinal = 0; ordinal < count; ++ordinal )
+    {
+        if( markers[ordinal] )
         {
-            wxASSERT( m_currentMarker );
-            m_pcb->Add( m_currentMarker );
-            m_currentMarker = 0;
+            m_pcb->Add( markers[ordinal] );
+
+            if( m_onlineIndex )
+                m_onlineMarkers[ m_spatialIndex->GetTrack( ordinal ) ] = markers[ordinal];
         }
     }
 
-    if( progressDialog )
-        progressDialog->Destroy();
+    if( mismatches )
+        wxLogWarning( wxT( "DRC cross check: %d track(s) differ from the legacy test" ),
+                      mismatches );
+}
+
+
+void DRC::reportProgress( const wxString& aTitle, int aDone, int aTotal )
+{
+    if( m_progressReporter && !m_progressReporter->Report( aTitle, aDone, aTotal ) )
+        setAborted();
+}
+
+
+bool DRC::crossCheckTrackDrc( TRACK* aRefSeg, bool aIndexedResult )
+{
+    // Keep the marker created by the indexed test, if any
+    MARKER_PCB* indexedMarker = m_currentMarker;
+    m_currentMarker = NULL;
+
+    bool legacyResult = doTrackDrc( aRefSeg, aRefSeg->Next(), true );
+    bool same = ( legacyResult == aIndexedResult );
+
+    if( same && !legacyResult )
+    {
+        const DRC_ITEM& legacy  = m_currentMarker->GetReporter();
+        const DRC_ITEM& indexed = indexedMarker->GetReporter();
+
+        same = legacy.GetErrorCode() == indexed.GetErrorCode()
+               && legacy.GetTextB() == indexed.GetTextB()
+               && legacy.GetPointB() == indexed.GetPointB();
+    }
+
+    if( !same )
+    {
+        wxLogDebug( wxT( "DRC cross check: %s: legacy error %d, indexed error %d" ),
+                    GetChars( aRefSeg->GetSelectMenuText() ),
+                    legacyResult ? 0 : m_currentMarker->GetReporter().GetErrorCode(),
+                    aIndexedResult ? 0 : indexedMarker->GetReporter().GetErrorCode() );
+    }
+
+    delete m_currentMarker;
+    m_currentMarker = indexedMarker;
+
+    return same;
 }
 
 
 void DRC::testUnconnected()
 {
+    // The legacy ratsnest can only be built by the frame
+    if( !m_mainWindow )
+    {
+        testRatsnestUnconnected();
+        return;
+    }
+
     if( (m_pcb->m_Status_Pcb & LISTE_RATSNEST_ITEM_OK) == 0 )
     {
         wxClientDC dc( m_mainWindow->GetCanvas() );
@@ -536,6 +833,71 @@ void DRC::testUnconnected()
 }
 
 
+void DRC::testRatsnestUnconnected()
+{
+    RN_DATA* ratsnest = m_pcb->GetRatsnest();
+
+    ratsnest->ProcessBoard();
+    ratsnest->Recalculate();
+
+    // The pads found at the ends of the unconnected links, to report them by name
+    typedef std::map<const RN_NODE*, D_PAD*> PAD_NODES;
+    PAD_NODES padNodes;
+
+    for( MODULE* module = m_pcb->m_Modules; module; module = module->Next() )
+    {
+        for( D_PAD* pad = module->Pads(); pad; pad = pad->Next() )
+        {
+            int netCode = pad->GetNetCode();
+
+            // net 0 is the "not connected" net, it is not handled by the ratsnest
+            if( netCode <= 0 || netCode >= ratsnest->GetNetCount() )
+                continue;
+
+            std::list<RN_NODE_PTR> nodes = ratsnest->GetNet( netCode ).GetNodes( pad );
+
+            BOOST_FOREACH( const RN_NODE_PTR& node, nodes )
+                padNodes[node.get()] = pad;
+        }
+    }
+
+    wxString netMsg;
+
+    for( int netCode = 1; netCode < ratsnest->GetNetCount(); ++netCode )
+    {
+        const std::vector<RN_EDGE_PTR>* edges = ratsnest->GetNet( netCode ).GetUnconnected();
+
+        if( !edges || edges->empty() )
+            continue;
+
+        NETINFO_ITEM* net = m_pcb->FindNet( netCode );
+
+        netMsg = net ? net->GetNetname() : wxString();
+
+        for( unsigned ii = 0; ii < edges->size(); ++ii )
+        {
+            const RN_NODE_PTR& start = (*edges)[ii]->getSourceNode();
+            const RN_NODE_PTR& end   = (*edges)[ii]->getTargetNode();
+
+            PAD_NODES::const_iterator padStart = padNodes.find( start.get() );
+            PAD_NODES::const_iterator padEnd   = padNodes.find( end.get() );
+
+            wxString msgStart = ( padStart != padNodes.end() ) ?
+                                padStart->second->GetSelectMenuText() + wxT( " net " ) + netMsg :
+                                wxT( "Net " ) + netMsg;
+            wxString msgEnd = ( padEnd != padNodes.end() ) ?
+                              padEnd->second->GetSelectMenuText() : wxT( "Net " ) + netMsg;
+
+            DRC_ITEM* uncItem = new DRC_ITEM( DRCE_UNCONNECTED_PADS, msgStart, msgEnd,
+                                              wxPoint( start->GetX(), start->GetY() ),
+                                              wxPoint( end->GetX(), end->GetY() ) );
+
+            m_unconnected.push_back( uncItem );
+        }
+    }
+}
+
+
 void DRC::testZones()
 {
     // Test copper areas for valid netcodes
@@ -573,8 +935,17 @@ void DRC::testKeepoutAreas()
         if( !area->GetIsKeepout() )
             continue;
 
-        for( TRACK* segm = m_pcb->m_Track; segm != NULL; segm = segm->Next() )
+        // Only the items crossing the area bounding box can be inside the area
+        EDA_RECT bbox = area->GetBoundingBox();
+        std::vector<int> candidates;
+
+        m_spatialIndex->QueryTracks( bbox.GetOrigin(), bbox.GetEnd(),
+                                     GetLayerMask( area->GetLayer() ), candidates );
+
+        for( unsigned jj = 0; jj < candidates.size(); ++jj )
         {
+            TRACK* segm = m_spatialIndex->GetTrack( candidates[jj] );
+
             if( segm->Type() == PCB_TRACE_T )
             {
                 if( ! area->GetDoNotAllowTracks()  )
@@ -0,0 +1,308 @@
+/**
+ * @file drc_online.cpp
+ * @brief DRC of the tracks and vias changed by the last edits.
+ */
+
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/* The online DRC keeps a DRC_SPATIAL_INDEX of the board between edits.  The edit
+ * commands already give their changed items to the undo list, which tells the DRC
+ * (see OnlineItemsChanged()), then PCB_EDIT_FRAME::OnModify() runs the tests.
+ * An item changed is removed from the index, using the area it had when it was
+ * indexed, then added again if it is still on the board.  The tracks found near
+ * its old and new areas are the only ones which can have a different result:
+ * they are tested again, exactly like testTracks() does, and their markers are
+ * replaced.
+ * An added item gets a new ordinal, but a full DRC tests a pair of tracks from
+ * the first one in BOARD::m_Track: the ranks of the index are updated before the
+ * tests, so the pair is tested from the same track, and gives the same marker.
+ */
+
+#include <fctsys.h>
+#include <algorithm>
+#include <wxPcbStruct.h>
+#include <class_undoredo_container.h>
+
+#include <class_board.h>
+#include <class_module.h>
+#include <class_track.h>
+#include <class_marker_pcb.h>
+
+#include <drc_stuff.h>
+#include <drc_spatial_index.h>
+
+
+void DRC::StartOnlineTests()
+{
+    updatePointers();
+
+    delete m_onlineIndex;
+    m_onlineIndex = new DRC_SPATIAL_INDEX();
+    m_onlineBoard = m_pcb;
+    m_onlineRulesChanged = false;
+
+    // The markers of a previous session are now ordinary markers of the board,
+    // which can even have been deleted with it.
+    m_onlineMarkers.clear();
+    m_onlineChanges.clear();
+
+    buildOnlineIndex();
+
+    std::vector<int> ordinals( m_onlineIndex->GetTrackCount() );
+
+    for( unsigned ii = 0; ii < ordinals.size(); ++ii )
+        ordinals[ii] = ii;
+
+    testOnlineTracks( ordinals );
+}
+
+
+void DRC::StopOnlineTests()
+{
+    delete m_onlineIndex;
+    m_onlineIndex = NULL;
+    m_onlineBoard = NULL;
+
+    m_onlineMarkers.clear();
+    m_onlineChanges.clear();
+}
+
+
+void DRC::buildOnlineIndex()
+{
+    wxPoint bmin, bmax;
+
+    m_onlineIndex->Clear();
+
+    for( TRACK* track = m_pcb->m_Track; track; track = track->Next() )
+        m_onlineIndex->AddTrack( track );
+
+    for( MODULE* module = m_pcb->m_Modules; module; module = module->Next() )
+        m_onlineIndex->AddModule( module, bmin, bmax );
+}
+
+
+void DRC::OnlineItemsChanged( const PICKED_ITEMS_LIST& aItems )
+{
+    if( !m_onlineIndex )
+        return;
+
+    for( unsigned ii = 0; ii < aItems.GetCount(); ++ii )
+        m_onlineChanges.insert( (BOARD_ITEM*) aItems.GetPickedItem( ii ) );
+}
+
+
+void DRC::RunOnlineTests()
+{
+    if( !m_onlineIndex || m_drcInProgress )
+        return;
+
+    BOARD* board = m_mainWindow ? m_mainWindow->GetBoard() : m_pcb;
+
+    // New clearances can change the result of any test
+    if( board != m_onlineBoard || m_onlineRulesChanged )
+    {
+        StartOnlineTests();
+        return;
+    }
+
+    if( m_onlineChanges.empty() )
+        return;
+
+    forgetDeletedOnlineMarkers();
+
+    // The deleted items can have been freed with the undo list since they changed:
+    // only the items found on the board are read, the others are only looked for
+    // in the index.
+    std::vector<TRACK*>  changedTracks;
+    std::vector<MODULE*> changedModules;
+
+    for( TRACK* track = m_pcb->m_Track; track; track = track->Next() )
+    {
+        if( m_onlineChanges.count( track ) )
+            changedTracks.push_back( track );
+    }
+
+    for( MODULE* module = m_pcb->m_Modules; module; module = module->Next() )
+    {
+        if( m_onlineChanges.count( module ) )
+            changedModules.push_back( module );
+    }
+
+    // The areas where the tracks must be tested again
+    std::vector< std::pair<wxPoint, wxPoint> > areas;
+    wxPoint bmin, bmax;
+
+    for( std::set<BOARD_ITEM*>::iterator it = m_onlineChanges.begin();
+         it != m_onlineChanges.end(); ++it )
+    {
+        if( m_onlineIndex->RemoveTrack( *it, bmin, bmax ) )
+            areas.push_back( std::make_pair( bmin, bmax ) );
+
+        if( m_onlineIndex->RemoveModule( *it, bmin, bmax ) )
+            areas.push_back( std::make_pair( bmin, bmax ) );
+
+        removeOnlineMarker( *it );
+    }
+
+    m_onlineChanges.clear();
+
+    for( unsigned ii = 0; ii < changedTracks.size(); ++ii )
+    {
+        m_onlineIndex->AddTrack( changedTracks[ii] );
+        DRC_SPATIAL_INDEX::ItemArea( changedTracks[ii], bmin, bmax );
+        areas.push_back( std::make_pair( bmin, bmax ) );
+    }
+
+    for( unsigned ii = 0; ii < changedModules.size(); ++ii )
+    {
+        if( m_onlineIndex->AddModule( changedModules[ii], bmin, bmax ) )
+            areas.push_back( std::make_pair( bmin, bmax ) );
+    }
+
+    // Some commands do not use the undo list, e.g. a netlist read: when the index
+    // does not match the board any more, start again.
+    if( m_onlineIndex->GetIndexedTrackCount() != (int) m_pcb->m_Track.GetCount()
+        || m_onlineIndex->GetIndexedModuleCount() != (int) m_pcb->m_Modules.GetCount() )
+    {
+        StartOnlineTests();
+        return;
+    }
+
+    // The ordinals of the removed items are not given again: the index is built
+    // again once they are more than its items.  The areas found above stay valid.
+    if( m_onlineIndex->GetRemovedCount() > std::max( 1024, m_onlineIndex->GetIndexedTrackCount() ) )
+        buildOnlineIndex();
+    else
+        m_onlineIndex->UpdateRanks( m_pcb );
+
+    // Collect the tracks close enough to a changed item to be in conflict with it
+    int margin = m_onlineIndex->GetMaxClearance() + 1;
+    std::vector<int> found;
+    std::vector<int> ordinals;
+
+    for( unsigned ii = 0; ii < areas.size(); ++ii )
+    {
+        m_onlineIndex->QueryTracks( areas[ii].first - wxPoint( margin, margin ),
+                                    areas[ii].second + wxPoint( margin, margin ),
+                                    ALL_CU_LAYERS, found );
+
+        ordinals.insert( ordinals.end(), found.begin(), found.end() );
+    }
+
+    std::sort( ordinals.begin(), ordinals.end() );
+    ordinals.erase( std::unique( ordinals.begin(), ordinals.end() ), ordinals.end() );
+
+    testOnlineTracks( ordinals );
+
+    // update the m_ui listboxes
+    updatePointers();
+}
+
+
+void DRC::testOnlineTracks( const std::vector<int>& aOrdinals )
+{
+    // One marker slot per track, as in testTracks()
+    std::vector<MARKER_PCB*> markers( aOrdinals.size(), (MARKER_PCB*) NULL );
+
+    // The last track of m_Track has nothing left to be compared to, and is not
+    // tested by testTracks() either.
+    const int lastRank = m_onlineIndex->GetIndexedTrackCount() - 1;
+
+#ifdef USE_OPENMP
+    #pragma omp parallel shared( markers )
+#endif /* USE_OPENMP */
+    {
+        DRC worker( *this, WORKER );
+
+#ifdef USE_OPENMP
+        #pragma omp for schedule( dynamic, 64 )
+#endif /* USE_OPENMP */
+        for( int ii = 0; ii < (int) aOrdinals.size(); ++ii )
+        {
+            TRACK* segm = m_onlineIndex->GetTrack( aOrdinals[ii] );
+
+            if( m_onlineIndex->GetTrackRank( aOrdinals[ii] ) >= lastRank )
+                continue;
+
+            if( !worker.doTrackDrc( segm, aOrdinals[ii], *m_onlineIndex ) )
+            {
+                wxASSERT( worker.m_currentMarker );
+                markers[ii] = worker.m_currentMarker;
+                worker.m_currentMarker = 0;
+            }
+        }
+    }
+
+    for( unsigned ii = 0; ii < aOrdinals.size(); ++ii )
+    {
+        TRACK* segm = m_onlineIndex->GetTrack( aOrdinals[ii] );
+
+        removeOnlineMarker( segm );
+
+        if( markers[ii] )
+        {
+            m_pcb->Add( markers[ii] );
+            m_onlineMarkers[segm] = markers[ii];
+        }
+    }
+}
+
+
+void DRC::forgetDeletedOnlineMarkers()
+{
+    std::set<MARKER_PCB*> boardMarkers;
+
+    for( int ii = 0; ii < m_pcb->GetMARKERCount(); ++ii )
+        boardMarkers.insert( m_pcb->GetMARKER( ii ) );
+
+    std::map<const BOARD_ITEM*, MARKER_PCB*>::iterator it = m_onlineMarkers.begin();
+
+    while( it != m_onlineMarkers.end() )
+    {
+        if( boardMarkers.count( it->second ) )
+            ++it;
+        else
+            m_onlineMarkers.erase( it++ );
+    }
+}
+
+
+void DRC::removeOnlineMarker( const BOARD_ITEM* aItem )
+{
+    std::map<const BOARD_ITEM*, MARKER_PCB*>::iterator it = m_onlineMarkers.find( aItem );
+
+    if( it == m_onlineMarkers.end() )
+        return;
+
+    MARKER_PCB* marker = it->second;
+
+    m_onlineMarkers.erase( it );
+
+    if( m_mainWindow && m_mainWindow->GetCurItem() == marker )
+        m_mainWindow->SetCurItem( NULL );
+
+    m_pcb->Remove( marker );
+    delete marker;
+}
@@ -0,0 +1,310 @@
+/**
+ * @file drc_online_test.cpp
+ * @brief checks that the online DRC gives the markers of a full DRC after edits.
+ */
+
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/*
+    Usage: drc_online_test [--edits=<n>] <board file> ...
+
+        --edits=<n>     count of edits of each board, 50 by default
+
+    Each board is edited as the edit commands do, one item after the other:
+    a track is moved over a track of another net, moved and put again in
+    BOARD::m_Track as an undo does, copied over another track, or deleted.
+    After each edit, the changed item is given to the online DRC, then the
+    markers it gives are compared to the ones of a full DRC of the board.
+    Only the track clearances are tested, since the online DRC only tests them.
+
+    The exit code is 1 if a marker differs, or if a board cannot be loaded.
+
+    e.g. drc_online_test ../demos/video/video.kicad_pcb ../demos/pic_programmer/pic_programmer.kicad_pcb
+*/
+
+
+#include <fctsys.h>
+#include <algorithm>
+#include <iterator>
+#include <wx/init.h>
+#include <wx/filename.h>
+
+#include <macros.h>
+#include <common.h>
+#include <kiway.h>
+#include <pgm_base.h>
+#include <wildcards_and_files_ext.h>
+#include <class_undoredo_container.h>
+
+#include <io_mgr.h>
+#include <class_board.h>
+#include <class_track.h>
+#include <class_marker_pcb.h>
+#include <drc_stuff.h>
+
+
+/**
+ * Struct PGM_DRC_ONLINE_TEST
+ * implements PGM_BASE for this tool, which has no wxApp, like pcbnew_drc does.
+ */
+static struct PGM_DRC_ONLINE_TEST : public PGM_BASE
+{
+    bool OnPgmInit( wxApp* aWxApp ) { return true; }
+    void OnPgmExit()                { }
+    void MacOpenFile( const wxString& aFileName ) { }
+} program;
+
+
+static void usage()
+{
+    fprintf( stderr, "usage: drc_online_test [--edits=<n>] <board file> ...\n" );
+}
+
+
+/// @return the reports of the markers of aBoard, sorted
+static std::vector<wxString> markerReports( BOARD* aBoard )
+{
+    std::vector<wxString> reports;
+
+    for( int ii = 0; ii < aBoard->GetMARKERCount(); ++ii )
+        reports.push_back( aBoard->GetMARKER( ii )->GetReporter().ShowReport() );
+
+    std::sort( reports.begin(), reports.end() );
+
+    return reports;
+}
+
+
+/**
+ * Function compareReports
+ * prints the reports found only in one of the lists.
+ * @return the number of these reports.
+ */
+static int compareReports( const std::vector<wxString>& aOnline,
+                           const std::vector<wxString>& aFull )
+{
+    std::vector<wxString> onlineOnly;
+    std::vector<wxString> fullOnly;
+
+    std::set_difference( aOnline.begin(), aOnline.end(), aFull.begin(), aFull.end(),
+                         std::back_inserter( onlineOnly ) );
+    std::set_difference( aFull.begin(), aFull.end(), aOnline.begin(), aOnline.end(),
+                         std::back_inserter( fullOnly ) );
+
+    for( unsigned ii = 0; ii < onlineOnly.size(); ++ii )
+        printf( "    online DRC only: %s", TO_UTF8( onlineOnly[ii] ) );
+
+    for( unsigned ii = 0; ii < fullOnly.size(); ++ii )
+        printf( "    full DRC only: %s", TO_UTF8( fullOnly[ii] ) );
+
+    return onlineOnly.size() + fullOnly.size();
+}
+
+
+/**
+ * Function editBoard
+ * makes the edit number aEdit of aBoard, and gives its changed item to aChanges.
+ * @param aDeleted receives the deleted items, which are owned by the undo list in pcbnew.
+ */
+static void editBoard( BOARD* aBoard, int aEdit, PICKED_ITEMS_LIST& aChanges,
+                       std::vector<TRACK*>& aDeleted )
+{
+    std::vector<TRACK*> tracks;
+
+    for( TRACK* track = aBoard->m_Track; track; track = track->Next() )
+        tracks.push_back( track );
+
+    TRACK* track = tracks[ ( aEdit * 7919 ) % tracks.size() ];
+    TRACK* other = tracks[ ( aEdit * 104729 + tracks.size() / 2 ) % tracks.size() ];
+
+    // Put the middle of track over the middle of other: if both are on the same
+    // layer and not of the same net, this is a clearance error for one of them.
+    wxPoint offset = ( other->GetStart() + other->GetEnd() ) / 2
+                     - ( track->GetStart() + track->GetEnd() ) / 2;
+
+    switch( aEdit % 4 )
+    {
+    case 0:     // a move
+        track->Move( offset );
+        aChanges.PushItem( ITEM_PICKER( track, UR_CHANGED ) );
+        break;
+
+    case 1:     // a move, then the track is put again in the list, as by an undo
+        aBoard->Remove( track );
+        track->Move( offset );
+        aBoard->Add( track );
+        aChanges.PushItem( ITEM_PICKER( track, UR_CHANGED ) );
+        break;
+
+    case 2:     // a copy
+        track = (TRACK*) track->Clone();
+        track->Move( offset );
+        aBoard->Add( track );
+        aChanges.PushItem( ITEM_PICKER( track, UR_NEW ) );
+        break;
+
+    case 3:     // a deletion
+        aBoard->Remove( track );
+        aDeleted.push_back( track );
+        aChanges.PushItem( ITEM_PICKER( track, UR_DELETED ) );
+        break;
+    }
+}
+
+
+/**
+ * Function testBoard
+ * loads a board, then edits it and compares the online DRC markers to the full DRC ones.
+ * @return the number of differences, or -1 if the board cannot be loaded.
+ */
+static int testBoard( const wxString& aFileName, int aEdits )
+{
+    IO_MGR::PCB_FILE_T pluginType = IO_MGR::LEGACY;
+
+    if( wxFileName( aFileName ).GetExt() == KiCadPcbFileExtension )
+        pluginType = IO_MGR::KICAD;
+
+    BOARD* board = NULL;
+
+    try
+    {
+        board = IO_MGR::Load( pluginType, aFileName );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        fprintf( stderr, "drc_online_test: %s\n", TO_UTF8( ioe.errorText ) );
+        return -1;
+    }
+
+    if( !board )
+        return -1;
+
+    board->BuildListOfNets();
+    board->SynchronizeNetsAndNetClasses();
+
+    DRC drc( board );
+
+    drc.SetSettings( false, false, false, false, wxEmptyString, false );
+
+    // The online tests replace the track markers of a full DRC, and keep the others
+    drc.StartOnlineTests();
+    board->DeleteMARKERs();
+    drc.RunTests();
+
+    std::vector<TRACK*> deleted;
+    int differences = 0;
+    int edit;
+
+    for( edit = 0; edit < aEdits && board->m_Track.GetCount() > 2; ++edit )
+    {
+        PICKED_ITEMS_LIST changes;
+
+        editBoard( board, edit, changes, deleted );
+
+        drc.OnlineItemsChanged( changes );
+        drc.RunOnlineTests();
+
+        std::vector<wxString> online = markerReports( board );
+
+        // The full DRC gives its markers to the online tests too: the next edit
+        // starts from them.
+        board->DeleteMARKERs();
+        drc.RunTests();
+
+        std::vector<wxString> full = markerReports( board );
+
+        if( online != full )
+        {
+            printf( "  edit %d:\n", edit );
+            differences += compareReports( online, full );
+        }
+    }
+
+    printf( "%s: %d edits, %d marker differences\n",
+            TO_UTF8( wxFileName( aFileName ).GetFullName() ), edit, differences );
+
+    drc.StopOnlineTests();
+    delete board;
+
+    for( unsigned ii = 0; ii < deleted.size(); ++ii )
+        delete deleted[ii];
+
+    return differences;
+}
+
+
+int main( int argc, char** argv )
+{
+    wxInitializer initializer;
+
+    if( !initializer.IsOk() )
+    {
+        fprintf( stderr, "drc_online_test: cannot initialize wxWidgets\n" );
+        return 1;
+    }
+
+    int kifaceVersion;
+    KIFACE_GETTER( &kifaceVersion, KIFACE_VERSION, &program );
+
+    wxArrayString boardFiles;
+    long edits = 50;
+
+    for( int ii = 1; ii < argc; ++ii )
+    {
+        wxString arg = FROM_UTF8( argv[ii] );
+        wxString value;
+
+        if( arg.StartsWith( wxT( "--edits=" ), &value ) && value.ToLong( &edits ) && edits > 0 )
+            continue;
+
+        if( arg.StartsWith( wxT( "-" ) ) )
+        {
+            usage();
+            return 1;
+        }
+
+        boardFiles.Add( arg );
+    }
+
+    if( boardFiles.IsEmpty() )
+    {
+        usage();
+        return 1;
+    }
+
+    int errors = 0;
+
+    for( unsigned ii = 0; ii < boardFiles.GetCount(); ++ii )
+    {
+        int differences = testBoard( boardFiles[ii], edits );
+
+        if( differences < 0 )
+            fprintf( stderr, "drc_online_test: cannot load %s\n", TO_UTF8( boardFiles[ii] ) );
+
+        if( differences != 0 )
+            ++errors;
+    }
+
+    return errors ? 1 : 0;
+}
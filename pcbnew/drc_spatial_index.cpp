@@ -0,0 +1,449 @@
+/**
+ * @file drc_spatial_index.cpp
+ */
+
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#include <fctsys.h>
+#include <algorithm>
+
+#include <class_board.h>
+#include <class_track.h>
+#include <class_pad.h>
+#include <class_module.h>
+
+#include <drc_spatial_index.h>
+
+
+/**
+ * Struct ORDINAL_COLLECTOR
+ * is the R-tree visitor used by the queries: it only records what it is given.
+ */
+struct ORDINAL_COLLECTOR
+{
+    std::vector<int>& m_result;
+
+    ORDINAL_COLLECTOR( std::vector<int>& aResult ) :
+        m_result( aResult )
+    {
+    }
+
+    bool operator()( intptr_t aOrdinal )
+    {
+        m_result.push_back( aOrdinal );
+        return true;    // continue the search
+    }
+};
+
+
+/**
+ * Struct RANK_LESS
+ * orders ordinals by their rank, then by ordinal, so the duplicates of an
+ * ordinal stay next to each other.
+ */
+struct RANK_LESS
+{
+    const std::vector<int>& m_ranks;
+
+    RANK_LESS( const std::vector<int>& aRanks ) :
+        m_ranks( aRanks )
+    {
+    }
+
+    bool operator()( int aFirst, int aSecond ) const
+    {
+        if( m_ranks[aFirst] != m_ranks[aSecond] )
+            return m_ranks[aFirst] < m_ranks[aSecond];
+
+        return aFirst < aSecond;
+    }
+};
+
+
+DRC_SPATIAL_INDEX::DRC_SPATIAL_INDEX()
+{
+    m_removedPadCount = 0;
+    m_maxClearance = 0;
+}
+
+
+DRC_SPATIAL_INDEX::~DRC_SPATIAL_INDEX()
+{
+}
+
+
+void DRC_SPATIAL_INDEX::Clear()
+{
+    for( int layer = FIRST_COPPER_LAYER; layer <= LAST_COPPER_LAYER; ++layer )
+        m_trackTrees[layer].RemoveAll();
+
+    m_padTree.RemoveAll();
+
+    m_tracks.clear();
+    m_trackAreas.clear();
+    m_trackRanks.clear();
+    m_pads.clear();
+    m_padAreas.clear();
+    m_padRanks.clear();
+
+    m_trackOrdinals.clear();
+    m_modulePads.clear();
+
+    m_removedPadCount = 0;
+    m_maxClearance = 0;
+}
+
+
+void DRC_SPATIAL_INDEX::Build( BOARD* aBoard )
+{
+    Clear();
+
+    for( TRACK* track = aBoard->m_Track; track; track = track->Next() )
+        AddTrack( track );
+
+    for( unsigned ii = 0; ii < aBoard->GetPadCount(); ++ii )
+        addPad( aBoard->GetPad( ii ) );
+
+    // Footprints without pads are known too, see GetIndexedModuleCount()
+    for( MODULE* module = aBoard->m_Modules; module; module = module->Next() )
+        m_modulePads[module];
+}
+
+
+int DRC_SPATIAL_INDEX::FindTrack( const TRACK* aTrack ) const
+{
+    std::map<const BOARD_ITEM*, int>::const_iterator it = m_trackOrdinals.find( aTrack );
+
+    return it == m_trackOrdinals.end() ? -1 : it->second;
+}
+
+
+int DRC_SPATIAL_INDEX::AddTrack( TRACK* aTrack )
+{
+    wxASSERT( m_trackOrdinals.find( aTrack ) == m_trackOrdinals.end() );
+
+    intptr_t  ordinal = m_tracks.size();
+    ITEM_AREA area;
+
+    ItemArea( aTrack, area.m_Min, area.m_Max );
+    area.m_Layers = aTrack->GetLayerMask() & ALL_CU_LAYERS;
+
+    m_tracks.push_back( aTrack );
+    m_trackAreas.push_back( area );
+    m_trackRanks.push_back( ordinal );
+    m_trackOrdinals[aTrack] = ordinal;
+
+    m_maxClearance = std::max( m_maxClearance, aTrack->GetClearance() );
+
+    const int mmin[2] = { area.m_Min.x, area.m_Min.y };
+    const int mmax[2] = { area.m_Max.x, area.m_Max.y };
+
+    for( int layer = FIRST_COPPER_LAYER; layer <= LAST_COPPER_LAYER; ++layer )
+    {
+        if( area.m_Layers & GetLayerMask( layer ) )
+            m_trackTrees[layer].Insert( mmin, mmax, ordinal );
+    }
+
+    return ordinal;
+}
+
+
+bool DRC_SPATIAL_INDEX::RemoveTrack( const BOARD_ITEM* aTrack, wxPoint& aMin, wxPoint& aMax )
+{
+    std::map<const BOARD_ITEM*, int>::iterator it = m_trackOrdinals.find( aTrack );
+
+    if( it == m_trackOrdinals.end() )
+        return false;
+
+    intptr_t         ordinal = it->second;
+    const ITEM_AREA& area = m_trackAreas[ordinal];
+
+    const int mmin[2] = { area.m_Min.x, area.m_Min.y };
+    const int mmax[2] = { area.m_Max.x, area.m_Max.y };
+
+    for( int layer = FIRST_COPPER_LAYER; layer <= LAST_COPPER_LAYER; ++layer )
+    {
+        if( area.m_Layers & GetLayerMask( layer ) )
+            m_trackTrees[layer].Remove( mmin, mmax, ordinal );
+    }
+
+    aMin = area.m_Min;
+    aMax = area.m_Max;
+
+    m_tracks[ordinal] = NULL;
+    m_trackOrdinals.erase( it );
+
+    // m_maxClearance is kept: it only has to be an upper bound.
+    return true;
+}
+
+
+bool DRC_SPATIAL_INDEX::AddModule( MODULE* aModule, wxPoint& aMin, wxPoint& aMax )
+{
+    // Register the footprint even if it has no pad
+    m_modulePads[aModule];
+
+    bool found = false;
+
+    for( D_PAD* pad = aModule->Pads(); pad; pad = pad->Next() )
+    {
+        const ITEM_AREA& area = m_padAreas[ addPad( pad ) ];
+
+        if( !found )
+        {
+            aMin  = area.m_Min;
+            aMax  = area.m_Max;
+            found = true;
+        }
+        else
+        {
+            aMin.x = std::min( aMin.x, area.m_Min.x );
+            aMin.y = std::min( aMin.y, area.m_Min.y );
+            aMax.x = std::max( aMax.x, area.m_Max.x );
+            aMax.y = std::max( aMax.y, area.m_Max.y );
+        }
+    }
+
+    return found;
+}
+
+
+bool DRC_SPATIAL_INDEX::RemoveModule( const BOARD_ITEM* aModule, wxPoint& aMin, wxPoint& aMax )
+{
+    std::map<const BOARD_ITEM*, std::vector<int> >::iterator it = m_modulePads.find( aModule );
+
+    if( it == m_modulePads.end() )
+        return false;
+
+    const std::vector<int>& ordinals = it->second;
+
+    for( unsigned ii = 0; ii < ordinals.size(); ++ii )
+    {
+        const ITEM_AREA& area = m_padAreas[ ordinals[ii] ];
+
+        if( ii == 0 )
+        {
+            aMin = area.m_Min;
+            aMax = area.m_Max;
+        }
+        else
+        {
+            aMin.x = std::min( aMin.x, area.m_Min.x );
+            aMin.y = std::min( aMin.y, area.m_Min.y );
+            aMax.x = std::max( aMax.x, area.m_Max.x );
+            aMax.y = std::max( aMax.y, area.m_Max.y );
+        }
+
+        removePad( ordinals[ii] );
+    }
+
+    bool found = !ordinals.empty();
+
+    m_modulePads.erase( it );
+
+    return found;
+}
+
+
+int DRC_SPATIAL_INDEX::addPad( D_PAD* aPad )
+{
+    intptr_t  ordinal = m_pads.size();
+    ITEM_AREA area;
+
+    ItemArea( aPad, area.m_Min, area.m_Max );
+    area.m_Layers = aPad->GetLayerMask();
+
+    m_pads.push_back( aPad );
+    m_padAreas.push_back( area );
+    m_padRanks.push_back( ordinal );
+    m_modulePads[ aPad->GetParent() ].push_back( ordinal );
+
+    m_maxClearance = std::max( m_maxClearance, aPad->GetClearance() );
+
+    const int mmin[2] = { area.m_Min.x, area.m_Min.y };
+    const int mmax[2] = { area.m_Max.x, area.m_Max.y };
+
+    m_padTree.Insert( mmin, mmax, ordinal );
+
+    return ordinal;
+}
+
+
+void DRC_SPATIAL_INDEX::removePad( int aOrdinal )
+{
+    const ITEM_AREA& area = m_padAreas[aOrdinal];
+
+    const int mmin[2] = { area.m_Min.x, area.m_Min.y };
+    const int mmax[2] = { area.m_Max.x, area.m_Max.y };
+
+    m_padTree.Remove( mmin, mmax, (intptr_t) aOrdinal );
+    m_pads[aOrdinal] = NULL;
+    m_removedPadCount++;
+}
+
+
+void DRC_SPATIAL_INDEX::QueryTracks( const wxPoint& aMin, const wxPoint& aMax,
+                                     LAYER_MSK aLayerMask, std::vector<int>& aResult )
+{
+    aResult.clear();
+
+    const int mmin[2] = { aMin.x, aMin.y };
+    const int mmax[2] = { aMax.x, aMax.y };
+
+    ORDINAL_COLLECTOR collector( aResult );
+    int layerCount = 0;
+
+    for( int layer = FIRST_COPPER_LAYER; layer <= LAST_COPPER_LAYER; ++layer )
+    {
+        if( aLayerMask & GetLayerMask( layer ) )
+        {
+            m_trackTrees[layer].Search( mmin, mmax, collector );
+            layerCount++;
+        }
+    }
+
+    std::sort( aResult.begin(), aResult.end(), RANK_LESS( m_trackRanks ) );
+
+    // Vias are found once per layer searched
+    if( layerCount > 1 )
+        aResult.erase( std::unique( aResult.begin(), aResult.end() ), aResult.end() );
+}
+
+
+void DRC_SPATIAL_INDEX::QueryPads( const wxPoint& aMin, const wxPoint& aMax,
+                                   std::vector<int>& aResult )
+{
+    aResult.clear();
+
+    const int mmin[2] = { aMin.x, aMin.y };
+    const int mmax[2] = { aMax.x, aMax.y };
+
+    ORDINAL_COLLECTOR collector( aResult );
+
+    m_padTree.Search( mmin, mmax, collector );
+
+    std::sort( aResult.begin(), aResult.end(), RANK_LESS( m_padRanks ) );
+}
+
+
+void DRC_SPATIAL_INDEX::UpdateRanks( BOARD* aBoard )
+{
+    int rank = 0;
+
+    for( TRACK* track = aBoard->m_Track; track; track = track->Next(), ++rank )
+    {
+        int ordinal = FindTrack( track );
+
+        if( ordinal >= 0 )
+            m_trackRanks[ordinal] = rank;
+    }
+
+    // The pads are only known by ordinal: find them by address
+    std::map<const D_PAD*, int> padOrdinals;
+    int padCount = aBoard->GetPadCount();
+
+    for( unsigned ii = 0; ii < m_pads.size(); ++ii )
+    {
+        if( m_pads[ii] )
+            padOrdinals[ m_pads[ii] ] = ii;
+
+        m_padRanks[ii] = padCount + ii;
+    }
+
+    for( int ii = 0; ii < padCount; ++ii )
+    {
+        std::map<const D_PAD*, int>::const_iterator it = padOrdinals.find( aBoard->GetPad( ii ) );
+
+        if( it != padOrdinals.end() )
+            m_padRanks[it->second] = ii;
+    }
+}
+
+
+void DRC_SPATIAL_INDEX::GetTrackOrdinalsByTile( int aTileSize, std::vector<int>& aResult ) const
+{
+    // sort key: tile row, tile column, then ordinal to keep the list order in a tile
+    std::vector< std::pair< std::pair<int, int>, int > > keys;
+
+    keys.reserve( m_tracks.size() );
+
+    for( unsigned ii = 0; ii < m_tracks.size(); ++ii )
+    {
+        if( !m_tracks[ii] )     // removed track
+            continue;
+
+        const wxPoint& pos = m_tracks[ii]->GetStart();
+
+        // Coordinates can be negative: use floor division for the tile numbers
+        int col = pos.x >= 0 ? pos.x / aTileSize : ( pos.x + 1 ) / aTileSize - 1;
+        int row = pos.y >= 0 ? pos.y / aTileSize : ( pos.y + 1 ) / aTileSize - 1;
+
+        keys.push_back( std::make_pair( std::make_pair( row, col ), (int) ii ) );
+    }
+
+    std::sort( keys.begin(), keys.end() );
+
+    aResult.resize( keys.size() );
+
+    for( unsigned ii = 0; ii < keys.size(); ++ii )
+        aResult[ii] = keys[ii].second;
+}
+
+
+void DRC_SPATIAL_INDEX::ItemArea( const TRACK* aTrack, wxPoint& aMin, wxPoint& aMax )
+{
+    // For a via, m_Width is the diameter and start == end
+    int radius = ( aTrack->GetWidth() + 1 ) / 2;
+
+    aMin.x = std::min( aTrack->GetStart().x, aTrack->GetEnd().x ) - radius;
+    aMin.y = std::min( aTrack->GetStart().y, aTrack->GetEnd().y ) - radius;
+    aMax.x = std::max( aTrack->GetStart().x, aTrack->GetEnd().x ) + radius;
+    aMax.y = std::max( aTrack->GetStart().y, aTrack->GetEnd().y ) + radius;
+}
+
+
+void DRC_SPATIAL_INDEX::ItemArea( D_PAD* aPad, wxPoint& aMin, wxPoint& aMax )
+{
+    // The pad shape is inside its bounding circle, centered on the shape position
+    wxPoint shapePos = aPad->ShapePos();
+    int     radius   = aPad->GetBoundingRadius();
+
+    aMin = wxPoint( shapePos.x - radius, shapePos.y - radius );
+    aMax = wxPoint( shapePos.x + radius, shapePos.y + radius );
+
+    // The hole is centered on the pad position, and can be bigger than the pad
+    // shape when the pad exists only on one layer.
+    const wxSize& drill = aPad->GetDrillSize();
+
+    if( drill.x > 0 )
+    {
+        wxPoint holePos = aPad->GetPosition();
+        int     holeRadius = ( std::max( drill.x, drill.y ) + 1 ) / 2;
+
+        aMin.x = std::min( aMin.x, holePos.x - holeRadius );
+        aMin.y = std::min( aMin.y, holePos.y - holeRadius );
+        aMax.x = std::max( aMax.x, holePos.x + holeRadius );
+        aMax.y = std::max( aMax.y, holePos.y + holeRadius );
+    }
+}
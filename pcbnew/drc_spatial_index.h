@@ -0,0 +1,258 @@
+/**
+ * @file drc_spatial_index.h
+ * @brief spatial lookup of tracks, vias and pads used by the DRC.
+ */
+
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+#ifndef DRC_SPATIAL_INDEX_H
+#define DRC_SPATIAL_INDEX_H
+
+#include <vector>
+#include <map>
+#include <stdint.h>
+
+#include <layers_id_colors_and_visibility.h>
+#include <geometry/rtree.h>
+
+class BOARD;
+class BOARD_ITEM;
+class TRACK;
+class D_PAD;
+class MODULE;
+
+
+/**
+ * Class DRC_SPATIAL_INDEX
+ * holds one R-tree per copper layer for the tracks and vias of a BOARD, and one
+ * R-tree for its pads.  Items are stored by their ordinal, i.e. their order of
+ * insertion, and each ordinal has a rank, i.e. the position of the item in
+ * BOARD::m_Track or in the BOARD pad list.  Query results are sorted by rank, so
+ * they can be walked in the same order as the legacy list walks, and the DRC
+ * reports the same first error for a given item.
+ * The index does not own the items.  It can be kept in sync with the board by
+ * removing and adding again the tracks and footprints which are changed: the
+ * ordinal of a removed item is not reused, and an added item gets a new ordinal
+ * after all the others.  UpdateRanks() must then be called to find the ranks
+ * of the items in the board lists again.
+ */
+class DRC_SPATIAL_INDEX
+{
+public:
+    DRC_SPATIAL_INDEX();
+    ~DRC_SPATIAL_INDEX();
+
+    /**
+     * Function Build
+     * clears the index, then inserts all tracks, vias and pads of \a aBoard.
+     */
+    void Build( BOARD* aBoard );
+
+    /**
+     * Function Clear
+     * removes all items from the index.
+     */
+    void Clear();
+
+    /**
+     * Function GetMaxClearance
+     * @return the largest clearance found among the indexed items.  Because the
+     * clearance between two items is the larger of their own clearances, this is
+     * an upper bound for any clearance the DRC can ask for.
+     */
+    int GetMaxClearance() const { return m_maxClearance; }
+
+    /**
+     * Function GetTrackCount
+     * @return the number of track ordinals given, including the ordinals of the
+     * removed tracks, for which GetTrack() returns NULL.
+     */
+    int GetTrackCount() const { return m_tracks.size(); }
+    TRACK* GetTrack( int aOrdinal ) const { return m_tracks[aOrdinal]; }
+
+    /// @return the number of tracks and vias currently in the index.
+    int GetIndexedTrackCount() const { return m_trackOrdinals.size(); }
+
+    /// @return the number of footprints whose pads are currently in the index.
+    int GetIndexedModuleCount() const { return m_modulePads.size(); }
+
+    /**
+     * Function GetRemovedCount
+     * @return the number of ordinals of removed tracks and pads, which are never
+     * given again: the index should be built again when it is large.
+     */
+    int GetRemovedCount() const
+    {
+        return m_tracks.size() - m_trackOrdinals.size() + m_removedPadCount;
+    }
+
+    int GetPadCount() const { return m_pads.size(); }
+    D_PAD* GetPad( int aOrdinal ) const { return m_pads[aOrdinal]; }
+
+    /// @return the rank in BOARD::m_Track of the track of ordinal \a aOrdinal
+    int GetTrackRank( int aOrdinal ) const { return m_trackRanks[aOrdinal]; }
+
+    /// @return the rank in the BOARD pad list of the pad of ordinal \a aOrdinal
+    int GetPadRank( int aOrdinal ) const { return m_padRanks[aOrdinal]; }
+
+    /**
+     * Function UpdateRanks
+     * finds the rank of each indexed track in the track list of \a aBoard, and the
+     * rank of each indexed pad in its pad list.  An item is given the rank of its
+     * ordinal when it is added, so this is only needed once items are added after
+     * Build(): the edits move items in the board lists, and an added item has
+     * no reason to be the last one there.
+     * A pad missing from the pad list of the board is ranked after all the others.
+     */
+    void UpdateRanks( BOARD* aBoard );
+
+    /**
+     * Function FindTrack
+     * @return the ordinal of \a aTrack, or -1 if it is not in the index.
+     */
+    int FindTrack( const TRACK* aTrack ) const;
+
+    /**
+     * Function AddTrack
+     * inserts a track or a via in the index, with a new ordinal.
+     * @return the ordinal of aTrack.
+     */
+    int AddTrack( TRACK* aTrack );
+
+    /**
+     * Function RemoveTrack
+     * removes a track or a via from the index.  aTrack is not dereferenced, so it
+     * can be given after it has been changed or deleted: the area it had when
+     * indexed is used.  Any board item can be given, only a track is found.
+     * @param aTrack The item to remove
+     * @param aMin receives the top left corner of the area the item had.
+     * @param aMax receives the bottom right corner of the area the item had.
+     * @return bool - false if aTrack was not in the index.
+     */
+    bool RemoveTrack( const BOARD_ITEM* aTrack, wxPoint& aMin, wxPoint& aMax );
+
+    /**
+     * Function AddModule
+     * inserts the pads of a footprint in the index.
+     * @param aModule The footprint to add
+     * @param aMin receives the top left corner of the area of the pads.
+     * @param aMax receives the bottom right corner of the area of the pads.
+     * @return bool - false if aModule has no pad.
+     */
+    bool AddModule( MODULE* aModule, wxPoint& aMin, wxPoint& aMax );
+
+    /**
+     * Function RemoveModule
+     * removes the pads of a footprint from the index.  Neither aModule nor its pads
+     * are dereferenced: the pads of a footprint can be deleted and created again by
+     * an undo command.  Any board item can be given, only a footprint is found.
+     * @param aModule The footprint to remove
+     * @param aMin receives the top left corner of the area the pads had.
+     * @param aMax receives the bottom right corner of the area the pads had.
+     * @return bool - false if no pad of aModule was in the index.
+     */
+    bool RemoveModule( const BOARD_ITEM* aModule, wxPoint& aMin, wxPoint& aMax );
+
+    /**
+     * Function QueryTracks
+     * collects the tracks and vias found on any copper layer of \a aLayerMask whose
+     * bounding box intersects the given area.
+     * @param aMin is the top left corner of the area.
+     * @param aMax is the bottom right corner of the area.
+     * @param aLayerMask gives the copper layers to search.
+     * @param aResult receives the ordinals of the items found, sorted by rank and
+     *                without duplicates (a via is indexed on each of its layers).
+     */
+    void QueryTracks( const wxPoint& aMin, const wxPoint& aMax, LAYER_MSK aLayerMask,
+                      std::vector<int>& aResult );
+
+    /**
+     * Function QueryPads
+     * collects the pads whose shape or hole bounding box intersects the given area,
+     * on any layer.
+     * @param aMin is the top left corner of the area.
+     * @param aMax is the bottom right corner of the area.
+     * @param aResult receives the ordinals of the pads found, sorted by rank.
+     */
+    void QueryPads( const wxPoint& aMin, const wxPoint& aMax, std::vector<int>& aResult );
+
+    /**
+     * Function GetTrackOrdinalsByTile
+     * gives the ordinals of the tracks, grouped by square tiles of the board area.
+     * Testing the tracks in this order keeps the R-tree nodes visited by
+     * consecutive queries close to each other.
+     * @param aTileSize The tile side length
+     * @param aResult receives the track ordinals, tile by tile.
+     */
+    void GetTrackOrdinalsByTile( int aTileSize, std::vector<int>& aResult ) const;
+
+    /**
+     * Function ItemArea
+     * computes the area covered by a track or a via, including its width.
+     */
+    static void ItemArea( const TRACK* aTrack, wxPoint& aMin, wxPoint& aMax );
+
+    /**
+     * Function ItemArea
+     * computes the area covered by a pad shape and by its hole.
+     */
+    static void ItemArea( D_PAD* aPad, wxPoint& aMin, wxPoint& aMax );
+
+private:
+    /// The area of an indexed item, needed to remove it from the R-trees
+    struct ITEM_AREA
+    {
+        wxPoint   m_Min;
+        wxPoint   m_Max;
+        LAYER_MSK m_Layers;
+    };
+
+    int addPad( D_PAD* aPad );
+    void removePad( int aOrdinal );
+
+    // The R-tree stores its data in place of a node pointer, so the ordinals
+    // are kept as pointer sized integers.
+    typedef RTree<intptr_t, int, 2, float> ORDINAL_RTREE;
+
+    ORDINAL_RTREE        m_trackTrees[NB_COPPER_LAYERS];
+    ORDINAL_RTREE        m_padTree;
+
+    std::vector<TRACK*>     m_tracks;       ///< by ordinal, NULL once removed
+    std::vector<ITEM_AREA>  m_trackAreas;
+    std::vector<int>        m_trackRanks;
+    std::vector<D_PAD*>     m_pads;         ///< by ordinal, NULL once removed
+    std::vector<ITEM_AREA>  m_padAreas;
+    std::vector<int>        m_padRanks;
+
+    // keyed by board item, so that an item can be looked for without knowing
+    // its type, e.g. once deleted
+    std::map<const BOARD_ITEM*, int>                m_trackOrdinals;
+    std::map<const BOARD_ITEM*, std::vector<int> >  m_modulePads;
+
+    int                     m_removedPadCount;
+    int                     m_maxClearance;
+};
+
+
+#endif  // DRC_SPATIAL_INDEX_H
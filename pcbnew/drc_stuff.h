@@ -31,6 +31,8 @@
 
 
 #include <vector>
+#include <set>
+#include <map>
 
 #define OK_DRC  0
 #define BAD_DRC 1
@@ -88,6 +90,8 @@ class TRACK;
 class MARKER_PCB;
 class DRC_ITEM;
 class NETCLASS;
+class DRC_SPATIAL_INDEX;
+class PICKED_ITEMS_LIST;
 
 
 /**
@@ -137,6 +141,30 @@ public:
 typedef std::vector<DRC_ITEM*> DRC_LIST;
 
 
+/**
+ * Class DRC_PROGRESS_REPORTER
+ * is an abstract interface to follow, and possibly cancel, the long DRC tests.
+ * It is only called from the thread which runs DRC::RunTests(), even when the
+ * tests themselves are spread over several threads.
+ */
+class DRC_PROGRESS_REPORTER
+{
+public:
+
+    /**
+     * Function Report
+     * is called at the beginning of a test, then from time to time while it runs.
+     * @param aTitle The name of the test in progress
+     * @param aDone The number of items already tested
+     * @param aTotal The number of items to test
+     * @return bool - true to continue, false to abort the DRC.
+     */
+    virtual bool Report( const wxString& aTitle, int aDone, int aTotal ) = 0;
+
+    virtual ~DRC_PROGRESS_REPORTER() { }
+};
+
+
 /**
  * Class DRC
  * is the Design Rule Checker, and performs all the DRC tests.  The output of
@@ -152,6 +180,9 @@ class DRC
 
 private:
 
+    /// tag of the worker constructor
+    enum WORKER_T { WORKER };
+
     //  protected or private functions() are lowercase first character.
 
     bool     m_doPad2PadTest;
@@ -159,12 +190,15 @@ private:
     bool     m_doZonesTest;
     bool     m_doKeepoutTest;
     bool     m_doCreateRptFile;
+    bool     m_doLegacyCrossCheck;
 
     wxString m_rptFilename;
 
     MARKER_PCB* m_currentMarker;
 
-    bool        m_abortDRC;
+    /// set by Abort() or by a cancelled progress report while the worker threads
+    /// of RunTests() poll it: only accessed through isAborted() and setAborted()
+    volatile bool m_abortDRC;
     bool        m_drcInProgress;
 
     /* In DRC functions, many calculations are using coordinates relative
@@ -196,6 +230,62 @@ private:
 
     DRC_LIST            m_unconnected;  ///< list of unconnected pads, as DRC_ITEMs
 
+    DRC_SPATIAL_INDEX*  m_spatialIndex; ///< tracks and pads lookup, valid during RunTests()
+
+    DRC_PROGRESS_REPORTER* m_progressReporter;
+
+    // Online tests state, see StartOnlineTests()
+    DRC_SPATIAL_INDEX*  m_onlineIndex;      ///< NULL when the online tests are off
+    BOARD*              m_onlineBoard;      ///< the board indexed in m_onlineIndex
+    std::set<BOARD_ITEM*> m_onlineChanges;  ///< items changed since the last online test
+    bool                m_onlineRulesChanged;   ///< see OnlineRulesChanged()
+
+    /// track markers given to the board, by track
+    std::map<const BOARD_ITEM*, MARKER_PCB*> m_onlineMarkers;
+
+    /**
+     * Constructor
+     * creates a worker for the threads of RunTests().  The worker shares the board,
+     * the settings and the spatial index of aParent, but has its own test state
+     * (m_currentMarker, m_segmAngle ...) so several workers can test items at the
+     * same time.  Its markers must be handed back to the parent.
+     * The WORKER tag keeps this constructor from being taken for a copy constructor.
+     */
+    DRC( const DRC& aParent, WORKER_T );
+
+    // A DRC owns its index and markers: it is not copyable.
+    DRC( const DRC& );
+    DRC& operator=( const DRC& );
+
+    /// @return true once the tests have been cancelled, from any thread
+    bool isAborted() const
+    {
+#ifdef USE_OPENMP
+        #pragma omp flush
+#endif /* USE_OPENMP */
+        return m_abortDRC;
+    }
+
+    /// cancels the running tests, see Abort()
+    void setAborted()
+    {
+        m_abortDRC = true;
+#ifdef USE_OPENMP
+        #pragma omp flush
+#endif /* USE_OPENMP */
+    }
+
+    /// sets the initial values of the settings and of the test state
+    void init();
+
+    /**
+     * Function reportProgress
+     * forwards the progress of a test to m_progressReporter, if any, and sets
+     * m_abortDRC if the user has cancelled the tests.
+     * Must be called only from the thread running RunTests().
+     */
+    void reportProgress( const wxString& aTitle, int aDone, int aTotal );
+
 
     /**
      * Function updatePointers
@@ -267,20 +357,72 @@ private:
     /**
      * Function testTracks
      * performs the DRC on all tracks.
-     * because this test can take a while, a progress bar can be displayed
-     * @param aShowProgressBar = true to show a progrsse bar
-     * (Note: it is shown only if there are many tracks)
+     * The tracks are tested in parallel when OpenMP is available, and the markers
+     * are added to the board in m_Track order, whatever the thread which found them.
+     * Because this test can take a while, its progress is sent to m_progressReporter.
      */
-    void testTracks( bool aShowProgressBar );
+    void testTracks();
 
+    /**
+     * Function crossCheckTrackDrc
+     * runs the legacy track walk on aRefSeg and compares its result to the one
+     * found through the spatial index, for the regression mode.
+     * m_currentMarker is left as it was given, i.e. holding the indexed result.
+     * @param aRefSeg The segment which has just been tested
+     * @param aIndexedResult The value returned by the indexed doTrackDrc()
+     * @return bool - true if both tests agree.
+     */
+    bool crossCheckTrackDrc( TRACK* aRefSeg, bool aIndexedResult );
+
+    /**
+     * Function testPad2Pad
+     * performs the DRC between all pads, in parallel when OpenMP is available.
+     * The markers are added to the board in the pad order.
+     */
     void testPad2Pad();
 
     void testUnconnected();
 
+    /**
+     * Function testRatsnestUnconnected
+     * gathers the unconnected items from the board ratsnest (RN_DATA) rather than from
+     * the legacy ratsnest, which needs the frame to be built.  The ends of an item are
+     * reported by pad when they are pads, else by position and net.
+     */
+    void testRatsnestUnconnected();
+
     void testZones();
 
     void testKeepoutAreas();
 
+    /**
+     * Function testOnlineTracks
+     * performs the DRC on some tracks of m_onlineIndex, in parallel when OpenMP is
+     * available, and replaces their previous markers by the new ones.
+     * @param aOrdinals The sorted ordinals of the tracks to test
+     */
+    void testOnlineTracks( const std::vector<int>& aOrdinals );
+
+    /**
+     * Function forgetDeletedOnlineMarkers
+     * removes from m_onlineMarkers the markers which are not on the board any more,
+     * because they have been deleted by the user or by a full DRC run.
+     */
+    void forgetDeletedOnlineMarkers();
+
+    /**
+     * Function removeOnlineMarker
+     * removes from the board, and deletes, the marker of aItem if any, which only
+     * a track has.  aItem is not dereferenced.
+     */
+    void removeOnlineMarker( const BOARD_ITEM* aItem );
+
+    /**
+     * Function buildOnlineIndex
+     * fills m_onlineIndex, cleared first, with the tracks and pads of the board.
+     */
+    void buildOnlineIndex();
+
     //-----<single "item" tests>-----------------------------------------
 
     bool doNetClass( NETCLASS* aNetClass, wxString& msg );
@@ -297,21 +439,45 @@ private:
     bool doPadToPadsDrc( D_PAD* aRefPad, D_PAD** aStart, D_PAD** aEnd, int x_limit );
 
     /**
-     * Function DoTrackDrc
+     * Function doTrackDrc
      * tests the current segment.
      * @param aRefSeg The segment to test
      * @param aStart The head of a list of tracks to test against (usually BOARD::m_Track)
      * @param doPads true if should do pads test
-     * @return bool - true if no poblems, else false and m_currentMarker is
+     * @return bool - true if no problems, else false and m_currentMarker is
      *          filled in with the problem information.
      */
     bool doTrackDrc( TRACK* aRefSeg, TRACK* aStart, bool doPads = true );
 
+    /**
+     * Function doTrackDrc
+     * tests the current segment against the pads, and against the segments following
+     * it in BOARD::m_Track, like the function above, but only for the items that
+     * the spatial index finds close enough to be in conflict with it.
+     * @param aRefSeg The segment to test
+     * @param aRefOrdinal The ordinal of aRefSeg in aIndex
+     * @param aIndex The spatial index of the board items, with up to date ranks
+     * @return bool - true if no problems, else false and m_currentMarker is
+     *          filled in with the problem information.
+     */
+    bool doTrackDrc( TRACK* aRefSeg, int aRefOrdinal, DRC_SPATIAL_INDEX& aIndex );
+
+    /**
+     * Function doTrackSelfDrc
+     * tests the sizes of a segment or via, and the layer pair of micro vias, then
+     * initializes m_segmEnd, m_segmAngle and m_segmLength from this reference segment
+     * for the clearance tests.
+     * @param aRefSeg The segment to test
+     * @return bool - true if no problems, else false and m_currentMarker is
+     *          filled in with the problem information.
+     */
+    bool doTrackSelfDrc( TRACK* aRefSeg );
+
     /**
      * Function doTrackKeepoutDrc
      * tests the current segment or via.
      * @param aRefSeg The segment to test
-     * @return bool - true if no poblems, else false and m_currentMarker is
+     * @return bool - true if no problems, else false and m_currentMarker is
      *          filled in with the problem information.
      */
     bool doTrackKeepoutDrc( TRACK* aRefSeg );
@@ -330,6 +496,30 @@ private:
 
     //-----<single tests>----------------------------------------------
 
+    /**
+     * Function checkClearanceTrackToPad
+     * tests the clearance between the reference segment and a pad, or the pad hole
+     * if the pad is not on the segment layers.  doTrackSelfDrc() must have been
+     * called for aRefSeg.
+     * @param aRefSeg The reference segment
+     * @param aPad The pad to test
+     * @param aHolePad A dummy pad on all copper layers, used to test the pad hole
+     * @return bool - true if no problems, else false and m_currentMarker is
+     *          filled in with the problem information.
+     */
+    bool checkClearanceTrackToPad( TRACK* aRefSeg, D_PAD* aPad, D_PAD& aHolePad );
+
+    /**
+     * Function checkClearanceTrackToTrack
+     * tests the clearance between the reference segment and another segment or via.
+     * doTrackSelfDrc() must have been called for aRefSeg.
+     * @param aRefSeg The reference segment
+     * @param aTrack The segment to test
+     * @return bool - true if no problems, else false and m_currentMarker is
+     *          filled in with the problem information.
+     */
+    bool checkClearanceTrackToTrack( TRACK* aRefSeg, TRACK* aTrack );
+
     /**
      * Function checkClearancePadToPad
      * @param aRefPad The reference pad to check
@@ -387,6 +577,14 @@ private:
 public:
     DRC( PCB_EDIT_FRAME* aPcbWindow );
 
+    /**
+     * Constructor
+     * creates a DRC for a board which is not shown in a frame, e.g. for a batch run.
+     * Such a DRC does not open any window: only RunTests() and the reports of
+     * its results can be used.
+     */
+    DRC( BOARD* aBoard );
+
     ~DRC();
 
     /**
@@ -470,6 +668,37 @@ public:
     }
 
 
+    /**
+     * Function SetLegacyCrossCheck
+     * enables a regression mode where the track clearances found through the
+     * spatial index are compared to the ones found by the full list walk.
+     * Any difference is logged.  This mode is as slow as the list walk.
+     */
+    void SetLegacyCrossCheck( bool aEnable )
+    {
+        m_doLegacyCrossCheck = aEnable;
+    }
+
+    /**
+     * Function SetProgressReporter
+     * sets the object which follows the progress of RunTests() and can cancel it.
+     * @param aReporter The reporter, or NULL to use a progress dialog
+     */
+    void SetProgressReporter( DRC_PROGRESS_REPORTER* aReporter )
+    {
+        m_progressReporter = aReporter;
+    }
+
+    /**
+     * Function Abort
+     * asks the running tests to stop as soon as possible.  The markers found so
+     * far are kept.
+     */
+    void Abort()
+    {
+        setAborted();
+    }
+
     /**
      * Function RunTests
      * will actually run all the tests specified with a previous call to
@@ -478,6 +707,58 @@ public:
      */
     void RunTests( wxTextCtrl* aMessages = NULL );
 
+    /**
+     * Function StartOnlineTests
+     * starts the online DRC: the track clearances of the whole board are tested
+     * once, then after each edit only the tracks and vias which can be in conflict
+     * with the changed items are tested again, see RunOnlineTests().
+     * Calling it again restarts the online tests from scratch, e.g. for a new board.
+     */
+    void StartOnlineTests();
+
+    /**
+     * Function StopOnlineTests
+     * stops the online DRC.  The markers already created are left on the board.
+     */
+    void StopOnlineTests();
+
+    bool IsOnlineTestsActive() const { return m_onlineIndex != NULL; }
+
+    /**
+     * Function OnlineItemChanged
+     * tells the online DRC that aItem has been, or will soon be, added, removed
+     * or modified.  aItem is read by the next RunOnlineTests() only if it is on
+     * the board then, so it can be deleted meanwhile, e.g. with the undo list.
+     */
+    void OnlineItemChanged( BOARD_ITEM* aItem )
+    {
+        if( m_onlineIndex )
+            m_onlineChanges.insert( aItem );
+    }
+
+    /**
+     * Function OnlineItemsChanged
+     * calls OnlineItemChanged() for all the items of an undo/redo command.
+     */
+    void OnlineItemsChanged( const PICKED_ITEMS_LIST& aItems );
+
+    /**
+     * Function OnlineRulesChanged
+     * tells the online DRC that the design rules have been edited: the whole board
+     * is tested again by the next RunOnlineTests().
+     */
+    void OnlineRulesChanged()
+    {
+        m_onlineRulesChanged = true;
+    }
+
+    /**
+     * Function RunOnlineTests
+     * tests again the tracks and vias close to the items changed since the last
+     * call, and updates their markers.  Does nothing if the online DRC is off.
+     */
+    void RunOnlineTests();
+
     /**
      * Function ListUnconnectedPad
      * gathers a list of all the unconnected pads and shows them in the
@@ -485,6 +766,25 @@ public:
      */
     void ListUnconnectedPads();
 
+    /**
+     * Function GetUnconnectedCount
+     * @return int - the number of unconnected items found by the last RunTests()
+     *  or ListUnconnectedPads().
+     */
+    int GetUnconnectedCount() const
+    {
+        return m_unconnected.size();
+    }
+
+    /**
+     * Function GetUnconnectedItem
+     * @return the unconnected item at a given index, as a DRC_ITEM.
+     */
+    const DRC_ITEM* GetUnconnectedItem( int aIndex ) const
+    {
+        return m_unconnected[aIndex];
+    }
+
     /**
      * @return a pointer to the current marker (last created marker
      */
@@ -285,6 +285,15 @@ void PCB_EDIT_FRAME::Process_Special_Functions( wxCommandEvent& event )
         m_drc->ShowDialog();
         break;
 
+    case ID_DRC_ONLINE:
+        if( m_drc->IsOnlineTestsActive() )
+            m_drc->StopOnlineTests();
+        else
+            m_drc->StartOnlineTests();
+
+        m_canvas->Refresh();
+        break;
+
     case ID_GET_NETLIST:
         InstallNetlistFrame( &dc );
         break;
@@ -1272,7 +1272,8 @@ static void export_vrml_module( MODEL_VRML& aModel, BOARD* aPcb, MODULE* aModule
 
         if( fname.EndsWith( wxT( "x3d" ) ) )
         {
-            X3D_MODEL_PARSER* parser = new X3D_MODEL_PARSER( vrmlm );
+            S3D_MODEL model;
+            X3D_MODEL_PARSER* parser = new X3D_MODEL_PARSER( &model );
 
             if( parser )
             {
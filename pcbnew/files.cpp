@@ -46,6 +46,8 @@
 #include <pcbnew.h>
 #include <pcbnew_id.h>
 #include <io_mgr.h>
+#include <kicad_plugin.h>
+#include <async_file_writer.h>
 #include <wildcards_and_files_ext.h>
 
 #include <class_board.h>
@@ -552,6 +554,10 @@ bool PCB_EDIT_FRAME::SavePcbFile( const wxString& aFileName, bool aCreateBackupF
 
     IO_MGR::PCB_FILE_T pluginType;
 
+    // An auto save file still being written must not be written over, nor be
+    // written after this save deletes it.
+    m_autoSaveWriter->Wait();
+
     if( aFileName == wxEmptyString )
     {
         wxString    wildcard;
@@ -762,6 +768,51 @@ bool PCB_EDIT_FRAME::doAutoSave()
     wxLogTrace( traceAutoSave,
                 wxT( "Creating auto save file <" + fn.GetFullPath() ) + wxT( ">" ) );
 
+    if( fn.GetExt() != LegacyPcbFileExtension )
+    {
+        // The board is formatted here, but written to the disk by m_autoSaveWriter
+        // in the background, so a slow disk does not freeze the editor.
+        wxString msg;
+
+        // Still writing the previous auto save file, the timer will try again later.
+        if( m_autoSaveWriter->IsBusy() )
+            return false;
+
+        if( !m_autoSaveWriter->Wait( &msg ) )
+            wxLogWarning( _( "Error saving the auto save file.\n%s" ), GetChars( msg ) );
+
+        fn.SetExt( KiCadPcbFileExtension );
+
+        if( !IsWritable( fn ) )
+            return false;
+
+        GetBoard()->m_Status_Pcb &= ~CONNEXION_OK;
+
+        GetBoard()->SynchronizeNetsAndNetClasses();
+
+        // Select default Netclass before writing file, as SavePcbFile() does.
+        GetBoard()->SetCurrentNetClass( GetBoard()->m_NetClasses.GetDefault()->GetName() );
+
+        std::string text;
+
+        try
+        {
+            PCB_IO  pi;
+
+            pi.FormatBoardFile( GetBoard(), text );
+        }
+        catch( const IO_ERROR& ioe )
+        {
+            wxLogWarning( _( "Error saving the auto save file.\n%s" ),
+                          GetChars( ioe.errorText ) );
+            return false;
+        }
+
+        m_autoSaveWriter->Write( fn.GetFullPath(), text );
+        m_autoSaveState = false;
+        return true;
+    }
+
     if( SavePcbFile( fn.GetFullPath(), NO_BACKUP_FILE ) )
     {
         GetScreen()->SetModify();
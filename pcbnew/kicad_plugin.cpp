@@ -45,6 +45,7 @@
 #include <zones.h>
 #include <kicad_plugin.h>
 #include <pcb_parser.h>
+#include <async_file_writer.h>
 
 #include <wx/dir.h>
 #include <wx/filename.h>
@@ -69,13 +70,16 @@ static const wxString traceFootprintLibrary( wxT( "KicadFootprintLib" ) );
  * that contain a single module per file.  This class is a helper only for the
  * footprint portion of the PLUGIN API, and only for the #PCB_IO plugin.  It is
  * private to this implementation file so it is not placed into a header.
+ *
+ * The module of an item read from a library is only parsed when it is first
+ * needed, see FP_CACHE::GetModule().
  */
 class FP_CACHE_ITEM
 {
     wxFileName              m_file_name; ///< The the full file name and path of the footprint to cache.
     bool                    m_writable;  ///< Writability status of the footprint file.
     wxDateTime              m_mod_time;  ///< The last file modified time stamp.
-    std::auto_ptr<MODULE>   m_module;
+    std::auto_ptr<MODULE>   m_module;    ///< NULL until the footprint file is parsed.
 
 public:
     FP_CACHE_ITEM( MODULE* aModule, const wxFileName& aFileName );
@@ -87,6 +91,7 @@ public:
     bool        IsModified() const;
 
     MODULE*     GetModule() const { return m_module.get(); }
+    void        SetModule( MODULE* aModule ) { m_module.reset( aModule ); }
     void        UpdateModificationTime() { m_mod_time = m_file_name.GetModificationTime(); }
 };
 
@@ -138,6 +143,16 @@ public:
     bool        IsWritable() const { return m_lib_path.IsOk() && m_lib_path.IsDirWritable(); }
     MODULE_MAP& GetModules() { return m_modules; }
 
+    /**
+     * Function GetModule
+     * returns the footprint \a aFootprintName of the cache, which is parsed from its
+     * file the first time.
+     *
+     * @return MODULE* - the footprint, owned by the cache, or NULL if not found.
+     * @throw IO_ERROR, PARSE_ERROR if the footprint file cannot be read.
+     */
+    MODULE* GetModule( const wxString& aFootprintName );
+
     // Most all functions in this class throw IO_ERROR exceptions.  There are no
     // error codes nor user interface calls from here, nor in any PLUGIN.
     // Catch these exceptions higher up please.
@@ -145,6 +160,10 @@ public:
     /// save the entire legacy library to m_lib_name;
     void Save();
 
+    /**
+     * Function Load
+     * lists the footprint files of the library, without parsing them.
+     */
     void Load();
 
     void Remove( const wxString& aFootprintName );
@@ -212,6 +231,10 @@ void FP_CACHE::Save()
     {
         wxFileName fn = it->second->GetFileName();
 
+        // A footprint never parsed has not been modified in memory either.
+        if( !it->second->GetModule() )
+            continue;
+
         if( fn.FileExists() && !it->second->IsModified() )
             continue;
 
@@ -271,16 +294,11 @@ void FP_CACHE::Load()
             // prepend the libpath into fullPath
             wxFileName fullPath( m_lib_path.GetPath(), fpFileName );
 
-            FILE_LINE_READER    reader( fullPath.GetFullPath() );
-
-            m_owner->m_parser->SetLineReader( &reader );
-
+            // The footprint name is the file name without the extension.  The file is
+            // parsed by GetModule(), most footprints of a large library are never used.
             std::string name = TO_UTF8( fullPath.GetName() );
-            MODULE*     footprint = (MODULE*) m_owner->m_parser->Parse();
 
-            // The footprint name is the file name without the extension.
-            footprint->SetFPID( fullPath.GetName() );
-            m_modules.insert( name, new FP_CACHE_ITEM( footprint, fullPath ) );
+            m_modules.insert( name, new FP_CACHE_ITEM( NULL, fullPath ) );
 
         } while( dir.GetNext( &fpFileName ) );
 
@@ -292,6 +310,37 @@ void FP_CACHE::Load()
 }
 
 
+MODULE* FP_CACHE::GetModule( const wxString& aFootprintName )
+{
+    MODULE_ITER it = m_modules.find( TO_UTF8( aFootprintName ) );
+
+    if( it == m_modules.end() )
+        return NULL;
+
+    FP_CACHE_ITEM* item = it->second;
+
+    if( !item->GetModule() )
+    {
+        wxFileName fullPath = item->GetFileName();
+
+        // IsModified() must compare to the file which is parsed now, not to the
+        // one which was listed by Load().
+        item->UpdateModificationTime();
+
+        MMAP_LINE_READER    reader( fullPath.GetFullPath() );
+
+        m_owner->m_parser->SetLineReader( &reader );
+
+        MODULE* footprint = (MODULE*) m_owner->m_parser->Parse();
+
+        footprint->SetFPID( fullPath.GetName() );
+        item->SetModule( footprint );
+    }
+
+    return item->GetModule();
+}
+
+
 void FP_CACHE::Remove( const wxString& aFootprintName )
 {
 
@@ -373,6 +422,21 @@ bool FP_CACHE::IsModified( const wxString& aLibPath, const wxString& aFootprintN
 
 
 void PCB_IO::Save( const wxString& aFileName, BOARD* aBoard, const PROPERTIES* aProperties )
+{
+    std::string text;
+
+    FormatBoardFile( aBoard, text, aProperties );
+
+    // Written in place, not through a renamed temporary file, which would replace
+    // a link to the board, and lose the permissions and the owner of the file.
+    // The text is formatted before the file is opened, so a formatting error
+    // leaves it unchanged.
+    ASYNC_FILE_WRITER::WriteFile( aFileName, text, false );
+}
+
+
+void PCB_IO::FormatBoardFile( BOARD* aBoard, std::string& aText, const PROPERTIES* aProperties )
+    throw( IO_ERROR )
 {
     LOCALE_IO   toggle;     // toggles on, then off, the C locale.
 
@@ -383,7 +447,7 @@ void PCB_IO::Save( const wxString& aFileName, BOARD* aBoard, const PROPERTIES* a
     // Prepare net mapping that assures that net codes saved in a file are consecutive integers
     m_mapping->SetBoard( aBoard );
 
-    FILE_OUTPUTFORMATTER    formatter( aFileName );
+    STRING_FORMATTER    formatter;
 
     m_out = &formatter;     // no ownership
 
@@ -393,6 +457,11 @@ void PCB_IO::Save( const wxString& aFileName, BOARD* aBoard, const PROPERTIES* a
     Format( aBoard, 1 );
 
     m_out->Print( 0, ")\n" );
+
+    m_out = NULL;
+
+    aText.clear();
+    aText.swap( formatter.MutableString() );
 }
 
 
@@ -1646,7 +1715,7 @@ PCB_IO::~PCB_IO()
 
 BOARD* PCB_IO::Load( const wxString& aFileName, BOARD* aAppendToMe, const PROPERTIES* aProperties )
 {
-    FILE_LINE_READER    reader( aFileName );
+    MMAP_LINE_READER    reader( aFileName );
 
     init( aProperties );
 
@@ -1735,17 +1804,15 @@ MODULE* PCB_IO::FootprintLoad( const wxString& aLibraryPath, const wxString& aFo
 
     cacheLib( aLibraryPath, aFootprintName );
 
-    const MODULE_MAP& mods = m_cache->GetModules();
-
-    MODULE_CITER it = mods.find( TO_UTF8( aFootprintName ) );
+    const MODULE* module = m_cache->GetModule( aFootprintName );
 
-    if( it == mods.end() )
+    if( !module )
     {
         return NULL;
     }
 
     // copy constructor to clone the already loaded MODULE
-    return new MODULE( *it->second->GetModule() );
+    return new MODULE( *module );
 }
 
 
@@ -149,6 +149,19 @@ public:
 
     void SetOutputFormatter( OUTPUTFORMATTER* aFormatter ) { m_out = aFormatter; }
 
+    /**
+     * Function FormatBoardFile
+     * formats \a aBoard in memory exactly as Save() writes it to its file, so the
+     * caller may write the text later or on another thread.
+     *
+     * @param aBoard is the board to format.
+     * @param aText receives the content of the board file.
+     * @param aProperties is passed as it would be to Save().
+     * @throw IO_ERROR on format error.
+     */
+    void FormatBoardFile( BOARD* aBoard, std::string& aText,
+                          const PROPERTIES* aProperties = NULL ) throw( IO_ERROR );
+
     BOARD_ITEM* Parse( const wxString& aClipboardSourceInput )
         throw( PARSE_ERROR, IO_ERROR );
 
@@ -596,6 +596,11 @@ void PCB_EDIT_FRAME::ReCreateMenuBar()
                  _( "&DRC" ),
                  _( "Perform design rules check" ), KiBitmap( erc_xpm ) );
 
+    AddMenuItem( toolsMenu, ID_DRC_ONLINE,
+                 _( "&Online DRC" ),
+                 _( "Check the track clearances after each change" ),
+                 KiBitmap( erc_xpm ), wxITEM_CHECK );
+
     /* FreeRoute */
     AddMenuItem( toolsMenu, ID_TOOLBARH_PCB_FREEROUTE_ACCESS,
                  _( "&FreeRoute" ),
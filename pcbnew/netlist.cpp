@@ -42,6 +42,7 @@
 
 #include <class_board.h>
 #include <class_module.h>
+#include <ratsnest_data.h>
 #include <pcbnew.h>
 #include <io_mgr.h>
 
@@ -100,6 +101,9 @@ void PCB_EDIT_FRAME::ReadPcbNetlist( const wxString& aNetlistFileName,
     if( netlist.IsDryRun() )
         return;
 
+    // The nets of the pads are changed behind the undo list
+    notifyBoardChanged();
+
     OnModify();
 
     SetCurItem( NULL );
@@ -112,6 +116,12 @@ void PCB_EDIT_FRAME::ReadPcbNetlist( const wxString& aNetlistFileName,
 
     // Rebuild the board connectivity:
     Compile_Ratsnest( NULL, true );
+
+    // The pads may have new nets, so the ratsnest of the GAL canvas is rebuilt as well
+    RN_DATA* ratsnest = GetBoard()->GetRatsnest();
+    ratsnest->ProcessBoard();
+    ratsnest->Recalculate();
+
     SetMsgPanel( GetBoard() );
     m_canvas->Refresh();
 }
@@ -51,6 +51,68 @@
 #include <zones.h>
 #include <pcb_parser.h>
 
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif /* USE_OPENMP */
+
+
+/**
+ * Class SECTION_LINE_READER
+ * reads the lines of the text of a board item kept by DSNLEXER::ReadListText(), with
+ * the line numbers of the board file.
+ */
+class SECTION_LINE_READER : public LINE_READER
+{
+    const char* m_next;
+    const char* m_end;
+
+public:
+    SECTION_LINE_READER( const wxString& aSource ) :
+        LINE_READER( LINE_READER_LINE_DEFAULT_MAX ),
+        m_next( NULL ),
+        m_end( NULL )
+    {
+        source = aSource;
+    }
+
+    /**
+     * Function SetSection
+     * sets the text to read next.
+     * @param aLineNumber is the line number of the first line of the text.
+     */
+    void SetSection( const char* aBegin, const char* aEnd, int aLineNumber )
+    {
+        m_next  = aBegin;
+        m_end   = aEnd;
+        lineNum = aLineNumber - 1;
+    }
+
+    char* ReadLine() throw( IO_ERROR )
+    {
+        const char* nl = (const char*) memchr( m_next, '\n', m_end - m_next );
+
+        length = nl ? nl - m_next + 1 : m_end - m_next;
+
+        if( length )
+        {
+            if( length >= maxLineLength )
+                THROW_IO_ERROR( _("Line length exceeded") );
+
+            if( length+1 > capacity )   // +1 for terminating nul
+                expandCapacity( length+1 );
+
+            memcpy( line, m_next, length );
+            m_next += length;
+        }
+
+        ++lineNum;      // this gets incremented even if no bytes were read
+
+        line[length] = 0;
+
+        return length ? line : NULL;
+    }
+};
+
 
 void PCB_PARSER::init()
 {
@@ -368,6 +430,19 @@ BOARD* PCB_PARSER::parseBOARD() throw( IO_ERROR, PARSE_ERROR )
 {
     T token;
 
+    // With several processors, the text of the items is kept to parse them all at
+    // once in parseSections().
+#ifdef USE_OPENMP
+    bool deferItems = omp_get_max_threads() > 1;
+#else
+    bool deferItems = false;
+#endif /* USE_OPENMP */
+
+    std::string             sectionText;
+    std::vector<SECTION>    sections;
+
+    m_warnings.Clear();     // of a board whose reading failed
+
     parseHeader();
 
     for( token = NextTok();  token != T_RIGHT;  token = NextTok() )
@@ -412,35 +487,25 @@ BOARD* PCB_PARSER::parseBOARD() throw( IO_ERROR, PARSE_ERROR )
         case T_gr_curve:
         case T_gr_line:
         case T_gr_poly:
-            m_board->Add( parseDRAWSEGMENT(), ADD_APPEND );
-            break;
-
         case T_gr_text:
-            m_board->Add( parseTEXTE_PCB(), ADD_APPEND );
-            break;
-
         case T_dimension:
-            m_board->Add( parseDIMENSION(), ADD_APPEND );
-            break;
-
         case T_module:
-            m_board->Add( parseMODULE(), ADD_APPEND );
-            break;
-
         case T_segment:
-            m_board->Add( parseTRACK(), ADD_APPEND );
-            break;
-
         case T_via:
-            m_board->Add( parseSEGVIA(), ADD_APPEND );
-            break;
-
         case T_zone:
-            m_board->Add( parseZONE_CONTAINER(), ADD_APPEND );
-            break;
-
         case T_target:
-            m_board->Add( parsePCB_TARGET(), ADD_APPEND );
+            if( deferItems )
+            {
+                SECTION section;
+
+                section.offset     = sectionText.size();
+                section.lineNumber = ReadListText( sectionText );
+                sections.push_back( section );
+            }
+            else
+            {
+                m_board->Add( parseBOARD_ITEM( token ), ADD_APPEND );
+            }
             break;
 
         default:
@@ -450,10 +515,169 @@ BOARD* PCB_PARSER::parseBOARD() throw( IO_ERROR, PARSE_ERROR )
         }
     }
 
+    if( sections.size() )
+        parseSections( sectionText, sections );
+
+    // Shown only now, as the items may have been parsed by other threads
+    for( unsigned ii = 0; ii < m_warnings.GetCount(); ++ii )
+        DisplayError( NULL, m_warnings[ii] );
+
+    m_warnings.Clear();
+
     return m_board;
 }
 
 
+BOARD_ITEM* PCB_PARSER::parseBOARD_ITEM( T aToken ) throw( IO_ERROR, PARSE_ERROR )
+{
+    switch( aToken )
+    {
+    case T_gr_arc:
+    case T_gr_circle:
+    case T_gr_curve:
+    case T_gr_line:
+    case T_gr_poly:
+        return parseDRAWSEGMENT();
+
+    case T_gr_text:
+        return parseTEXTE_PCB();
+
+    case T_dimension:
+        return parseDIMENSION();
+
+    case T_module:
+        return parseMODULE();
+
+    case T_segment:
+        return parseTRACK();
+
+    case T_via:
+        return parseSEGVIA();
+
+    case T_zone:
+        return parseZONE_CONTAINER();
+
+    case T_target:
+        return parsePCB_TARGET();
+
+    default:
+        return NULL;
+    }
+}
+
+
+void PCB_PARSER::parseSections( const std::string& aText, const std::vector<SECTION>& aSections )
+    throw( IO_ERROR, PARSE_ERROR )
+{
+    const int                   count = aSections.size();
+    std::vector<BOARD_ITEM*>    items( count, (BOARD_ITEM*) NULL );
+    std::vector<wxArrayString>  warnings( count );
+    IO_ERROR*                   error = NULL;     // of the first section which failed
+    int                         errorSection = count;
+
+#ifdef USE_OPENMP
+    #pragma omp parallel shared( items, warnings, error, errorSection )
+#endif /* USE_OPENMP */
+    {
+        // Each thread has its own parser, which only reads the board
+        SECTION_LINE_READER reader( CurSource() );
+        PCB_PARSER          worker;
+
+        worker.m_board        = m_board;
+        worker.m_layerIndices = m_layerIndices;
+        worker.m_layerMasks   = m_layerMasks;
+
+#ifdef USE_OPENMP
+        #pragma omp for schedule( dynamic, 64 )
+#endif /* USE_OPENMP */
+        for( int ii = 0; ii < count; ++ii )
+        {
+            int firstError;
+
+#ifdef USE_OPENMP
+            #pragma omp critical( pcbParserError )
+#endif /* USE_OPENMP */
+            firstError = errorSection;
+
+            // The sections after a failed one are useless, but not the ones before
+            // it, one of which may fail first in the file.  An OpenMP loop cannot
+            // be left with break.
+            if( ii > firstError )
+                continue;
+
+            size_t end = ii + 1 < count ? aSections[ii + 1].offset : aText.size();
+
+            reader.SetSection( aText.data() + aSections[ii].offset, aText.data() + end,
+                               aSections[ii].lineNumber );
+            worker.SetLineReader( &reader );
+
+            IO_ERROR* sectionError = NULL;
+
+            try
+            {
+                items[ii] = worker.parseBOARD_ITEM( worker.NextTok() );
+            }
+            catch( const PARSE_ERROR& pe )
+            {
+                sectionError = new PARSE_ERROR( pe );
+            }
+            catch( const IO_ERROR& ioe )
+            {
+                sectionError = new IO_ERROR( ioe );
+            }
+
+            // kept by section, to be shown in the file order
+            if( !worker.m_warnings.IsEmpty() )
+            {
+                warnings[ii] = worker.m_warnings;
+                worker.m_warnings.Clear();
+            }
+
+            if( sectionError )
+            {
+#ifdef USE_OPENMP
+                #pragma omp critical( pcbParserError )
+#endif /* USE_OPENMP */
+                {
+                    if( ii < errorSection )
+                    {
+                        delete error;
+                        error = sectionError;
+                        errorSection = ii;
+                    }
+                    else
+                    {
+                        delete sectionError;
+                    }
+                }
+            }
+        }
+    }
+
+    if( error )
+    {
+        for( int ii = 0; ii < count; ++ii )
+            delete items[ii];
+
+        std::auto_ptr<IO_ERROR> deleter( error );
+        PARSE_ERROR*            parseError = dynamic_cast<PARSE_ERROR*>( error );
+
+        if( parseError )
+            throw PARSE_ERROR( *parseError );
+
+        throw IO_ERROR( *error );
+    }
+
+    for( int ii = 0; ii < count; ++ii )
+    {
+        m_board->Add( items[ii], ADD_APPEND );
+
+        for( unsigned jj = 0; jj < warnings[ii].GetCount(); ++jj )
+            m_warnings.Add( warnings[ii][jj] );
+    }
+}
+
+
 void PCB_PARSER::parseHeader() throw( IO_ERROR, PARSE_ERROR )
 {
     wxCHECK_RET( CurTok() == T_kicad_pcb,
@@ -2429,7 +2653,7 @@ ZONE_CONTAINER* PCB_PARSER::parseZONE_CONTAINER() throw( IO_ERROR, PARSE_ERROR )
                 wxString msg;
                 msg.Printf( _( "There is a zone that belongs to a not existing net"
                                "(%s), you should verify it." ), GetChars( FromUTF8() ) );
-                DisplayError( NULL, msg );
+                m_warnings.Add( msg );
                 zone->SetNetCode( NETINFO_LIST::UNCONNECTED );
             }
             NeedRIGHT();
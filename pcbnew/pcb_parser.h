@@ -33,6 +33,7 @@
 #include <hashtables.h>
 #include <layers_id_colors_and_visibility.h>    // LAYER_NUM
 #include <common.h>                             // KiROUND
+#include <fixed_point_text.h>
 
 using namespace PCB_KEYS_T;
 
@@ -67,6 +68,18 @@ class PCB_PARSER : public PCB_LEXER
     BOARD*          m_board;
     LAYER_NUM_MAP   m_layerIndices;     ///< map layer name to it's index
     LAYER_MSK_MAP   m_layerMasks;       ///< map layer names to their masks
+    wxArrayString   m_warnings;         ///< shown once the board is read, see parseBOARD()
+
+    /**
+     * Struct SECTION
+     * locates the text of a top level item of a board, which parseBOARD() keeps
+     * to parse it later with the other ones, see parseSections().
+     */
+    struct SECTION
+    {
+        size_t      offset;             ///< of the item in the text of the sections
+        int         lineNumber;         ///< of the item in the board file
+    };
 
 
     /**
@@ -106,6 +119,30 @@ class PCB_PARSER : public PCB_LEXER
     PCB_TARGET*     parsePCB_TARGET() throw( IO_ERROR, PARSE_ERROR );
     BOARD*          parseBOARD() throw( IO_ERROR, PARSE_ERROR );
 
+    /**
+     * Function parseBOARD_ITEM
+     * parses a top level item of a board, which is not added to the board.
+     *
+     * @param aToken is the keyword of the item, the current token.
+     * @return BOARD_ITEM* - the item, or NULL if @a aToken is not an item keyword.
+     */
+    BOARD_ITEM*     parseBOARD_ITEM( T aToken ) throw( IO_ERROR, PARSE_ERROR );
+
+    /**
+     * Function parseSections
+     * parses the top level items kept by parseBOARD(), on all the processors, and
+     * adds them to the board in the order of the file.  The items are parsed once
+     * the whole file has been read, so the net table and the layers of the board
+     * are complete, and they are only read by the items.
+     *
+     * @param aText is the text of all the items.
+     * @param aSections locates each item in @a aText, in the order of the file.
+     * @throw IO_ERROR or PARSE_ERROR of the first item which cannot be parsed,
+     *  after all the items have been deleted.
+     */
+    void parseSections( const std::string& aText, const std::vector<SECTION>& aSections )
+        throw( IO_ERROR, PARSE_ERROR );
+
 
     /**
      * Function lookUpLayer
@@ -189,6 +226,13 @@ class PCB_PARSER : public PCB_LEXER
 
     inline int parseBoardUnits() throw( IO_ERROR )
     {
+        int iu;
+
+        // The values written by Pcbnew are a whole count of nanometers, which are
+        // read exactly without strtod() nor locale.
+        if( ParseFixedPoint( CurText(), IU_PER_MM_LOG10, &iu ) )
+            return iu;
+
         // There should be no major rounding issues here, since the values in
         // the file are in mm and get converted to nano-meters.
         // See test program tools/test-nm-biu-to-ascii-mm-round-tripping.cpp
@@ -200,10 +244,8 @@ class PCB_PARSER : public PCB_LEXER
 
     inline int parseBoardUnits( const char* aExpected ) throw( PARSE_ERROR )
     {
-        // Use here KiROUND, not KIROUND (see comments about them)
-        // when having a function as argument, because it will be called twice
-        // with KIROUND
-        return KiROUND( parseDouble( aExpected ) * IU_PER_MM );
+        NeedNUMBER( aExpected );
+        return parseBoardUnits();
     }
 
     inline int parseBoardUnits( T aToken ) throw( PARSE_ERROR )
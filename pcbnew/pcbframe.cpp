@@ -46,6 +46,7 @@
 #include <pcbnew.h>
 #include <pcbnew_id.h>
 #include <drc_stuff.h>
+#include <async_file_writer.h>
 #include <layer_widget.h>
 #include <dialog_design_rules.h>
 #include <class_pcb_layer_widget.h>
@@ -199,6 +200,7 @@ BEGIN_EVENT_TABLE( PCB_EDIT_FRAME, PCB_BASE_FRAME )
     EVT_TOOL( ID_FIND_ITEMS, PCB_EDIT_FRAME::Process_Special_Functions )
     EVT_TOOL( ID_GET_NETLIST, PCB_EDIT_FRAME::Process_Special_Functions )
     EVT_TOOL( ID_DRC_CONTROL, PCB_EDIT_FRAME::Process_Special_Functions )
+    EVT_MENU( ID_DRC_ONLINE, PCB_EDIT_FRAME::Process_Special_Functions )
     EVT_TOOL( ID_AUX_TOOLBAR_PCB_SELECT_LAYER_PAIR, PCB_EDIT_FRAME::Process_Special_Functions )
     EVT_TOOL( ID_AUX_TOOLBAR_PCB_SELECT_AUTO_WIDTH, PCB_EDIT_FRAME::Tracks_and_Vias_Size_Event )
     EVT_COMBOBOX( ID_TOOLBARH_PCB_SELECT_LAYER, PCB_EDIT_FRAME::Process_Special_Functions )
@@ -265,6 +267,7 @@ BEGIN_EVENT_TABLE( PCB_EDIT_FRAME, PCB_BASE_FRAME )
     EVT_UPDATE_UI( ID_AUX_TOOLBAR_PCB_SELECT_LAYER_PAIR, PCB_EDIT_FRAME::OnUpdateLayerPair )
     EVT_UPDATE_UI( ID_TOOLBARH_PCB_SELECT_LAYER, PCB_EDIT_FRAME::OnUpdateLayerSelectBox )
     EVT_UPDATE_UI( ID_TB_OPTIONS_DRC_OFF, PCB_EDIT_FRAME::OnUpdateDrcEnable )
+    EVT_UPDATE_UI( ID_DRC_ONLINE, PCB_EDIT_FRAME::OnUpdateOnlineDrc )
     EVT_UPDATE_UI( ID_TB_OPTIONS_SHOW_RATSNEST, PCB_EDIT_FRAME::OnUpdateShowBoardRatsnest )
     EVT_UPDATE_UI( ID_TB_OPTIONS_SHOW_MODULE_RATSNEST, PCB_EDIT_FRAME::OnUpdateShowModuleRatsnest )
     EVT_UPDATE_UI( ID_TB_OPTIONS_AUTO_DEL_TRACK, PCB_EDIT_FRAME::OnUpdateAutoDeleteTrack )
@@ -346,6 +349,7 @@ PCB_EDIT_FRAME::PCB_EDIT_FRAME( KIWAY* aKiway, wxWindow* aParent ) :
     m_Layers = new PCB_LAYER_WIDGET( this, GetCanvas(), pointSize );
 
     m_drc = new DRC( this );        // these 2 objects point to each other
+    m_autoSaveWriter = new ASYNC_FILE_WRITER();
 
     wxIcon  icon;
     icon.CopyFromBitmap( KiBitmap( icon_pcbnew_xpm ) );
@@ -487,6 +491,9 @@ PCB_EDIT_FRAME::~PCB_EDIT_FRAME()
         m_Macros[i].m_Record.clear();
 
     delete m_drc;
+
+    // waits for the auto save file in progress, if any
+    delete m_autoSaveWriter;
 }
 
 
@@ -652,6 +659,10 @@ void PCB_EDIT_FRAME::OnCloseWindow( wxCloseEvent& Event )
     // Auto save file name is the normal file name prefixed with a '$'.
     fn.SetName( wxT( "$" ) + fn.GetName() );
 
+    // An auto save still being written would rename its file in place after the
+    // removal.
+    m_autoSaveWriter->Wait();
+
     // Remove the auto save file on a normal close of Pcbnew.
     if( fn.FileExists() && !wxRemoveFile( fn.GetFullPath() ) )
     {
@@ -747,6 +758,7 @@ void PCB_EDIT_FRAME::ShowDesignRulesEditor( wxCommandEvent& event )
 
     if( returncode == wxID_OK )     // New rules, or others changes.
     {
+        m_drc->OnlineRulesChanged();
         ReCreateLayerBox();
         updateTraceWidthSelectBox();
         updateViaSizeSelectBox();
@@ -1075,6 +1087,8 @@ void PCB_EDIT_FRAME::OnModify( )
 
     if( m_Draw3DFrame )
         m_Draw3DFrame->ReloadRequest();
+
+    m_drc->RunOnlineTests();
 }
 
 
@@ -0,0 +1,403 @@
+/**
+ * @file pcbnew_drc.cpp
+ * @brief command line tool running the DRC on a board file, without any window.
+ */
+
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/*
+    Usage: pcbnew_drc [options] <board file>
+
+        --format=json|xml   report format, json by default
+        --output=<file>     report file, the standard output by default
+        --no-pad2pad        skip the pad to pad clearance test
+        --no-unconnected    skip the unconnected items test
+        --no-zones          skip the zones test
+        --no-keepout        skip the keepout areas test
+
+    The exit code is the number of violations found (markers and unconnected
+    items), up to 100, or one of the error codes of PCBNEW_DRC_EXIT_CODE.
+
+    The board is loaded with IO_MGR::Load() and tested by the same DRC class as
+    the one of pcbnew, but no frame and no window are created, so this is cheap
+    to start, and can run on a machine without display.
+*/
+
+
+#include <fctsys.h>
+#include <algorithm>
+#include <wx/init.h>
+#include <wx/filename.h>
+#include <wx/wfstream.h>
+#include <wx/xml/xml.h>
+
+#include <macros.h>
+#include <common.h>
+#include <kiway.h>
+#include <pgm_base.h>
+#include <richio.h>
+#include <xnode.h>
+#include <base_units.h>
+#include <wildcards_and_files_ext.h>
+
+#include <io_mgr.h>
+#include <class_board.h>
+#include <class_marker_pcb.h>
+#include <drc_stuff.h>
+
+
+/// Exit codes of pcbnew_drc, when it cannot give a number of violations
+enum PCBNEW_DRC_EXIT_CODE
+{
+    EXIT_NO_VIOLATION   = 0,
+    EXIT_MAX_VIOLATIONS = 100,      ///< 100 violations or more
+    EXIT_BAD_COMMAND    = 101,      ///< unknown option, or no board file
+    EXIT_LOAD_ERROR     = 102,      ///< the board file cannot be read
+    EXIT_WRITE_ERROR    = 103       ///< the report file cannot be written
+};
+
+
+/**
+ * Struct PGM_DRC
+ * implements PGM_BASE for this tool, which has no wxApp.  pcbnew.cpp is linked in
+ * for the pcbnew globals, and its Pgm() is given this object as single_top does.
+ */
+static struct PGM_DRC : public PGM_BASE
+{
+    bool OnPgmInit( wxApp* aWxApp ) { return true; }
+    void OnPgmExit()                { }
+    void MacOpenFile( const wxString& aFileName ) { }
+} program;
+
+
+/**
+ * Function jsonString
+ * quotes and escapes aText for a JSON document.
+ */
+static std::string jsonString( const wxString& aText )
+{
+    std::string utf8 = TO_UTF8( aText );
+    std::string ret  = "\"";
+
+    for( unsigned ii = 0; ii < utf8.size(); ++ii )
+    {
+        unsigned char c = utf8[ii];
+
+        if( c == '"' || c == '\\' )
+        {
+            ret += '\\';
+            ret += c;
+        }
+        else if( c < 0x20 )
+        {
+            char buf[8];
+            sprintf( buf, "\\u%04x", c );
+            ret += buf;
+        }
+        else
+            ret += c;
+    }
+
+    ret += '"';
+
+    return ret;
+}
+
+
+/// @return a coordinate in mm, in the C locale
+static wxString toMillimeters( int aValue )
+{
+    return wxString::Format( wxT( "%.4f" ), To_User_Unit( MILLIMETRES, aValue ) );
+}
+
+
+/**
+ * Function formatJsonItem
+ * writes one DRC_ITEM as a JSON object, without the trailing comma.
+ */
+static void formatJsonItem( OUTPUTFORMATTER& aOut, int aNestLevel, const DRC_ITEM& aItem )
+{
+    aOut.Print( aNestLevel, "{\n" );
+    aOut.Print( aNestLevel + 1, "\"code\": %d,\n", aItem.GetErrorCode() );
+    aOut.Print( aNestLevel + 1, "\"description\": %s,\n",
+                jsonString( aItem.GetErrorText() ).c_str() );
+    aOut.Print( aNestLevel + 1, "\"items\": [\n" );
+
+    aOut.Print( aNestLevel + 2, "{ \"text\": %s, \"x\": %s, \"y\": %s }",
+                jsonString( aItem.GetTextA() ).c_str(),
+                TO_UTF8( toMillimeters( aItem.GetPointA().x ) ),
+                TO_UTF8( toMillimeters( aItem.GetPointA().y ) ) );
+
+    if( aItem.HasSecondItem() )
+    {
+        aOut.Print( 0, ",\n" );
+        aOut.Print( aNestLevel + 2, "{ \"text\": %s, \"x\": %s, \"y\": %s }",
+                    jsonString( aItem.GetTextB() ).c_str(),
+                    TO_UTF8( toMillimeters( aItem.GetPointB().x ) ),
+                    TO_UTF8( toMillimeters( aItem.GetPointB().y ) ) );
+    }
+
+    aOut.Print( 0, "\n" );
+    aOut.Print( aNestLevel + 1, "]\n" );
+    aOut.Print( aNestLevel, "}" );
+}
+
+
+static std::string formatJsonReport( const wxString& aBoardFile, BOARD* aBoard, const DRC& aDrc )
+{
+    STRING_FORMATTER out;
+
+    out.Print( 0, "{\n" );
+    out.Print( 1, "\"board\": %s,\n", jsonString( aBoardFile ).c_str() );
+
+    out.Print( 1, "\"violations\": [\n" );
+
+    for( int ii = 0; ii < aBoard->GetMARKERCount(); ++ii )
+    {
+        formatJsonItem( out, 2, aBoard->GetMARKER( ii )->GetReporter() );
+        out.Print( 0, ii + 1 < aBoard->GetMARKERCount() ? ",\n" : "\n" );
+    }
+
+    out.Print( 1, "],\n" );
+
+    out.Print( 1, "\"unconnected\": [\n" );
+
+    for( int ii = 0; ii < aDrc.GetUnconnectedCount(); ++ii )
+    {
+        formatJsonItem( out, 2, *aDrc.GetUnconnectedItem( ii ) );
+        out.Print( 0, ii + 1 < aDrc.GetUnconnectedCount() ? ",\n" : "\n" );
+    }
+
+    out.Print( 1, "]\n" );
+    out.Print( 0, "}\n" );
+
+    return out.GetString();
+}
+
+
+/**
+ * Function xmlItem
+ * builds the XML node of one DRC_ITEM.
+ */
+static XNODE* xmlItem( const wxString& aName, const DRC_ITEM& aItem )
+{
+    XNODE* xitem = new XNODE( wxXML_ELEMENT_NODE, aName );
+
+    xitem->AddAttribute( wxT( "code" ), wxString::Format( wxT( "%d" ), aItem.GetErrorCode() ) );
+    xitem->AddAttribute( wxT( "description" ), aItem.GetErrorText() );
+
+    XNODE* xpos = new XNODE( wxXML_ELEMENT_NODE, wxT( "item" ) );
+    xpos->AddAttribute( wxT( "text" ), aItem.GetTextA() );
+    xpos->AddAttribute( wxT( "x" ), toMillimeters( aItem.GetPointA().x ) );
+    xpos->AddAttribute( wxT( "y" ), toMillimeters( aItem.GetPointA().y ) );
+    xitem->AddChild( xpos );
+
+    if( aItem.HasSecondItem() )
+    {
+        xpos = new XNODE( wxXML_ELEMENT_NODE, wxT( "item" ) );
+        xpos->AddAttribute( wxT( "text" ), aItem.GetTextB() );
+        xpos->AddAttribute( wxT( "x" ), toMillimeters( aItem.GetPointB().x ) );
+        xpos->AddAttribute( wxT( "y" ), toMillimeters( aItem.GetPointB().y ) );
+        xitem->AddChild( xpos );
+    }
+
+    return xitem;
+}
+
+
+static bool writeXmlReport( const wxString& aReportFile, const wxString& aBoardFile,
+                            BOARD* aBoard, const DRC& aDrc )
+{
+    XNODE* xroot = new XNODE( wxXML_ELEMENT_NODE, wxT( "drc" ) );
+
+    xroot->AddAttribute( wxT( "board" ), aBoardFile );
+
+    XNODE* xviolations = new XNODE( wxXML_ELEMENT_NODE, wxT( "violations" ) );
+    xroot->AddChild( xviolations );
+
+    for( int ii = 0; ii < aBoard->GetMARKERCount(); ++ii )
+        xviolations->AddChild( xmlItem( wxT( "violation" ),
+                                        aBoard->GetMARKER( ii )->GetReporter() ) );
+
+    XNODE* xunconnected = new XNODE( wxXML_ELEMENT_NODE, wxT( "unconnected_items" ) );
+    xroot->AddChild( xunconnected );
+
+    for( int ii = 0; ii < aDrc.GetUnconnectedCount(); ++ii )
+        xunconnected->AddChild( xmlItem( wxT( "unconnected" ),
+                                         *aDrc.GetUnconnectedItem( ii ) ) );
+
+    wxXmlDocument xdoc;
+
+    xdoc.SetRoot( xroot );
+
+    if( aReportFile.IsEmpty() )
+    {
+        wxFFileOutputStream out( stdout );
+        return xdoc.Save( out, 2 );
+    }
+
+    return xdoc.Save( aReportFile, 2 );
+}
+
+
+static void usage()
+{
+    fprintf( stderr,
+             "Usage: pcbnew_drc [options] <board file>\n"
+             "    --format=json|xml   report format, json by default\n"
+             "    --output=<file>     report file, the standard output by default\n"
+             "    --no-pad2pad        skip the pad to pad clearance test\n"
+             "    --no-unconnected    skip the unconnected items test\n"
+             "    --no-zones          skip the zones test\n"
+             "    --no-keepout        skip the keepout areas test\n" );
+}
+
+
+int main( int argc, char** argv )
+{
+    wxInitializer initializer;
+
+    if( !initializer.IsOk() )
+    {
+        fprintf( stderr, "pcbnew_drc: cannot initialize wxWidgets\n" );
+        return EXIT_BAD_COMMAND;
+    }
+
+    int kifaceVersion;
+    KIFACE_GETTER( &kifaceVersion, KIFACE_VERSION, &program );
+
+    wxString    boardFile;
+    wxString    reportFile;
+    bool        xmlFormat     = false;
+    bool        doPad2Pad     = true;
+    bool        doUnconnected = true;
+    bool        doZones       = true;
+    bool        doKeepout     = true;
+
+    for( int ii = 1; ii < argc; ++ii )
+    {
+        wxString arg = FROM_UTF8( argv[ii] );
+
+        if( arg.StartsWith( wxT( "--output=" ), &reportFile ) )
+            continue;
+
+        if( arg == wxT( "--format=json" ) )
+            xmlFormat = false;
+        else if( arg == wxT( "--format=xml" ) )
+            xmlFormat = true;
+        else if( arg == wxT( "--no-pad2pad" ) )
+            doPad2Pad = false;
+        else if( arg == wxT( "--no-unconnected" ) )
+            doUnconnected = false;
+        else if( arg == wxT( "--no-zones" ) )
+            doZones = false;
+        else if( arg == wxT( "--no-keepout" ) )
+            doKeepout = false;
+        else if( !arg.StartsWith( wxT( "-" ) ) && boardFile.IsEmpty() )
+            boardFile = arg;
+        else
+        {
+            usage();
+            return EXIT_BAD_COMMAND;
+        }
+    }
+
+    if( boardFile.IsEmpty() )
+    {
+        usage();
+        return EXIT_BAD_COMMAND;
+    }
+
+    IO_MGR::PCB_FILE_T pluginType = IO_MGR::LEGACY;
+
+    if( wxFileName( boardFile ).GetExt() == KiCadPcbFileExtension )
+        pluginType = IO_MGR::KICAD;
+
+    BOARD* board = NULL;
+
+    try
+    {
+        board = IO_MGR::Load( pluginType, boardFile );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        fprintf( stderr, "pcbnew_drc: %s\n", TO_UTF8( ioe.errorText ) );
+        return EXIT_LOAD_ERROR;
+    }
+
+    if( !board )
+    {
+        fprintf( stderr, "pcbnew_drc: cannot load %s\n", TO_UTF8( boardFile ) );
+        return EXIT_LOAD_ERROR;
+    }
+
+    // as PCB_EDIT_FRAME does after loading a board: plugins do not do this
+    board->BuildListOfNets();
+    board->SynchronizeNetsAndNetClasses();
+
+    int violations;
+    bool written = true;
+
+    {
+        DRC drc( board );
+
+        drc.SetSettings( doPad2Pad, doUnconnected, doZones, doKeepout, wxEmptyString, false );
+        drc.RunTests();
+
+        violations = board->GetMARKERCount() + drc.GetUnconnectedCount();
+
+        // Numbers are written with a '.', whatever the user locale
+        LOCALE_IO toggle;
+
+        if( xmlFormat )
+        {
+            written = writeXmlReport( reportFile, boardFile, board, drc );
+        }
+        else
+        {
+            std::string report = formatJsonReport( boardFile, board, drc );
+            FILE* fp = reportFile.IsEmpty() ? stdout : wxFopen( reportFile, wxT( "wt" ) );
+
+            if( fp )
+            {
+                written = fwrite( report.data(), 1, report.size(), fp ) == report.size();
+
+                if( fp != stdout )
+                    written = ( fclose( fp ) == 0 ) && written;
+            }
+            else
+                written = false;
+        }
+    }
+
+    delete board;
+
+    if( !written )
+    {
+        fprintf( stderr, "pcbnew_drc: cannot write %s\n", TO_UTF8( reportFile ) );
+        return EXIT_WRITE_ERROR;
+    }
+
+    return std::min( violations, (int) EXIT_MAX_VIOLATIONS );
+}
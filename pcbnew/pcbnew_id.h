@@ -305,6 +305,7 @@ enum pcbnew_ids
     ID_PCB_MUWAVE_END_CMD,
 
     ID_DRC_CONTROL,
+    ID_DRC_ONLINE,
     ID_PCB_GLOBAL_DELETE,
     ID_POPUP_PCB_DELETE_TRACKSEG,
     ID_TOOLBARH_PCB_SELECT_LAYER,
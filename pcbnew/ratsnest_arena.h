@@ -0,0 +1,251 @@
+/*
+ * This program source code file is part of KICAD, a free EDA CAD application.
+ *
+ * Copyright (C) 2013 CERN
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/**
+ * @file ratsnest_arena.h
+ * @brief Memory pool for the nodes and edges of a net.
+ */
+
+#ifndef RATSNEST_ARENA_H
+#define RATSNEST_ARENA_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+/**
+ * Class RN_ARENA
+ * Hands out memory blocks for the nodes and edges of a single net, so they do not need one heap
+ * allocation each. Blocks of the same size are kept in a free list, and taken from chunks which
+ * grow with the net, so small nets stay small.
+ * The arena lives as long as its owners or any of its blocks, and it is not thread safe: a net
+ * is only modified by one thread at once.
+ */
+class RN_ARENA
+{
+public:
+    RN_ARENA() : m_refCount( 0 )
+    {
+        for( int i = 0; i < ClassCount; ++i )
+        {
+            m_classes[i].m_free = NULL;
+            m_classes[i].m_chunkSize = FirstChunkSize;
+        }
+    }
+
+    ///> Adds an owner of the arena.
+    void Ref()
+    {
+        ++m_refCount;
+    }
+
+    ///> Removes an owner of the arena, which is deleted with the last owner or block.
+    void Unref()
+    {
+        if( --m_refCount == 0 )
+            delete this;
+    }
+
+    /**
+     * Function Alloc()
+     * Returns a block of aSize bytes.
+     */
+    void* Alloc( size_t aSize )
+    {
+        size_t sizeClass = ( aSize + BlockAlign - 1 ) / BlockAlign;
+
+        if( sizeClass == 0 || sizeClass > ClassCount )
+            return ::operator new( aSize );
+
+        SIZE_CLASS& blocks = m_classes[sizeClass - 1];
+
+        if( !blocks.m_free )
+            grow( blocks, sizeClass * BlockAlign );
+
+        BLOCK* block = blocks.m_free;
+        blocks.m_free = block->m_next;
+        ++m_refCount;
+
+        return block;
+    }
+
+    /**
+     * Function Free()
+     * Gives back a block returned by Alloc() with the same aSize.
+     */
+    void Free( void* aBlock, size_t aSize )
+    {
+        size_t sizeClass = ( aSize + BlockAlign - 1 ) / BlockAlign;
+
+        if( sizeClass == 0 || sizeClass > ClassCount )
+        {
+            ::operator delete( aBlock );
+            return;
+        }
+
+        SIZE_CLASS& blocks = m_classes[sizeClass - 1];
+        BLOCK* block = static_cast<BLOCK*>( aBlock );
+        block->m_next = blocks.m_free;
+        blocks.m_free = block;
+
+        Unref();
+    }
+
+private:
+    ///> Blocks are multiples of BlockAlign bytes, up to ClassCount * BlockAlign bytes.
+    static const int BlockAlign = 16;
+    static const int ClassCount = 16;
+
+    ///> Number of blocks of the first chunk of a size, the next ones are twice larger.
+    static const int FirstChunkSize = 4;
+    static const int MaxChunkSize = 256;
+
+    struct BLOCK
+    {
+        BLOCK* m_next;
+    };
+
+    struct SIZE_CLASS
+    {
+        BLOCK* m_free;
+        int m_chunkSize;
+    };
+
+    ~RN_ARENA()
+    {
+        for( unsigned int i = 0; i < m_chunks.size(); ++i )
+            ::operator delete( m_chunks[i] );
+    }
+
+    void grow( SIZE_CLASS& aBlocks, size_t aBlockSize )
+    {
+        char* chunk = static_cast<char*>( ::operator new( aBlocks.m_chunkSize * aBlockSize ) );
+        m_chunks.push_back( chunk );
+
+        for( int i = aBlocks.m_chunkSize - 1; i >= 0; --i )
+        {
+            BLOCK* block = reinterpret_cast<BLOCK*>( chunk + i * aBlockSize );
+            block->m_next = aBlocks.m_free;
+            aBlocks.m_free = block;
+        }
+
+        if( aBlocks.m_chunkSize < MaxChunkSize )
+            aBlocks.m_chunkSize *= 2;
+    }
+
+    ///> Number of owners plus number of blocks in use.
+    int m_refCount;
+
+    SIZE_CLASS m_classes[ClassCount];
+
+    std::vector<char*> m_chunks;
+
+    // Not copyable
+    RN_ARENA( const RN_ARENA& );
+    RN_ARENA& operator=( const RN_ARENA& );
+};
+
+
+/**
+ * Class RN_ALLOCATOR
+ * Standard allocator taking memory from a RN_ARENA. It is meant for boost::allocate_shared(),
+ * which puts the object and its reference count in a single block.
+ */
+template <class T>
+class RN_ALLOCATOR
+{
+public:
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    template <class U>
+    struct rebind
+    {
+        typedef RN_ALLOCATOR<U> other;
+    };
+
+    explicit RN_ALLOCATOR( RN_ARENA* aArena ) : m_arena( aArena )
+    {
+    }
+
+    template <class U>
+    RN_ALLOCATOR( const RN_ALLOCATOR<U>& aOther ) : m_arena( aOther.m_arena )
+    {
+    }
+
+    pointer allocate( size_type aCount, const void* = 0 )
+    {
+        return static_cast<pointer>( m_arena->Alloc( aCount * sizeof( T ) ) );
+    }
+
+    void deallocate( pointer aBlock, size_type aCount )
+    {
+        m_arena->Free( aBlock, aCount * sizeof( T ) );
+    }
+
+    void construct( pointer aBlock, const T& aValue )
+    {
+        new( aBlock ) T( aValue );
+    }
+
+    void destroy( pointer aBlock )
+    {
+        aBlock->~T();
+    }
+
+    size_type max_size() const
+    {
+        return size_type( -1 ) / sizeof( T );
+    }
+
+    pointer address( reference aValue ) const
+    {
+        return &aValue;
+    }
+
+    const_pointer address( const_reference aValue ) const
+    {
+        return &aValue;
+    }
+
+    template <class U>
+    bool operator==( const RN_ALLOCATOR<U>& aOther ) const
+    {
+        return m_arena == aOther.m_arena;
+    }
+
+    template <class U>
+    bool operator!=( const RN_ALLOCATOR<U>& aOther ) const
+    {
+        return m_arena != aOther.m_arena;
+    }
+
+    RN_ARENA* m_arena;
+};
+
+#endif /* RATSNEST_ARENA_H */
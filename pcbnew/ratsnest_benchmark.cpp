@@ -0,0 +1,237 @@
+/**
+ * @file ratsnest_benchmark.cpp
+ * @brief measures the time taken by the ratsnest updates while footprints are dragged.
+ */
+
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/*
+    Usage: ratsnest_benchmark [--steps=<n>] [--modules=<n>] <board file> ...
+
+        --steps=<n>     count of moves of each footprint, 100 by default
+        --modules=<n>   count of footprints dragged, 5 by default
+
+    For each board, the footprints having the most pads are dragged along a
+    circle, one after the other, as the move tool of the GAL canvas does: after
+    each move, RN_DATA::Update() is called for the footprint, then the dirty nets
+    are recomputed.  The time of a full computation of the ratsnest and the mean
+    and worst time of an update are printed, in microseconds.
+
+    e.g. ratsnest_benchmark ../demos/video/video.kicad_pcb ../demos/interf_u/interf_u.kicad_pcb
+*/
+
+
+#include <fctsys.h>
+#include <algorithm>
+#include <cmath>
+#include <wx/init.h>
+#include <wx/filename.h>
+
+#include <macros.h>
+#include <common.h>
+#include <kiway.h>
+#include <pgm_base.h>
+#include <wildcards_and_files_ext.h>
+
+#include <io_mgr.h>
+#include <class_board.h>
+#include <class_module.h>
+#include <ratsnest_data.h>
+
+
+/**
+ * Struct PGM_RATSNEST_BENCHMARK
+ * implements PGM_BASE for this tool, which has no wxApp, like pcbnew_drc does.
+ */
+static struct PGM_RATSNEST_BENCHMARK : public PGM_BASE
+{
+    bool OnPgmInit( wxApp* aWxApp ) { return true; }
+    void OnPgmExit()                { }
+    void MacOpenFile( const wxString& aFileName ) { }
+} program;
+
+
+static void usage()
+{
+    fprintf( stderr,
+             "usage: ratsnest_benchmark [--steps=<n>] [--modules=<n>] <board file> ...\n" );
+}
+
+
+static bool sortPadCount( const MODULE* aFirst, const MODULE* aSecond )
+{
+    return aFirst->GetPadCount() > aSecond->GetPadCount();
+}
+
+
+/**
+ * Function benchmarkBoard
+ * loads a board, then drags its largest footprints and prints the ratsnest timings.
+ * @return false if the board cannot be loaded.
+ */
+static bool benchmarkBoard( const wxString& aFileName, int aSteps, int aModules )
+{
+    IO_MGR::PCB_FILE_T pluginType = IO_MGR::LEGACY;
+
+    if( wxFileName( aFileName ).GetExt() == KiCadPcbFileExtension )
+        pluginType = IO_MGR::KICAD;
+
+    BOARD* board = NULL;
+
+    try
+    {
+        board = IO_MGR::Load( pluginType, aFileName );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        fprintf( stderr, "ratsnest_benchmark: %s\n", TO_UTF8( ioe.errorText ) );
+        return false;
+    }
+
+    if( !board )
+        return false;
+
+    board->BuildListOfNets();
+    board->SynchronizeNetsAndNetClasses();
+
+    RN_DATA ratsnest( board );
+
+    unsigned start = GetRunningMicroSecs();
+    ratsnest.ProcessBoard();
+    ratsnest.Recalculate();
+    unsigned full = GetRunningMicroSecs() - start;
+
+    printf( "%s: %u footprints, %u pads, %u nets, full computation %u us\n",
+            TO_UTF8( wxFileName( aFileName ).GetFullName() ),
+            board->m_Modules.GetCount(), board->GetPadCount(), board->GetNetCount(), full );
+
+    std::vector<MODULE*> modules;
+
+    for( MODULE* module = board->m_Modules; module; module = module->Next() )
+        modules.push_back( module );
+
+    std::sort( modules.begin(), modules.end(), sortPadCount );
+
+    if( (int) modules.size() > aModules )
+        modules.resize( aModules );
+
+    const int radius = Millimeter2iu( 5.0 );
+
+    for( unsigned ii = 0; ii < modules.size(); ++ii )
+    {
+        MODULE* module = modules[ii];
+        wxPoint origin = module->GetPosition();
+        wxPoint current = origin;
+        unsigned total = 0;
+        unsigned worst = 0;
+
+        for( int step = 1; step <= aSteps; ++step )
+        {
+            double  angle = 2.0 * M_PI * step / aSteps;
+            wxPoint next = origin + wxPoint( KiROUND( radius * ( cos( angle ) - 1.0 ) ),
+                                             KiROUND( radius * sin( angle ) ) );
+
+            start = GetRunningMicroSecs();
+            module->Move( next - current );
+            ratsnest.Update( module );
+            ratsnest.Recalculate();
+            unsigned elapsed = GetRunningMicroSecs() - start;
+
+            current = next;
+            total += elapsed;
+            worst = std::max( worst, elapsed );
+        }
+
+        // Put the footprint back where it was
+        module->Move( origin - current );
+        ratsnest.Update( module );
+        ratsnest.Recalculate();
+
+        printf( "    %s (%u pads): update mean %u us, worst %u us\n",
+                TO_UTF8( module->GetReference() ), module->GetPadCount(),
+                aSteps ? total / aSteps : 0, worst );
+    }
+
+    delete board;
+
+    return true;
+}
+
+
+int main( int argc, char** argv )
+{
+    wxInitializer initializer;
+
+    if( !initializer.IsOk() )
+    {
+        fprintf( stderr, "ratsnest_benchmark: cannot initialize wxWidgets\n" );
+        return 1;
+    }
+
+    int kifaceVersion;
+    KIFACE_GETTER( &kifaceVersion, KIFACE_VERSION, &program );
+
+    wxArrayString boardFiles;
+    long steps = 100;
+    long modules = 5;
+
+    for( int ii = 1; ii < argc; ++ii )
+    {
+        wxString arg = FROM_UTF8( argv[ii] );
+        wxString value;
+
+        if( arg.StartsWith( wxT( "--steps=" ), &value ) && value.ToLong( &steps ) && steps > 0 )
+            continue;
+
+        if( arg.StartsWith( wxT( "--modules=" ), &value ) && value.ToLong( &modules ) )
+            continue;
+
+        if( arg.StartsWith( wxT( "-" ) ) )
+        {
+            usage();
+            return 1;
+        }
+
+        boardFiles.Add( arg );
+    }
+
+    if( boardFiles.IsEmpty() )
+    {
+        usage();
+        return 1;
+    }
+
+    int errors = 0;
+
+    for( unsigned ii = 0; ii < boardFiles.GetCount(); ++ii )
+    {
+        if( !benchmarkBoard( boardFiles[ii], steps, modules ) )
+        {
+            fprintf( stderr, "ratsnest_benchmark: cannot load %s\n", TO_UTF8( boardFiles[ii] ) );
+            ++errors;
+        }
+    }
+
+    return errors ? 1 : 0;
+}
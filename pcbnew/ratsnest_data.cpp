@@ -32,6 +32,7 @@
 #endif /* USE_OPENMP */
 
 #include <ratsnest_data.h>
+#include <ttl/ttl.h>
 
 #include <class_board.h>
 #include <class_module.h>
@@ -46,6 +47,7 @@
 
 #include <cassert>
 #include <algorithm>
+#include <cmath>
 #include <limits>
 
 uint64_t getDistance( const RN_NODE_PTR& aNode1, const RN_NODE_PTR& aNode2 )
@@ -59,10 +61,22 @@ uint64_t getDistance( const RN_NODE_PTR& aNode1, const RN_NODE_PTR& aNode2 )
 }
 
 
-bool sortDistance( const RN_NODE_PTR& aOrigin, const RN_NODE_PTR& aNode1,
-                   const RN_NODE_PTR& aNode2 )
+static uint64_t getDistance( const VECTOR2I& aPos1, const VECTOR2I& aPos2 )
 {
-    return getDistance( aOrigin, aNode1 ) < getDistance( aOrigin, aNode2 );
+    // Same as above, for points
+    int64_t x = ( aPos1.x - aPos2.x ) >> 16;
+    int64_t y = ( aPos1.y - aPos2.y ) >> 16;
+
+    return ( x * x + y * y );
+}
+
+
+bool sortPosition( const RN_NODE_PTR& aNode1, const RN_NODE_PTR& aNode2 )
+{
+    if( aNode1->GetX() == aNode2->GetX() )
+        return aNode1->GetY() < aNode2->GetY();
+
+    return aNode1->GetX() < aNode2->GetX();
 }
 
 
@@ -97,7 +111,8 @@ bool isEdgeConnectingNode( const RN_EDGE_PTR& aEdge, const RN_NODE_PTR& aNode )
 
 
 std::vector<RN_EDGE_PTR>* kruskalMST( RN_LINKS::RN_EDGE_LIST& aEdges,
-                                      const std::vector<RN_NODE_PTR>& aNodes )
+                                      const std::vector<RN_NODE_PTR>& aNodes,
+                                      const RN_LINKS& aLinks )
 {
     unsigned int nodeNumber = aNodes.size();
     unsigned int mstExpectedSize = nodeNumber - 1;
@@ -148,9 +163,9 @@ std::vector<RN_EDGE_PTR>* kruskalMST( RN_LINKS::RN_EDGE_LIST& aEdges,
                 // Do a copy of edge, but make it RN_EDGE_MST. In contrary to RN_EDGE,
                 // RN_EDGE_MST saves both source and target node and does not require any other
                 // edges to exist for getting source/target nodes
-                RN_EDGE_MST_PTR newEdge = boost::make_shared<RN_EDGE_MST>( dt->getSourceNode(),
-                                                                           dt->getTargetNode(),
-                                                                           dt->getWeight() );
+                RN_EDGE_MST_PTR newEdge = aLinks.CreateEdge( dt->getSourceNode(),
+                                                             dt->getTargetNode(),
+                                                             dt->getWeight() );
                 mst->push_back( newEdge );
                 ++mstSize;
             }
@@ -179,7 +194,8 @@ void RN_NET::validateEdge( RN_EDGE_PTR& aEdge )
     {
         valid = false;
 
-        std::list<RN_NODE_PTR> closest = GetClosestNodes( source, WITHOUT_FLAG() );
+        // Two nodes are enough, at most one of them is the other end of the edge
+        std::list<RN_NODE_PTR> closest = GetClosestNodes( source, WITHOUT_FLAG(), 2 );
         BOOST_FOREACH( RN_NODE_PTR& node, closest )
         {
             if( node && node != target )
@@ -194,7 +210,7 @@ void RN_NET::validateEdge( RN_EDGE_PTR& aEdge )
     {
         valid = false;
 
-        std::list<RN_NODE_PTR> closest = GetClosestNodes( target, WITHOUT_FLAG() );
+        std::list<RN_NODE_PTR> closest = GetClosestNodes( target, WITHOUT_FLAG(), 2 );
         BOOST_FOREACH( RN_NODE_PTR& node, closest )
         {
             if( node && node != source )
@@ -207,29 +223,188 @@ void RN_NET::validateEdge( RN_EDGE_PTR& aEdge )
 
     // Replace an invalid edge with new, valid one
     if( !valid )
-        aEdge.reset( new RN_EDGE_MST( source, target ) );
+        aEdge = m_links.CreateEdge( source, target );
+}
+
+
+static unsigned int hashPosition( int aX, int aY )
+{
+    unsigned int hash = 2166136261u;
+
+    hash ^= aX;
+    hash *= 16777619;
+    hash ^= aY;
+
+    // Mix the bits, as only the lowest ones select the entry of the table
+    hash ^= hash >> 16;
+    hash *= 0x45d9f3b;
+    hash ^= hash >> 16;
+
+    return hash;
+}
+
+
+RN_LINKS::RN_LINKS() :
+    m_arena( new RN_ARENA ), m_nodeCount( 0 ), m_removedEntries( 0 ), m_edgeCount( 0 ),
+    m_cellSize( 1 ), m_gridColumns( 0 ), m_gridRows( 0 ), m_gridValid( true )
+{
+    m_arena->Ref();
+}
+
+
+RN_LINKS::RN_LINKS( const RN_LINKS& aOther ) :
+    m_arena( aOther.m_arena ), m_nodes( aOther.m_nodes ), m_freeNodes( aOther.m_freeNodes ),
+    m_positions( aOther.m_positions ), m_nodeCount( aOther.m_nodeCount ), m_nodeTable( aOther.m_nodeTable ),
+    m_removedEntries( aOther.m_removedEntries ), m_edges( aOther.m_edges ),
+    m_freeEdges( aOther.m_freeEdges ), m_edgeCount( aOther.m_edgeCount ),
+    m_cellSize( 1 ), m_gridColumns( 0 ), m_gridRows( 0 ), m_gridValid( false )
+{
+    // The nodes and edges are shared, so is their memory
+    m_arena->Ref();
+}
+
+
+RN_LINKS::~RN_LINKS()
+{
+    // The arena stays until the last node or edge is released
+    m_arena->Unref();
+}
+
+
+RN_LINKS& RN_LINKS::operator=( const RN_LINKS& aOther )
+{
+    if( this != &aOther )
+    {
+        aOther.m_arena->Ref();
+        m_arena->Unref();
+        m_arena = aOther.m_arena;
+
+        m_nodes = aOther.m_nodes;
+        m_freeNodes = aOther.m_freeNodes;
+        m_positions = aOther.m_positions;
+        m_nodeCount = aOther.m_nodeCount;
+        m_nodeTable = aOther.m_nodeTable;
+        m_removedEntries = aOther.m_removedEntries;
+        m_edges = aOther.m_edges;
+        m_freeEdges = aOther.m_freeEdges;
+        m_edgeCount = aOther.m_edgeCount;
+        m_gridValid = false;
+    }
+
+    return *this;
+}
+
+
+int RN_LINKS::FindNode( int aX, int aY ) const
+{
+    if( m_nodeTable.empty() )
+        return -1;
+
+    unsigned int mask = m_nodeTable.size() - 1;
+
+    // The table is at most 3/4 full, so there is always an empty entry
+    for( unsigned int i = hashPosition( aX, aY ) & mask; ; i = ( i + 1 ) & mask )
+    {
+        int node = m_nodeTable[i];
+
+        if( node == EMPTY_ENTRY )
+            return -1;
+
+        if( node >= 0 && m_positions[node].x == aX && m_positions[node].y == aY )
+            return node;
+    }
 }
 
 
-const RN_NODE_PTR& RN_LINKS::AddNode( int aX, int aY )
+void RN_LINKS::rehash()
 {
-    RN_NODE_SET::iterator node;
-    bool wasNewElement;
+    unsigned int size = 16;
+
+    while( size < ( m_nodeCount + 1 ) * 2 )
+        size *= 2;
+
+    m_nodeTable.assign( size, EMPTY_ENTRY );
+    m_removedEntries = 0;
+
+    for( unsigned int node = 0; node < m_nodes.size(); ++node )
+    {
+        if( !m_nodes[node] )
+            continue;
+
+        unsigned int i = hashPosition( m_positions[node].x, m_positions[node].y ) & ( size - 1 );
+
+        while( m_nodeTable[i] != EMPTY_ENTRY )
+            i = ( i + 1 ) & ( size - 1 );
+
+        m_nodeTable[i] = node;
+    }
+}
+
+
+int RN_LINKS::AddNode( int aX, int aY )
+{
+    int node = FindNode( aX, aY );
+
+    if( node < 0 )
+    {
+        if( ( m_nodeCount + m_removedEntries + 1 ) * 4 > m_nodeTable.size() * 3 )
+            rehash();
+
+        if( m_freeNodes.empty() )
+        {
+            node = m_nodes.size();
+            m_nodes.push_back( RN_NODE_PTR() );
+            m_positions.push_back( VECTOR2I() );
+        }
+        else
+        {
+            node = m_freeNodes.back();
+            m_freeNodes.pop_back();
+        }
 
-    boost::tie( node, wasNewElement ) = m_nodes.emplace( boost::make_shared<RN_NODE>( aX, aY ) );
-    (*node)->IncRefCount(); // TODO use the shared_ptr use_count
+        m_nodes[node] = boost::allocate_shared<RN_NODE>( RN_ALLOCATOR<RN_NODE>( m_arena ), aX, aY );
+        m_positions[node] = VECTOR2I( aX, aY );
+        ++m_nodeCount;
 
-    return *node;
+        unsigned int mask = m_nodeTable.size() - 1;
+        unsigned int i = hashPosition( aX, aY ) & mask;
+
+        while( m_nodeTable[i] >= 0 )
+            i = ( i + 1 ) & mask;
+
+        if( m_nodeTable[i] == REMOVED_ENTRY )
+            --m_removedEntries;
+
+        m_nodeTable[i] = node;
+        m_gridValid = false;
+    }
+
+    m_nodes[node]->IncRefCount(); // TODO use the shared_ptr use_count
+
+    return node;
 }
 
 
-bool RN_LINKS::RemoveNode( const RN_NODE_PTR& aNode )
+bool RN_LINKS::RemoveNode( int aNode )
 {
-    aNode->DecRefCount(); // TODO use the shared_ptr use_count
+    RN_NODE_PTR& node = m_nodes[aNode];
+    node->DecRefCount(); // TODO use the shared_ptr use_count
 
-    if( aNode->GetRefCount() == 0 )
+    if( node->GetRefCount() == 0 )
     {
-        m_nodes.erase( aNode );
+        unsigned int mask = m_nodeTable.size() - 1;
+        unsigned int i = hashPosition( m_positions[aNode].x, m_positions[aNode].y ) & mask;
+
+        while( m_nodeTable[i] != aNode )
+            i = ( i + 1 ) & mask;
+
+        m_nodeTable[i] = REMOVED_ENTRY;
+        ++m_removedEntries;
+
+        node.reset();
+        m_freeNodes.push_back( aNode );
+        --m_nodeCount;
+        m_gridValid = false;
 
         return true;
     }
@@ -238,61 +413,476 @@ bool RN_LINKS::RemoveNode( const RN_NODE_PTR& aNode )
 }
 
 
-const RN_EDGE_PTR& RN_LINKS::AddConnection( const RN_NODE_PTR& aNode1, const RN_NODE_PTR& aNode2,
-                                            unsigned int aDistance )
+void RN_LINKS::GetNodes( std::vector<RN_NODE_PTR>& aNodes ) const
+{
+    aNodes.reserve( aNodes.size() + m_nodeCount );
+
+    BOOST_FOREACH( const RN_NODE_PTR& node, m_nodes )
+    {
+        if( node )
+            aNodes.push_back( node );
+    }
+}
+
+
+void RN_LINKS::updateGrid() const
+{
+    m_gridNodes.clear();
+    m_gridPositions.clear();
+    m_cellStart.clear();
+    m_gridColumns = 0;
+    m_gridRows = 0;
+    m_gridValid = true;
+
+    if( m_nodeCount == 0 )
+        return;
+
+    // Bounding box of the nodes
+    VECTOR2I min( std::numeric_limits<int>::max(), std::numeric_limits<int>::max() );
+    VECTOR2I max( std::numeric_limits<int>::min(), std::numeric_limits<int>::min() );
+
+    for( unsigned int i = 0; i < m_nodes.size(); ++i )
+    {
+        if( !m_nodes[i] )
+            continue;
+
+        min.x = std::min( min.x, m_positions[i].x );
+        min.y = std::min( min.y, m_positions[i].y );
+        max.x = std::max( max.x, m_positions[i].x );
+        max.y = std::max( max.y, m_positions[i].y );
+    }
+
+    // Size the cells for about two nodes each, also when the nodes are aligned
+    int64_t width = (int64_t) max.x - min.x;
+    int64_t height = (int64_t) max.y - min.y;
+    int64_t cellCount = std::max<int64_t>( 1, m_nodeCount / 2 );
+    int64_t cellSize = std::max( (int64_t) sqrt( (double) width * height / cellCount ),
+                                 std::max( width, height ) / cellCount );
+
+    m_cellSize = std::max<int64_t>( 1, std::min<int64_t>( cellSize,
+                                                          std::numeric_limits<int>::max() ) );
+    m_gridOrigin = min;
+    m_gridColumns = width / m_cellSize + 1;
+    m_gridRows = height / m_cellSize + 1;
+
+    // Sort the nodes by cell (counting sort)
+    std::vector<int> nodeCells( m_nodes.size(), -1 );
+    m_cellStart.assign( m_gridColumns * m_gridRows + 1, 0 );
+
+    for( unsigned int i = 0; i < m_nodes.size(); ++i )
+    {
+        if( !m_nodes[i] )
+            continue;
+
+        int column = ( (int64_t) m_positions[i].x - min.x ) / m_cellSize;
+        int row = ( (int64_t) m_positions[i].y - min.y ) / m_cellSize;
+
+        nodeCells[i] = row * m_gridColumns + column;
+        ++m_cellStart[nodeCells[i] + 1];
+    }
+
+    for( unsigned int i = 1; i < m_cellStart.size(); ++i )
+        m_cellStart[i] += m_cellStart[i - 1];
+
+    std::vector<int> cellEnd( m_cellStart.begin(), m_cellStart.end() - 1 );
+    m_gridNodes.resize( m_nodeCount );
+    m_gridPositions.resize( m_nodeCount );
+
+    for( unsigned int i = 0; i < m_nodes.size(); ++i )
+    {
+        if( nodeCells[i] >= 0 )
+        {
+            int entry = cellEnd[nodeCells[i]]++;
+            m_gridNodes[entry] = i;
+            m_gridPositions[entry] = m_positions[i];
+        }
+    }
+}
+
+
+void RN_LINKS::FindClosestNodes( const VECTOR2I& aOrigin, const RN_NODE_FILTER& aFilter,
+                                 unsigned int aNumber, std::list<RN_NODE_PTR>& aClosest ) const
+{
+    aClosest.clear();
+
+    if( !m_gridValid )
+        updateGrid();
+
+    if( m_gridNodes.empty() || aNumber == 0 )
+        return;
+
+    // Cell of aOrigin, or the closest one if aOrigin lies outside the grid
+    int64_t column = ( (int64_t) aOrigin.x - m_gridOrigin.x ) / m_cellSize;
+    int64_t row = ( (int64_t) aOrigin.y - m_gridOrigin.y ) / m_cellSize;
+    column = std::max<int64_t>( 0, std::min<int64_t>( column, m_gridColumns - 1 ) );
+    row = std::max<int64_t>( 0, std::min<int64_t>( row, m_gridRows - 1 ) );
+
+    int maxRing = std::max( std::max<int>( column, m_gridColumns - 1 - column ),
+                            std::max<int>( row, m_gridRows - 1 - row ) );
+
+    // Max-heap of (distance, index) of the closest nodes found so far
+    std::vector<std::pair<uint64_t, int> > heap;
+
+    // Visit the cells by rings of growing size around the cell of aOrigin
+    for( int ring = 0; ring <= maxRing; ++ring )
+    {
+        // The nodes of this ring and the next ones are at least (ring - 1) cells away
+        if( heap.size() == aNumber && ring > 0 )
+        {
+            uint64_t bound = ( (int64_t) ( ring - 1 ) * m_cellSize ) >> 16;
+
+            if( bound * bound >= heap.front().first )
+                break;
+        }
+
+        int rowStart = std::max<int>( 0, row - ring );
+        int rowEnd = std::min<int>( m_gridRows - 1, row + ring );
+
+        for( int y = rowStart; y <= rowEnd; ++y )
+        {
+            // Only the first and the last rows of the ring are full
+            int step = ( y == row - ring || y == row + ring ) ? 1 : 2 * ring;
+
+            for( int x = column - ring; x <= column + ring; x += step )
+            {
+                if( x < 0 || x >= m_gridColumns )
+                    continue;
+
+                int cell = y * m_gridColumns + x;
+
+                for( int i = m_cellStart[cell]; i < m_cellStart[cell + 1]; ++i )
+                {
+                    const VECTOR2I& position = m_gridPositions[i];
+
+                    // Skip the node located at aOrigin, it is not interesting
+                    if( position == aOrigin )
+                        continue;
+
+                    uint64_t distance = getDistance( aOrigin, position );
+
+                    if( heap.size() < aNumber )
+                    {
+                        if( aFilter( m_nodes[m_gridNodes[i]] ) )
+                        {
+                            heap.push_back( std::make_pair( distance, i ) );
+                            std::push_heap( heap.begin(), heap.end() );
+                        }
+                    }
+                    else if( distance < heap.front().first && aFilter( m_nodes[m_gridNodes[i]] ) )
+                    {
+                        std::pop_heap( heap.begin(), heap.end() );
+                        heap.back() = std::make_pair( distance, i );
+                        std::push_heap( heap.begin(), heap.end() );
+                    }
+                }
+            }
+        }
+    }
+
+    std::sort_heap( heap.begin(), heap.end() );
+
+    for( unsigned int i = 0; i < heap.size(); ++i )
+        aClosest.push_back( m_nodes[m_gridNodes[heap[i].second]] );
+}
+
+
+RN_EDGE_MST_PTR RN_LINKS::CreateEdge( const RN_NODE_PTR& aNode1, const RN_NODE_PTR& aNode2,
+                                      unsigned int aDistance ) const
+{
+    return boost::allocate_shared<RN_EDGE_MST>( RN_ALLOCATOR<RN_EDGE_MST>( m_arena ),
+                                                aNode1, aNode2, aDistance );
+}
+
+
+int RN_LINKS::AddConnection( const RN_NODE_PTR& aNode1, const RN_NODE_PTR& aNode2,
+                             unsigned int aDistance )
+{
+    int edge;
+
+    if( m_freeEdges.empty() )
+    {
+        edge = m_edges.size();
+        m_edges.push_back( RN_EDGE_PTR() );
+    }
+    else
+    {
+        edge = m_freeEdges.back();
+        m_freeEdges.pop_back();
+    }
+
+    m_edges[edge] = CreateEdge( aNode1, aNode2, aDistance );
+    ++m_edgeCount;
+
+    return edge;
+}
+
+
+void RN_LINKS::RemoveConnection( int aEdge )
 {
-    m_edges.push_back( boost::make_shared<RN_EDGE_MST>( aNode1, aNode2, aDistance ) );
+    m_edges[aEdge].reset();
+    m_freeEdges.push_back( aEdge );
+    --m_edgeCount;
+}
+
 
-    return m_edges.back();
+void RN_LINKS::GetConnections( RN_EDGE_LIST& aEdges ) const
+{
+    BOOST_FOREACH( const RN_EDGE_PTR& edge, m_edges )
+    {
+        if( edge )
+            aEdges.push_front( edge );
+    }
 }
 
 
 void RN_NET::compute()
 {
-    const RN_LINKS::RN_NODE_SET& boardNodes = m_links.GetNodes();
-    const RN_LINKS::RN_EDGE_LIST& boardEdges = m_links.GetConnections();
+    std::vector<RN_NODE_PTR> nodes;
+    m_links.GetNodes( nodes );
 
     // Special case that does need so complicated algorithm
-    if( boardNodes.size() == 2 )
+    if( nodes.size() <= 2 )
+    {
+        m_triangulator.reset();
+        m_triangulatedNodes.clear();
+    }
+
+    if( nodes.size() == 2 )
     {
         m_rnEdges.reset( new std::vector<RN_EDGE_PTR>( 0 ) );
 
         // Check if the only possible connection exists
-        if( boardEdges.size() == 0 )
+        if( m_links.GetConnectionCount() == 0 )
         {
-            RN_LINKS::RN_NODE_SET::iterator last = ++boardNodes.begin();
-
             // There can be only one possible connection, but it is missing
-            m_rnEdges->push_back( boost::make_shared<RN_EDGE_MST>( *boardNodes.begin(), *last ) );
+            m_rnEdges->push_back( m_links.CreateEdge( nodes[0], nodes[1] ) );
         }
 
         return;
     }
-    else if( boardNodes.size() <= 1 )   // This case is even simpler
+    else if( nodes.size() <= 1 )   // This case is even simpler
     {
         m_rnEdges.reset( new std::vector<RN_EDGE_PTR>( 0 ) );
 
         return;
     }
 
+    // Edges of the Delaunay triangulation, with their weight/distance
+    boost::scoped_ptr<RN_LINKS::RN_EDGE_LIST> triangEdges( updateTriangulation() );
+
+    // Add the currently existing connections list to the results of triangulation
+    m_links.GetConnections( *triangEdges );
+
+    // Get the minimal spanning tree
+    m_rnEdges.reset( kruskalMST( *triangEdges, nodes, m_links ) );
+}
+
+
+void RN_NET::triangulate()
+{
     // Move and sort (sorting speeds up) all nodes to a vector for the Delaunay triangulation
-    std::vector<RN_NODE_PTR> nodes( boardNodes.size() );
-    std::partial_sort_copy( boardNodes.begin(), boardNodes.end(), nodes.begin(), nodes.end() );
+    std::vector<RN_NODE_PTR> nodes;
+    m_links.GetNodes( nodes );
+    std::sort( nodes.begin(), nodes.end(), sortPosition );
 
-    TRIANGULATOR triangulator;
-    triangulator.createDelaunay( nodes.begin(), nodes.end() );
-    boost::scoped_ptr<RN_LINKS::RN_EDGE_LIST> triangEdges( triangulator.getEdges() );
+    m_triangulator.reset( new TRIANGULATOR );
+    m_triangulatedNodes.clear();
 
-    // Compute weight/distance for edges resulting from triangulation
-    RN_LINKS::RN_EDGE_LIST::iterator eit, eitEnd;
-    for( eit = (*triangEdges).begin(), eitEnd = (*triangEdges).end(); eit != eitEnd; ++eit )
-        (*eit)->setWeight( getDistance( (*eit)->getSourceNode(), (*eit)->getTargetNode() ) );
+    // Same as TRIANGULATOR::createDelaunay(), but the enclosing rectangle is not removed
+    // at the end, so any node can be inserted later
+    ttl::TriangulationHelper helper( *m_triangulator );
+    hed::Dart dart( m_triangulator->initTwoEnclosingTriangles( nodes.begin(), nodes.end() ) );
 
-    // Add the currently existing connections list to the results of triangulation
-    std::copy( boardEdges.begin(), boardEdges.end(), std::front_inserter( *triangEdges ) );
+    BOOST_FOREACH( RN_NODE_PTR& node, nodes )
+    {
+        if( helper.insertNode<hed::TTLtraits>( dart, node ) )
+            m_triangulatedNodes.insert( node );
+    }
+}
 
-    // Get the minimal spanning tree
-    m_rnEdges.reset( kruskalMST( *triangEdges, nodes ) );
+
+RN_LINKS::RN_EDGE_LIST* RN_NET::updateTriangulation()
+{
+    unsigned int nodeCount = m_links.GetNodeCount();
+
+    if( m_triangulator )
+    {
+        ttl::TriangulationHelper helper( *m_triangulator );
+
+        for( int i = 0; i < m_links.GetNodeHandleCount(); ++i )
+        {
+            const RN_NODE_PTR& node = m_links.GetNode( i );
+
+            if( !node )
+                continue;
+
+            // A node at the place of a removed one uses it again
+            if( m_triangulatedNodes.count( node ) )
+                continue;
+
+            // Start the search of the triangle from the last one created, which is
+            // usually close, as the nodes of an item are inserted together
+            hed::Dart dart = m_triangulator->createDart();
+            RN_NODE_PTR newNode = node;
+
+            if( !helper.insertNode<hed::TTLtraits>( dart, newNode ) )
+            {
+                m_triangulator.reset();
+                break;
+            }
+
+            m_triangulatedNodes.insert( node );
+        }
+    }
+
+    // Removed nodes make the next updates slower, so remove them from time to time
+    if( m_triangulator && m_triangulatedNodes.size() > nodeCount +
+            std::max<size_t>( MAX_HOLE_BORDER, nodeCount / DEAD_NODES_DIVISOR ) )
+    {
+        m_triangulator.reset();
+    }
+
+    if( !m_triangulator )
+        triangulate();
+
+    RN_LINKS::RN_EDGE_LIST* edges = triangulationEdges();
+
+    if( !edges )
+    {
+        triangulate();
+        edges = triangulationEdges();
+    }
+
+    return edges;
+}
+
+
+RN_LINKS::RN_EDGE_LIST* RN_NET::triangulationEdges() const
+{
+    /* The triangulation contains nodes which are not in the net any more. Removing
+     * a node from a Delaunay triangulation only creates edges between the nodes around
+     * it, and this is still true for a group of connected removed nodes. So the edges
+     * between nodes of the net, plus the edges between all the nodes around each group
+     * of removed nodes, contain the Delaunay triangulation of the net, and so its minimum
+     * spanning tree. The nodes of the enclosing rectangle are not nodes of the net.
+     */
+    boost::scoped_ptr<std::list<hed::EdgePtr> > triangEdges( m_triangulator->getEdges() );
+    RN_LINKS::RN_EDGE_LIST* edges = new RN_LINKS::RN_EDGE_LIST;
+
+    // Groups of connected removed nodes, and the nodes around them
+    boost::unordered_map<RN_NODE_PTR, int, RN_NODE_HASH, RN_NODE_COMPARE> removedIndex;
+    std::vector<int> groups;
+    std::vector<std::pair<int, RN_NODE_PTR> > borders;
+
+    BOOST_FOREACH( hed::EdgePtr& edge, *triangEdges )
+    {
+        RN_NODE_PTR ends[2] = { edge->getSourceNode(), edge->getTargetNode() };
+        RN_NODE_PTR alive[2];
+        int removed[2] = { -1, -1 };
+        bool enclosing = false;
+
+        for( int i = 0; i < 2; ++i )
+        {
+            int node = m_links.FindNode( ends[i]->GetX(), ends[i]->GetY() );
+
+            if( node >= 0 )
+            {
+                alive[i] = m_links.GetNode( node );
+            }
+            else if( m_triangulatedNodes.count( ends[i] ) )
+            {
+                boost::unordered_map<RN_NODE_PTR, int, RN_NODE_HASH, RN_NODE_COMPARE>::iterator
+                    idx = removedIndex.find( ends[i] );
+
+                if( idx == removedIndex.end() )
+                {
+                    idx = removedIndex.insert( std::make_pair( ends[i], (int) groups.size() ) ).first;
+                    groups.push_back( groups.size() );
+                }
+
+                removed[i] = idx->second;
+            }
+            else
+            {
+                enclosing = true;
+            }
+        }
+
+        if( enclosing )
+            continue;
+
+        if( alive[0] && alive[1] )
+        {
+            unsigned int weight = getDistance( alive[0], alive[1] );
+
+            // Nodes of the triangulation are the nodes of the net, unless a node was
+            // removed and then added again at the same place
+            if( alive[0].get() == ends[0].get() && alive[1].get() == ends[1].get() )
+            {
+                edge->setWeight( weight );
+                edges->push_back( edge );
+            }
+            else
+            {
+                edges->push_back( m_links.CreateEdge( alive[0], alive[1], weight ) );
+            }
+        }
+        else if( alive[0] || alive[1] )
+        {
+            int i = alive[0] ? 1 : 0;
+            borders.push_back( std::make_pair( removed[i], alive[1 - i] ) );
+        }
+        else
+        {
+            // Merge the groups of both removed nodes
+            int a = removed[0];
+            int b = removed[1];
+
+            while( groups[a] != a )
+                a = groups[a] = groups[groups[a]];
+
+            while( groups[b] != b )
+                b = groups[b] = groups[groups[b]];
+
+            groups[b] = a;
+        }
+    }
+
+    // Connect together the nodes around each group of removed nodes
+    std::vector<std::vector<RN_NODE_PTR> > holes( groups.size() );
+
+    for( unsigned int i = 0; i < borders.size(); ++i )
+    {
+        int group = borders[i].first;
+
+        while( groups[group] != group )
+            group = groups[group];
+
+        std::vector<RN_NODE_PTR>& hole = holes[group];
+
+        if( std::find( hole.begin(), hole.end(), borders[i].second ) == hole.end() )
+            hole.push_back( borders[i].second );
+
+        if( hole.size() > MAX_HOLE_BORDER )
+        {
+            delete edges;
+            return NULL;
+        }
+    }
+
+    BOOST_FOREACH( const std::vector<RN_NODE_PTR>& hole, holes )
+    {
+        for( unsigned int i = 0; i < hole.size(); ++i )
+        {
+            for( unsigned int j = i + 1; j < hole.size(); ++j )
+            {
+                edges->push_back( m_links.CreateEdge( hole[i], hole[j],
+                                                      getDistance( hole[i], hole[j] ) ) );
+            }
+        }
+    }
+
+    return edges;
 }
 
 
@@ -315,7 +905,7 @@ RN_POLY::RN_POLY( const CPolyPt* aBegin, const CPolyPt* aEnd, const ZONE_CONTAIN
             RN_LINKS& aConnections, const BOX2I& aBBox ) :
     m_parent( aParent), m_begin( aBegin ), m_end( aEnd ), m_bbox( aBBox )
 {
-    m_node = aConnections.AddNode( m_begin->x, m_begin->y );
+    m_node = aConnections.GetNode( aConnections.AddNode( m_begin->x, m_begin->y ) );
 
     // Mark it as not feasible as a destination of ratsnest edges
     // (edges coming out from a polygon vertex look weird)
@@ -386,8 +976,7 @@ void RN_NET::Update()
 
 void RN_NET::AddItem( const D_PAD* aPad )
 {
-    RN_NODE_PTR nodePtr = m_links.AddNode( aPad->GetPosition().x, aPad->GetPosition().y );
-    m_pads[aPad] = nodePtr;
+    m_pads[aPad] = m_links.AddNode( aPad->GetPosition().x, aPad->GetPosition().y );
 
     m_dirty = true;
 }
@@ -403,10 +992,10 @@ void RN_NET::AddItem( const SEGVIA* aVia )
 
 void RN_NET::AddItem( const TRACK* aTrack )
 {
-    RN_NODE_PTR start = m_links.AddNode( aTrack->GetStart().x, aTrack->GetStart().y );
-    RN_NODE_PTR end = m_links.AddNode( aTrack->GetEnd().x, aTrack->GetEnd().y );
+    int start = m_links.AddNode( aTrack->GetStart().x, aTrack->GetStart().y );
+    int end = m_links.AddNode( aTrack->GetEnd().x, aTrack->GetEnd().y );
 
-    m_tracks[aTrack] = m_links.AddConnection( start, end );
+    m_tracks[aTrack] = m_links.AddConnection( m_links.GetNode( start ), m_links.GetNode( end ) );
 
     m_dirty = true;
 }
@@ -467,10 +1056,11 @@ void RN_NET::RemoveItem( const D_PAD* aPad )
 {
     try
     {
-        RN_NODE_PTR node = m_pads.at( aPad );
+        int node = m_pads.at( aPad );
+        RN_NODE_PTR nodePtr = m_links.GetNode( node );
 
         if( m_links.RemoveNode( node ) )
-            clearNode( node );
+            clearNode( nodePtr );
 
         m_pads.erase( aPad );
 
@@ -486,10 +1076,11 @@ void RN_NET::RemoveItem( const SEGVIA* aVia )
 {
     try
     {
-        RN_NODE_PTR node = m_vias.at( aVia );
+        int node = m_vias.at( aVia );
+        RN_NODE_PTR nodePtr = m_links.GetNode( node );
 
         if( m_links.RemoveNode( node ) )
-            clearNode( node );
+            clearNode( nodePtr );
 
         m_vias.erase( aVia );
 
@@ -505,19 +1096,19 @@ void RN_NET::RemoveItem( const TRACK* aTrack )
 {
     try
     {
-        RN_EDGE_PTR& edge = m_tracks.at( aTrack );
+        int edge = m_tracks.at( aTrack );
 
         // Save nodes, so they can be cleared later
-        RN_NODE_PTR aBegin = edge->getSourceNode();
-        RN_NODE_PTR aEnd = edge->getTargetNode();
+        RN_NODE_PTR aBegin = m_links.GetConnection( edge )->getSourceNode();
+        RN_NODE_PTR aEnd = m_links.GetConnection( edge )->getTargetNode();
         m_links.RemoveConnection( edge );
 
         // Remove nodes associated with the edge. It is done in a safe way, there is a check
         // if nodes are not used by other edges.
-        if( m_links.RemoveNode( aBegin ) )
+        if( m_links.RemoveNode( m_links.FindNode( aBegin->GetX(), aBegin->GetY() ) ) )
             clearNode( aBegin );
 
-        if( m_links.RemoveNode( aEnd ) )
+        if( m_links.RemoveNode( m_links.FindNode( aEnd->GetX(), aEnd->GetY() ) ) )
             clearNode( aEnd );
 
         m_tracks.erase( aTrack );
@@ -540,14 +1131,14 @@ void RN_NET::RemoveItem( const ZONE_CONTAINER* aZone )
         {
             const RN_NODE_PTR node = polygon.GetNode();
 
-            if( m_links.RemoveNode( node ) )
+            if( m_links.RemoveNode( m_links.FindNode( node->GetX(), node->GetY() ) ) )
                 clearNode( node );
         }
         polygons.clear();
 
         // Remove all connections added by the zone
-        std::deque<RN_EDGE_PTR>& edges = m_zoneConnections.at( aZone );
-        BOOST_FOREACH( RN_EDGE_PTR& edge, edges )
+        std::deque<int>& edges = m_zoneConnections.at( aZone );
+        BOOST_FOREACH( int edge, edges )
             m_links.RemoveConnection( edge );
         edges.clear();
 
@@ -561,109 +1152,62 @@ void RN_NET::RemoveItem( const ZONE_CONTAINER* aZone )
 
 const RN_NODE_PTR RN_NET::GetClosestNode( const RN_NODE_PTR& aNode ) const
 {
-    const RN_LINKS::RN_NODE_SET& nodes = m_links.GetNodes();
-    RN_LINKS::RN_NODE_SET::const_iterator it, itEnd;
-
-    unsigned int minDistance = std::numeric_limits<unsigned int>::max();
-    RN_NODE_PTR closest;
-
-    for( it = nodes.begin(), itEnd = nodes.end(); it != itEnd; ++it )
-    {
-        RN_NODE_PTR node = *it;
-
-        // Obviously the distance between node and itself is the shortest,
-        // that's why we have to skip it
-        if( node != aNode )
-        {
-            unsigned int distance = getDistance( node, aNode );
-            if( distance < minDistance )
-            {
-                minDistance = distance;
-                closest = node;
-            }
-        }
-    }
-
-    return closest;
+    return GetClosestNode( aNode, RN_NODE_FILTER() );
 }
 
 
 const RN_NODE_PTR RN_NET::GetClosestNode( const RN_NODE_PTR& aNode,
                                           const RN_NODE_FILTER& aFilter ) const
 {
-    const RN_LINKS::RN_NODE_SET& nodes = m_links.GetNodes();
-    RN_LINKS::RN_NODE_SET::const_iterator it, itEnd;
-
-    unsigned int minDistance = std::numeric_limits<unsigned int>::max();
-    RN_NODE_PTR closest;
-
-    for( it = nodes.begin(), itEnd = nodes.end(); it != itEnd; ++it )
-    {
-        RN_NODE_PTR node = *it;
-
-        // Obviously the distance between node and itself is the shortest,
-        // that's why we have to skip it
-        if( node != aNode && aFilter( node ) )
-        {
-            unsigned int distance = getDistance( node, aNode );
+    std::list<RN_NODE_PTR> closest;
+    m_links.FindClosestNodes( VECTOR2I( aNode->GetX(), aNode->GetY() ), aFilter, 1, closest );
 
-            if( distance < minDistance )
-            {
-                minDistance = distance;
-                closest = node;
-            }
-        }
-    }
+    if( closest.empty() )
+        return RN_NODE_PTR();
 
-    return closest;
+    return closest.front();
 }
 
 
 std::list<RN_NODE_PTR> RN_NET::GetClosestNodes( const RN_NODE_PTR& aNode, int aNumber ) const
 {
-    std::list<RN_NODE_PTR> closest;
-    const RN_LINKS::RN_NODE_SET& nodes = m_links.GetNodes();
-
-    // Copy nodes
-    BOOST_FOREACH( const RN_NODE_PTR& node, nodes )
-        closest.push_back( node );
-
-    // Sort by the distance from aNode
-    closest.sort( boost::bind( sortDistance, aNode, _1, _2 ) );
-
-    // Remove the first node (==aNode), as it is surely located within the smallest distance
-    closest.pop_front();
-
-    // Trim the result to the asked size
-    if( aNumber > 0 )
-        closest.resize( std::min( (size_t)aNumber, nodes.size() ) );
-
-    return closest;
+    return GetClosestNodes( aNode, RN_NODE_FILTER(), aNumber );
 }
 
 
 std::list<RN_NODE_PTR> RN_NET::GetClosestNodes( const RN_NODE_PTR& aNode,
                                                 const RN_NODE_FILTER& aFilter, int aNumber ) const
 {
+    const VECTOR2I origin( aNode->GetX(), aNode->GetY() );
     std::list<RN_NODE_PTR> closest;
-    const RN_LINKS::RN_NODE_SET& nodes = m_links.GetNodes();
 
-    // Copy nodes
-    BOOST_FOREACH( const RN_NODE_PTR& node, nodes )
-        closest.push_back( node );
+    // A few nodes are found using the grid of nodes
+    if( aNumber > 0 )
+    {
+        m_links.FindClosestNodes( origin, aFilter, aNumber, closest );
 
-    // Sort by the distance from aNode
-    closest.sort( boost::bind( sortDistance, aNode, _1, _2 ) );
+        return closest;
+    }
 
-    // Remove the first node (==aNode), as it is surely located within the smallest distance
-    closest.pop_front();
+    // Pairs of distance from aNode and node handle, for the nodes passing the filter
+    typedef std::pair<uint64_t, int> CANDIDATE;
+    std::vector<CANDIDATE> candidates;
+    candidates.reserve( m_links.GetNodeCount() );
 
-    // Filter out by condition
-    std::remove_if( closest.begin(), closest.end(), aFilter );
+    for( int i = 0; i < m_links.GetNodeHandleCount(); ++i )
+    {
+        const RN_NODE_PTR& node = m_links.GetNode( i );
 
-    // Trim the result to the asked size
-    if( aNumber > 0 )
-        closest.resize( std::min( static_cast<size_t>( aNumber ), nodes.size() ) );
+        // Skip aNode, as it is surely located within the smallest distance
+        if( node && m_links.GetPosition( i ) != origin && aFilter( node ) )
+            candidates.push_back( CANDIDATE( getDistance( origin, m_links.GetPosition( i ) ), i ) );
+    }
+
+    // Sort by the distance from aNode
+    std::sort( candidates.begin(), candidates.end() );
+
+    for( unsigned int i = 0; i < candidates.size(); ++i )
+        closest.push_back( m_links.GetNode( candidates[i].second ) );
 
     return closest;
 }
@@ -680,21 +1224,21 @@ std::list<RN_NODE_PTR> RN_NET::GetNodes( const BOARD_CONNECTED_ITEM* aItem ) con
         case PCB_PAD_T:
         {
             const D_PAD* pad = static_cast<const D_PAD*>( aItem );
-            nodes.push_back( m_pads.at( pad ) );
+            nodes.push_back( m_links.GetNode( m_pads.at( pad ) ) );
         }
         break;
 
         case PCB_VIA_T:
         {
             const SEGVIA* via = static_cast<const SEGVIA*>( aItem );
-            nodes.push_back( m_vias.at( via ) );
+            nodes.push_back( m_links.GetNode( m_vias.at( via ) ) );
         }
         break;
 
         case PCB_TRACE_T:
         {
             const TRACK* track = static_cast<const TRACK*>( aItem );
-            RN_EDGE_PTR edge = m_tracks.at( track );
+            const RN_EDGE_PTR& edge = m_links.GetConnection( m_tracks.at( track ) );
 
             nodes.push_back( edge->getSourceNode() );
             nodes.push_back( edge->getTargetNode() );
@@ -786,19 +1330,19 @@ void RN_DATA::AddSimple( const VECTOR2I& aPosition, int aNetCode )
 
 void RN_NET::processZones()
 {
-    BOOST_FOREACH( std::deque<RN_EDGE_PTR>& edges, m_zoneConnections | boost::adaptors::map_values )
+    BOOST_FOREACH( std::deque<int>& edges, m_zoneConnections | boost::adaptors::map_values )
     {
-        BOOST_FOREACH( RN_EDGE_PTR& edge, edges )
+        BOOST_FOREACH( int edge, edges )
             m_links.RemoveConnection( edge );
 
         edges.clear();
     }
 
-    RN_LINKS::RN_NODE_SET candidates = m_links.GetNodes();
+    std::vector<RN_NODE_PTR> candidates;
+    m_links.GetNodes( candidates );
 
     BOOST_FOREACH( std::deque<RN_POLY>& polygons, m_zonePolygons | boost::adaptors::map_values )
     {
-        RN_LINKS::RN_NODE_SET::iterator point, pointEnd;
         std::deque<RN_POLY>::iterator poly, polyEnd;
 
         // Sorting by area should speed up the processing, as smaller polygons are computed
@@ -807,19 +1351,18 @@ void RN_NET::processZones()
 
         for( poly = polygons.begin(), polyEnd = polygons.end(); poly != polyEnd; ++poly )
         {
-            point = candidates.begin();
-            pointEnd = candidates.end();
+            unsigned int point = 0;
 
-            while( point != pointEnd )
+            while( point < candidates.size() )
             {
-                if( poly->HitTest( *point ) )
+                if( poly->HitTest( candidates[point] ) )
                 {
-                    const RN_EDGE_PTR& connection = m_links.AddConnection( poly->GetNode(), *point );
+                    int connection = m_links.AddConnection( poly->GetNode(), candidates[point] );
                     m_zoneConnections[poly->GetParent()].push_back( connection );
 
                     // This point already belongs to a polygon, we do not need to check it anymore
-                    point = candidates.erase( point );
-                    pointEnd = candidates.end();
+                    candidates[point] = candidates.back();
+                    candidates.pop_back();
                 }
                 else
                 {
@@ -954,6 +1497,10 @@ void RN_DATA::ProcessBoard()
     m_nets.resize( m_board->GetNetCount() );
     int netCode;
 
+    // Items are sorted by net first, then every net is filled by its own thread:
+    // nets do not share nodes nor edges.
+    std::vector<std::vector<BOARD_CONNECTED_ITEM*> > netItems( m_nets.size() );
+
     // Iterate over all items that may need to be connected
     for( MODULE* module = m_board->m_Modules; module; module = module->Next() )
     {
@@ -962,7 +1509,7 @@ void RN_DATA::ProcessBoard()
             netCode = pad->GetNetCode();
 
             if( netCode > 0 )
-                m_nets[netCode].AddItem( pad );
+                netItems[netCode].push_back( pad );
         }
     }
 
@@ -970,13 +1517,8 @@ void RN_DATA::ProcessBoard()
     {
         netCode = track->GetNetCode();
 
-        if( netCode > 0 )
-        {
-            if( track->Type() == PCB_VIA_T )
-                m_nets[netCode].AddItem( static_cast<SEGVIA*>( track ) );
-            else if( track->Type() == PCB_TRACE_T )
-                m_nets[netCode].AddItem( track );
-        }
+        if( netCode > 0 && ( track->Type() == PCB_VIA_T || track->Type() == PCB_TRACE_T ) )
+            netItems[netCode].push_back( track );
     }
 
     for( int i = 0; i < m_board->GetAreaCount(); ++i )
@@ -985,8 +1527,50 @@ void RN_DATA::ProcessBoard()
         netCode = zone->GetNetCode();
 
         if( netCode > 0 )
-            m_nets[netCode].AddItem( zone );
+            netItems[netCode].push_back( zone );
     }
+
+    int netCount = netItems.size();
+
+#ifdef USE_OPENMP
+    #pragma omp parallel for schedule(dynamic, 16)
+#endif /* USE_OPENMP */
+    for( int i = 1; i < netCount; ++i )
+    {
+        RN_NET& net = m_nets[i];
+
+        BOOST_FOREACH( BOARD_CONNECTED_ITEM* item, netItems[i] )
+        {
+            switch( item->Type() )
+            {
+            case PCB_PAD_T:
+                net.AddItem( static_cast<D_PAD*>( item ) );
+                break;
+
+            case PCB_VIA_T:
+                net.AddItem( static_cast<SEGVIA*>( item ) );
+                break;
+
+            case PCB_TRACE_T:
+                net.AddItem( static_cast<TRACK*>( item ) );
+                break;
+
+            case PCB_ZONE_AREA_T:
+                net.AddItem( static_cast<ZONE_CONTAINER*>( item ) );
+                break;
+
+            default:
+                break;
+            }
+        }
+    }
+}
+
+
+static bool sortNodeCount( const std::pair<unsigned int, int>& aFirst,
+                           const std::pair<unsigned int, int>& aSecond )
+{
+    return aFirst.first > aSecond.first;
 }
 
 
@@ -994,23 +1578,26 @@ void RN_DATA::Recalculate( int aNet )
 {
     if( aNet < 0 )              // Recompute everything
     {
-        unsigned int i, netCount;
-        netCount = m_board->GetNetCount();
+        // Dirty nets, the largest first: a large net started last would keep
+        // a single thread busy while the others have nothing left to do.
+        std::vector<std::pair<unsigned int, int> > dirtyNets;
 
-#ifdef USE_OPENMP
-        #pragma omp parallel shared(netCount) private(i)
-        {
-            #pragma omp for schedule(guided, 1)
-#else /* USE_OPENMP */
+        // Start with net number 1, as 0 stands for not connected
+        for( unsigned int i = 1; i < m_nets.size(); ++i )
         {
-#endif
-            // Start with net number 1, as 0 stands for not connected
-            for( i = 1; i < netCount; ++i )
-            {
-                if( m_nets[i].IsDirty() )
-                    updateNet( i );
-            }
-        }  /* end of parallel section */
+            if( m_nets[i].IsDirty() )
+                dirtyNets.push_back( std::make_pair( m_nets[i].GetNodeCount(), (int) i ) );
+        }
+
+        std::sort( dirtyNets.begin(), dirtyNets.end(), sortNodeCount );
+
+        int dirtyCount = dirtyNets.size();
+
+#ifdef USE_OPENMP
+        #pragma omp parallel for schedule(dynamic, 1)
+#endif /* USE_OPENMP */
+        for( int i = 0; i < dirtyCount; ++i )
+            updateNet( dirtyNets[i].second );
     }
     else if( aNet > 0 )         // Recompute only specific net
     {
@@ -34,6 +34,7 @@
 #include <ttl/halfedge/hetraits.h>
 
 #include <math/box2.h>
+#include <ratsnest_arena.h>
 
 #include <boost/unordered_set.hpp>
 #include <boost/unordered_map.hpp>
@@ -110,7 +111,9 @@ struct RN_NODE_HASH : std::unary_function<RN_NODE_PTR, std::size_t>
 
 /**
  * Class RN_LINKS
- * Manages data describing nodes and connections for a given net.
+ * Manages data describing nodes and connections for a given net. Nodes and connections are
+ * stored in tables and referred to by handles, which stay valid until they are removed. Their
+ * memory is taken from an arena owned by the net.
  */
 class RN_LINKS
 {
@@ -119,34 +122,97 @@ public:
     typedef boost::unordered_set<RN_NODE_PTR, RN_NODE_HASH, RN_NODE_COMPARE> RN_NODE_SET;
     typedef std::list<RN_EDGE_PTR> RN_EDGE_LIST;
 
+    RN_LINKS();
+    RN_LINKS( const RN_LINKS& aOther );
+    ~RN_LINKS();
+
+    RN_LINKS& operator=( const RN_LINKS& aOther );
+
     /**
      * Function AddNode()
-     * Adds a node with given coordinates and returns pointer to the newly added node. If the node
-     * existed before, only appropriate pointer is returned.
+     * Adds a node with given coordinates and returns its handle. If the node existed before,
+     * only its handle is returned.
      * @param aX is the x coordinate of a node.
      * @param aY is the y coordinate of a node.
-     * @return Pointer to the node with given coordinates.
+     * @return Handle of the node with given coordinates.
      */
-    const RN_NODE_PTR& AddNode( int aX, int aY );
+    int AddNode( int aX, int aY );
 
     /**
      * Function RemoveNode()
-     * Removes a node described by a given node pointer.
-     * @param aNode is a pointer to node to be removed.
+     * Removes a reference to a node, the node is removed with its last reference.
+     * @param aNode is the handle of the node to be removed.
      * @return True if node was removed, false if there were other references, so it was kept.
      */
-    bool RemoveNode( const RN_NODE_PTR& aNode );
+    bool RemoveNode( int aNode );
 
     /**
-     * Function GetNodes()
-     * Returns the set of currently used nodes.
-     * @return The set of currently used nodes.
+     * Function FindNode()
+     * Returns the handle of the node with given coordinates, or -1 if there is no such node.
+     */
+    int FindNode( int aX, int aY ) const;
+
+    /**
+     * Function GetNode()
+     * Returns the node of a handle, which is empty if the handle is not used.
+     */
+    const RN_NODE_PTR& GetNode( int aNode ) const
+    {
+        return m_nodes[aNode];
+    }
+
+    /**
+     * Function GetPosition()
+     * Returns the position of the node of a used handle.
+     */
+    const VECTOR2I& GetPosition( int aNode ) const
+    {
+        return m_positions[aNode];
+    }
+
+    /**
+     * Function GetNodeHandleCount()
+     * Returns the end of the range of node handles. Some handles of the range may be unused.
      */
-    const RN_NODE_SET& GetNodes() const
+    int GetNodeHandleCount() const
     {
-        return m_nodes;
+        return m_nodes.size();
     }
 
+    /**
+     * Function GetNodeCount()
+     * Returns the number of currently used nodes.
+     */
+    unsigned int GetNodeCount() const
+    {
+        return m_nodeCount;
+    }
+
+    /**
+     * Function GetNodes()
+     * Appends the currently used nodes to a vector.
+     */
+    void GetNodes( std::vector<RN_NODE_PTR>& aNodes ) const;
+
+    /**
+     * Function FindClosestNodes()
+     * Looks for the nodes closest to a point. Only the grid cells which may contain them are
+     * visited, so the time does not depend much on the number of nodes.
+     * @param aOrigin is the point, a node located exactly there is skipped.
+     * @param aFilter is a functor that filters nodes.
+     * @param aNumber is the maximal number of nodes searched.
+     * @param aClosest is filled with the closest nodes, sorted by their distance from aOrigin.
+     */
+    void FindClosestNodes( const VECTOR2I& aOrigin, const RN_NODE_FILTER& aFilter,
+                           unsigned int aNumber, std::list<RN_NODE_PTR>& aClosest ) const;
+
+    /**
+     * Function CreateEdge()
+     * Returns a new edge allocated in the arena of the net, which is not added to connections.
+     */
+    RN_EDGE_MST_PTR CreateEdge( const RN_NODE_PTR& aNode1, const RN_NODE_PTR& aNode2,
+                                unsigned int aDistance = 0 ) const;
+
     /**
      * Function AddConnection()
      * Adds a connection between two nodes and of given distance. Edges with distance equal 0 are
@@ -156,36 +222,96 @@ public:
      * @param aNode2 is the end node of a new connection.
      * @param aDistance is the distance of the connection (0 means that nodes are actually
      * connected, >0 means a missing connection).
+     * @return Handle of the new connection.
      */
-    const RN_EDGE_PTR& AddConnection( const RN_NODE_PTR& aNode1, const RN_NODE_PTR& aNode2,
-                                      unsigned int aDistance = 0 );
+    int AddConnection( const RN_NODE_PTR& aNode1, const RN_NODE_PTR& aNode2,
+                       unsigned int aDistance = 0 );
 
     /**
      * Function RemoveConnection()
-     * Removes a connection described by a given edge pointer.
-     * @param aEdge is a pointer to edge to be removed.
+     * Removes a connection described by a given handle.
+     * @param aEdge is the handle of the edge to be removed.
      */
-    void RemoveConnection( const RN_EDGE_PTR& aEdge )
+    void RemoveConnection( int aEdge );
+
+    /**
+     * Function GetConnection()
+     * Returns the edge of a connection handle.
+     */
+    const RN_EDGE_PTR& GetConnection( int aEdge ) const
     {
-        m_edges.remove( aEdge );
+        return m_edges[aEdge];
     }
 
     /**
-     * Function GetConnections()
-     * Returns the list of edges that currently connect nodes.
-     * @return the list of edges that currently connect nodes.
+     * Function GetConnectionCount()
+     * Returns the number of edges that currently connect nodes.
      */
-    const RN_EDGE_LIST& GetConnections() const
+    unsigned int GetConnectionCount() const
     {
-        return m_edges;
+        return m_edgeCount;
     }
 
+    /**
+     * Function GetConnections()
+     * Adds the edges that currently connect nodes at the front of a list.
+     */
+    void GetConnections( RN_EDGE_LIST& aEdges ) const;
+
 protected:
-    ///> Set of nodes that are used are expected to be connected together.
-    RN_NODE_SET m_nodes;
+    ///> Values of the entries of m_nodeTable which are not node handles.
+    enum
+    {
+        EMPTY_ENTRY = -1,
+        REMOVED_ENTRY = -2
+    };
+
+    ///> Builds m_nodeTable again, at most half full with the nodes and one more.
+    void rehash();
+
+    /**
+     * Function updateGrid()
+     * Sorts the nodes by the cells of a grid sized for about two nodes per cell.
+     */
+    void updateGrid() const;
+
+    ///> Memory of the nodes and the edges.
+    RN_ARENA* m_arena;
+
+    ///> Nodes that are used are expected to be connected together, indexed by handle.
+    ///> Unused handles hold an empty pointer and are listed in m_freeNodes.
+    std::vector<RN_NODE_PTR> m_nodes;
+    std::vector<int> m_freeNodes;
+
+    ///> Positions of the nodes, indexed by handle, so searches do not need to load the nodes.
+    std::vector<VECTOR2I> m_positions;
+    unsigned int m_nodeCount;
+
+    ///> Open addressing hash table of node handles, to find nodes by their coordinates.
+    ///> Its size is a power of two, and it is at most 3/4 full.
+    std::vector<int> m_nodeTable;
+    unsigned int m_removedEntries;
 
-    ///> List of edges that currently connect nodes.
-    RN_EDGE_LIST m_edges;
+    ///> Edges that currently connect nodes, indexed by handle, like nodes.
+    std::vector<RN_EDGE_PTR> m_edges;
+    std::vector<int> m_freeEdges;
+    unsigned int m_edgeCount;
+
+    ///> Handles and positions of the nodes sorted by grid cell, rebuilt from m_nodes on demand.
+    mutable std::vector<int> m_gridNodes;
+    mutable std::vector<VECTOR2I> m_gridPositions;
+
+    ///> Index of the first node of every grid cell in m_gridNodes, plus the node count.
+    mutable std::vector<int> m_cellStart;
+
+    ///> Grid of nodes: position of its first cell, size of the cells and count of cells.
+    mutable VECTOR2I m_gridOrigin;
+    mutable int m_cellSize;
+    mutable int m_gridColumns;
+    mutable int m_gridRows;
+
+    ///> Flag telling if the grid matches m_nodes.
+    mutable bool m_gridValid;
 };
 
 
@@ -261,6 +387,14 @@ public:
     RN_NET() : m_dirty( true ), m_visible( true )
     {}
 
+    ///> Largest count of removed nodes kept in the triangulation, relative to the count
+    ///> of nodes of the net (see updateTriangulation()).
+    static const int DEAD_NODES_DIVISOR = 8;
+
+    ///> Largest count of nodes around an area of removed nodes, before the triangulation
+    ///> is built again.
+    static const unsigned int MAX_HOLE_BORDER = 32;
+
     /**
      * Function SetVisible()
      * Sets state of the visibility flag.
@@ -302,6 +436,15 @@ public:
         return m_dirty;
     }
 
+    /**
+     * Function GetNodeCount()
+     * Returns the number of nodes of the net.
+     */
+    unsigned int GetNodeCount() const
+    {
+        return m_links.GetNodeCount();
+    }
+
     /**
      * Function GetUnconnected()
      * Returns pointer to a vector of edges that makes ratsnest for a given net.
@@ -503,12 +646,31 @@ protected:
     ///> Recomputes ratsnset from scratch.
     void compute();
 
+    ///> Builds m_triangulator again, with the current nodes of the net.
+    void triangulate();
+
+    ///> Inserts the new nodes of the net in m_triangulator, building it again when needed,
+    ///> and returns the edges which can make the minimum spanning tree.
+    RN_LINKS::RN_EDGE_LIST* updateTriangulation();
+
+    ///> Returns the edges of m_triangulator between nodes of the net, with the edges replacing
+    ///> the removed nodes, or NULL if an area of removed nodes is too large.
+    RN_LINKS::RN_EDGE_LIST* triangulationEdges() const;
+
     ////> Stores information about connections for a given net.
     RN_LINKS m_links;
 
     ///> Vector of edges that makes ratsnest for a given net.
     boost::shared_ptr< std::vector<RN_EDGE_PTR> > m_rnEdges;
 
+    ///> Delaunay triangulation of the nodes, kept between updates. It keeps its enclosing
+    ///> rectangle, so nodes can be inserted without triangulating again the whole net.
+    boost::shared_ptr<TRIANGULATOR> m_triangulator;
+
+    ///> Nodes inserted in m_triangulator. The ones which are not in m_links any more
+    ///> are removed nodes, they stay in the triangulation until it is built again.
+    RN_LINKS::RN_NODE_SET m_triangulatedNodes;
+
     ///> List of nodes for which ratsnest is drawn in simple mode.
     std::deque<RN_NODE_PTR> m_simpleNodes;
 
@@ -519,19 +681,19 @@ protected:
     bool m_dirty;
 
     ///> Map that associates nodes in the ratsnest model to respective nodes.
-    boost::unordered_map<const D_PAD*, RN_NODE_PTR> m_pads;
+    boost::unordered_map<const D_PAD*, int> m_pads;
 
     ///> Map that associates nodes in the ratsnest model to respective vias.
-    boost::unordered_map<const SEGVIA*, RN_NODE_PTR> m_vias;
+    boost::unordered_map<const SEGVIA*, int> m_vias;
 
     ///> Map that associates edges in the ratsnest model to respective tracks.
-    boost::unordered_map<const TRACK*, RN_EDGE_PTR> m_tracks;
+    boost::unordered_map<const TRACK*, int> m_tracks;
 
     ///> Map that associates groups of subpolygons in the ratsnest model to their respective zones.
     boost::unordered_map<const ZONE_CONTAINER*, std::deque<RN_POLY> > m_zonePolygons;
 
     ///> Map that associates groups of edges in the ratsnest model to their respective zones.
-    boost::unordered_map<const ZONE_CONTAINER*, std::deque<RN_EDGE_PTR> > m_zoneConnections;
+    boost::unordered_map<const ZONE_CONTAINER*, std::deque<int> > m_zoneConnections;
 
     ///> Visibility flag.
     bool m_visible;
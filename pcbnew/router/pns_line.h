@@ -30,6 +30,7 @@
 #include "direction.h"
 #include "pns_item.h"
 #include "pns_via.h"
+#include "pns_pool.h"
 
 class PNS_NODE;
 class PNS_SEGMENT;
@@ -120,6 +121,17 @@ public:
     ///> (just the properties - net, width, layers, etc.)
     PNS_LINE* CloneProperties() const;
 
+    ///> Lines are created for each candidate path, their memory is recycled.
+    static void* operator new( size_t aSize )
+    {
+        return PNS_POOL<PNS_LINE>::Alloc( aSize );
+    }
+
+    static void operator delete( void* aPtr, size_t aSize )
+    {
+        PNS_POOL<PNS_LINE>::Free( aPtr, aSize );
+    }
+
     int GetLayer() const { return GetLayers().Start(); }
 
     ///> Geometry accessors
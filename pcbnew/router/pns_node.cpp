@@ -19,6 +19,7 @@
  */
 
 #include <vector>
+#include <algorithm>
 #include <cassert>
 
 #include <math/vector2d.h>
@@ -27,6 +28,7 @@
 #include <geometry/shape.h>
 #include <geometry/shape_line_chain.h>
 #include <geometry/shape_index.h>
+#include <geometry/seg_boxes.h>
 
 #include "trace.h"
 #include "pns_item.h"
@@ -79,6 +81,12 @@ PNS_NODE::~PNS_NODE()
 }
 
 
+int PNS_NODE::AllocatedNodeCount()
+{
+    return allocNodes.size();
+}
+
+
 int PNS_NODE::GetClearance( const PNS_ITEM* a, const PNS_ITEM* b ) const
 {
     int clearance = (*m_clearanceFunctor)( a, b );
@@ -109,24 +117,8 @@ PNS_NODE* PNS_NODE::Branch()
     child->m_clearanceFunctor = m_clearanceFunctor;
     child->m_root = isRoot() ? this : m_root;
 
-    // immmediate offspring of the root branch needs not copy anything.
-    // For the rest, deep-copy joints, overridden item map and pointers
-    // to stored items.
-    if( !isRoot() )
-    {
-        JointMap::iterator j;
-
-        for( PNS_INDEX::ItemSet::iterator i = m_index->begin();
-             i != m_index->end(); ++i )
-            child->m_index->Add( *i );
-
-        child->m_joints = m_joints;
-        child->m_override = m_override;
-    }
-
-    TRACE( 2, "%d items, %d joints, %d overrides",
-            child->m_index->Size() % child->m_joints.size() % child->m_override.size() );
-
+    // Nothing is copied, whatever the depth of the branch: the queries walk
+    // up the parents, and the joints are copied when they are first touched.
     return child;
 }
 
@@ -155,9 +147,6 @@ struct PNS_NODE::obstacleVisitor
     ///> node we are searching in (either root or a branch)
     PNS_NODE* m_node;
 
-    ///> node that overrides root entries
-    PNS_NODE* m_override;
-
     ///> list of encountered obstacles
     Obstacles& m_tab;
 
@@ -187,10 +176,9 @@ struct PNS_NODE::obstacleVisitor
         m_limitCount = aLimit;
     }
 
-    void SetWorld( PNS_NODE* aNode, PNS_NODE* aOverride = NULL )
+    void SetWorld( PNS_NODE* aNode )
     {
         m_node = aNode;
-        m_override = aOverride;
     }
 
     bool operator()( PNS_ITEM* aItem )
@@ -200,7 +188,7 @@ struct PNS_NODE::obstacleVisitor
 
         // check if there is a more recent branch with a newer
         // (possibily modified) version of this item.
-        if( m_override && m_override->overrides( aItem ) )
+        if( m_node->overrides( aItem ) )
             return true;
 
         int clearance = m_node->GetClearance( aItem, m_item );
@@ -231,39 +219,171 @@ int PNS_NODE::QueryColliding( const PNS_ITEM* aItem,
     assert( allocNodes.find( this ) != allocNodes.end() );
 
     visitor.SetCountLimit( aLimitCount );
-    visitor.SetWorld( this, NULL );
+    visitor.SetWorld( this );
 
-    // first, look for colliding items ourselves
-    m_index->Query( aItem, m_maxClearance, visitor );
-
-    // if we haven't found enough items, look in the root branch as well.
-    if( !isRoot() && ( visitor.m_matchCount < aLimitCount || aLimitCount < 0) )
+    // first, look for colliding items ourselves, then in the parents as long as
+    // we haven't found enough items.
+    for( PNS_NODE* node = this; node; node = node->m_parent )
     {
-        visitor.SetWorld( m_root, this );
-        m_root->m_index->Query( aItem, m_maxClearance, visitor );
+        if( aLimitCount > 0 && visitor.m_matchCount >= aLimitCount )
+            break;
+
+        node->m_index->Query( aItem, m_maxClearance, visitor );
     }
 
     return aObstacles.size();
 }
 
 
-PNS_NODE::OptObstacle PNS_NODE::NearestObstacle( const PNS_LINE* aItem, int aKindMask )
+// function object that visits the potential obstacles of a whole line, and
+// finds which of its segments collide with each of them. The segments of the line
+// are packed once in a SEG_BOXES, and each obstacle segment is tested against all
+// of them at once, instead of querying the index again for each segment.
+struct PNS_NODE::lineObstacleVisitor
 {
-    Obstacles obs_list;
-    bool found_isects = false;
+    typedef std::pair<int, PNS_ITEM*> HIT;
 
-    const SHAPE_LINE_CHAIN& line = aItem->GetCLine();
+    ///> node we are searching in (either root or a branch)
+    PNS_NODE* m_node;
 
-    obs_list.reserve( 100 );
+    ///> the line we are looking for collisions with
+    const PNS_LINE* m_line;
+
+    ///> the boxes of the segments of m_line
+    const SEG_BOXES& m_boxes;
+
+    ///> acccepted kinds of colliding items (solids, vias, segments, etc...)
+    int m_kindMask;
+
+    ///> encountered obstacles, with the index of the line segment they collide with
+    std::vector<HIT>& m_hits;
+
+    ///> the line segments colliding with the current obstacle
+    std::vector<int>& m_segments;
 
-    int n = 0;
+    lineObstacleVisitor( std::vector<HIT>& aHits, std::vector<int>& aSegments,
+            const PNS_LINE* aLine, const SEG_BOXES& aBoxes, int aKindMask ) :
+        m_node( NULL ),
+        m_line( aLine ),
+        m_boxes( aBoxes ),
+        m_kindMask( aKindMask ),
+        m_hits( aHits ),
+        m_segments( aSegments )
+    {};
 
-    for( int i = 0; i < line.SegmentCount(); i++ )
+    void SetWorld( PNS_NODE* aNode )
     {
-        const PNS_SEGMENT s( *aItem, line.CSegment( i ) );
-        n += QueryColliding( &s, obs_list, aKindMask );
+        m_node = aNode;
     }
 
+    bool operator()( PNS_ITEM* aItem )
+    {
+        if( !aItem->OfKind( m_kindMask ) )
+            return true;
+
+        if( m_node->overrides( aItem ) )
+            return true;
+
+        // the tests of PNS_ITEM::Collide()
+        if( aItem->GetNet() == m_line->GetNet() || !aItem->GetLayers().Overlaps( m_line->GetLayers() ) )
+            return true;
+
+        int clearance = m_node->GetClearance( aItem, m_line );
+        const SHAPE_LINE_CHAIN& line = m_line->GetCLine();
+
+        m_segments.clear();
+
+        if( aItem->OfKind( PNS_ITEM::SEGMENT ) )
+        {
+            const SHAPE_LINE_CHAIN& seg = static_cast<PNS_SEGMENT*>( aItem )->GetCLine();
+
+            if( seg.SegmentCount() == 1 )
+                m_boxes.CollidingSegments( seg.CSegment( 0 ), clearance, m_segments );
+        }
+        else
+        {
+            for( int i = 0; i < line.SegmentCount(); i++ )
+            {
+                if( aItem->GetShape()->Collide( line.CSegment( i ), clearance ) )
+                    m_segments.push_back( i );
+            }
+        }
+
+        for( unsigned i = 0; i < m_segments.size(); i++ )
+        {
+            const SEG s = line.CSegment( m_segments[i] );
+
+            // a PNS_SEGMENT made of a zero length segment has no segment at all
+            if( s.A != s.B )
+                m_hits.push_back( HIT( m_segments[i], aItem ) );
+        }
+
+        return true;
+    };
+};
+
+
+int PNS_NODE::queryLineColliding( const PNS_LINE* aLine, PNS_NODE::Obstacles& aObstacles,
+        int aKindMask, int aLimitCount )
+{
+    std::vector<lineObstacleVisitor::HIT>& hits = m_root->m_lineHits;
+    SEG_BOXES boxes( aLine->GetCLine() );
+    lineObstacleVisitor visitor( hits, m_root->m_lineSegments, aLine, boxes, aKindMask );
+
+    assert( allocNodes.find( this ) != allocNodes.end() );
+
+    if( boxes.Size() == 0 )
+        return 0;
+
+    hits.clear();
+
+    visitor.SetWorld( this );
+
+    for( PNS_NODE* node = this; node; node = node->m_parent )
+        node->m_index->Query( aLine, m_maxClearance, visitor );
+
+    // The items are found in the order of the index: sorting them by segment gives
+    // the order of the queries of each segment, which the shove depends on. The sort
+    // is a counting sort, stable and without the temporary buffer of std::stable_sort.
+    std::vector<int>& first = m_root->m_lineSegments;
+    int count = hits.size();
+
+    first.assign( boxes.Size() + 1, 0 );
+
+    for( int i = 0; i < count; i++ )
+        first[hits[i].first + 1]++;
+
+    for( int s = 0; s < boxes.Size(); s++ )
+        first[s + 1] += first[s];
+
+    if( aLimitCount > 0 )
+        count = std::min( count, aLimitCount );
+
+    int base = aObstacles.size();
+
+    aObstacles.resize( base + count );
+
+    for( unsigned i = 0; i < hits.size(); i++ )
+    {
+        int pos = first[hits[i].first]++;
+
+        if( pos < count )
+            aObstacles[base + pos].item = hits[i].second;
+    }
+
+    return count;
+}
+
+
+PNS_NODE::OptObstacle PNS_NODE::NearestObstacle( const PNS_LINE* aItem, int aKindMask )
+{
+    Obstacles obs_list;
+    bool found_isects = false;
+
+    obs_list.reserve( 100 );
+
+    int n = queryLineColliding( aItem, obs_list, aKindMask );
+
     if( aItem->EndsWithVia() )
         n += QueryColliding( &aItem->GetVia(), obs_list, aKindMask );
 
@@ -360,16 +480,11 @@ PNS_NODE::OptObstacle PNS_NODE::CheckColliding( const PNS_ITEM* aItemA, int aKin
     {
         int n = 0;
         const PNS_LINE* line = static_cast<const PNS_LINE*>(aItemA);
-        const SHAPE_LINE_CHAIN& l = line->GetCLine();
 
-        for( int i = 0; i < l.SegmentCount(); i++ )
-        {
-            const PNS_SEGMENT s( *line, l.CSegment( i ) );
-            n += QueryColliding( &s, obs, aKindMask, 1 );
+        n += queryLineColliding( line, obs, aKindMask, 1 );
 
-            if( n )
-                return OptObstacle( obs[0] );
-        }
+        if( n )
+            return OptObstacle( obs[0] );
 
         if( line->EndsWithVia() )
         {
@@ -432,13 +547,13 @@ const PNS_ITEMSET PNS_NODE::HitTest( const VECTOR2I& aPoint )
 
     m_index->Query( &s, m_maxClearance, visitor );
 
-    if( !isRoot() )    // fixme: could be made cleaner
+    for( PNS_NODE* node = m_parent; node; node = node->m_parent )
     {
-        PNS_ITEMSET items_root;
-        hitVisitor  visitor_root( items_root, aPoint, m_root );
-        m_root->m_index->Query( &s, m_maxClearance, visitor_root );
+        PNS_ITEMSET items_parent;
+        hitVisitor  visitor_parent( items_parent, aPoint, node );
+        node->m_index->Query( &s, m_maxClearance, visitor_parent );
 
-        BOOST_FOREACH( PNS_ITEM * item, items_root.Items() )
+        BOOST_FOREACH( PNS_ITEM * item, items_parent.Items() )
         {
             if( !overrides( item ) )
                 items.Add( item );
@@ -535,19 +650,28 @@ void PNS_NODE::Add( PNS_ITEM* aItem )
 
 void PNS_NODE::doRemove( PNS_ITEM* aItem )
 {
-    // case 1: removing an item that is stored in the root node from any branch:
-    // mark it as overridden, but do not remove
-    if( aItem->BelongsTo( m_root ) && !isRoot() )
+    // case 1: the item belongs to this particular branch (or we are the root):
+    // remove it from the index and un-reference it
+    if( aItem->BelongsTo( this ) || isRoot() )
+    {
+        m_index->Remove( aItem );
+
+        if( aItem->BelongsTo( this ) )
+            aItem->SetOwner( NULL );
+    }
+
+    // case 2: removing an item that is stored in a parent node (root or not):
+    // mark it as overridden, but do not remove, the parent is left untouched
+    else
         m_override.insert( aItem );
+}
 
-    // case 2: the item belongs to this branch or a parent, non-root branch,
-    // or the root itself and we are the root: remove from the index
-    else if( !aItem->BelongsTo( m_root ) || isRoot() )
-        m_index->Remove( aItem );
 
-    // the item belongs to this particular branch: un-reference it
-    if( aItem->BelongsTo( this ) )
-        aItem->SetOwner( NULL );
+void PNS_NODE::removeSolid( PNS_SOLID* aSolid )
+{
+    unlinkJoint( aSolid->GetCenter(), aSolid->GetLayers(), aSolid->GetNet(), aSolid );
+
+    doRemove( aSolid );
 }
 
 
@@ -598,7 +722,7 @@ void PNS_NODE::Remove( PNS_ITEM* aItem )
     switch( aItem->GetKind() )
     {
     case PNS_ITEM::SOLID:
-        assert( false );
+        removeSolid( static_cast<PNS_SOLID*>( aItem ) );
         break;
 
     case PNS_ITEM::SEGMENT:
@@ -728,17 +852,13 @@ const PNS_NODE::OptJoint PNS_NODE::FindJoint( const VECTOR2I& aPos, int aLayer,
     tag.net = aNet;
     tag.pos = aPos;
 
-    JointMap::iterator f = m_joints.find( tag ), end = m_joints.end();
+    JointMap* joints = findJoints( tag );
 
-    if( f == end && !isRoot() )
-    {
-        end = m_root->m_joints.end();
-        f = m_root->m_joints.find( tag );    // m_root->FindJoint(aPos, aLayer, aNet);
-    }
-
-    if( f == end )
+    if( !joints )
         return OptJoint();
 
+    JointMap::iterator f = joints->find( tag ), end = joints->end();
+
     while( f != end )
     {
         if( f->second.GetLayers().Overlaps( aLayer ) )
@@ -751,6 +871,18 @@ const PNS_NODE::OptJoint PNS_NODE::FindJoint( const VECTOR2I& aPos, int aLayer,
 }
 
 
+PNS_NODE::JointMap* PNS_NODE::findJoints( const PNS_JOINT::HashTag& aTag )
+{
+    for( PNS_NODE* node = this; node; node = node->m_parent )
+    {
+        if( node->m_joints.find( aTag ) != node->m_joints.end() )
+            return &node->m_joints;
+    }
+
+    return NULL;
+}
+
+
 PNS_JOINT& PNS_NODE::touchJoint( const VECTOR2I& aPos, const PNS_LAYERSET& aLayers, int aNet )
 {
     PNS_JOINT::HashTag tag;
@@ -763,13 +895,18 @@ PNS_JOINT& PNS_NODE::touchJoint( const VECTOR2I& aPos, const PNS_LAYERSET& aLaye
 
     std::pair<JointMap::iterator, JointMap::iterator> range;
 
-    // not found and we are not root? find in the root and copy results here.
+    // not found and we are not root? find in the parents and copy results here.
     if( f == m_joints.end() && !isRoot() )
     {
-        range = m_root->m_joints.equal_range( tag );
+        JointMap* joints = m_parent->findJoints( tag );
 
-        for( f = range.first; f != range.second; ++f )
-            m_joints.insert( *f );
+        if( joints )
+        {
+            range = joints->equal_range( tag );
+
+            for( f = range.first; f != range.second; ++f )
+                m_joints.insert( *f );
+        }
     }
 
     // now insert and combine overlapping joints
@@ -913,17 +1050,36 @@ void PNS_NODE::Dump( bool aLong )
 
 void PNS_NODE::GetUpdatedItems( ItemVector& aRemoved, ItemVector& aAdded )
 {
-    aRemoved.reserve( m_override.size() );
-    aAdded.reserve( m_index->Size() );
-
     if( isRoot() )
         return;
 
-    BOOST_FOREACH( PNS_ITEM * item, m_override )
-    aRemoved.push_back( item );
+    // an item of the root may be overridden by several nodes of the branch
+    boost::unordered_set<PNS_ITEM*> removed;
 
-    for( PNS_INDEX::ItemSet::iterator i = m_index->begin(); i!=m_index->end(); ++i )
-        aAdded.push_back( *i );
+    for( PNS_NODE* node = this; !node->isRoot(); node = node->m_parent )
+    {
+        BOOST_FOREACH( PNS_ITEM * item, node->m_override )
+        {
+            if( item->BelongsTo( m_root ) && removed.insert( item ).second )
+                aRemoved.push_back( item );
+        }
+
+        for( PNS_INDEX::ItemSet::iterator i = node->m_index->begin();
+             i != node->m_index->end(); ++i )
+        {
+            if( !overrides( *i ) )
+                aAdded.push_back( *i );
+        }
+    }
+}
+
+
+void PNS_NODE::AllItems( ItemVector& aItems )
+{
+    aItems.reserve( aItems.size() + m_index->Size() );
+
+    for( PNS_INDEX::ItemSet::iterator i = m_index->begin(); i != m_index->end(); ++i )
+        aItems.push_back( *i );
 }
 
 
@@ -944,12 +1100,15 @@ void PNS_NODE::Commit( PNS_NODE* aNode )
     if( aNode->isRoot() )
         return;
 
-    BOOST_FOREACH( PNS_ITEM * item, aNode->m_override )
+    ItemVector removed, added;
+
+    aNode->GetUpdatedItems( removed, added );
+
+    BOOST_FOREACH( PNS_ITEM * item, removed )
     Remove( item );
 
-    for( PNS_INDEX::ItemSet::iterator i = aNode->m_index->begin();
-         i != aNode->m_index->end(); ++i )
-        Add( *i );
+    BOOST_FOREACH( PNS_ITEM * item, added )
+    Add( item );
 
     releaseChildren();
 }
@@ -965,21 +1124,15 @@ void PNS_NODE::KillChildren()
 
 void PNS_NODE::AllItemsInNet( int aNet, std::list<PNS_ITEM*>& aItems )
 {
-    PNS_INDEX::NetItemsList* l_cur = m_index->GetItemsForNet( aNet );
-
-    if( !l_cur )
-        return;
-
-    std::copy( aItems.begin(), l_cur->begin(), l_cur->end() );
-
-    if( !isRoot() )
+    for( PNS_NODE* node = this; node; node = node->m_parent )
     {
-        PNS_INDEX::NetItemsList* l_root = m_root->m_index->GetItemsForNet( aNet );
+        PNS_INDEX::NetItemsList* l_cur = node->m_index->GetItemsForNet( aNet );
+
+        if( !l_cur )
+            continue;
 
-        for( PNS_INDEX::NetItemsList::iterator i = l_root->begin(); i!= l_root->end(); ++i )
+        for( PNS_INDEX::NetItemsList::iterator i = l_cur->begin(); i != l_cur->end(); ++i )
             if( !overrides( *i ) )
                 aItems.push_back( *i );
-
-
     }
 }
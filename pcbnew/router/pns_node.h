@@ -148,6 +148,9 @@ public:
 
     ///> Creates a lightweight copy ("branch") of self. Note that if there are
     ///> any branches in use, their parents must NOT be deleted.
+    ///> Nothing is copied: the branch stores only the items added, removed
+    ///> and the joints touched since, and looks up the rest in its parents,
+    ///> which must not be modified while they have children.
     PNS_NODE* Branch();
 
     ///> Assembles a line connecting two non-trivial joints the
@@ -158,16 +161,24 @@ public:
     ///> Dumps the contents and joints structure
     void Dump( bool aLong = false );
 
-    ///> Returns the number of joints
+    ///> Returns the number of joints stored in this node (i.e. touched in this
+    ///> branch)
     int JointCount() const
     {
         return m_joints.size();
     }
 
+    ///> Returns the number of nodes (roots and branches) in memory
+    static int AllocatedNodeCount();
+
     ///> Returns the lists of items removed and added in this branch, with
     ///> respect to the root.
     void GetUpdatedItems( ItemVector& aRemoved, ItemVector& aAdded );
 
+    ///> Returns the items stored in this node, without the ones of its parents.
+    ///> For the root, this is the whole world.
+    void AllItems( ItemVector& aItems );
+
     ///> Copies the changes from a given branch (aNode) to the root. Called on
     ///> a non-root branch will fail.
     void Commit( PNS_NODE* aNode );
@@ -194,6 +205,7 @@ public:
 
 private:
     struct obstacleVisitor;
+    struct lineObstacleVisitor;
     typedef boost::unordered_multimap<PNS_JOINT::HashTag, PNS_JOINT> JointMap;
     typedef JointMap::value_type TagJointPair;
 
@@ -223,6 +235,11 @@ private:
     void removeSegment( PNS_SEGMENT* aSeg );
     void removeVia( PNS_VIA* aVia );
 
+    ///> finds the items colliding with the segments of aLine, in the order of
+    ///> a QueryColliding() of each segment, one after the other.
+    int queryLineColliding( const PNS_LINE* aLine, Obstacles& aObstacles, int aKindMask,
+            int aLimitCount = -1 );
+
     void doRemove( PNS_ITEM* aItem );
     void unlinkParent();
     void releaseChildren();
@@ -232,13 +249,24 @@ private:
         return m_parent == NULL;
     }
 
-    ///> checks if this branch contains an updated version of the item
-    ///> from the root branch.
+    ///> checks if this branch, or one of its parents younger than the owner of
+    ///> the item, contains an updated version of (i.e. has removed) the item.
     bool overrides( PNS_ITEM* aItem ) const
     {
-        return m_override.find( aItem ) != m_override.end();
+        for( const PNS_NODE* node = this; node && node != aItem->GetOwner();
+             node = node->m_parent )
+        {
+            if( node->m_override.find( aItem ) != node->m_override.end() )
+                return true;
+        }
+
+        return false;
     }
 
+    ///> returns the joint map of the youngest node of the branch (this one
+    ///> or a parent) holding joints at aTag, NULL if none does.
+    JointMap* findJoints( const PNS_JOINT::HashTag& aTag );
+
     ///> scans the joint map, forming a line starting from segment (current).
     void followLine( PNS_SEGMENT* current,
             bool scanDirection,
@@ -251,7 +279,8 @@ private:
     // SHAPE_INDEX_LIST<PNS_ITEM *> m_items;
 
     ///> hash table with the joints, linking the items. Joints are hashed by
-    ///> their position, layer set and net.
+    ///> their position, layer set and net. A branch holds only the joints it
+    ///> has touched, copied from its parents on their first change.
     JointMap m_joints;
 
     ///> node this node was branched from
@@ -263,7 +292,7 @@ private:
     ///> list of nodes branched from this one
     std::vector<PNS_NODE*> m_children;
 
-    ///> hash of root's items that are more recent in this node
+    ///> hash of the parents' items that are removed (or more recent) in this node
     boost::unordered_set<PNS_ITEM*> m_override;
 
     ///> worst case item-item clearance
@@ -272,11 +301,16 @@ private:
     ///> Clearance resolution functor
     PNS_CLEARANCE_FUNC* m_clearanceFunctor;
 
-    ///> Geometric/Net index of the items
+    ///> Geometric/Net index of the items added in this node
     PNS_INDEX* m_index;
 
     ///> list of currently processed obstacles.
     Obstacles m_obstacleList;
+
+    ///> buffers of queryLineColliding(), used from the root node by all its branches,
+    ///> so their memory is not allocated again for each query.
+    std::vector< std::pair<int, PNS_ITEM*> > m_lineHits;
+    std::vector<int> m_lineSegments;
 };
 
 #endif
@@ -0,0 +1,115 @@
+/*
+ * KiRouter - a push-and-(sometimes-)shove PCB router
+ *
+ * Copyright (C) 2013  CERN
+ * Author: Tomasz Wlostowski <tomasz.wlostowski@cern.ch>
+ *
+ * This program is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.or/licenses/>.
+ */
+
+#ifndef __PNS_POOL_H
+#define __PNS_POOL_H
+
+#include <cstddef>
+#include <new>
+
+/**
+ * Class PNS_POOL
+ *
+ * Recycles the memory of the objects of class T, which the shove, walkaround and
+ * optimizer create and destroy by the thousands per mouse move. The memory is taken
+ * from the heap in chunks of ChunkSize objects, and an object deleted (e.g. with
+ * the branch owning it) goes to a free list, from which the next one is taken.
+ * The chunks are never given back: the pool holds at most the memory of the
+ * largest number of objects alive at a time. Not thread safe, like the router.
+ *
+ * A class uses it by defining its operator new and delete with Alloc() and Free().
+ */
+template <class T>
+class PNS_POOL
+{
+public:
+    static void* Alloc( size_t aSize )
+    {
+        // a derived class, which is not pooled
+        if( aSize != sizeof( T ) )
+            return ::operator new( aSize );
+
+        PNS_POOL& pool = instance();
+
+        if( !pool.m_free )
+            pool.grow();
+
+        BLOCK* block = pool.m_free;
+        pool.m_free = block->next;
+
+        return block;
+    }
+
+    static void Free( void* aPtr, size_t aSize )
+    {
+        if( !aPtr )
+            return;
+
+        if( aSize != sizeof( T ) )
+        {
+            ::operator delete( aPtr );
+            return;
+        }
+
+        PNS_POOL& pool = instance();
+        BLOCK* block = static_cast<BLOCK*>( aPtr );
+
+        block->next = pool.m_free;
+        pool.m_free = block;
+    }
+
+private:
+    static const int ChunkSize = 256;
+
+    union BLOCK
+    {
+        BLOCK*  next;
+        char    storage[sizeof( T )];
+        double  align;      // the alignment of the usual members
+        void*   alignPtr;
+    };
+
+    PNS_POOL() :
+        m_free( NULL )
+    {}
+
+    static PNS_POOL& instance()
+    {
+        // never deleted, as objects may be freed by destructors of other statics
+        static PNS_POOL* pool = new PNS_POOL;
+
+        return *pool;
+    }
+
+    void grow()
+    {
+        BLOCK* chunk = static_cast<BLOCK*>( ::operator new( ChunkSize * sizeof( BLOCK ) ) );
+
+        for( int i = 0; i < ChunkSize; i++ )
+        {
+            chunk[i].next = m_free;
+            m_free = &chunk[i];
+        }
+    }
+
+    BLOCK* m_free;
+};
+
+#endif
@@ -204,6 +204,10 @@ PNS_ITEM* PNS_ROUTER::syncVia( SEGVIA* aVia )
 
 void PNS_ROUTER::SetBoard( BOARD* aBoard )
 {
+    // the world of another board is of no use
+    if( aBoard != m_board )
+        ClearWorld();
+
     m_board = aBoard;
     TRACE( 1, "m_board = %p\n", m_board );
 }
@@ -233,8 +237,6 @@ int PNS_ROUTER::NextCopperLayer( bool aUp )
 
 void PNS_ROUTER::SyncWorld()
 {
-    std::vector<D_PAD*> pads;
-
     if( !m_board )
     {
         TRACEn( 0, "No board attached, aborting sync." );
@@ -243,38 +245,330 @@ void PNS_ROUTER::SyncWorld()
 
     ClearWorld();
 
+    m_worldDirty = false;
+
     m_clearanceFunc = new PCBNEW_CLEARANCE_FUNC( m_board );
     m_world = new PNS_NODE();
     m_world->SetClearanceFunctor( m_clearanceFunc );
     m_world->SetMaxClearance( 1000000 );    // m_board->GetBiggestClearanceValue());
-    pads = m_board->GetPads();
 
     for( MODULE* module = m_board->m_Modules; module; module = module->Next() )
+        syncBoardItem( module );
+
+    for( TRACK* t = m_board->m_Track; t; t = t->Next() )
+        syncBoardItem( t );
+
+    m_placer = new PNS_LINE_PLACER( m_world );
+}
+
+
+void PNS_ROUTER::syncBoardItem( BOARD_ITEM* aItem )
+{
+    switch( aItem->Type() )
     {
+    case PCB_MODULE_T:
+    {
+        MODULE* module = static_cast<MODULE*>( aItem );
+        std::vector<PNS_ITEM*>& solids = m_syncedModules[module];
+
         for( D_PAD* pad = module->Pads(); pad; pad = pad->Next() )
         {
-            PNS_ITEM* solid = syncPad( pad );
+            PNS_ITEM* solid = addSyncedItem( syncPad( pad ) );
 
             if( solid )
-                m_world->Add( solid );
+                solids.push_back( solid );
         }
+
+        break;
     }
 
-    for( TRACK* t = m_board->m_Track; t; t = t->Next() )
+    case PCB_TRACE_T:
+        m_syncedTracks[aItem] = addSyncedItem( syncTrack( static_cast<TRACK*>( aItem ) ) );
+        break;
+
+    case PCB_VIA_T:
+        m_syncedTracks[aItem] = addSyncedItem( syncVia( static_cast<SEGVIA*>( aItem ) ) );
+        break;
+
+    default:
+        // another item of the track list, only counted
+        m_syncedTracks[aItem] = NULL;
+        break;
+    }
+}
+
+
+PNS_ITEM* PNS_ROUTER::addSyncedItem( PNS_ITEM* aItem )
+{
+    if( !aItem )
+        return NULL;
+
+    m_world->Add( aItem );
+
+    // e.g. a zero length track, which the world ignores
+    if( !aItem->BelongsTo( m_world ) )
+    {
+        delete aItem;
+        return NULL;
+    }
+
+    return aItem;
+}
+
+
+void PNS_ROUTER::unsyncBoardItem( BOARD_ITEM* aItem )
+{
+    // A freed item and a new one can have the same address, both maps are searched.
+    SyncedTrackMap::iterator track = m_syncedTracks.find( aItem );
+
+    if( track != m_syncedTracks.end() )
+    {
+        if( track->second )
+        {
+            m_world->Remove( track->second );
+            delete track->second;
+        }
+
+        m_syncedTracks.erase( track );
+    }
+
+    SyncedModuleMap::iterator module = m_syncedModules.find( aItem );
+
+    if( module != m_syncedModules.end() )
+    {
+        BOOST_FOREACH( PNS_ITEM* solid, module->second )
+        {
+            m_world->Remove( solid );
+            delete solid;
+        }
+
+        m_syncedModules.erase( module );
+    }
+}
+
+
+bool PNS_ROUTER::sameItems( const PNS_ITEM* aA, const PNS_ITEM* aB ) const
+{
+    if( aA->GetKind() != aB->GetKind() || aA->GetParent() != aB->GetParent()
+        || aA->GetNet() != aB->GetNet()
+        || aA->GetLayers().Start() != aB->GetLayers().Start()
+        || aA->GetLayers().End() != aB->GetLayers().End() )
+        return false;
+
+    switch( aA->GetKind() )
+    {
+    case PNS_ITEM::SEGMENT:
+    {
+        const PNS_SEGMENT* a = static_cast<const PNS_SEGMENT*>( aA );
+        const PNS_SEGMENT* b = static_cast<const PNS_SEGMENT*>( aB );
+
+        return a->GetSeg().A == b->GetSeg().A && a->GetSeg().B == b->GetSeg().B
+               && a->GetWidth() == b->GetWidth();
+    }
+
+    case PNS_ITEM::VIA:
+    {
+        const PNS_VIA* a = static_cast<const PNS_VIA*>( aA );
+        const PNS_VIA* b = static_cast<const PNS_VIA*>( aB );
+
+        return a->GetPos() == b->GetPos() && a->GetDiameter() == b->GetDiameter();
+    }
+
+    case PNS_ITEM::SOLID:
+    {
+        const PNS_SOLID* a = static_cast<const PNS_SOLID*>( aA );
+        const PNS_SOLID* b = static_cast<const PNS_SOLID*>( aB );
+        const SHAPE* sa = a->GetShape();
+        const SHAPE* sb = b->GetShape();
+
+        if( a->GetCenter() != b->GetCenter() || sa->Type() != sb->Type() )
+            return false;
+
+        if( sa->Type() == SH_CIRCLE )
+        {
+            const SHAPE_CIRCLE* ca = static_cast<const SHAPE_CIRCLE*>( sa );
+            const SHAPE_CIRCLE* cb = static_cast<const SHAPE_CIRCLE*>( sb );
+
+            return ca->GetCenter() == cb->GetCenter() && ca->GetRadius() == cb->GetRadius();
+        }
+        else if( sa->Type() == SH_RECT )
+        {
+            const SHAPE_RECT* ra = static_cast<const SHAPE_RECT*>( sa );
+            const SHAPE_RECT* rb = static_cast<const SHAPE_RECT*>( sb );
+
+            return ra->GetPosition() == rb->GetPosition() && ra->GetSize() == rb->GetSize();
+        }
+
+        return false;
+    }
+
+    default:
+        return false;
+    }
+}
+
+
+void PNS_ROUTER::ItemChanged( BOARD_ITEM* aItem )
+{
+    switch( aItem->Type() )
+    {
+    case PCB_PAD_T:
+        // the pads are synced with their module
+        if( aItem->GetParent() )
+            m_changedItems.insert( aItem->GetParent() );
+
+        break;
+
+    case PCB_MODULE_T:
+    case PCB_TRACE_T:
+    case PCB_VIA_T:
+        m_changedItems.insert( aItem );
+        break;
+
+    default:
+        break;
+    }
+}
+
+
+void PNS_ROUTER::SyncChanges()
+{
+    if( !m_board || RoutingInProgress() )
+        return;
+
+    if( !m_world || m_worldDirty )
+    {
+        SyncWorld();
+    }
+    else
+    {
+        m_world->KillChildren();
+
+        // The net classes may have been edited, and nets added.
+        delete m_clearanceFunc;
+        m_clearanceFunc = new PCBNEW_CLEARANCE_FUNC( m_board );
+        m_world->SetClearanceFunctor( m_clearanceFunc );
+
+        // The deleted items can have been freed with the undo list since they
+        // changed: only the items found on the board are read.
+        std::vector<BOARD_ITEM*> onBoard;
+
+        if( !m_changedItems.empty() )
+        {
+            for( MODULE* module = m_board->m_Modules; module; module = module->Next() )
+            {
+                if( m_changedItems.count( module ) )
+                    onBoard.push_back( module );
+            }
+
+            for( TRACK* t = m_board->m_Track; t; t = t->Next() )
+            {
+                if( m_changedItems.count( t ) )
+                    onBoard.push_back( t );
+            }
+        }
+
+        BOOST_FOREACH( BOARD_ITEM* item, m_changedItems )
+            unsyncBoardItem( item );
+
+        BOOST_FOREACH( BOARD_ITEM* item, onBoard )
+            syncBoardItem( item );
+
+        m_changedItems.clear();
+
+        // Some commands do not use the undo list, e.g. a netlist read: when the
+        // world does not match the board any more, start again.
+        if( m_syncedTracks.size() != m_board->m_Track.GetCount()
+            || m_syncedModules.size() != m_board->m_Modules.GetCount() )
+        {
+            TRACEn( 0, "board items out of sync, syncing the whole world." );
+            SyncWorld();
+        }
+    }
+
+    if( m_checkWorld )
+        CheckWorld();
+}
+
+
+bool PNS_ROUTER::CheckWorld()
+{
+    if( !m_world )
+        return false;
+
+    // The items a full sync would create now, by parent
+    boost::unordered_map<BOARD_ITEM*, PNS_ITEM*> fresh;
+    std::vector<PNS_ITEM*> items;
+
+    for( MODULE* module = m_board->m_Modules; module; module = module->Next() )
     {
-        KICAD_T type = t->Type();
-        PNS_ITEM* item = NULL;
+        for( D_PAD* pad = module->Pads(); pad; pad = pad->Next() )
+            items.push_back( syncPad( pad ) );
+    }
 
-        if( type == PCB_TRACE_T )
-            item = syncTrack( t );
-        else if( type == PCB_VIA_T )
-            item = syncVia( static_cast<SEGVIA*>( t ) );
+    for( TRACK* t = m_board->m_Track; t; t = t->Next() )
+    {
+        if( t->Type() == PCB_TRACE_T )
+        {
+            // the world ignores the zero length tracks
+            if( t->GetStart() != t->GetEnd() )
+                items.push_back( syncTrack( t ) );
+        }
+        else if( t->Type() == PCB_VIA_T )
+        {
+            items.push_back( syncVia( static_cast<SEGVIA*>( t ) ) );
+        }
+    }
 
+    BOOST_FOREACH( PNS_ITEM* item, items )
+    {
         if( item )
-            m_world->Add( item );
+            fresh[item->GetParent()] = item;
     }
 
-    m_placer = new PNS_LINE_PLACER( m_world );
+    items.clear();
+    m_world->AllItems( items );
+
+    int errors = 0;
+
+    BOOST_FOREACH( PNS_ITEM* item, items )
+    {
+        boost::unordered_map<BOARD_ITEM*, PNS_ITEM*>::iterator it =
+            fresh.find( item->GetParent() );
+
+        if( it == fresh.end() )
+        {
+            // The parent may have been freed, it is not read.
+            wxLogDebug( wxT( "router world check: item %p of kind %d has no board item" ),
+                        item, (int) item->GetKind() );
+            errors++;
+            continue;
+        }
+
+        if( !sameItems( item, it->second ) )
+        {
+            wxLogDebug( wxT( "router world check: item of %s differs from the board" ),
+                        GetChars( it->first->GetSelectMenuText() ) );
+            errors++;
+        }
+
+        delete it->second;
+        fresh.erase( it );
+    }
+
+    for( boost::unordered_map<BOARD_ITEM*, PNS_ITEM*>::iterator it = fresh.begin();
+         it != fresh.end(); ++it )
+    {
+        wxLogDebug( wxT( "router world check: %s is missing" ),
+                    GetChars( it->first->GetSelectMenuText() ) );
+        delete it->second;
+        errors++;
+    }
+
+    if( errors )
+        wxLogDebug( wxT( "router world check: %d differences" ), errors );
+
+    return errors == 0;
 }
 
 
@@ -290,9 +584,14 @@ PNS_ROUTER::PNS_ROUTER()
     m_state = IDLE;
     m_world = NULL;
     m_placer = NULL;
+    m_view = NULL;
     m_previewItems = NULL;
     m_start_diagonal = false;
     m_board = NULL;
+    m_worldDirty = false;
+
+    // The check of the world is only useful to test the incremental sync itself
+    m_checkWorld = wxGetEnv( wxT( "KICAD_ROUTER_SYNC_CHECK" ), NULL );
 
     TRACE( 1, "m_board = %p\n", m_board );
 }
@@ -344,6 +643,10 @@ void PNS_ROUTER::ClearWorld()
     m_clearanceFunc = NULL;
     m_world = NULL;
     m_placer = NULL;
+
+    m_syncedTracks.clear();
+    m_syncedModules.clear();
+    m_changedItems.clear();
 }
 
 
@@ -476,6 +779,10 @@ void PNS_ROUTER::EraseView()
 
 void PNS_ROUTER::DisplayItem( const PNS_ITEM* aItem, bool aIsHead )
 {
+    // no view: the router runs without a display, e.g. in router_benchmark
+    if( !m_previewItems )
+        return;
+
     ROUTER_PREVIEW_ITEM* pitem = new ROUTER_PREVIEW_ITEM( aItem, m_previewItems );
 
     m_previewItems->Add( pitem );
@@ -490,6 +797,9 @@ void PNS_ROUTER::DisplayItem( const PNS_ITEM* aItem, bool aIsHead )
 
 void PNS_ROUTER::DisplayDebugLine( const SHAPE_LINE_CHAIN& aLine, int aType, int aWidth )
 {
+    if( !m_previewItems )
+        return;
+
     ROUTER_PREVIEW_ITEM* pitem = new ROUTER_PREVIEW_ITEM( NULL, m_previewItems );
 
     pitem->DebugLine( aLine, aWidth, aType );
@@ -589,9 +899,14 @@ void PNS_ROUTER::commitRouting( PNS_NODE* aNode )
 
         if( parent )
         {
+            // the item itself is removed from the world by Commit()
+            m_syncedTracks.erase( parent );
+
             m_undoBuffer.PushItem( ITEM_PICKER( parent, UR_DELETED ) );
             m_board->Remove( parent );
-            m_view->Remove( parent );
+
+            if( m_view )
+                m_view->Remove( parent );
         }
     }
 
@@ -635,9 +950,13 @@ void PNS_ROUTER::commitRouting( PNS_NODE* aNode )
         {
             item->SetParent( newBI );
             newBI->ClearFlags();
-            m_view->Add( newBI );
+
+            if( m_view )
+                m_view->Add( newBI );
+
             m_board->Add( newBI );
             m_undoBuffer.PushItem( ITEM_PICKER( newBI, UR_NEW ) );
+            m_syncedTracks[newBI] = item;
             newBI->ViewUpdate( KIGFX::VIEW_ITEM::GEOMETRY );
         }
     }
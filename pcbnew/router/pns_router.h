@@ -22,9 +22,11 @@
 #define __PNS_ROUTER_H
 
 #include <list>
+#include <vector>
 
 #include <boost/optional.hpp>
 #include <boost/unordered_set.hpp>
+#include <boost/unordered_map.hpp>
 
 #include <geometry/shape_line_chain.h>
 #include <class_undoredo_container.h>
@@ -82,6 +84,44 @@ public:
     void SetBoard( BOARD* aBoard );
     void SyncWorld();
 
+    /**
+     * Function ItemChanged
+     * tells the router that a track, via, module or pad of the board is about to be
+     * changed, or has been added, changed or removed.  The world is patched by the next
+     * SyncChanges().
+     */
+    void ItemChanged( BOARD_ITEM* aItem );
+
+    /**
+     * Function MarkWorldDirty
+     * tells the router that the board has been changed without ItemChanged(), e.g. the
+     * nets of the pads and tracks by a netlist read: the next SyncChanges() syncs the
+     * whole world again.
+     */
+    void MarkWorldDirty()
+    {
+        m_worldDirty = true;
+    }
+
+    /**
+     * Function SyncChanges
+     * brings the world up to date with the board: only the items of the tracks, vias
+     * and modules given to ItemChanged() since the last sync are created again.  When
+     * the world has been marked dirty, or the board has items the world does not know
+     * about (a command which does not use the undo list), the whole world is synced
+     * again.  Does nothing while routing.
+     */
+    void SyncChanges();
+
+    /**
+     * Function CheckWorld
+     * compares the world with the one a full SyncWorld() would create now, and logs
+     * the differences.  It is called by SyncChanges() when the environment variable
+     * KICAD_ROUTER_SYNC_CHECK is set, and is as slow as SyncWorld().
+     * @return bool - true if both worlds have the same items.
+     */
+    bool CheckWorld();
+
     void SetView( KIGFX::VIEW* aView );
 
     bool RoutingInProgress() const;
@@ -171,6 +211,20 @@ private:
     PNS_ITEM* syncTrack( TRACK* aTrack );
     PNS_ITEM* syncVia( SEGVIA* aVia );
 
+    ///> Adds to the world the items of a track, via or module of the board.
+    void syncBoardItem( BOARD_ITEM* aItem );
+
+    ///> Adds aItem to the world, if not NULL.
+    ///> @return aItem, or NULL if the world ignores it.
+    PNS_ITEM* addSyncedItem( PNS_ITEM* aItem );
+
+    ///> Checks if two items have the same parent, kind, net, layers and geometry.
+    bool sameItems( const PNS_ITEM* aA, const PNS_ITEM* aB ) const;
+
+    ///> Removes from the world and frees the items of a track, via or module.
+    ///> aItem itself is not read, it may have been freed already.
+    void unsyncBoardItem( BOARD_ITEM* aItem );
+
     void commitPad( PNS_SOLID* aPad );
     void commitSegment( PNS_SEGMENT* aTrack );
     void commitVia( PNS_VIA* aVia );
@@ -207,6 +261,25 @@ private:
 
     boost::unordered_set<BOARD_ITEM*> m_hiddenItems;
 
+    typedef boost::unordered_map<BOARD_ITEM*, PNS_ITEM*> SyncedTrackMap;
+    typedef boost::unordered_map<BOARD_ITEM*, std::vector<PNS_ITEM*> > SyncedModuleMap;
+
+    ///> Item of the world of each track and via of the board, NULL for a track
+    ///> the world ignores (e.g. a zero length one).
+    SyncedTrackMap m_syncedTracks;
+
+    ///> Items of the world of the pads of each module of the board
+    SyncedModuleMap m_syncedModules;
+
+    ///> Board items changed since the last sync, see ItemChanged()
+    boost::unordered_set<BOARD_ITEM*> m_changedItems;
+
+    ///> The board has been changed behind ItemChanged(), see MarkWorldDirty()
+    bool m_worldDirty;
+
+    ///> Compares the world with a fresh one after each SyncChanges()
+    bool m_checkWorld;
+
     ///> Stores list of modified items in the current operation
     PICKED_ITEMS_LIST m_undoBuffer;
 };
@@ -29,6 +29,7 @@
 
 #include "pns_item.h"
 #include "pns_line.h"
+#include "pns_pool.h"
 
 class PNS_NODE;
 
@@ -62,6 +63,17 @@ public:
 
     PNS_SEGMENT* Clone() const;
 
+    ///> Segments are created for each candidate path, their memory is recycled.
+    static void* operator new( size_t aSize )
+    {
+        return PNS_POOL<PNS_SEGMENT>::Alloc( aSize );
+    }
+
+    static void operator delete( void* aPtr, size_t aSize )
+    {
+        PNS_POOL<PNS_SEGMENT>::Free( aPtr, aSize );
+    }
+
     const SHAPE* GetShape() const
     {
         return static_cast<const SHAPE*>( &m_shape );
@@ -18,6 +18,7 @@
  * with this program.  If not, see <http://www.gnu.or/licenses/>.
  */
 
+#include <cstdarg>
 #include <boost/foreach.hpp>
 #include <boost/optional.hpp>
 
@@ -26,6 +27,7 @@
 #include "class_board.h"
 
 #include <wxPcbStruct.h>
+#include <macros.h>
 #include <view/view_controls.h>
 #include <pcbcommon.h>
 #include <pcb_painter.h>
@@ -63,35 +65,82 @@ ROUTER_TOOL::ROUTER_TOOL() :
     m_menu->Add( wxT( "Switch posture" ), 6 );
 
     m_menu->Add( wxT( "Routing options..." ), 7 );
+
+    wxString traceFile;
+
+    if( wxGetEnv( wxT( "KICAD_ROUTER_TRACE" ), &traceFile ) )
+        m_trace = wxFopen( traceFile, wxT( "at" ) );
+    else
+        m_trace = NULL;
 }
 
 
 ROUTER_TOOL::~ROUTER_TOOL()
 {
+    if( m_toolMgr && getEditFrame<PCB_BASE_FRAME>() )
+        getEditFrame<PCB_BASE_FRAME>()->RemoveBoardChangeListener( this );
+
     delete m_router;
+
+    if( m_trace )
+        fclose( m_trace );
 }
 
 
 void ROUTER_TOOL::Reset( RESET_REASON aReason )
 {
-    if( m_router )
-        delete m_router;
-
-    m_router = new PNS_ROUTER;
-
     TRACEn( 0, "Reset" );
-    m_router->ClearWorld();
-    m_router->SetBoard( getModel<BOARD>( PCB_T ) );
-    m_router->SyncWorld();
+
+    m_startItem = NULL;
+    m_endItem = NULL;
     m_needsSync = false;
 
-    if( getView() )
-        m_router->SetView( getView() );
+    // The frame tells the router of the board changes made by the edit commands
+    getEditFrame<PCB_BASE_FRAME>()->AddBoardChangeListener( this );
+
+    if( aReason == RUN && m_router )
+    {
+        // The world is kept between the runs of the tool, only the items changed
+        // since the last run are synced.
+        m_router->SetBoard( getModel<BOARD>( PCB_T ) );
+        m_router->SyncChanges();
+    }
+    else
+    {
+        if( m_router )
+            delete m_router;
+
+        m_router = new PNS_ROUTER;
+
+        m_router->ClearWorld();
+        m_router->SetBoard( getModel<BOARD>( PCB_T ) );
+        m_router->SyncWorld();
+
+        if( getView() )
+            m_router->SetView( getView() );
+    }
 
     Go( &ROUTER_TOOL::Main, TOOL_EVENT( TC_COMMAND, TA_ACTION, GetName() ) );
 }
 
 
+void ROUTER_TOOL::OnBoardItemChanged( BOARD_ITEM* aItem )
+{
+    if( m_router )
+        m_router->ItemChanged( aItem );
+}
+
+
+void ROUTER_TOOL::OnBoardChanged()
+{
+    if( m_router )
+        m_router->MarkWorldDirty();
+
+    // Synced at the next event if the tool is running, else when it is started
+    m_needsSync = true;
+}
+
+
 int ROUTER_TOOL::getDefaultWidth( int aNetCode )
 {
     int w, d1, d2;
@@ -178,6 +227,21 @@ PNS_ITEM* ROUTER_TOOL::pickSingleItem( const VECTOR2I& aWhere, int aNet, int aLa
 }
 
 
+void ROUTER_TOOL::recordEvent( const char* aFormat, ... )
+{
+    if( !m_trace )
+        return;
+
+    va_list args;
+
+    va_start( args, aFormat );
+    vfprintf( m_trace, aFormat, args );
+    va_end( args );
+
+    fputc( '\n', m_trace );
+}
+
+
 void ROUTER_TOOL::setMsgPanel( bool aEnabled, int aEntry,
         const wxString& aUpperMessage, const wxString& aLowerMessage )
 {
@@ -328,6 +392,17 @@ void ROUTER_TOOL::startRouting()
     m_router->SetCurrentWidth( width );
     m_router->SwitchLayer( m_startLayer );
 
+    // The board is named in the trace once, before its first route.
+    BOARD* board = getModel<BOARD>( PCB_T );
+
+    if( m_trace && board && board->GetFileName() != m_traceBoard )
+    {
+        m_traceBoard = board->GetFileName();
+        recordEvent( "# board %s", TO_UTF8( m_traceBoard ) );
+    }
+
+    recordEvent( "layer %d", m_startLayer );
+
     getEditFrame<PCB_EDIT_FRAME>()->SetTopLayer( m_startLayer );
 
     if( m_startItem && m_startItem->GetNet() >= 0 )
@@ -337,6 +412,7 @@ void ROUTER_TOOL::startRouting()
     ctls->SetAutoPan( true );
 
     m_router->StartRouting( m_startSnapPoint, m_startItem );
+    recordEvent( "start %d %d", m_startSnapPoint.x, m_startSnapPoint.y );
 
     m_endItem = NULL;
     m_endSnapPoint = m_startSnapPoint;
@@ -354,10 +430,12 @@ void ROUTER_TOOL::startRouting()
         {
             updateEndItem( *evt );
             m_router->Move( m_endSnapPoint, m_endItem );
+            recordEvent( "move %d %d", m_endSnapPoint.x, m_endSnapPoint.y );
         }
         else if( evt->IsClick( BUT_LEFT ) )
         {
             updateEndItem( *evt );
+            recordEvent( "fix %d %d", m_endSnapPoint.x, m_endSnapPoint.y );
 
             if( m_router->FixRoute( m_endSnapPoint, m_endItem ) )
                 break;
@@ -375,6 +453,7 @@ void ROUTER_TOOL::startRouting()
                 m_router->SetCurrentViaDiameter( diameter );
                 m_router->SetCurrentViaDrill( drill );
                 m_router->ToggleViaPlacement();
+                recordEvent( "via" );
                 getEditFrame<PCB_EDIT_FRAME>()->SetTopLayer( m_router->GetCurrentLayer() );
                 m_router->Move( m_endSnapPoint, m_endItem );
                 break;
@@ -382,11 +461,13 @@ void ROUTER_TOOL::startRouting()
 
             case '/':
                 m_router->FlipPosture();
+                recordEvent( "posture" );
                 break;
 
             case '+':
             case '=':
                 m_router->SwitchLayer( m_router->NextCopperLayer( true ) );
+                recordEvent( "layer %d", m_router->GetCurrentLayer() );
                 updateEndItem( *evt );
                 getEditFrame<PCB_EDIT_FRAME>()->SetTopLayer( m_router->GetCurrentLayer() );
                 m_router->Move( m_endSnapPoint, m_endItem );
@@ -395,6 +476,7 @@ void ROUTER_TOOL::startRouting()
 
             case '-':
                 m_router->SwitchLayer( m_router->NextCopperLayer( false ) );
+                recordEvent( "layer %d", m_router->GetCurrentLayer() );
                 getEditFrame<PCB_EDIT_FRAME>()->SetTopLayer( m_router->GetCurrentLayer() );
                 m_router->Move( m_endSnapPoint, m_endItem );
                 break;
@@ -403,6 +485,10 @@ void ROUTER_TOOL::startRouting()
     }
 
     m_router->StopRouting();
+    recordEvent( "stop" );
+
+    if( m_trace )
+        fflush( m_trace );
 
     if( saveUndoBuffer )
     {
@@ -439,7 +525,8 @@ int ROUTER_TOOL::Main( TOOL_EVENT& aEvent )
     {
         if( m_needsSync )
         {
-            m_router->SyncWorld();
+            m_router->SyncChanges();
+            m_startItem = NULL;
             m_needsSync = false;
         }
 
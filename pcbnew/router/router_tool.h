@@ -22,12 +22,14 @@
 #define __ROUTER_TOOL_H
 
 #include <set>
+#include <cstdio>
 #include <boost/shared_ptr.hpp>
 
 #include <math/vector2d.h>
 #include <tool/tool_interactive.h>
 
 #include <wxstruct.h>
+#include <wxBasePcbFrame.h>
 #include <msgpanel.h>
 
 #include "pns_layerset.h"
@@ -35,7 +37,7 @@
 class PNS_ROUTER;
 class PNS_ITEM;
 
-class ROUTER_TOOL : public TOOL_INTERACTIVE
+class ROUTER_TOOL : public TOOL_INTERACTIVE, public BOARD_CHANGE_LISTENER
 {
 public:
     ROUTER_TOOL();
@@ -44,6 +46,10 @@ public:
     void Reset( RESET_REASON aReason );
     int Main( TOOL_EVENT& aEvent );
 
+    ///> The changes of the edit frame are given to the router, for its next sync.
+    void OnBoardItemChanged( BOARD_ITEM* aItem );
+    void OnBoardChanged();
+
 private:
 
     PNS_ITEM* pickSingleItem( const VECTOR2I& aWhere, int aNet = -1, int aLayer = -1 );
@@ -61,6 +67,9 @@ private:
 
     void getNetclassDimensions( int aNetCode, int& aWidth, int& aViaDiameter, int& aViaDrill );
 
+    ///> Writes an event to the mouse trace, if it is recorded.
+    void recordEvent( const char* aFormat, ... );
+
     MSG_PANEL_ITEMS m_panelItems;
 
     PNS_ROUTER* m_router;
@@ -75,6 +84,13 @@ private:
     ///> Flag marking that the router's world needs syncing.
     bool m_needsSync;
 
+    ///> Mouse trace replayed by router_benchmark, recorded to the file given by the
+    ///> KICAD_ROUTER_TRACE environment variable.
+    FILE* m_trace;
+
+    ///> The file name of the board last written to the trace.
+    wxString m_traceBoard;
+
     /*boost::shared_ptr<CONTEXT_MENU> m_menu;*/
     CONTEXT_MENU* m_menu;
 };
@@ -0,0 +1,662 @@
+/**
+ * @file router_benchmark.cpp
+ * @brief measures the time taken by the interactive router to follow recorded mouse traces.
+ */
+
+/*
+ * This program source code file is part of KiCad, a free EDA CAD application.
+ *
+ * Copyright (C) 2014 KiCad Developers, see AUTHORS.txt for contributors.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, you may find one here:
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.html
+ * or you may search the http://www.gnu.org website for the version 2 license,
+ * or you may write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA
+ */
+
+/*
+    Usage: router_benchmark [--repeat=<n>] [--max-p99=<us>] <board file> <trace file> ...
+
+        --repeat=<n>    count of replays of each trace, 1 by default
+        --max-p99=<us>  latency budget of the 99th percentile of the moves, none
+                        by default
+
+    Each trace file is replayed on the board, loaded again for each replay, by the
+    router without a display, so it runs on a build machine.  A trace is a list
+    of events, one per line, in internal units (nanometers), as ROUTER_TOOL
+    records them in the file given by the KICAD_ROUTER_TRACE environment variable:
+
+        # a comment
+        start <x> <y>   starts a track at the item under (x, y), as a click does
+        move <x> <y>    moves the end of the track, as the mouse does
+        fix <x> <y>     fixes the track, as a click does
+        layer <n>       switches to the copper layer n, as '+' and '-' do
+        via             toggles the via placement, as 'V' does
+        posture         flips the posture of the track, as '/' does
+        stop            ends the track, as Esc does
+
+    For each kind of event, the percentiles of the times (in microseconds), the
+    mean count of allocations and the greatest count of PNS_NODEs in memory after
+    the event are printed, then the tracks and vias of the routed board.
+
+    The replays of a trace must give the same board: a difference (e.g. when a
+    shove is cut by its time limit) is an error, the exit code is then 1.  When a
+    latency budget is exceeded, the exit code is 2.
+
+    e.g. router_benchmark --repeat=5 --max-p99=20000 ../demos/video/video.kicad_pcb video_bus.trace
+*/
+
+
+#include <fctsys.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+#include <boost/foreach.hpp>
+#include <wx/init.h>
+#include <wx/filename.h>
+
+#include <macros.h>
+#include <common.h>
+#include <kiway.h>
+#include <pgm_base.h>
+#include <wildcards_and_files_ext.h>
+
+#include <io_mgr.h>
+#include <class_board.h>
+#include <class_track.h>
+#include <class_netclass.h>
+#include <ratsnest_data.h>
+
+#include <router/pns_router.h>
+#include <router/pns_node.h>
+#include <router/pns_segment.h>
+
+
+/// Count of the allocations of the program, the replay being single threaded.
+static unsigned long s_allocations = 0;
+
+
+void* operator new( std::size_t aSize )
+{
+    ++s_allocations;
+
+    void* ptr = malloc( aSize ? aSize : 1 );
+
+    if( !ptr )
+        throw std::bad_alloc();
+
+    return ptr;
+}
+
+
+void operator delete( void* aPtr ) throw()
+{
+    free( aPtr );
+}
+
+
+/**
+ * Struct PGM_ROUTER_BENCHMARK
+ * implements PGM_BASE for this tool, which has no wxApp, like pcbnew_drc does.
+ */
+static struct PGM_ROUTER_BENCHMARK : public PGM_BASE
+{
+    bool OnPgmInit( wxApp* aWxApp ) { return true; }
+    void OnPgmExit()                { }
+    void MacOpenFile( const wxString& aFileName ) { }
+} program;
+
+
+/**
+ * Class EVENT_STATS
+ * gathers the times, allocations and node counts of the events of a kind.
+ */
+class EVENT_STATS
+{
+public:
+    EVENT_STATS() : m_allocations( 0 ), m_maxNodes( 0 ) {}
+
+    void Add( unsigned aElapsed, unsigned long aAllocations )
+    {
+        m_times.push_back( aElapsed );
+        m_allocations += aAllocations;
+        m_maxNodes = std::max( m_maxNodes, PNS_NODE::AllocatedNodeCount() );
+    }
+
+    unsigned Count() const { return m_times.size(); }
+
+    /// @return the time below which aPercent % of the events are, by nearest rank.
+    unsigned Percentile( int aPercent ) const
+    {
+        if( m_times.empty() )
+            return 0;
+
+        std::vector<unsigned> sorted = m_times;
+        std::sort( sorted.begin(), sorted.end() );
+
+        unsigned rank = ( sorted.size() * aPercent + 99 ) / 100;
+
+        return sorted[ std::max( rank, 1u ) - 1 ];
+    }
+
+    void Print( const char* aName ) const
+    {
+        if( m_times.empty() )
+            return;
+
+        printf( "    %-10s %6u, p50 %u us, p90 %u us, p99 %u us, worst %u us, "
+                "%lu allocations, %d nodes\n",
+                aName, Count(), Percentile( 50 ), Percentile( 90 ), Percentile( 99 ),
+                Percentile( 100 ), m_allocations / Count(), m_maxNodes );
+    }
+
+private:
+    std::vector<unsigned>   m_times;
+    unsigned long           m_allocations;
+    int                     m_maxNodes;
+};
+
+
+/**
+ * Struct REPLAY_STATS
+ * gathers the statistics of the replays of a trace.
+ */
+struct REPLAY_STATS
+{
+    EVENT_STATS sync;
+    EVENT_STATS start;
+    EVENT_STATS move;
+    EVENT_STATS fix;
+    EVENT_STATS layer;
+    EVENT_STATS via;
+    EVENT_STATS posture;
+
+    void Print() const
+    {
+        sync.Print( "sync" );
+        start.Print( "start" );
+        move.Print( "move" );
+        fix.Print( "fix" );
+        layer.Print( "layer" );
+        via.Print( "via" );
+        posture.Print( "posture" );
+    }
+};
+
+
+/**
+ * Struct BOARD_SIGNATURE
+ * sums up the tracks of a board whatever their order, to compare the replays.
+ */
+struct BOARD_SIGNATURE
+{
+    int         tracks;
+    int         vias;
+    long long   length;
+    long long   ends;
+
+    BOARD_SIGNATURE( BOARD* aBoard ) : tracks( 0 ), vias( 0 ), length( 0 ), ends( 0 )
+    {
+        for( TRACK* track = aBoard->m_Track; track; track = track->Next() )
+        {
+            if( track->Type() == PCB_VIA_T )
+                ++vias;
+            else
+                ++tracks;
+
+            length += KiROUND( track->GetLength() );
+            ends += (long long) track->GetStart().x * 3 + (long long) track->GetStart().y * 5
+                    + (long long) track->GetEnd().x * 7 + (long long) track->GetEnd().y * 11
+                    + track->GetLayer() * 13;
+        }
+    }
+
+    bool operator==( const BOARD_SIGNATURE& aOther ) const
+    {
+        return tracks == aOther.tracks && vias == aOther.vias && length == aOther.length
+               && ends == aOther.ends;
+    }
+
+    void Print() const
+    {
+        printf( "    result: %d tracks, %d vias, length %lld nm, ends %lld\n",
+                tracks, vias, length, ends );
+    }
+};
+
+
+static void usage()
+{
+    fprintf( stderr, "usage: router_benchmark [--repeat=<n>] [--max-p99=<us>] "
+             "<board file> <trace file> ...\n" );
+}
+
+
+/**
+ * Function pickItem
+ * chooses the item under a point as ROUTER_TOOL does, the vias and pads first.
+ * @param aNet is the net of the item, -1 for any.
+ * @param aLayer is the layer of the item, -1 for any.
+ */
+static PNS_ITEM* pickItem( PNS_ROUTER& aRouter, const VECTOR2I& aWhere, int aNet, int aLayer )
+{
+    int tl = aLayer >= 0 ? aLayer : aRouter.GetCurrentLayer();
+
+    PNS_ITEM* picked_seg = NULL;
+    PNS_ITEM* picked_via = NULL;
+    PNS_ITEMSET candidates = aRouter.QueryHoverItems( aWhere );
+
+    BOOST_FOREACH( PNS_ITEM* item, candidates.Items() )
+    {
+        if( !IsCopperLayer( item->GetLayers().Start() ) )
+            continue;
+
+        if( aNet >= 0 && item->GetNet() != aNet )
+            continue;
+
+        if( item->OfKind( PNS_ITEM::VIA | PNS_ITEM::SOLID ) )
+        {
+            if( item->GetLayers().Overlaps( tl ) || !picked_via )
+                picked_via = item;
+        }
+        else
+        {
+            if( item->GetLayers().Overlaps( tl ) || !picked_seg )
+                picked_seg = item;
+        }
+    }
+
+    PNS_ITEM* rv = picked_via ? picked_via : picked_seg;
+
+    if( rv && aLayer >= 0 && !rv->GetLayers().Overlaps( aLayer ) )
+        rv = NULL;
+
+    return rv;
+}
+
+
+/**
+ * Function netclassOf
+ * @return the net class of a net, the default one for no net.
+ */
+static NETCLASS* netclassOf( BOARD* aBoard, int aNetCode )
+{
+    NETCLASS*       netClass = NULL;
+    NETINFO_ITEM*   ni = aNetCode >= 0 ? aBoard->FindNet( aNetCode ) : NULL;
+
+    if( ni )
+        netClass = aBoard->m_NetClasses.Find( ni->GetClassName() );
+
+    if( !netClass )
+        netClass = aBoard->m_NetClasses.GetDefault();
+
+    return netClass;
+}
+
+
+/**
+ * Class TRACE_PLAYER
+ * replays the events of a trace with a router, as ROUTER_TOOL calls it.
+ */
+class TRACE_PLAYER
+{
+public:
+    TRACE_PLAYER( BOARD* aBoard, REPLAY_STATS& aStats ) :
+        m_board( aBoard ),
+        m_stats( aStats )
+    {
+        begin();
+        m_router.SetBoard( aBoard );
+        m_router.SyncWorld();
+        end( m_stats.sync );
+
+        m_router.SwitchLayer( LAYER_N_FRONT );
+    }
+
+    ~TRACE_PLAYER()
+    {
+        stop();
+    }
+
+    /**
+     * Function Play
+     * replays an event, a line of a trace.
+     * @return bool - false if the event is not understood.
+     */
+    bool Play( const char* aLine )
+    {
+        char    command[16];
+        int     x, y, layer;
+
+        if( sscanf( aLine, "%15s", command ) != 1 || command[0] == '#' )
+            return true;
+
+        if( !strcmp( command, "start" ) && sscanf( aLine, "%*s %d %d", &x, &y ) == 2 )
+        {
+            stop();
+
+            VECTOR2I    p( x, y );
+            PNS_ITEM*   startItem = pickItem( m_router, p, -1, -1 );
+            int         width = netclassOf( m_board, startItem ? startItem->GetNet() : -1 )
+                                ->GetTrackWidth();
+
+            if( startItem && startItem->OfKind( PNS_ITEM::SEGMENT ) )
+                width = static_cast<PNS_SEGMENT*>( startItem )->GetWidth();
+
+            m_router.SetCurrentWidth( width );
+
+            begin();
+            m_router.StartRouting( p, startItem );
+            end( m_stats.start );
+
+            m_end = p;
+        }
+        else if( !strcmp( command, "move" ) && sscanf( aLine, "%*s %d %d", &x, &y ) == 2 )
+        {
+            m_end = VECTOR2I( x, y );
+
+            if( m_router.RoutingInProgress() )
+                move( m_stats.move );
+        }
+        else if( !strcmp( command, "fix" ) && sscanf( aLine, "%*s %d %d", &x, &y ) == 2 )
+        {
+            m_end = VECTOR2I( x, y );
+
+            if( m_router.RoutingInProgress() )
+            {
+                PNS_ITEM* endItem = pickEndItem();
+
+                begin();
+                bool done = m_router.FixRoute( m_end, endItem );
+                end( m_stats.fix );
+
+                if( done )
+                    stop();
+                else
+                    move( m_stats.move );
+            }
+        }
+        else if( !strcmp( command, "layer" ) && sscanf( aLine, "%*s %d", &layer ) == 1 )
+        {
+            m_router.SwitchLayer( layer );
+
+            if( m_router.RoutingInProgress() )
+                move( m_stats.layer );
+        }
+        else if( !strcmp( command, "via" ) )
+        {
+            if( m_router.RoutingInProgress() )
+            {
+                NETCLASS* netClass = netclassOf( m_board, m_router.GetCurrentNet() );
+
+                m_router.SetCurrentViaDiameter( netClass->GetViaDiameter() );
+                m_router.SetCurrentViaDrill( netClass->GetViaDrill() );
+                m_router.ToggleViaPlacement();
+                move( m_stats.via );
+            }
+        }
+        else if( !strcmp( command, "posture" ) )
+        {
+            if( m_router.RoutingInProgress() )
+            {
+                begin();
+                m_router.FlipPosture();
+                end( m_stats.posture );
+            }
+        }
+        else if( !strcmp( command, "stop" ) )
+        {
+            stop();
+        }
+        else
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+private:
+    void begin()
+    {
+        m_allocations = s_allocations;
+        m_start = GetRunningMicroSecs();
+    }
+
+    void end( EVENT_STATS& aStats )
+    {
+        unsigned elapsed = GetRunningMicroSecs() - m_start;
+
+        aStats.Add( elapsed, s_allocations - m_allocations );
+    }
+
+    /// @return the item the track ends on, as ROUTER_TOOL picks it.
+    PNS_ITEM* pickEndItem()
+    {
+        // no end item for a track started out of any net
+        if( m_router.GetCurrentNet() < 0 )
+            return NULL;
+
+        int         layer = m_router.IsPlacingVia() ? -1 : m_router.GetCurrentLayer();
+        PNS_ITEM*   endItem = pickItem( m_router, m_end, m_router.GetCurrentNet(), layer );
+        bool        dummy;
+
+        if( endItem )
+            m_end = m_router.SnapToItem( endItem, m_end, dummy );
+
+        return endItem;
+    }
+
+    void move( EVENT_STATS& aStats )
+    {
+        PNS_ITEM* endItem = pickEndItem();
+
+        begin();
+        m_router.Move( m_end, endItem );
+        end( aStats );
+    }
+
+    void stop()
+    {
+        m_router.StopRouting();
+        m_router.ClearLastChanges();
+    }
+
+    BOARD*          m_board;
+    REPLAY_STATS&   m_stats;
+    PNS_ROUTER      m_router;
+    VECTOR2I        m_end;
+    unsigned        m_start;
+    unsigned long   m_allocations;
+};
+
+
+/**
+ * Function replayTrace
+ * loads a board, then replays a trace on it.
+ * @return BOARD_SIGNATURE* - the routed board, or NULL if the board or the trace
+ *  cannot be read.
+ */
+static BOARD_SIGNATURE* replayTrace( const wxString& aBoardFile, const char* aTraceFile,
+                                     REPLAY_STATS& aStats )
+{
+    FILE* trace = fopen( aTraceFile, "rt" );
+
+    if( !trace )
+    {
+        fprintf( stderr, "router_benchmark: cannot read %s\n", aTraceFile );
+        return NULL;
+    }
+
+    IO_MGR::PCB_FILE_T pluginType = IO_MGR::LEGACY;
+
+    if( wxFileName( aBoardFile ).GetExt() == KiCadPcbFileExtension )
+        pluginType = IO_MGR::KICAD;
+
+    BOARD* board = NULL;
+
+    try
+    {
+        board = IO_MGR::Load( pluginType, aBoardFile );
+    }
+    catch( const IO_ERROR& ioe )
+    {
+        fprintf( stderr, "router_benchmark: %s\n", TO_UTF8( ioe.errorText ) );
+    }
+
+    if( !board )
+    {
+        fprintf( stderr, "router_benchmark: cannot load %s\n", TO_UTF8( aBoardFile ) );
+        fclose( trace );
+        return NULL;
+    }
+
+    board->BuildListOfNets();
+    board->SynchronizeNetsAndNetClasses();
+    board->GetRatsnest()->ProcessBoard();
+
+    bool ok = true;
+
+    // The player, and its router, is deleted before the board, whose items the
+    // router may have hidden.
+    {
+        TRACE_PLAYER    player( board, aStats );
+        char            line[256];
+        int             lineNum = 0;
+
+        while( ok && fgets( line, sizeof( line ), trace ) )
+        {
+            ++lineNum;
+
+            if( !player.Play( line ) )
+            {
+                fprintf( stderr, "router_benchmark: %s:%d: bad event\n", aTraceFile, lineNum );
+                ok = false;
+            }
+        }
+    }
+
+    fclose( trace );
+
+    BOARD_SIGNATURE* signature = ok ? new BOARD_SIGNATURE( board ) : NULL;
+
+    delete board;
+
+    return signature;
+}
+
+
+int main( int argc, char** argv )
+{
+    wxInitializer initializer;
+
+    if( !initializer.IsOk() )
+    {
+        fprintf( stderr, "router_benchmark: cannot initialize wxWidgets\n" );
+        return 1;
+    }
+
+    int kifaceVersion;
+    KIFACE_GETTER( &kifaceVersion, KIFACE_VERSION, &program );
+
+    int repeat = 1;
+    unsigned maxP99 = 0;
+    int ii;
+
+    for( ii = 1; ii < argc && argv[ii][0] == '-'; ++ii )
+    {
+        if( !strncmp( argv[ii], "--repeat=", 9 ) && ( repeat = atoi( argv[ii] + 9 ) ) > 0 )
+            continue;
+
+        if( !strncmp( argv[ii], "--max-p99=", 10 ) && atoi( argv[ii] + 10 ) > 0 )
+        {
+            maxP99 = atoi( argv[ii] + 10 );
+            continue;
+        }
+
+        usage();
+        return 1;
+    }
+
+    if( argc - ii < 2 )
+    {
+        usage();
+        return 1;
+    }
+
+    wxString boardFile = FROM_UTF8( argv[ii] );
+    int errors = 0;
+    int slow = 0;
+
+    for( ++ii; ii < argc; ++ii )
+    {
+        REPLAY_STATS        stats;
+        BOARD_SIGNATURE*    first = NULL;
+        bool                ok = true;
+
+        for( int run = 0; run < repeat && ok; ++run )
+        {
+            BOARD_SIGNATURE* signature = replayTrace( boardFile, argv[ii], stats );
+
+            if( !signature )
+            {
+                ok = false;
+            }
+            else if( !first )
+            {
+                first = signature;
+            }
+            else
+            {
+                if( !( *signature == *first ) )
+                {
+                    fprintf( stderr, "router_benchmark: %s: the replay %d gives another board\n",
+                             argv[ii], run + 1 );
+                    ok = false;
+                }
+
+                delete signature;
+            }
+        }
+
+        printf( "%s on %s, %d replays:\n", argv[ii],
+                TO_UTF8( wxFileName( boardFile ).GetFullName() ), repeat );
+        stats.Print();
+
+        if( first )
+        {
+            first->Print();
+            delete first;
+        }
+
+        if( !ok )
+            ++errors;
+
+        if( ok && maxP99 && stats.move.Percentile( 99 ) > maxP99 )
+        {
+            fprintf( stderr, "router_benchmark: %s: move p99 %u us over the %u us budget\n",
+                     argv[ii], stats.move.Percentile( 99 ), maxP99 );
+            ++slow;
+        }
+    }
+
+    if( errors )
+        return 1;
+
+    return slow ? 2 : 0;
+}
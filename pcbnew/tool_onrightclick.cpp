@@ -33,6 +33,7 @@
 #include <wxPcbStruct.h>
 #include <module_editor_frame.h>
 #include <dialog_design_rules.h>
+#include <drc_stuff.h>
 #include <pcbnew_id.h>
 
 
@@ -51,6 +52,7 @@ void PCB_EDIT_FRAME::ToolOnRightClick( wxCommandEvent& event )
 
         if( dlg.ShowModal() == wxID_OK )
         {
+            m_drc->OnlineRulesChanged();
             updateTraceWidthSelectBox();
             updateViaSizeSelectBox();
         }
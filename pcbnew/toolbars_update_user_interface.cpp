@@ -121,6 +121,12 @@ void PCB_EDIT_FRAME::OnUpdateDrcEnable( wxUpdateUIEvent& aEvent )
                                         _( "Enable design rule checking" ) );
 }
 
+
+void PCB_EDIT_FRAME::OnUpdateOnlineDrc( wxUpdateUIEvent& aEvent )
+{
+    aEvent.Check( m_drc->IsOnlineTestsActive() );
+}
+
 void PCB_EDIT_FRAME::OnUpdateShowBoardRatsnest( wxUpdateUIEvent& aEvent )
 {
     aEvent.Check( GetBoard()->IsElementVisible( RATSNEST_VISIBLE ) );
@@ -69,64 +69,65 @@ bool ZONE_CONTAINER::BuildFilledSolidAreasPolygons( BOARD* aPcb,
         return 0;
 
     // Make a smoothed polygon out of the user-drawn polygon if required
-    if( m_smoothedPoly )
-    {
-        delete m_smoothedPoly;
-        m_smoothedPoly = NULL;
-    }
+    CPolyLine* smoothedPoly;
 
     switch( m_cornerSmoothingType )
     {
     case ZONE_SETTINGS::SMOOTHING_CHAMFER:
-        m_smoothedPoly = m_Poly->Chamfer( m_cornerRadius );
+        smoothedPoly = m_Poly->Chamfer( m_cornerRadius );
         break;
     case ZONE_SETTINGS::SMOOTHING_FILLET:
-        m_smoothedPoly = m_Poly->Fillet( m_cornerRadius, m_ArcToSegmentsCount );
+        smoothedPoly = m_Poly->Fillet( m_cornerRadius, m_ArcToSegmentsCount );
         break;
     default:
-        m_smoothedPoly = new CPolyLine;
-        m_smoothedPoly->Copy( m_Poly );
+        smoothedPoly = new CPolyLine;
+        smoothedPoly->Copy( m_Poly );
         break;
     }
 
+    // The outline of a zone is read while other zones are filled, maybe by other
+    // threads: in this case the zone itself is left unchanged.
     if( aCornerBuffer )
-        ConvertPolysListWithHolesToOnePolygon( m_smoothedPoly->m_CornersList,
-                                               *aCornerBuffer );
-    else
-        ConvertPolysListWithHolesToOnePolygon( m_smoothedPoly->m_CornersList,
-                                               m_FilledPolysList );
+    {
+        ConvertPolysListWithHolesToOnePolygon( smoothedPoly->m_CornersList, *aCornerBuffer );
+        delete smoothedPoly;
+
+        return 1;
+    }
+
+    delete m_smoothedPoly;
+    m_smoothedPoly = smoothedPoly;
+
+    ConvertPolysListWithHolesToOnePolygon( m_smoothedPoly->m_CornersList, m_FilledPolysList );
 
     /* For copper layers, we now must add holes in the Polygon list.
      * holes are pads and tracks with their clearance area
      * for non copper layers just recalculate the m_FilledPolysList
      * with m_ZoneMinThickness taken in account
      */
-    if( ! aCornerBuffer )
+    if( IsOnCopperLayer() )
+        AddClearanceAreasPolygonsToPolysList( aPcb );
+    else
     {
-        if( IsOnCopperLayer() )
-            AddClearanceAreasPolygonsToPolysList( aPcb );
-        else
-        {
-            // This KI_POLYGON_SET is the area(s) to fill, with m_ZoneMinThickness/2
-            KI_POLYGON_SET polyset_zone_solid_areas;
-            int         margin = m_ZoneMinThickness / 2;
-
-            /* First, creates the main polygon (i.e. the filled area using only one outline)
-             * to reserve a m_ZoneMinThickness/2 margin around the outlines and holes
-             * this margin is the room to redraw outlines with segments having a width set to
-             * m_ZoneMinThickness
-             * so m_ZoneMinThickness is the min thickness of the filled zones areas
-             * the polygon is stored in polyset_zone_solid_areas
-             */
-            CopyPolygonsFromFilledPolysListToKiPolygonList( polyset_zone_solid_areas );
-            polyset_zone_solid_areas -= margin;
-            // put solid area in m_FilledPolysList:
-            m_FilledPolysList.RemoveAllContours();
-            CopyPolygonsFromKiPolygonListToFilledPolysList( polyset_zone_solid_areas );
-        }
-        if ( m_FillMode )   // if fill mode uses segments, create them:
-            FillZoneAreasWithSegments( );
+        // This KI_POLYGON_SET is the area(s) to fill, with m_ZoneMinThickness/2
+        KI_POLYGON_SET polyset_zone_solid_areas;
+        int         margin = m_ZoneMinThickness / 2;
+
+        /* First, creates the main polygon (i.e. the filled area using only one outline)
+         * to reserve a m_ZoneMinThickness/2 margin around the outlines and holes
+         * this margin is the room to redraw outlines with segments having a width set to
+         * m_ZoneMinThickness
+         * so m_ZoneMinThickness is the min thickness of the filled zones areas
+         * the polygon is stored in polyset_zone_solid_areas
+         */
+        CopyPolygonsFromFilledPolysListToKiPolygonList( polyset_zone_solid_areas );
+        polyset_zone_solid_areas -= margin;
+        // put solid area in m_FilledPolysList:
+        m_FilledPolysList.RemoveAllContours();
+        CopyPolygonsFromKiPolygonListToFilledPolysList( polyset_zone_solid_areas );
     }
+    if ( m_FillMode )   // if fill mode uses segments, create them:
+        FillZoneAreasWithSegments( );
 
     return 1;
 }
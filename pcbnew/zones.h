@@ -40,6 +40,13 @@ enum ZoneConnection {
     THT_THERMAL             ///< Thermal relief only for THT pads
 };
 
+/**
+ * Definition for enabling and disabling the zone fill trace output, which gives the
+ * time taken by every zone.  See the wxWidgets documentation on using the WXTRACE
+ * environment variable.
+ */
+extern const wxChar traceZoneFill[];
+
 class ZONE_CONTAINER;
 class ZONE_SETTINGS;
 class PCB_BASE_FRAME;
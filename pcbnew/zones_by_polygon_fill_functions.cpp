@@ -29,10 +29,12 @@
 #include <wx/progdlg.h>
 
 #include <fctsys.h>
+#include <algorithm>
 #include <pgm_base.h>
 #include <class_drawpanel.h>
 #include <wxPcbStruct.h>
 #include <macros.h>
+#include <common.h>
 
 #include <class_board.h>
 #include <class_track.h>
@@ -41,8 +43,35 @@
 #include <pcbnew.h>
 #include <zones.h>
 
+#ifdef USE_OPENMP
+#include <omp.h>
+#endif /* USE_OPENMP */
+
 #define FORMAT_STRING _( "Filling zone %d out of %d (net %s)..." )
 
+const wxChar traceZoneFill[] = wxT( "KicadZoneFill" );
+
+
+/**
+ * Function isMainThread
+ * @return true in the thread which started the zone fill.  Only this one can use the UI.
+ */
+static inline bool isMainThread()
+{
+#ifdef USE_OPENMP
+    return omp_get_thread_num() == 0;
+#else
+    return true;
+#endif /* USE_OPENMP */
+}
+
+
+static bool sortZoneArea( const std::pair<double, ZONE_CONTAINER*>& aFirst,
+                          const std::pair<double, ZONE_CONTAINER*>& aSecond )
+{
+    return aFirst.first > aSecond.first;
+}
+
 
 /**
  * Function Delete_OldZone_Fill (obsolete)
@@ -120,9 +149,120 @@ int PCB_EDIT_FRAME::Fill_Zone( ZONE_CONTAINER* aZone )
 }
 
 
-int PCB_EDIT_FRAME::Fill_All_Zones( wxWindow * aActiveWindow, bool aVerbose )
+int BOARD::FillAllZones( ZONE_FILL_REPORTER* aReporter )
+{
+    // Remove segment zones
+    m_Zone.DeleteAll();
+
+    // The zones to fill, the largest first, so a large zone is not started last
+    std::vector< std::pair<double, ZONE_CONTAINER*> > zones;
+
+    for( int ii = 0; ii < GetAreaCount(); ii++ )
+    {
+        ZONE_CONTAINER* zoneContainer = GetArea( ii );
+
+        // Cannot fill keepout zones, but a keepout zone can have a fill of the time it
+        // was a copper zone: remove it, as PCB_EDIT_FRAME::Fill_Zone() does.
+        if( zoneContainer->GetIsKeepout() )
+        {
+            zoneContainer->ClearFilledPolysList();
+            zoneContainer->UnFill();
+            continue;
+        }
+
+        zones.push_back( std::make_pair( zoneContainer->GetBoundingBox().GetArea(),
+                                         zoneContainer ) );
+    }
+
+    std::sort( zones.begin(), zones.end(), sortZoneArea );
+
+    // A zone only reads the board and the outlines of the other zones while it is
+    // filled, so the zones are filled in parallel.
+    const int zoneCount = zones.size();
+    std::vector<int> fillTimes( zoneCount, -1 );
+    int done = 0;
+
+    // Set by the main thread and polled by the others: always flushed around its use
+    volatile bool aborted = false;
+
+#ifdef USE_OPENMP
+    #pragma omp parallel for schedule( dynamic, 1 ) shared( zones, fillTimes, done, aborted )
+#endif /* USE_OPENMP */
+    for( int ii = 0; ii < zoneCount; ii++ )
+    {
+#ifdef USE_OPENMP
+        #pragma omp flush
+#endif /* USE_OPENMP */
+
+        if( aborted )
+            continue;   // an OpenMP loop cannot be left with break
+
+        ZONE_CONTAINER* zoneContainer = zones[ii].second;
+        unsigned start = GetRunningMicroSecs();
+
+        zoneContainer->ClearFilledPolysList();
+        zoneContainer->UnFill();
+        zoneContainer->BuildFilledSolidAreasPolygons( this );
+
+        fillTimes[ii] = GetRunningMicroSecs() - start;
+
+#ifdef USE_OPENMP
+        #pragma omp atomic
+#endif /* USE_OPENMP */
+        done++;
+
+        // Only the main thread can use the UI
+        if( aReporter && isMainThread() )
+        {
+            if( !aReporter->Report( zoneContainer, done, zoneCount ) )
+            {
+                aborted = true;     // Aborted by user
+#ifdef USE_OPENMP
+                #pragma omp flush
+#endif /* USE_OPENMP */
+            }
+        }
+    }
+
+    for( int ii = 0; ii < zoneCount; ii++ )
+    {
+        if( fillTimes[ii] < 0 )
+            continue;
+
+        wxLogTrace( traceZoneFill, wxT( "Zone of net %s on layer %d: filled in %d us" ),
+                    GetChars( zones[ii].second->GetNetname() ),
+                    zones[ii].second->GetLayer(), fillTimes[ii] );
+    }
+
+    return done;
+}
+
+
+/**
+ * Class ZONE_FILL_PROGRESS
+ * shows the progress of BOARD::FillAllZones() in a wxProgressDialog.
+ */
+class ZONE_FILL_PROGRESS : public ZONE_FILL_REPORTER
+{
+public:
+    ZONE_FILL_PROGRESS( wxProgressDialog* aDialog ) : m_dialog( aDialog ) { }
+
+    bool Report( const ZONE_CONTAINER* aZone, int aDone, int aTotal )
+    {
+        wxString msg;
+
+        msg.Printf( FORMAT_STRING, aDone, aTotal, GetChars( aZone->GetNetname() ) );
+
+        return m_dialog->Update( aDone, msg );
+    }
+
+private:
+    wxProgressDialog* m_dialog;
+};
+
+
+void PCB_EDIT_FRAME::Fill_All_Zones( wxWindow * aActiveWindow )
 {
-    int errorLevel = 0;
     int areaCount = GetBoard()->GetAreaCount();
     wxBusyCursor dummyCursor;
     wxString msg;
@@ -139,38 +279,27 @@ int PCB_EDIT_FRAME::Fill_All_Zones( wxWindow * aActiveWindow, bool aVerbose )
     if( progressDialog )
         progressDialog->Update( 0, _( "Starting zone fill..." ) );
 
-    // Remove segment zones
-    GetBoard()->m_Zone.DeleteAll();
+    int done;
 
-    int ii;
-
-    for( ii = 0; ii < areaCount; ii++ )
+    if( progressDialog )
     {
-        ZONE_CONTAINER* zoneContainer = GetBoard()->GetArea( ii );
-        if( zoneContainer->GetIsKeepout() )
-            continue;
-
-        msg.Printf( FORMAT_STRING, ii + 1, areaCount, GetChars( zoneContainer->GetNetname() ) );
-
-        if( progressDialog )
-        {
-            if( !progressDialog->Update( ii+1, msg ) )
-                break;  // Aborted by user
-        }
-
-        errorLevel = Fill_Zone( zoneContainer );
-
-        if( errorLevel && !aVerbose )
-            break;
+        ZONE_FILL_PROGRESS reporter( progressDialog );
+        done = GetBoard()->FillAllZones( &reporter );
     }
+    else
+    {
+        done = GetBoard()->FillAllZones();
+    }
+
+    if( done )
+        OnModify();
 
     if( progressDialog )
-        progressDialog->Update( ii+2, _( "Updating ratsnest..." ) );
+        progressDialog->Update( areaCount+1, _( "Updating ratsnest..." ) );
     TestConnections();
 
     // Recalculate the active ratsnest, i.e. the unconnected links
     TestForActiveLinksInRatsnest( 0 );
     if( progressDialog )
         progressDialog->Destroy();
-    return errorLevel;
 }
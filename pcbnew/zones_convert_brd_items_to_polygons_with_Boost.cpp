@@ -82,17 +82,7 @@ extern void CreateThermalReliefPadPolygon( CPOLYGONS_LIST& aCornerBuffer,
                                            double                aThermalRot );
 
 // Local Variables:
-static double s_thermalRot = 450;  // angle of stubs in thermal reliefs for round pads
-
-// how many segments are used to create a polygon from a circle:
-static int s_CircleToSegmentsCount = ARC_APPROX_SEGMENTS_COUNT_LOW_DEF;   /* default value. the real value will be changed to
-                                                                           * ARC_APPROX_SEGMENTS_COUNT_HIGHT_DEF
-                                                                           * if m_ArcToSegmentsCount == ARC_APPROX_SEGMENTS_COUNT_HIGHT_DEF
-                                                                           */
-double s_Correction;     /* mult coeff used to enlarge rounded and oval pads (and vias)
-                          * because the segment approximation for arcs and circles
-                          * create a smaller gap than a true circle
-                          */
+static const double s_thermalRot = 450;  // angle of stubs in thermal reliefs for round pads
 
 /**
  * Function AddClearanceAreasPolygonsToPolysList
@@ -125,18 +115,21 @@ double s_Correction;     /* mult coeff used to enlarge rounded and oval pads (an
  */
 void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList( BOARD* aPcb )
 {
-    // Set the number of segments in arc approximations
+    // Several zones can be filled at once, so these settings are local variables.
+
+    // how many segments are used to create a polygon from a circle:
+    int circleToSegmentsCount = ARC_APPROX_SEGMENTS_COUNT_LOW_DEF;
+
     if( m_ArcToSegmentsCount == ARC_APPROX_SEGMENTS_COUNT_HIGHT_DEF  )
-        s_CircleToSegmentsCount = ARC_APPROX_SEGMENTS_COUNT_HIGHT_DEF;
-    else
-        s_CircleToSegmentsCount = ARC_APPROX_SEGMENTS_COUNT_LOW_DEF;
+        circleToSegmentsCount = ARC_APPROX_SEGMENTS_COUNT_HIGHT_DEF;
 
     /* calculates the coeff to compensate radius reduction of holes clearance
      * due to the segment approx.
-     * For a circle the min radius is radius * cos( 2PI / s_CircleToSegmentsCount / 2)
-     * s_Correction is 1 /cos( PI/s_CircleToSegmentsCount  )
+     * For a circle the min radius is radius * cos( 2PI / circleToSegmentsCount / 2)
+     * correction is 1 /cos( PI/circleToSegmentsCount  )
+     * it is used to enlarge rounded and oval pads (and vias)
      */
-    s_Correction = 1.0 / cos( M_PI / s_CircleToSegmentsCount );
+    double correction = 1.0 / cos( M_PI / circleToSegmentsCount );
 
     // This KI_POLYGON_SET is the area(s) to fill, with m_ZoneMinThickness/2
     KI_POLYGON_SET polyset_zone_solid_areas;
@@ -186,9 +179,7 @@ void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList( BOARD* aPcb )
      */
     int item_clearance;
 
-    // static to avoid unnecessary memory allocation when filling many zones.
-    static CPOLYGONS_LIST cornerBufferPolysToSubstract;
-    cornerBufferPolysToSubstract.RemoveAllContours();
+    CPOLYGONS_LIST cornerBufferPolysToSubstract;
 
     /* Use a dummy pad to calculate hole clerance when a pad is not on all copper layers
      * and this pad has a hole
@@ -239,8 +230,8 @@ void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList( BOARD* aPcb )
                     int clearance = std::max( zone_clearance, item_clearance );
                     pad->TransformShapeWithClearanceToPolygon( cornerBufferPolysToSubstract,
                                                                clearance,
-                                                               s_CircleToSegmentsCount,
-                                                               s_Correction );
+                                                               circleToSegmentsCount,
+                                                               correction );
                 }
 
                 continue;
@@ -260,8 +251,8 @@ void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList( BOARD* aPcb )
                 {
                     pad->TransformShapeWithClearanceToPolygon( cornerBufferPolysToSubstract,
                                                                gap,
-                                                               s_CircleToSegmentsCount,
-                                                               s_Correction );
+                                                               circleToSegmentsCount,
+                                                               correction );
                 }
             }
         }
@@ -286,8 +277,8 @@ void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList( BOARD* aPcb )
             int clearance = std::max( zone_clearance, item_clearance );
             track->TransformShapeWithClearanceToPolygon( cornerBufferPolysToSubstract,
                                                          clearance,
-                                                         s_CircleToSegmentsCount,
-                                                         s_Correction );
+                                                         circleToSegmentsCount,
+                                                         correction );
         }
     }
 
@@ -311,7 +302,7 @@ void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList( BOARD* aPcb )
             {
                 ( (EDGE_MODULE*) item )->TransformShapeWithClearanceToPolygon(
                     cornerBufferPolysToSubstract, zone_clearance,
-                    s_CircleToSegmentsCount, s_Correction );
+                    circleToSegmentsCount, correction );
             }
         }
     }
@@ -327,7 +318,7 @@ void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList( BOARD* aPcb )
         case PCB_LINE_T:
             ( (DRAWSEGMENT*) item )->TransformShapeWithClearanceToPolygon(
                 cornerBufferPolysToSubstract,
-                zone_clearance, s_CircleToSegmentsCount, s_Correction );
+                zone_clearance, circleToSegmentsCount, correction );
             break;
 
         case PCB_TEXT_T:
@@ -406,8 +397,8 @@ void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList( BOARD* aPcb )
                                                *pad, thermalGap,
                                                GetThermalReliefCopperBridge( pad ),
                                                m_ZoneMinThickness,
-                                               s_CircleToSegmentsCount,
-                                               s_Correction, s_thermalRot );
+                                               circleToSegmentsCount,
+                                               correction, s_thermalRot );
             }
         }
     }
@@ -438,7 +429,7 @@ void ZONE_CONTAINER::AddClearanceAreasPolygonsToPolysList( BOARD* aPcb )
     // (this is a refinement for thermal relief shapes)
     if( GetNetCode() > 0 )
         BuildUnconnectedThermalStubsPolygonList( cornerBufferPolysToSubstract, aPcb, this,
-                                                 s_Correction, s_thermalRot );
+                                                 correction, s_thermalRot );
 
     // remove copper areas corresponding to not connected stubs
     if( cornerBufferPolysToSubstract.GetCornersCount() )
@@ -800,8 +800,8 @@ void CPolyLine::Hatch()
     #define MAXPTS 200      // Usually we store only few values per one hatch line
                             // depending on the compexity of the zone outline
 
-    static std::vector <wxPoint> pointbuffer;
-    pointbuffer.clear();
+    // Not static: zones are hatched by several threads at once when a board is loaded
+    std::vector <wxPoint> pointbuffer;
     pointbuffer.reserve( MAXPTS + 2 );
 
     for( int a = min_a; a < max_a; a += spacing )
@@ -0,0 +1,31 @@
+import unittest
+import os
+import tempfile
+import pcbnew
+
+class TestZoneLoad(unittest.TestCase):
+
+    # The zones of a board are parsed by several threads at once, and each
+    # hatched zone outline is hatched while it is parsed.
+
+    def setUp(self):
+        self.FILENAME = tempfile.mktemp() + ".kicad_pcb"
+
+    def test_hatched_zones_load(self):
+        for ii in range(20):
+            pcb = pcbnew.LoadBoard("data/hatched_zones.kicad_pcb")
+            self.assertNotEqual(pcb, None)
+            self.assertEqual(pcb.GetAreaCount(), 64)
+
+    def test_hatched_zones_save(self):
+        pcb = pcbnew.LoadBoard("data/hatched_zones.kicad_pcb")
+        self.assertTrue(pcbnew.SaveBoard(self.FILENAME, pcb))
+
+        text = open(self.FILENAME).read()
+        os.remove(self.FILENAME)
+
+        self.assertEqual(text.count("(hatch edge 0.508)"), 32)
+        self.assertEqual(text.count("(hatch full 0.508)"), 32)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -6,17 +6,33 @@
     that an int can hold, and converts to ASCII and back and verifies integrity
     of the round tripped value.
 
+    The locale free conversions of fixed_point_text.h, used by Pcbnew to write
+    and read the boards, are checked against the printf() and strtod() ones for
+    all the values too.
+
+    Usage: test-nm-biu-to-ascii-mm-round-tripping
+               tests all the values.
+           test-nm-biu-to-ascii-mm-round-tripping <value in mm>
+               round trips one value.
+           test-nm-biu-to-ascii-mm-round-tripping --benchmark <board file> ...
+               times both conversions of the numbers of *.kicad_pcb files.
+
     Author: Dick Hollenbeck
 */
 
 
+#include <ctype.h>
 #include <limits.h>
 #include <stdio.h>
 #include <cmath>
 #include <string>
+#include <vector>
 #include <string.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <sys/time.h>
+
+#include <fixed_point_text.h>
 
 
 static inline int KiROUND( double v )
@@ -28,6 +44,7 @@ static inline int KiROUND( double v )
 typedef int             BIU;
 
 #define BIU_PER_MM      1e6
+#define BIU_DECIMALS    6       // BIU_PER_MM is 10^BIU_DECIMALS
 
 
 //double  scale = BIU_PER_MM;
@@ -67,10 +84,209 @@ int parseBIU( const char* s )
 }
 
 
+/**
+ * Function checkParse
+ * checks ParseFixedPoint() against parseBIU() for a text, if it is read.
+ * @return false if both disagree.
+ */
+static bool checkParse( const char* aText )
+{
+    int value;
+
+    if( ParseFixedPoint( aText, BIU_DECIMALS, &value ) && value != parseBIU( aText ) )
+    {
+        printf( "text:%s  ParseFixedPoint:%d  parseBIU:%d\n", aText, value, parseBIU( aText ) );
+        return false;
+    }
+
+    return true;
+}
+
+
+/**
+ * Function checkTexts
+ * checks ParseFixedPoint() on random texts, which are not all written as
+ * FormatFixedPoint() does: leading and trailing zeros, signs, more decimals, exponents.
+ * @return the count of mismatches.
+ */
+static unsigned checkTexts( unsigned aCount )
+{
+    unsigned    mismatches = 0;
+    char        text[64];
+
+    srand( 1 );
+
+    for( unsigned ii = 0; ii < aCount; ++ii )
+    {
+        char*   cp = text;
+
+        switch( rand() % 4 )
+        {
+        case 0:     *cp++ = '-';    break;
+        case 1:     *cp++ = '+';    break;
+        default:                    break;
+        }
+
+        for( int digits = rand() % 12;  digits > 0;  --digits )
+            *cp++ = '0' + rand() % 10;
+
+        if( rand() % 4 )
+        {
+            *cp++ = '.';
+
+            for( int decimals = rand() % 11;  decimals > 0;  --decimals )
+                *cp++ = rand() % 3 ? '0' + rand() % 10 : '0';
+        }
+
+        if( !( rand() % 8 ) )
+            cp += sprintf( cp, "e%d", rand() % 7 - 3 );
+
+        *cp = '\0';
+
+        if( !checkParse( text ) )
+            ++mismatches;
+    }
+
+    return mismatches;
+}
+
+
+static double seconds()
+{
+    struct timeval  tv;
+
+    gettimeofday( &tv, NULL );
+
+    return tv.tv_sec + tv.tv_usec * 1e-6;
+}
+
+
+/**
+ * Function benchmark
+ * times the reading and the writing of the numbers of a board file, with strtod()
+ * and printf(), then with the fixed point conversions.
+ */
+static bool benchmark( const char* aFileName )
+{
+    FILE* fp = fopen( aFileName, "rb" );
+
+    if( !fp )
+    {
+        fprintf( stderr, "cannot open %s\n", aFileName );
+        return false;
+    }
+
+    std::vector<std::string>    numbers;
+    std::string                 token;
+    int                         c;
+
+    // the tokens of the s-expressions which are numbers, quoted strings aside
+    while( ( c = getc( fp ) ) != EOF )
+    {
+        if( c == '"' )
+        {
+            while( ( c = getc( fp ) ) != EOF && c != '"' )
+            {
+                if( c == '\\' )
+                    getc( fp );
+            }
+
+            token.clear();
+        }
+        else if( c == '(' || c == ')' || isspace( c ) )
+        {
+            if( !token.empty() && strspn( token.c_str(), "+-.0123456789" ) == token.size() )
+                numbers.push_back( token );
+
+            token.clear();
+        }
+        else
+        {
+            token += (char) c;
+        }
+    }
+
+    fclose( fp );
+
+    const int               repeat = 20;
+    std::vector<BIU>        values( numbers.size() );
+    char                    buf[FIXED_POINT_TEXT_MAX];
+    size_t                  length = 0;
+    double                  start;
+
+    start = seconds();
+
+    for( int rr = 0; rr < repeat; ++rr )
+    {
+        for( unsigned ii = 0; ii < numbers.size(); ++ii )
+            values[ii] = parseBIU( numbers[ii].c_str() );
+    }
+
+    double readStrtod = seconds() - start;
+
+    start = seconds();
+
+    for( int rr = 0; rr < repeat; ++rr )
+    {
+        for( unsigned ii = 0; ii < numbers.size(); ++ii )
+        {
+            if( !ParseFixedPoint( numbers[ii].c_str(), BIU_DECIMALS, &values[ii] ) )
+                values[ii] = parseBIU( numbers[ii].c_str() );
+        }
+    }
+
+    double readFixed = seconds() - start;
+
+    start = seconds();
+
+    for( int rr = 0; rr < repeat; ++rr )
+    {
+        for( unsigned ii = 0; ii < values.size(); ++ii )
+            length += biuFmt( values[ii] ).size();
+    }
+
+    double writePrintf = seconds() - start;
+
+    start = seconds();
+
+    for( int rr = 0; rr < repeat; ++rr )
+    {
+        for( unsigned ii = 0; ii < values.size(); ++ii )
+            length += std::string( buf, FormatFixedPoint( buf, values[ii], BIU_DECIMALS ) ).size();
+    }
+
+    double writeFixed = seconds() - start;
+
+    double  ns = numbers.empty() ? 0.0 : 1e9 / ( (double) numbers.size() * repeat );
+
+    printf( "%s: %u numbers (%u chars)\n", aFileName, (unsigned) numbers.size(),
+            (unsigned) ( length / 2 / repeat ) );
+    printf( "    read:  strtod %.1f ns, fixed point %.1f ns\n",
+            readStrtod * ns, readFixed * ns );
+    printf( "    write: printf %.1f ns, fixed point %.1f ns\n",
+            writePrintf * ns, writeFixed * ns );
+
+    return true;
+}
+
+
 int main( int argc, char** argv )
 {
     unsigned mismatches = 0;
 
+    if( argc > 2 && !strcmp( argv[1], "--benchmark" ) )
+    {
+        int errors = 0;
+
+        for( int ii = 2; ii < argc; ++ii )
+        {
+            if( !benchmark( argv[ii] ) )
+                ++errors;
+        }
+
+        return errors ? 1 : 0;
+    }
+
     if( argc > 1 )
     {
         // take a value on the command line and round trip it back to ASCII.
@@ -83,14 +299,28 @@ int main( int argc, char** argv )
 
         printf( "%s: s:%s\n", __func__, s.c_str() );
 
+        if( ParseFixedPoint( argv[1], BIU_DECIMALS, &i ) )
+            printf( "%s: ParseFixedPoint i:%d\n", __func__, i );
+        else
+            printf( "%s: ParseFixedPoint cannot read %s\n", __func__, argv[1] );
+
+        char buf[FIXED_POINT_TEXT_MAX];
+
+        FormatFixedPoint( buf, i, BIU_DECIMALS );
+
+        printf( "%s: FormatFixedPoint s:%s\n", __func__, buf );
+
         exit(0);
     }
 
     // printf( "sizeof(long double): %zd\n", sizeof( long double ) );
 
+    mismatches += checkTexts( 10000000 );
+
     // Emperically prove that we can round trip all 4 billion 32 bit integers representative
     // of nanometers out to textual floating point millimeters, and back without error using
-    // the above two functions.
+    // the above two functions.  The fixed point conversions must give the same text and the
+    // same value.
 //    for( int i = INT_MIN;  int64_t( i ) <= int64_t( INT_MAX );  ++i )
     for( int64_t j = INT_MIN;  j  <= int64_t( INT_MAX );  ++j )
     {
@@ -106,6 +336,21 @@ int main( int argc, char** argv )
             ++mismatches;
         }
 
+        char    buf[FIXED_POINT_TEXT_MAX];
+        int     len = FormatFixedPoint( buf, i, BIU_DECIMALS );
+        int     fixed;
+
+        if( s.compare( 0, std::string::npos, buf, len ) )
+        {
+            printf( "i:%d  biuFmt:%s  FormatFixedPoint:%s\n", i, s.c_str(), buf );
+            ++mismatches;
+        }
+        else if( !ParseFixedPoint( buf, BIU_DECIMALS, &fixed ) || fixed != i )
+        {
+            printf( "i:%d  FormatFixedPoint:%s  ParseFixedPoint failed\n", i, buf );
+            ++mismatches;
+        }
+
         if( !( i & 0xFFFFFF ) )
         {
             printf( " %08x", i );
@@ -117,4 +362,3 @@ int main( int argc, char** argv )
 
     return 0;
 }
-